@@ -0,0 +1,139 @@
+#include "CompoundDictionary.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @brief Autocomplete over a large name list: top-5 completions of typed
+ * prefixes from the trie image (in memory and memory-mapped) versus a
+ * prefix range scan of a sorted vector. All three must return the same names.
+ */
+
+namespace {
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+struct Named {
+    std::string key; // Normalized
+    std::string name;
+    std::uint32_t score;
+};
+
+// Top k of the sorted range starting with prefix, ordered like CompoundDictionary::complete
+void scanComplete(const std::vector<Named>& sorted, const std::string& prefix, size_t k,
+                  std::vector<const Named*>& out) {
+    out.clear();
+    auto it = std::lower_bound(sorted.begin(), sorted.end(), prefix,
+                               [](const Named& n, const std::string& p) { return n.key < p; });
+    for (; it != sorted.end() && it->key.compare(0, prefix.size(), prefix) == 0; ++it) out.push_back(&*it);
+    auto better = [](const Named* a, const Named* b) { return a->score != b->score ? a->score > b->score : a < b; };
+    std::partial_sort(out.begin(), out.begin() + std::min(k, out.size()), out.end(), better);
+    out.resize(std::min(k, out.size()));
+}
+
+} // namespace
+
+int main() {
+    // 120k names: Russian and English stems with substituent prefixes and numbered isomers
+    const char* stems[] = {"метил", "этил", "пропил", "бутил", "фенил", "хлор", "бром", "нитро", "амино", "гидрокси",
+                           "methyl", "ethyl", "propyl", "butyl", "phenyl", "chloro", "bromo", "nitro", "amino", "hydroxy"};
+    const char* bases[] = {"бензол", "толуол", "анилин", "фенол", "пиридин", "уксусная кислота", "benzene",
+                           "toluene", "aniline", "phenol", "pyridine", "acetic acid"};
+    std::mt19937 rng(20);
+    std::uniform_int_distribution<int> stem(0, 19), base(0, 11), position(1, 9), score(0, 1000);
+
+    CompoundDictionary::Builder builder;
+    std::vector<Named> sorted;
+    std::unordered_set<std::string> seen;
+    std::string key;
+    while (sorted.size() < 120000) {
+        const bool russian = rng() & 1;
+        std::string name = std::to_string(position(rng)) + "-";
+        const int parts = 1 + static_cast<int>(rng() % 4);
+        for (int i = 0; i < parts; ++i) name += stems[stem(rng) % 10 + (russian ? 0 : 10)];
+        name += bases[base(rng) % 6 + (russian ? 0 : 6)];
+        CompoundDictionary::normalize(name, key);
+        if (!seen.insert(key).second) continue;
+        sorted.push_back({key, name, static_cast<std::uint32_t>(score(rng))});
+    }
+    seen.clear();
+    std::sort(sorted.begin(), sorted.end(), [](const Named& a, const Named& b) { return a.key < b.key; });
+    for (const Named& n : sorted) builder.add(n.name, "C6H6", n.score);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<char> image = builder.build();
+    double buildMs = millisecondsSince(start);
+
+    const std::string path = "compound_dictionary_bench.dict";
+    CompoundDictionary::save(image, path);
+    start = std::chrono::steady_clock::now();
+    const CompoundDictionary mapped = CompoundDictionary::open(path);
+    double openMs = millisecondsSince(start);
+    const CompoundDictionary owned(std::move(image));
+
+    // What a player types: the first 1..8 characters of existing names
+    std::vector<std::string> prefixes;
+    for (size_t i = 0; i < 20000; ++i) {
+        const std::string& name = sorted[rng() % sorted.size()].key;
+        size_t length = 1 + rng() % 8, bytes = 0;
+        for (size_t chars = 0; bytes < name.size() && chars < length; ++chars) {
+            bytes += (static_cast<unsigned char>(name[bytes]) >= 0xC0) ? 2 : 1;
+        }
+        prefixes.push_back(name.substr(0, bytes));
+    }
+
+    std::vector<const Named*> scanned;
+    start = std::chrono::steady_clock::now();
+    size_t scanTotal = 0;
+    for (const std::string& prefix : prefixes) {
+        scanComplete(sorted, prefix, 5, scanned);
+        scanTotal += scanned.size();
+    }
+    double scanMs = millisecondsSince(start);
+
+    std::vector<CompoundDictionary::Entry> completions;
+    start = std::chrono::steady_clock::now();
+    size_t trieTotal = 0;
+    for (const std::string& prefix : prefixes) {
+        trieTotal += mapped.complete(prefix, 5, completions);
+    }
+    double trieMs = millisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    size_t hits = 0;
+    CompoundDictionary::Entry entry;
+    for (const Named& n : sorted) {
+        hits += mapped.lookup(n.name, entry);
+    }
+    double lookupMs = millisecondsSince(start);
+
+    // Same names, same order, from all three
+    bool ok = scanTotal == trieTotal && hits == sorted.size();
+    std::vector<CompoundDictionary::Entry> fromOwned;
+    for (size_t i = 0; ok && i < prefixes.size(); ++i) {
+        scanComplete(sorted, prefixes[i], 5, scanned);
+        mapped.complete(prefixes[i], 5, completions);
+        owned.complete(prefixes[i], 5, fromOwned);
+        for (size_t j = 0; ok && j < scanned.size(); ++j) {
+            ok = completions[j].name == scanned[j]->name && fromOwned[j].name == scanned[j]->name;
+        }
+    }
+    std::remove(path.c_str());
+
+    std::cout << std::fixed << std::setprecision(2) << sorted.size() << " names, image "
+              << mapped.imageBytes() / 1048576.0 << " MiB, build " << buildMs << " ms, open (mapped) " << openMs
+              << " ms\n"
+              << "sorted vector top-5: " << scanMs * 1000.0 / prefixes.size() << " us/prefix\n"
+              << "trie top-5:          " << trieMs * 1000.0 / prefixes.size() << " us/prefix\n"
+              << "exact lookup:        " << lookupMs * 1000.0 / sorted.size() << " us/name\n"
+              << (ok ? "completions agree" : "MISMATCH") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,96 @@
+#include "DialogSystem.h"
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+
+/**
+ * @brief Loading a large content pack: over 60 MB of JSON with 60 000 levels
+ * (Cyrillic dialog text, escapes, every task type, most answers given and
+ * some computed) through DialogSystem::loadFromJSON. Then a copy with one
+ * missing colon must fail, naming the line and column of the error.
+ */
+
+namespace {
+
+const char* TYPES[] = {"MOLAR_MASS", "MOLES_CONVERSION", "EQUATION_BALANCE", "STOICHIOMETRY", "FORMULA_PARSE"};
+const char* CHARACTERS[] = {"WALTER", "JESSE", "MIKE", "GUS", "GALE", "SAUL"};
+const char* FORMULAS[] = {"H2O", "C6H6", "C6H5NO2", "NaCl", "CuSO4.5H2O", "K4[Fe(CN)6]", "C10H15N", "Ca3(PO4)2"};
+
+const char* LINE =
+    "Наука, вот в чем суть. Рассчитай это точно: от этого зависит чистота продукта \\u2014 "
+    "и \\\"качество\\\" превыше всего.\\n";
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main() {
+    const int levels = 60000;
+    std::mt19937 rng(24);
+    std::uniform_int_distribution<int> lines(1, 3);
+
+    std::string pack = "{\n  \"version\": 1,\n  \"dialogs\": [\n";
+    for (int level = 1; level <= levels; ++level) {
+        pack += "    {\"level\": " + std::to_string(level) + ", \"character\": \"" + CHARACTERS[level % 6] +
+                "\", \"text\": \"";
+        for (int i = lines(rng); i > 0; --i) pack += LINE;
+        pack += "\", \"correct\": \"Верно.\", \"incorrect\": \"Пересчитай.\"}";
+        pack += level < levels ? ",\n" : "\n";
+    }
+    pack += "  ],\n  \"tasks\": [\n";
+    for (int level = 1; level <= levels; ++level) {
+        const int type = level % 5;
+        const char* formula = FORMULAS[level % 8];
+        pack += "    {\"level\": " + std::to_string(level) + ", \"type\": \"" + TYPES[type] +
+                "\", \"description\": \"Задача " + std::to_string(level) + "\", \"question\": \"";
+        for (int i = lines(rng); i > 0; --i) pack += LINE;
+        pack += "\", \"formula1\": \"" + std::string(formula) + "\", \"formula2\": \"C6H5NO2\", \"inputMoles\": 2.5";
+        if (type == 2) {
+            pack += ", \"equation\": \"C3H8 + O2 -> CO2 + H2O\"";
+        } else if (level % 4 != 0) {
+            pack += ", \"answer\": " + std::to_string(level) + ".5, \"tolerance\": 0.1";
+        } else if (type == 4) {
+            pack += ", \"answer\": \"" + std::string(formula) + "\"";
+        }
+        pack += ", \"extra\": {\"tags\": [\"bench\", null, true]}}";
+        pack += level < levels ? ",\n" : "\n";
+    }
+    pack += "  ]\n}\n";
+
+    const std::string path = "content_loader_bench.json";
+    std::ofstream(path, std::ios::binary) << pack;
+
+    DialogSystem dialogs;
+    auto start = std::chrono::steady_clock::now();
+    bool loaded = dialogs.loadFromJSON(path);
+    double loadMs = millisecondsSince(start);
+    const double megabytes = pack.size() / 1048576.0;
+
+    DialogSystem::Task last = dialogs.getTask(levels);
+    DialogSystem::Task balance = dialogs.getTask(2);
+    bool ok = loaded && dialogs.getTaskCount() == levels && last.level == levels && balance.answer == "1 5 3 4" &&
+              dialogs.getDialog(levels).text.find("\xE2\x80\x94 и \"качество\"") != std::string::npos;
+
+    std::cout << std::fixed << std::setprecision(1) << megabytes << " MiB, " << dialogs.getTaskCount()
+              << " tasks: " << loadMs << " ms (" << megabytes / (loadMs / 1000.0) << " MiB/s)\n";
+    if (!loaded) std::cout << dialogs.getLoadError() << "\n";
+
+    // Drop the colon after the 30000th task's "question" key
+    size_t broken = 0;
+    for (int i = 0; i < 30000; ++i) broken = pack.find("\"question\":", broken + 1);
+    pack.erase(broken + 10, 1);
+    std::ofstream(path, std::ios::binary | std::ios::trunc) << pack;
+    bool rejected = !dialogs.loadFromJSON(path) && dialogs.getTaskCount() == levels;
+    std::cout << "broken copy: " << dialogs.getLoadError() << "\n";
+    ok = ok && rejected && dialogs.getLoadError().find(":90005:") != std::string::npos;
+
+    std::remove(path.c_str());
+    std::cout << (ok ? "content agrees" : "MISMATCH") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,123 @@
+#include "ContentPack.h"
+#include "DialogSystem.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Startup from precompiled content packs of 1 000 to 300 000 levels:
+ * DialogSystem::loadFromPack should take about the same time for each, and
+ * serving a task should not depend on the pack size either. Then one damaged
+ * byte in a task's text must make that level read as missing (and fail
+ * verify()), and a damaged header must make the pack fail to open.
+ */
+
+namespace {
+
+const char* FORMULAS[] = {"H2O", "C6H6", "C6H5NO2", "NaCl", "CuSO4.5H2O", "K4[Fe(CN)6]", "C10H15N", "Ca3(PO4)2"};
+
+std::string question(int level) {
+    return "Задача " + std::to_string(level) + ": рассчитай молярную массу " + FORMULAS[level % 8] +
+           ". От этого зависит чистота продукта.";
+}
+
+std::vector<char> buildPack(int levels) {
+    ContentPack::Builder builder;
+    for (int level = 1; level <= levels; ++level) {
+        const std::string text = question(level);
+        const std::string answer = std::to_string(level) + ".5";
+        ContentPack::TaskView task;
+        task.level = static_cast<std::uint32_t>(level);
+        task.type = static_cast<std::uint32_t>(level % 5);
+        task.tolerance = 0.1;
+        task.inputMoles = 2.5;
+        task.description = "Молярная масса";
+        task.question = text;
+        task.answer = answer;
+        task.formula1 = FORMULAS[level % 8];
+        task.formula2 = "C6H5NO2";
+        builder.addTask(task);
+
+        ContentPack::DialogView dialog;
+        dialog.level = static_cast<std::uint32_t>(level);
+        dialog.character = static_cast<std::uint32_t>(level % 6);
+        dialog.text = text;
+        dialog.correctResponse = "Верно.";
+        dialog.incorrectResponse = "Пересчитай.";
+        builder.addDialog(dialog);
+    }
+    return builder.build();
+}
+
+double microsecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main() {
+    const std::string path = "content_pack_bench.pack";
+    const int runs = 21;
+    bool ok = true;
+
+    std::cout << std::fixed;
+    for (int levels : {1000, 10000, 100000, 300000}) {
+        ContentPack::save(buildPack(levels), path);
+
+        // Median of several opens; the file stays in the page cache between them
+        std::vector<double> openTimes;
+        DialogSystem dialogs;
+        for (int run = 0; run < runs; ++run) {
+            auto start = std::chrono::steady_clock::now();
+            ok = dialogs.loadFromPack(path) && ok;
+            openTimes.push_back(microsecondsSince(start));
+        }
+        std::nth_element(openTimes.begin(), openTimes.begin() + runs / 2, openTimes.end());
+
+        // Serve every level once, checking what comes back
+        size_t served = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (int level = 1; level <= levels; ++level) {
+            DialogSystem::Task task = dialogs.getTask(level);
+            served += task.question.size();
+            ok = ok && task.level == level && task.answer == std::to_string(level) + ".5" &&
+                 task.dialog.correctResponse == "Верно.";
+        }
+        const double serveMicroseconds = microsecondsSince(start) / levels;
+        ok = ok && served > 0 && dialogs.getTaskCount() == levels &&
+             dialogs.getTask(levels).question == question(levels);
+
+        std::ifstream file(path, std::ios::binary | std::ios::ate);
+        const double megabytes = static_cast<double>(file.tellg()) / 1048576.0;
+        std::cout << std::setw(6) << levels << " levels, " << std::setprecision(1) << std::setw(5) << megabytes
+                  << " MiB: open " << std::setprecision(1) << openTimes[runs / 2] << " us, serve "
+                  << std::setprecision(2) << serveMicroseconds << " us per task\n";
+    }
+
+    // One byte of the 500th task's question: that level reads as missing, the others do not
+    std::vector<char> image = buildPack(1000);
+    const std::string damaged = question(500);
+    auto at = std::search(image.begin(), image.end(), damaged.begin(), damaged.end());
+    *(at + 3) ^= 0x20;
+    ContentPack::save(image, path);
+    DialogSystem dialogs;
+    bool detected = dialogs.loadFromPack(path) && dialogs.getTask(500).level == 1 &&
+                    dialogs.getTask(501).level == 501 && !ContentPack::open(path).verify();
+    std::cout << "damaged task: " << (detected ? "level 500 reads as missing" : "NOT DETECTED") << "\n";
+    ok = ok && detected;
+
+    image[20] ^= 0x01; // stringBytes in the header
+    ContentPack::save(image, path);
+    detected = !dialogs.loadFromPack(path) && dialogs.getTaskCount() == 1000 && dialogs.getTask(501).level == 501;
+    std::cout << "damaged header: " << (detected ? dialogs.getLoadError() : "NOT DETECTED") << "\n";
+    ok = ok && detected;
+
+    std::remove(path.c_str());
+    std::cout << (ok ? "content agrees" : "MISMATCH") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,81 @@
+#include "CanonicalFormula.h"
+#include "EmpiricalFormula.h"
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @brief "Find the formula" tasks: random compounds are turned into percent
+ * compositions rounded to one decimal (as a textbook prints them) and molar
+ * masses rounded to 0.1 g/mol, then solved back. Reports tasks per second and
+ * how often the best candidate is the original molecular formula.
+ */
+
+namespace {
+
+double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main() {
+    const size_t taskCount = 100000;
+    std::mt19937 rng(23);
+    const int heteroatoms[] = {7, 8, 16, 17, 11, 26};
+    std::uniform_int_distribution<int> carbon(1, 10), hydrogen(0, 16), extraCount(1, 4), extraKinds(0, 2);
+    std::uniform_int_distribution<int> pick(0, 5);
+
+    struct Task {
+        EmpiricalFormula::Query query;
+        std::string molecular;
+    };
+    std::vector<Task> tasks;
+    tasks.reserve(taskCount);
+    FormulaParser::ElementCounts counts;
+    while (tasks.size() < taskCount) {
+        counts.clear();
+        counts.add(6, carbon(rng));
+        int h = hydrogen(rng);
+        if (h > 0) counts.add(1, h);
+        for (int kinds = extraKinds(rng) + 1; kinds > 0; --kinds) counts.add(heteroatoms[pick(rng)], extraCount(rng));
+
+        Task task;
+        for (EmpiricalFormula::Component component : EmpiricalFormula::percentComposition(counts)) {
+            component.percent = std::round(component.percent * 10.0) / 10.0;
+            if (component.percent > 0.0) task.query.composition.push_back(component);
+        }
+        if (task.query.composition.size() < 2) continue;
+        task.query.molarMass = std::round(counts.molarMass() * 10.0) / 10.0;
+        task.molecular = CanonicalFormula::hill(counts);
+        tasks.push_back(std::move(task));
+    }
+
+    size_t solved = 0, first = 0, listed = 0;
+    auto start = std::chrono::steady_clock::now();
+    for (const Task& task : tasks) {
+        std::vector<EmpiricalFormula::Candidate> candidates = EmpiricalFormula::solve(task.query);
+        solved += !candidates.empty();
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            if (candidates[i].molecularFormula == task.molecular) {
+                first += i == 0;
+                listed++;
+                break;
+            }
+        }
+    }
+    double seconds = secondsSince(start);
+
+    std::cout << std::fixed << std::setprecision(1) << tasks.size() << " tasks in " << seconds * 1000.0 << " ms ("
+              << std::setprecision(0) << tasks.size() / seconds << " tasks/s, " << std::setprecision(2)
+              << seconds * 1e6 / tasks.size() << " us/task)\n"
+              << std::setprecision(1) << "some candidate:     " << 100.0 * solved / tasks.size() << "%\n"
+              << "original first:     " << 100.0 * first / tasks.size() << "%\n"
+              << "original in top " << EmpiricalFormula::Query().maxCandidates << ": " << 100.0 * listed / tasks.size()
+              << "%\n";
+    return solved == tasks.size() ? 0 : 1;
+}
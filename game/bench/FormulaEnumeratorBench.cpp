@@ -0,0 +1,82 @@
+#include "ChemistryEngine.h"
+#include "FormulaEnumerator.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Formula-from-mass queries for real CHNOS compounds across the organic mass range.
+ * Each compound's own molar mass is the target. The table shows how many formulas the
+ * organic query leaves, where the true formula ranks among them (closest mass first),
+ * and how many the bare CHNOS search (no ratio limits) would have offered instead.
+ */
+
+int main(int argc, char** argv) {
+    double tolerance = argc > 1 ? std::stod(argv[1]) : 0.01;
+
+    const std::vector<std::pair<std::string, std::string>> compounds = {
+        {"acetic acid", "C2H4O2"},
+        {"glycine", "C2H5NO2"},
+        {"benzoic acid", "C7H6O2"},
+        {"methionine", "C5H11NO2S"},
+        {"nicotine", "C10H14N2"},
+        {"paracetamol", "C8H9NO2"},
+        {"glucose", "C6H12O6"},
+        {"aspirin", "C9H8O4"},
+        {"caffeine", "C8H10N4O2"},
+        {"ibuprofen", "C13H18O2"},
+        {"morphine", "C17H19NO3"},
+        {"penicillin G", "C16H18N2O4S"},
+        {"sucrose", "C12H22O11"},
+        {"cholesterol", "C27H46O"},
+        {"glutathione", "C10H17N3O6S"},
+        {"reserpine", "C33H40N2O9"}
+    };
+
+    std::cout << std::left << std::setw(14) << "compound" << std::setw(14) << "formula" << std::right
+              << std::setw(10) << "mass" << std::setw(9) << "results" << std::setw(6) << "rank"
+              << std::setw(10) << "bare" << std::setw(10) << "nodes" << std::setw(9) << "ms\n";
+
+    double totalMs = 0.0;
+    size_t totalResults = 0;
+    size_t totalBare = 0;
+    int missing = 0;
+    for (const auto& compound : compounds) {
+        double mass = ChemistryEngine::calculateMolarMass(compound.second);
+        FormulaEnumerator::Query query = FormulaEnumerator::organicQuery(mass, tolerance);
+
+        FormulaEnumerator::Summary summary;
+        auto start = std::chrono::steady_clock::now();
+        auto results = FormulaEnumerator::find(query, &summary);
+        double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+        totalMs += ms;
+
+        size_t rank = 0;
+        for (size_t i = 0; i < results.size() && rank == 0; ++i) {
+            rank = results[i].formula == compound.second ? i + 1 : 0;
+        }
+        missing += rank == 0;
+
+        FormulaEnumerator::Query bare = query;
+        bare.ratios.clear();
+        size_t bareCount = FormulaEnumerator::enumerate(bare, [](const FormulaEnumerator::Candidate&) {
+            return true;
+        }).results;
+        totalResults += results.size();
+        totalBare += bareCount;
+
+        std::cout << std::left << std::setw(14) << compound.first << std::setw(14) << compound.second
+                  << std::right << std::fixed << std::setprecision(3) << std::setw(10) << mass
+                  << std::setw(9) << results.size() << std::setw(6) << (rank == 0 ? std::string("-") : std::to_string(rank))
+                  << std::setw(10) << bareCount << std::setw(10) << summary.nodes << std::setw(9) << ms << "\n";
+    }
+
+    std::cout << std::setprecision(3) << "mean: " << totalMs / compounds.size() << " ms/query, "
+              << std::setprecision(1) << static_cast<double>(totalResults) / compounds.size()
+              << " candidates/query (bare CHNOS: " << static_cast<double>(totalBare) / compounds.size() << ")\n"
+              << "true formula found for " << compounds.size() - missing << "/" << compounds.size() << " compounds\n";
+    return missing == 0 ? 0 : 1;
+}
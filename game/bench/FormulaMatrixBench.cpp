@@ -0,0 +1,74 @@
+#include "ChemistryEngine.h"
+#include "FormulaMatrix.h"
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Batch molar masses through FormulaMatrix versus one
+ * ChemistryEngine::calculateMolarMass call per formula.
+ */
+
+namespace {
+
+// Random organic-looking formulas: CHNO backbone plus occasional heteroatoms
+std::vector<ChemistryEngine::ChemicalFormula> generateCatalogue(size_t count) {
+    static const char* extras[] = {"S", "P", "Cl", "Br", "Na", "Fe", "Mn", "Hg"};
+    std::mt19937 rng(42);
+    std::uniform_int_distribution<int> small(0, 12), large(1, 60), pick(0, 7), coin(0, 3);
+
+    std::vector<ChemistryEngine::ChemicalFormula> formulas;
+    formulas.reserve(count);
+    for (size_t i = 0; i < count; ++i) {
+        std::string formula = "C" + std::to_string(large(rng)) + "H" + std::to_string(large(rng));
+        if (coin(rng) != 0) formula += "N" + std::to_string(small(rng) + 1);
+        if (coin(rng) != 0) formula += "O" + std::to_string(small(rng) + 1);
+        if (coin(rng) == 0) formula += extras[pick(rng)] + std::to_string(small(rng) + 1);
+        formulas.push_back(ChemistryEngine::parseFormula(formula));
+    }
+    return formulas;
+}
+
+double millisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    auto formulas = generateCatalogue(count);
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<double> scalar(formulas.size());
+    for (size_t i = 0; i < formulas.size(); ++i) {
+        scalar[i] = ChemistryEngine::calculateMolarMass(formulas[i]);
+    }
+    double scalarMs = millisSince(start);
+
+    start = std::chrono::steady_clock::now();
+    FormulaMatrix matrix(formulas);
+    double packMs = millisSince(start);
+
+    start = std::chrono::steady_clock::now();
+    std::vector<double> batch = matrix.molarMasses();
+    double batchMs = millisSince(start);
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < formulas.size(); ++i) {
+        if (std::memcmp(&scalar[i], &batch[i], sizeof(double)) != 0) mismatches++;
+    }
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "formulas:        " << formulas.size() << " (" << matrix.columns() << " element columns)\n"
+              << "kernel:          " << FormulaMatrix::kernelName() << "\n"
+              << "per-formula:     " << scalarMs << " ms\n"
+              << "matrix packing:  " << packMs << " ms\n"
+              << "batch kernel:    " << batchMs << " ms (" << scalarMs / batchMs << "x)\n"
+              << "bit mismatches:  " << mismatches << "\n";
+    return mismatches == 0 ? 0 : 1;
+}
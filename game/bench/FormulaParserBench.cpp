@@ -0,0 +1,189 @@
+#include "ChemistryEngine.h"
+#include "FormulaParser.h"
+#include "PeriodicTable.h"
+#include <algorithm>
+#include <chrono>
+#include <cctype>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Compares the flat string_view FormulaParser with the original
+ * map-based recursive descent parser that ChemistryEngine used before it.
+ */
+
+namespace {
+
+// The previous ChemistryEngine parser, kept verbatim as the baseline
+struct LegacyParser {
+    static std::map<std::string, int> parse(const std::string& formula) {
+        std::map<std::string, int> elements;
+        std::string cleanFormula = formula;
+        cleanFormula.erase(std::remove_if(cleanFormula.begin(), cleanFormula.end(), ::isspace), cleanFormula.end());
+        size_t pos = 0;
+        parseRecursive(cleanFormula, pos, elements, 1);
+        return elements;
+    }
+
+    static void parseRecursive(const std::string& formula, size_t& pos,
+                               std::map<std::string, int>& elements, int multiplier) {
+        while (pos < formula.length()) {
+            if (formula[pos] == '(') {
+                pos++;
+                std::map<std::string, int> subElements;
+                parseRecursive(formula, pos, subElements, 1);
+                if (pos < formula.length() && formula[pos] == ')') {
+                    pos++;
+                    int subMultiplier = readNumber(formula, pos);
+                    if (subMultiplier == 0) subMultiplier = 1;
+                    for (auto& elem : subElements) {
+                        elements[elem.first] += elem.second * subMultiplier * multiplier;
+                    }
+                }
+            } else if (std::isupper(formula[pos])) {
+                std::string symbol = readElementSymbol(formula, pos);
+                int count = readNumber(formula, pos);
+                if (count == 0) count = 1;
+                elements[symbol] += count * multiplier;
+            } else {
+                break;
+            }
+        }
+    }
+
+    static std::string readElementSymbol(const std::string& formula, size_t& pos) {
+        std::string symbol;
+        symbol += formula[pos++];
+        if (pos < formula.length() && std::islower(formula[pos])) {
+            symbol += formula[pos++];
+        }
+        return symbol;
+    }
+
+    static int readNumber(const std::string& formula, size_t& pos) {
+        int number = 0;
+        while (pos < formula.length() && std::isdigit(formula[pos])) {
+            number = number * 10 + (formula[pos] - '0');
+            pos++;
+        }
+        return number;
+    }
+
+    static double molarMass(const std::string& formula) {
+        double total = 0.0;
+        for (const auto& elem : parse(formula)) {
+            total += PeriodicTable::atomicMass(PeriodicTable::atomicNumber(elem.first)) * elem.second;
+        }
+        return total;
+    }
+};
+
+template <typename F>
+double nanosPerOp(F&& body, int iterations) {
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < iterations; ++i) {
+        body();
+    }
+    auto elapsed = std::chrono::steady_clock::now() - start;
+    return std::chrono::duration<double, std::nano>(elapsed).count() / iterations;
+}
+
+std::string longFormula() {
+    // Protein-like chain: 200 nested residues
+    std::string formula;
+    for (int i = 0; i < 200; ++i) {
+        formula += "(C5H8NO2(CH2)2S)";
+    }
+    return formula + "H2O";
+}
+
+// Amylose-like chain of glucose units, about megabytes of formula text
+std::string polymerFormula(size_t megabytes) {
+    const std::string unit = "(C6H10O5)";
+    std::string formula = "HO";
+    formula.reserve(megabytes * 1000000 + 3);
+    while (formula.size() < megabytes * 1000000) {
+        formula += unit;
+    }
+    return formula + "H";
+}
+
+bool sameCounts(const FormulaParser::ElementCounts& a, const FormulaParser::ElementCounts& b) {
+    for (int z = 1; z <= PeriodicTable::ELEMENT_COUNT; ++z) {
+        if (a[z] != b[z]) return false;
+    }
+    return a.charge == b.charge;
+}
+
+} // namespace
+
+int main() {
+    const std::vector<std::pair<std::string, std::string>> inputs = {
+        {"short", "H2O"},
+        {"medium", "C10H15N"},
+        {"nested", "Ca3(PO4)2(NH4)2SO4"},
+        {"deep", "K4(Fe(CN)6)(Cu((NH3)4(H2O)2))3"},
+        {"long", longFormula()},
+    };
+
+    volatile double sink = 0.0;
+    FormulaParser::ElementCounts counts;
+
+    std::cout << std::left << std::setw(8) << "input"
+              << std::right << std::setw(14) << "legacy ns/op"
+              << std::setw(14) << "flat ns/op"
+              << std::setw(10) << "speedup" << "\n";
+
+    for (const auto& input : inputs) {
+        const std::string& formula = input.second;
+        int iterations = formula.size() > 1000 ? 2000 : 200000;
+
+        double legacy = nanosPerOp([&] { sink = sink + LegacyParser::molarMass(formula); }, iterations);
+        double flat = nanosPerOp([&] {
+            FormulaParser::parse(formula, counts);
+            sink = sink + counts.molarMass();
+        }, iterations);
+
+        if (std::abs(LegacyParser::molarMass(formula) - ChemistryEngine::calculateMolarMass(formula)) > 1e-6) {
+            std::cerr << "Mismatch on " << input.first << "\n";
+            return 1;
+        }
+
+        std::cout << std::left << std::setw(8) << input.first
+                  << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(14) << legacy
+                  << std::setw(14) << flat
+                  << std::setw(9) << legacy / flat << "x\n";
+    }
+
+    // Multi-megabyte formulas: one string_view pass versus 64 KB chunks from a stream.
+    // Constant ns/byte across sizes means linear time.
+    std::cout << "\n" << std::left << std::setw(8) << "polymer"
+              << std::right << std::setw(16) << "view ns/byte"
+              << std::setw(16) << "stream ns/byte" << "\n";
+    FormulaParser::ElementCounts streamed;
+    for (size_t megabytes : {1, 4, 16}) {
+        const std::string formula = polymerFormula(megabytes);
+        double view = nanosPerOp([&] { FormulaParser::parse(formula, counts); }, 3) / formula.size();
+        double stream = nanosPerOp([&] {
+            std::istringstream input(formula);
+            FormulaParser::parse(input, streamed);
+        }, 3) / formula.size();
+
+        if (!sameCounts(counts, streamed)) {
+            std::cerr << "Stream mismatch on " << megabytes << " MB\n";
+            return 1;
+        }
+
+        std::cout << std::left << std::setw(8) << (std::to_string(megabytes) + " MB")
+                  << std::right << std::fixed << std::setprecision(2)
+                  << std::setw(16) << view
+                  << std::setw(16) << stream << "\n";
+    }
+
+    return 0;
+}
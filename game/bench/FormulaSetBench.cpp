@@ -0,0 +1,101 @@
+#include "CanonicalFormula.h"
+#include "FormulaSet.h"
+#include "PeriodicTable.h"
+#include <algorithm>
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+/**
+ * @brief Deduplicating a large compound list: the same formulas written in
+ * random element order, inserted into FormulaSet (canonical keys and hashes)
+ * versus a std::unordered_set of Hill-order strings. Both must find the same
+ * number of distinct formulas.
+ */
+
+namespace {
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main() {
+    // 400k distinct CHNOS(+halogen) compositions, each written 5 times in shuffled element order.
+    // C and H take 1..40 and up to three of N, O, S take 1..6: 414 400 compositions in all, every
+    // one distinct, so the sample is drawn from the whole space rather than by rejection.
+    const size_t distinct = 400000, copies = 5;
+    std::mt19937 rng(19);
+    const int palette[] = {6, 1, 7, 8, 16, 17, 15, 9};
+
+    std::vector<std::vector<std::pair<int, int>>> compositions;
+    for (int carbon = 1; carbon <= 40; ++carbon) {
+        for (int hydrogen = 1; hydrogen <= 40; ++hydrogen) {
+            for (int more = 0, variants = 1; more <= 3; ++more, variants *= 6) {
+                for (int variant = 0; variant < variants; ++variant) {
+                    std::vector<std::pair<int, int>> parts{{6, carbon}, {1, hydrogen}};
+                    for (int i = 0, rest = variant; i < more; ++i, rest /= 6) {
+                        parts.emplace_back(palette[2 + i], 1 + rest % 6);
+                    }
+                    compositions.push_back(std::move(parts));
+                }
+            }
+        }
+    }
+    std::shuffle(compositions.begin(), compositions.end(), rng);
+    compositions.resize(distinct);
+    FormulaParser::ElementCounts counts;
+
+    std::vector<std::string> list;
+    list.reserve(distinct * copies);
+    for (size_t copy = 0; copy < copies; ++copy) {
+        for (auto parts : compositions) {
+            std::shuffle(parts.begin(), parts.end(), rng);
+            std::string text;
+            for (const auto& part : parts) text += PeriodicTable::symbol(part.first) + std::to_string(part.second);
+            list.push_back(std::move(text));
+        }
+    }
+    std::shuffle(list.begin(), list.end(), rng);
+
+    // Both sides parse every line; the baseline keys on Hill text
+    auto start = std::chrono::steady_clock::now();
+    std::unordered_set<std::string> baseline;
+    std::string hill;
+    for (const std::string& formula : list) {
+        FormulaParser::parse(formula, counts);
+        CanonicalFormula::hill(counts, hill);
+        baseline.insert(hill);
+    }
+    double baselineMs = millisecondsSince(start);
+
+    start = std::chrono::steady_clock::now();
+    FormulaSet set;
+    for (const std::string& formula : list) {
+        set.insert(formula);
+    }
+    double setMs = millisecondsSince(start);
+
+    // Lookups of present formulas
+    start = std::chrono::steady_clock::now();
+    size_t found = 0;
+    for (const std::string& formula : list) {
+        found += set.find(formula) != FormulaSet::NPOS;
+    }
+    double findMs = millisecondsSince(start);
+
+    bool ok = set.size() == distinct && baseline.size() == distinct && found == list.size();
+    std::cout << std::fixed << std::setprecision(1) << list.size() << " formulas, " << set.size() << " distinct\n"
+              << "unordered_set<Hill string>: " << baselineMs << " ms (" << baselineMs * 1e6 / list.size()
+              << " ns/insert)\n"
+              << "FormulaSet:                 " << setMs << " ms (" << setMs * 1e6 / list.size() << " ns/insert), "
+              << set.memoryUsage() / 1048576.0 << " MiB, find " << findMs * 1e6 / list.size() << " ns\n"
+              << "example: " << list.front() << " -> " << set.hillFormula(set.find(list.front())) << "\n"
+              << (ok ? "counts agree" : "MISMATCH") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,107 @@
+#include "FormulaParser.h"
+#include "FormulaValidator.h"
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Typing a long formula into the task box, with typos fixed by
+ * backspace: the verdict and molar mass after every keystroke, by re-parsing
+ * the whole buffer versus FormulaValidator's incremental state. Both must agree
+ * after every keystroke.
+ */
+
+namespace {
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// +1 types the next byte of the target, -1 is a backspace
+std::vector<int> keystrokes(const std::string& target, std::mt19937& rng) {
+    std::vector<int> keys;
+    std::bernoulli_distribution typo(0.05);
+    for (size_t i = 0; i < target.size(); ++i) {
+        if (typo(rng)) {
+            keys.push_back(+2); // A wrong byte, then its correction
+            keys.push_back(-1);
+        }
+        keys.push_back(+1);
+    }
+    return keys;
+}
+
+} // namespace
+
+int main() {
+    // A hydrated coordination polymer: about 1 KB of nested groups and isotope labels
+    std::string target;
+    for (int i = 0; i < 40; ++i) target += "[Fe(CN)6]2(NH4)3[13C]H3";
+    target += "(C2H4O2)12.5H2O";
+
+    std::mt19937 rng(21);
+    const std::vector<int> keys = keystrokes(target, rng);
+
+    // Both paths replay the same keystrokes into their own buffer
+    auto replay = [&](auto&& onKey) {
+        std::string text;
+        size_t next = 0;
+        for (int key : keys) {
+            if (key == +1) {
+                text += target[next++];
+            } else if (key == +2) {
+                text += 'q';
+            } else {
+                text.pop_back();
+            }
+            onKey(key, text);
+        }
+    };
+
+    std::vector<int> parsedOk;
+    std::vector<double> parsedMass;
+    FormulaParser::ElementCounts counts;
+    auto start = std::chrono::steady_clock::now();
+    replay([&](int, const std::string& text) {
+        const bool ok = FormulaParser::parse(text, counts).ok();
+        parsedOk.push_back(ok);
+        parsedMass.push_back(ok ? counts.molarMass() : 0.0);
+    });
+    double parseMs = millisecondsSince(start);
+
+    std::vector<int> validOk;
+    std::vector<double> validMass;
+    FormulaValidator validator;
+    size_t next = 0;
+    start = std::chrono::steady_clock::now();
+    for (int key : keys) {
+        if (key == +1) {
+            validator.push(target[next++]);
+        } else if (key == +2) {
+            validator.push('q');
+        } else {
+            validator.pop();
+        }
+        const bool ok = validator.status() == FormulaValidator::Status::VALID;
+        validOk.push_back(ok);
+        validMass.push_back(ok ? validator.molarMass() : 0.0);
+    }
+    double validatorMs = millisecondsSince(start);
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < keys.size(); ++i) {
+        const double tolerance = 1e-9 * std::max(1.0, parsedMass[i]);
+        mismatches += parsedOk[i] != validOk[i] || std::abs(parsedMass[i] - validMass[i]) > tolerance;
+    }
+
+    std::cout << std::fixed << std::setprecision(1) << keys.size() << " keystrokes, final formula " << target.size()
+              << " bytes, M = " << std::setprecision(3) << validator.molarMass() << " g/mol\n"
+              << std::setprecision(1) << "re-parse per keystroke:   " << parseMs * 1e6 / keys.size() << " ns/key\n"
+              << "FormulaValidator:         " << validatorMs * 1e6 / keys.size() << " ns/key\n"
+              << (mismatches == 0 ? "verdicts agree" : "MISMATCH") << "\n";
+    return mismatches == 0 ? 0 : 1;
+}
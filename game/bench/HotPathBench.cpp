@@ -0,0 +1,421 @@
+#include "ChemistryEngine.h"
+#include "DialogSystem.h"
+#include "EquationParser.h"
+#include "GameEngine.h"
+#include "TextLayout.h"
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <new>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Regression microbenchmarks for the per-frame and per-answer hot paths:
+ * formula parsing, molar masses, equation balancing, answer checking, task lookup
+ * and text wrapping. Each case is timed in samples of many iterations and reports
+ * ns/op percentiles plus heap allocations per op. --csv and --json write the
+ * results for other tools; --baseline compares with an earlier --csv run and
+ * exits non-zero on a regression.
+ */
+
+// Counts every heap allocation made by this program
+namespace {
+std::atomic<std::uint64_t> allocationCount{0};
+std::atomic<std::uint64_t> allocationBytes{0};
+
+// Both forms of new allocate with malloc here rather than new[] calling operator new,
+// so every delete below visibly frees memory from malloc (no -Wmismatched-new-delete)
+void* countedMalloc(std::size_t size) {
+    allocationCount.fetch_add(1, std::memory_order_relaxed);
+    allocationBytes.fetch_add(size, std::memory_order_relaxed);
+    if (void* memory = std::malloc(size ? size : 1)) {
+        return memory;
+    }
+    throw std::bad_alloc();
+}
+} // namespace
+
+void* operator new(std::size_t size) {
+    return countedMalloc(size);
+}
+
+void* operator new[](std::size_t size) {
+    return countedMalloc(size);
+}
+
+void operator delete(void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory) noexcept {
+    std::free(memory);
+}
+
+void operator delete(void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+void operator delete[](void* memory, std::size_t) noexcept {
+    std::free(memory);
+}
+
+namespace {
+
+struct Options {
+    size_t samples = 200;
+    double sampleMicros = 200.0; // Target duration of one sample
+    std::string filter;
+    std::string csvPath;
+    std::string jsonPath;
+    std::string baselinePath;
+    double threshold = 10.0; // Allowed p50 slowdown against the baseline, in percent
+};
+
+struct Measurement {
+    std::string name;
+    size_t iterations = 0; // Per sample
+    size_t samples = 0;
+    double meanNs = 0.0;
+    double p50Ns = 0.0;
+    double p90Ns = 0.0;
+    double p99Ns = 0.0;
+    double minNs = 0.0;
+    double allocsPerOp = 0.0;
+    double bytesPerOp = 0.0;
+};
+
+// Results are folded in here so the compiler cannot drop the measured calls
+volatile std::uint64_t sink = 0;
+
+double percentile(const std::vector<double>& sorted, double p) {
+    double rank = p * (sorted.size() - 1);
+    size_t low = static_cast<size_t>(rank);
+    size_t high = std::min(low + 1, sorted.size() - 1);
+    return sorted[low] + (sorted[high] - sorted[low]) * (rank - low);
+}
+
+template <typename Op>
+Measurement measure(const std::string& name, const Options& options, Op&& op) {
+    using Clock = std::chrono::steady_clock;
+
+    // Warm up, then grow the batch until one sample lasts about sampleMicros
+    size_t iterations = 1;
+    for (;;) {
+        auto start = Clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            sink = sink + op();
+        }
+        double micros = std::chrono::duration<double, std::micro>(Clock::now() - start).count();
+        if (micros >= options.sampleMicros || iterations >= (size_t(1) << 24)) break;
+        iterations *= 2;
+    }
+
+    std::vector<double> perOp(options.samples);
+    std::uint64_t allocationsBefore = allocationCount.load(std::memory_order_relaxed);
+    std::uint64_t bytesBefore = allocationBytes.load(std::memory_order_relaxed);
+    for (size_t s = 0; s < options.samples; ++s) {
+        auto start = Clock::now();
+        for (size_t i = 0; i < iterations; ++i) {
+            sink = sink + op();
+        }
+        perOp[s] = std::chrono::duration<double, std::nano>(Clock::now() - start).count() / iterations;
+    }
+    double ops = static_cast<double>(iterations) * options.samples;
+
+    Measurement result;
+    result.name = name;
+    result.iterations = iterations;
+    result.samples = options.samples;
+    result.allocsPerOp = (allocationCount.load(std::memory_order_relaxed) - allocationsBefore) / ops;
+    result.bytesPerOp = (allocationBytes.load(std::memory_order_relaxed) - bytesBefore) / ops;
+    for (double ns : perOp) result.meanNs += ns;
+    result.meanNs /= perOp.size();
+    std::sort(perOp.begin(), perOp.end());
+    result.minNs = perOp.front();
+    result.p50Ns = percentile(perOp, 0.50);
+    result.p90Ns = percentile(perOp, 0.90);
+    result.p99Ns = percentile(perOp, 0.99);
+    return result;
+}
+
+std::uint64_t balance(ChemistryEngine::ChemicalEquation& equation) {
+    for (auto& component : equation.reactants) component.coefficient = 1;
+    for (auto& component : equation.products) component.coefficient = 1;
+    return ChemistryEngine::balanceEquation(equation) ? equation.products.back().coefficient : 0;
+}
+
+std::uint64_t massBits(double mass) {
+    return static_cast<std::uint64_t>(mass * 1000.0);
+}
+
+// An amylose-like chain: 120 nested glucose units, about a kilobyte of formula text
+std::string longFormula() {
+    std::string formula = "HO";
+    for (int i = 0; i < 120; ++i) {
+        formula += "(C6H10O5)";
+    }
+    return formula + "H";
+}
+
+std::string csvLine(const Measurement& m) {
+    std::ostringstream out;
+    out << m.name << ',' << m.iterations << ',' << m.samples << std::fixed << std::setprecision(2) << ','
+        << m.meanNs << ',' << m.p50Ns << ',' << m.p90Ns << ',' << m.p99Ns << ',' << m.minNs << ','
+        << std::setprecision(3) << m.allocsPerOp << ',' << m.bytesPerOp;
+    return out.str();
+}
+
+const char* CSV_HEADER = "name,iterations,samples,mean_ns,p50_ns,p90_ns,p99_ns,min_ns,allocs_per_op,bytes_per_op";
+
+void writeCsv(std::ostream& out, const std::vector<Measurement>& results) {
+    out << CSV_HEADER << "\n";
+    for (const auto& m : results) {
+        out << csvLine(m) << "\n";
+    }
+}
+
+void writeJson(std::ostream& out, const std::vector<Measurement>& results) {
+    out << std::fixed << "{\"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); ++i) {
+        const auto& m = results[i];
+        out << "  {\"name\": \"" << m.name << "\", \"iterations\": " << m.iterations
+            << ", \"samples\": " << m.samples << std::setprecision(2)
+            << ", \"mean_ns\": " << m.meanNs << ", \"p50_ns\": " << m.p50Ns << ", \"p90_ns\": " << m.p90Ns
+            << ", \"p99_ns\": " << m.p99Ns << ", \"min_ns\": " << m.minNs << std::setprecision(3)
+            << ", \"allocs_per_op\": " << m.allocsPerOp << ", \"bytes_per_op\": " << m.bytesPerOp << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "]}\n";
+}
+
+// Writes to a file, or to stdout for "-"
+bool writeOutput(const std::string& path, const std::vector<Measurement>& results,
+                 void (*write)(std::ostream&, const std::vector<Measurement>&)) {
+    if (path == "-") {
+        write(std::cout, results);
+        return true;
+    }
+    std::ofstream file(path);
+    if (!file) {
+        std::cerr << "cannot write " << path << "\n";
+        return false;
+    }
+    write(file, results);
+    return true;
+}
+
+// Reads name -> measurement from an earlier --csv run
+std::map<std::string, Measurement> readBaseline(const std::string& path) {
+    std::map<std::string, Measurement> baseline;
+    std::ifstream file(path);
+    if (!file) {
+        throw std::runtime_error("cannot read baseline " + path);
+    }
+    std::string line;
+    std::getline(file, line);
+    if (line != CSV_HEADER) {
+        throw std::runtime_error("baseline " + path + " is not a hot_path_bench CSV file");
+    }
+    while (std::getline(file, line)) {
+        std::istringstream fields(line);
+        Measurement m;
+        std::string field;
+        std::vector<std::string> values;
+        while (std::getline(fields, field, ',')) values.push_back(field);
+        if (values.size() != 10) continue;
+        m.name = values[0];
+        m.meanNs = std::stod(values[3]);
+        m.p50Ns = std::stod(values[4]);
+        m.p99Ns = std::stod(values[6]);
+        m.allocsPerOp = std::stod(values[8]);
+        baseline[m.name] = m;
+    }
+    return baseline;
+}
+
+// A case regresses when its median slows down past the threshold or it allocates more
+size_t compareWithBaseline(std::ostream& out, const std::vector<Measurement>& results,
+                           const std::map<std::string, Measurement>& baseline, double threshold) {
+    size_t regressions = 0;
+    out << "\nagainst baseline (threshold " << threshold << "% on p50):\n";
+    for (const auto& m : results) {
+        auto it = baseline.find(m.name);
+        if (it == baseline.end()) {
+            out << "  " << std::left << std::setw(34) << m.name << std::right << " new\n";
+            continue;
+        }
+        double change = (m.p50Ns - it->second.p50Ns) / it->second.p50Ns * 100.0;
+        bool slower = change > threshold;
+        bool moreAllocations = m.allocsPerOp > it->second.allocsPerOp + 0.01;
+        if (slower || moreAllocations) regressions++;
+        out << "  " << std::left << std::setw(34) << m.name << std::right << std::fixed
+                  << std::setprecision(1) << std::showpos << std::setw(8) << change << "%" << std::noshowpos
+                  << std::setprecision(2) << "  allocs " << it->second.allocsPerOp << " -> " << m.allocsPerOp
+                  << (slower ? "  SLOWER" : "") << (moreAllocations ? "  MORE ALLOCATIONS" : "") << "\n";
+    }
+    return regressions;
+}
+
+// Whole decimal arguments only: std::stoul and std::stod throw on "abc" and accept "5x"
+bool readCount(const char* text, size_t& out) {
+    if (*text < '0' || *text > '9') {
+        return false;
+    }
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long value = std::strtoull(text, &end, 10);
+    if (*end != '\0' || errno == ERANGE || value > static_cast<unsigned long long>(SIZE_MAX)) {
+        return false;
+    }
+    out = static_cast<size_t>(value);
+    return true;
+}
+
+bool readNumber(const char* text, double& out) {
+    char* end = nullptr;
+    errno = 0;
+    double value = std::strtod(text, &end);
+    if (end == text || *end != '\0' || errno == ERANGE || !std::isfinite(value)) {
+        return false;
+    }
+    out = value;
+    return true;
+}
+
+void usage() {
+    std::cerr << "usage: hot_path_bench [--samples N] [--sample-us N] [--filter TEXT]\n"
+                 "                      [--csv FILE|-] [--json FILE|-] [--baseline FILE] [--threshold PCT]\n";
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        bool valid = true;
+        if (arg == "--samples" && hasValue) {
+            valid = readCount(argv[++i], options.samples);
+            options.samples = std::max<size_t>(1, options.samples);
+        } else if (arg == "--sample-us" && hasValue) {
+            valid = readNumber(argv[++i], options.sampleMicros) && options.sampleMicros > 0.0;
+        } else if (arg == "--filter" && hasValue) {
+            options.filter = argv[++i];
+        } else if (arg == "--csv" && hasValue) {
+            options.csvPath = argv[++i];
+        } else if (arg == "--json" && hasValue) {
+            options.jsonPath = argv[++i];
+        } else if (arg == "--baseline" && hasValue) {
+            options.baselinePath = argv[++i];
+        } else if (arg == "--threshold" && hasValue) {
+            valid = readNumber(argv[++i], options.threshold) && options.threshold >= 0.0;
+        } else {
+            valid = false;
+        }
+        if (!valid) {
+            usage();
+            return 2;
+        }
+    }
+
+    // Inputs
+    const std::string shortFormula = "H2O";
+    const std::string nestedFormula = "K4[Fe(CN)6]*3H2O";
+    const std::string chainFormula = longFormula();
+    const auto parsedGlucose = ChemistryEngine::parseFormula("C6H12O6");
+
+    const std::string combustionText = "C3H8 + O2 -> CO2 + H2O";
+    const std::string ferrocyanideText =
+        "K4Fe(CN)6 + KMnO4 + H2SO4 -> KHSO4 + Fe2(SO4)3 + MnSO4 + HNO3 + CO2 + H2O";
+    auto combustion = ChemistryEngine::parseEquation(combustionText);
+    auto permanganate = ChemistryEngine::parseEquation("KMnO4 + HCl -> KCl + MnCl2 + Cl2 + H2O");
+    auto ferrocyanide = ChemistryEngine::parseEquation(ferrocyanideText);
+    EquationParser::Equation splitEquation;
+    std::vector<FormulaParser::ElementCounts> splitSpecies;
+
+    DialogSystem dialogs;
+    DialogSystem::Task textTask = dialogs.getTask(1);
+    DialogSystem::Task numericTask = dialogs.getTask(1);
+    for (int level = 1; level <= dialogs.getTaskCount(); ++level) {
+        DialogSystem::Task task = dialogs.getTask(level);
+        if (task.tolerance == 0.0) textTask = task;
+    }
+    const std::string textAnswer = " " + textTask.answer + " ";
+    const std::string numericAnswer = numericTask.answer;
+
+    GameEngine engine;
+    engine.startGame();
+
+    // Longest dialog text, as drawn in the dialog panel (GameWindow: 1000 px wide, 16 pt)
+    std::string dialogText;
+    for (int level = 1; level <= dialogs.getTaskCount(); ++level) {
+        const std::string& text = dialogs.getDialog(level).text;
+        if (text.size() > dialogText.size()) dialogText = text;
+    }
+    const std::string taskText = textTask.description + "\n\n" + textTask.question;
+
+    std::vector<Measurement> results;
+    auto run = [&](const std::string& name, auto&& op) {
+        if (!options.filter.empty() && name.find(options.filter) == std::string::npos) return;
+        results.push_back(measure(name, options, op));
+    };
+
+    run("parseFormula/short", [&] { return ChemistryEngine::parseFormula(shortFormula).elements().size(); });
+    run("parseFormula/nested", [&] { return ChemistryEngine::parseFormula(nestedFormula).elements().size(); });
+    run("parseFormula/long", [&] { return ChemistryEngine::parseFormula(chainFormula).elements().size(); });
+    run("calculateMolarMass/short", [&] { return massBits(ChemistryEngine::calculateMolarMass(shortFormula)); });
+    run("calculateMolarMass/long", [&] { return massBits(ChemistryEngine::calculateMolarMass(chainFormula)); });
+    run("calculateMolarMass/parsed", [&] { return massBits(ChemistryEngine::calculateMolarMass(parsedGlucose)); });
+    run("cachedMolarMass/nested", [&] { return massBits(ChemistryEngine::cachedMolarMass(nestedFormula)); });
+    run("EquationParser/ferrocyanide", [&] {
+        return std::uint64_t(EquationParser::parse(ferrocyanideText, splitEquation, splitSpecies).ok());
+    });
+    run("parseEquation/combustion", [&] { return ChemistryEngine::parseEquation(combustionText).products.size(); });
+    run("balanceEquation/combustion", [&] { return balance(combustion); });
+    run("balanceEquation/redox", [&] { return balance(permanganate); });
+    run("balanceEquation/ferrocyanide", [&] { return balance(ferrocyanide); });
+    run("checkAnswer/text", [&] { return std::uint64_t(dialogs.checkAnswer(textTask, textAnswer)); });
+    run("checkAnswer/numeric", [&] { return std::uint64_t(dialogs.checkAnswer(numericTask, numericAnswer)); });
+    run("getCurrentTask", [&] { return engine.getCurrentTask().answer.size(); });
+    run("wrapText/dialog", [&] { return TextLayout::wrapText(dialogText, 900.0f, 16).size(); });
+    run("wrapText/task", [&] { return TextLayout::wrapText(taskText, 880.0f, 14).size(); });
+
+    // The table moves to stderr when a machine-readable format goes to stdout
+    std::ostream& table = options.csvPath == "-" || options.jsonPath == "-" ? std::cerr : std::cout;
+    table << std::left << std::setw(32) << "benchmark" << std::right << std::setw(11) << "mean ns"
+              << std::setw(11) << "p50 ns" << std::setw(11) << "p90 ns" << std::setw(11) << "p99 ns"
+              << std::setw(11) << "allocs/op" << std::setw(11) << "bytes/op" << "\n";
+    for (const auto& m : results) {
+        table << std::left << std::setw(32) << m.name << std::right << std::fixed << std::setprecision(1)
+                  << std::setw(11) << m.meanNs << std::setw(11) << m.p50Ns << std::setw(11) << m.p90Ns
+                  << std::setw(11) << m.p99Ns << std::setprecision(2) << std::setw(11) << m.allocsPerOp
+                  << std::setprecision(0) << std::setw(11) << m.bytesPerOp << "\n";
+    }
+
+    if (!options.csvPath.empty() && !writeOutput(options.csvPath, results, writeCsv)) return 2;
+    if (!options.jsonPath.empty() && !writeOutput(options.jsonPath, results, writeJson)) return 2;
+
+    if (!options.baselinePath.empty()) {
+        try {
+            size_t regressions = compareWithBaseline(table, results, readBaseline(options.baselinePath), options.threshold);
+            table << regressions << " regression(s)\n";
+            return regressions == 0 ? 0 : 1;
+        } catch (const std::exception& e) {
+            std::cerr << e.what() << "\n";
+            return 2;
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,117 @@
+#include "ChemistryEngine.h"
+#include "IsotopePattern.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @brief IsotopePattern timings from glucose to a 5,000-atom protein, at
+ * fine-structure (0.01 u) and unit (envelope) resolution, plus a parallel batch
+ * checked bit for bit against the one-at-a-time results.
+ */
+
+namespace {
+
+double millisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool samePattern(const IsotopePattern::Pattern& a, const IsotopePattern::Pattern& b) {
+    if (a.peaks.size() != b.peaks.size() || a.basePeak != b.basePeak) return false;
+    for (size_t i = 0; i < a.peaks.size(); ++i) {
+        if (std::memcmp(&a.peaks[i], &b.peaks[i], sizeof(IsotopePattern::Peak)) != 0) return false;
+    }
+    return true;
+}
+
+// Peptide-like CHNOS compositions of 100 to 1,000 atoms
+std::vector<FormulaParser::ElementCounts> peptideBatch(size_t count) {
+    std::mt19937 rng(11);
+    std::uniform_int_distribution<int> residues(8, 80);
+    std::vector<FormulaParser::ElementCounts> formulas(count);
+    for (auto& counts : formulas) {
+        int n = residues(rng);
+        counts.add(6, 5 * n);
+        counts.add(1, 8 * n + 2);
+        counts.add(7, (3 * n) / 2);
+        counts.add(8, (3 * n) / 2 + 1);
+        counts.add(16, n / 20);
+    }
+    return formulas;
+}
+
+} // namespace
+
+int main() {
+    const std::vector<std::pair<std::string, std::string>> molecules = {
+        {"glucose", "C6H12O6"},
+        {"insulin", "C257H383N65O77S6"},
+        {"5000 atoms", "C1580H2520N430O460S10"},
+    };
+
+    std::cout << std::left << std::setw(12) << "molecule" << std::right << std::setw(12) << "resolution"
+              << std::setw(8) << "peaks" << std::setw(12) << "ms/pattern" << std::setw(14) << "base m/z"
+              << std::setw(12) << "mean error" << "\n";
+    bool ok = true;
+    for (const auto& molecule : molecules) {
+        ChemistryEngine::ChemicalFormula formula = ChemistryEngine::parseFormula(molecule.second);
+        for (double resolution : {0.01, 1.0}) {
+            IsotopePattern::Options options;
+            options.resolution = resolution;
+            IsotopePattern::Pattern pattern = ChemistryEngine::isotopePattern(formula, options); // Warm-up
+
+            const int repeats = 20;
+            auto start = std::chrono::steady_clock::now();
+            for (int i = 0; i < repeats; ++i) {
+                pattern = ChemistryEngine::isotopePattern(formula, options);
+            }
+            double ms = millisSince(start) / repeats;
+
+            // The centroids must average back to the abundance-weighted mass
+            double mean = 0.0;
+            double total = 0.0;
+            for (const auto& peak : pattern.peaks) {
+                mean += peak.mass * peak.probability;
+                total += peak.probability;
+            }
+            double meanError = mean / total - pattern.averageMass;
+            ok = ok && std::abs(meanError) < 1e-3 && std::abs(total - 1.0) < 1e-3;
+
+            std::cout << std::left << std::setw(12) << molecule.first << std::right << std::fixed
+                      << std::setprecision(2) << std::setw(12) << resolution << std::setw(8) << pattern.peaks.size()
+                      << std::setprecision(3) << std::setw(12) << ms << std::setprecision(4) << std::setw(14)
+                      << pattern.peaks[pattern.basePeak].mass << std::scientific << std::setprecision(1)
+                      << std::setw(12) << meanError << std::defaultfloat << "\n";
+        }
+    }
+
+    // Batch: one thread versus the pool, same bits expected
+    std::vector<FormulaParser::ElementCounts> batch = peptideBatch(200);
+    IsotopePattern::Options options;
+    auto start = std::chrono::steady_clock::now();
+    std::vector<IsotopePattern::Pattern> serial;
+    for (const auto& counts : batch) {
+        serial.push_back(IsotopePattern::compute(counts, options));
+    }
+    double serialMs = millisSince(start);
+
+    ThreadPool pool;
+    start = std::chrono::steady_clock::now();
+    std::vector<IsotopePattern::Pattern> parallel = IsotopePattern::computeBatch(batch, options, pool);
+    double parallelMs = millisSince(start);
+
+    size_t mismatches = 0;
+    for (size_t i = 0; i < batch.size(); ++i) {
+        if (!samePattern(serial[i], parallel[i])) mismatches++;
+    }
+    std::cout << std::fixed << std::setprecision(1) << "\nbatch of " << batch.size() << " peptides: "
+              << serialMs << " ms on 1 thread, " << parallelMs << " ms on " << pool.size() << " threads, "
+              << mismatches << " mismatches\n";
+    return ok && mismatches == 0 ? 0 : 1;
+}
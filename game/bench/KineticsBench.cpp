@@ -0,0 +1,118 @@
+#include "Kinetics.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Kinetics integrator cost: the stiff Robertson problem (checked against
+ * reference values) with both methods, then a random mechanism with hundreds of
+ * species and thousands of steps streamed to an observer at fixed intervals.
+ */
+
+using namespace units::literals;
+
+namespace {
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+void report(const char* label, const Kinetics::Result& result, double ms) {
+    std::cout << std::setw(28) << std::left << label << std::right << std::setw(9) << ms << " ms  " << result.steps
+              << " steps, " << result.rejectedSteps << " rejected, " << result.functionEvaluations << " f, "
+              << result.factorizations << " LU" << (result.ok() ? "" : "  (did not finish)") << "\n";
+}
+
+} // namespace
+
+int main() {
+    bool ok = true;
+    std::cout << std::fixed << std::setprecision(3);
+
+    // Robertson: A -> B, 2B -> B + C, B + C -> A + C, with rate constants nine orders apart
+    Kinetics robertson;
+    robertson.addReaction("He -> Li", 0.04);
+    robertson.addReaction("2Li -> Li + Be", 3e7);
+    robertson.addReaction("Li + Be -> He + Be", 1e4);
+    Kinetics::Options options;
+    options.relativeTolerance = 1e-6;
+    options.absoluteTolerance = 1e-12;
+
+    std::vector<double> y{1.0, 0.0, 0.0};
+    auto start = std::chrono::steady_clock::now();
+    Kinetics::Result result = robertson.integrate(y, 0.0_s, 40.0_s, options);
+    report("Robertson ROS3, 0-40 s", result, millisecondsSince(start));
+    const double reference[] = {0.7158271, 9.185535e-6, 0.2841637};
+    for (int i = 0; i < 3; ++i) ok = ok && std::fabs(y[i] - reference[i]) <= 1e-4 * reference[i] + 1e-9;
+    std::cout << std::scientific << std::setprecision(6) << "  [A] " << y[0] << "  [B] " << y[1] << "  [C] " << y[2]
+              << std::fixed << std::setprecision(3) << (ok ? "  (matches reference)" : "  (WRONG)") << "\n";
+
+    // The explicit method is held to stability, not accuracy: compare on a short interval
+    y = {1.0, 0.0, 0.0};
+    options.method = Kinetics::Method::RK45;
+    start = std::chrono::steady_clock::now();
+    result = robertson.integrate(y, 0.0_s, 1.0_s, options);
+    report("Robertson RK45, 0-1 s", result, millisecondsSince(start));
+    y = {1.0, 0.0, 0.0};
+    options.method = Kinetics::Method::ROSENBROCK;
+    start = std::chrono::steady_clock::now();
+    result = robertson.integrate(y, 0.0_s, 1.0_s, options);
+    report("Robertson ROS3, 0-1 s", result, millisecondsSince(start));
+
+    // Random mechanism: 300 hydrocarbons, 3000 elementary steps with rate constants over six decades
+    const size_t speciesCount = 300, reactionCount = 3000;
+    std::vector<std::string> names;
+    for (int c = 1; names.size() < speciesCount; ++c) {
+        for (int h = 2; h <= 2 * c + 2 && names.size() < speciesCount; h += 2) {
+            names.push_back("C" + std::to_string(c) + "H" + std::to_string(h));
+        }
+    }
+    std::mt19937 rng(17);
+    std::uniform_int_distribution<size_t> pick(0, speciesCount - 1);
+    std::uniform_int_distribution<int> nearby(-12, 12);
+    std::uniform_real_distribution<double> decade(-2.0, 4.0);
+    // Partners are chosen among neighbouring species, the way chain growth couples C(n) to C(n+1)
+    auto partner = [&](size_t of) {
+        int index = static_cast<int>(of) + nearby(rng);
+        return static_cast<size_t>(std::clamp(index, 0, static_cast<int>(speciesCount) - 1));
+    };
+    Kinetics mechanism;
+    for (const std::string& name : names) mechanism.addSpecies(name);
+    for (size_t r = 0; r < reactionCount; ++r) {
+        size_t a = pick(rng), b = partner(a), c = partner(a);
+        while (b == a) b = partner(a);
+        while (c == a || c == b) c = partner(a);
+        double k = std::pow(10.0, decade(rng));
+        if (r % 3 == 0) {
+            mechanism.addReaction(names[a] + " -> " + names[b], k);
+        } else if (r % 3 == 1) {
+            mechanism.addReaction(names[a] + " + " + names[b] + " -> " + names[c], k);
+        } else {
+            mechanism.addReaction(names[a] + " <=> " + names[b] + " + " + names[c], k, k * 10.0);
+        }
+    }
+    std::cout << mechanism.speciesCount() << " species, " << mechanism.reactionCount() << " directional reactions, "
+              << mechanism.jacobianNonZeros() << " Jacobian non-zeros, " << mechanism.factorNonZeros()
+              << " in the LU factors\n";
+
+    std::vector<double> concentrations(speciesCount, 0.01);
+    options.outputInterval = 0.1_s;
+    size_t samples = 0;
+    double checksum = 0.0;
+    start = std::chrono::steady_clock::now();
+    result = mechanism.integrate(concentrations, 0.0_s, 10.0_s, options,
+                                 [&](units::Seconds, const double* c) {
+                                     samples++;
+                                     checksum += c[0];
+                                 });
+    report("300 species ROS3, 0-10 s", result, millisecondsSince(start));
+    std::cout << "  " << samples << " samples streamed, checksum " << checksum << "\n";
+    ok = ok && result.ok() && samples == 101;
+
+    return ok ? 0 : 1;
+}
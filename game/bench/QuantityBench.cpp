@@ -0,0 +1,117 @@
+#include "Quantity.h"
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <vector>
+
+/**
+ * @brief Typed quantities versus raw doubles on the same solution-prep kernel
+ * (mass from moles, molarity from mL, dilution volume, total volume). The
+ * outputs must match bit for bit and the timings should be the same.
+ */
+
+using namespace units::literals;
+
+namespace {
+
+struct RawColumns {
+    std::vector<double> moles, millilitres, molarMass;
+    std::vector<double> grams, molarity, dilutedMillilitres;
+};
+
+struct TypedColumns {
+    std::vector<units::Moles> moles;
+    std::vector<units::Millilitres> millilitres;
+    std::vector<units::GramsPerMole> molarMass;
+    std::vector<units::Grams> grams;
+    std::vector<units::Molarity> molarity;
+    std::vector<units::Millilitres> dilutedMillilitres;
+};
+
+// The hand-written version a careful programmer would use: mL -> L folded into * 1000
+void rawKernel(RawColumns& c) {
+    const double target = 0.1; // mol/L
+    const size_t n = c.moles.size();
+    for (size_t i = 0; i < n; ++i) {
+        c.grams[i] = c.moles[i] * c.molarMass[i];
+        c.molarity[i] = c.moles[i] / c.millilitres[i] * 1000.0;
+        c.dilutedMillilitres[i] = c.millilitres[i] + c.moles[i] / target * 1000.0;
+    }
+}
+
+void typedKernel(TypedColumns& c) {
+    const units::Molarity target = 0.1_M;
+    const size_t n = c.moles.size();
+    for (size_t i = 0; i < n; ++i) {
+        c.grams[i] = c.moles[i] * c.molarMass[i];
+        c.molarity[i] = c.moles[i] / c.millilitres[i];
+        c.dilutedMillilitres[i] = c.millilitres[i] + c.moles[i] / target;
+    }
+}
+
+template <typename Kernel, typename Columns>
+double bestNsPerElement(Kernel kernel, Columns& columns, size_t elements) {
+    double best = 1e300;
+    for (int run = 0; run < 15; ++run) {
+        auto start = std::chrono::steady_clock::now();
+        kernel(columns);
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+        best = std::min(best, ns / static_cast<double>(elements));
+    }
+    return best;
+}
+
+template <typename T>
+bool sameBits(const std::vector<double>& raw, const std::vector<T>& typed) {
+    static_assert(sizeof(T) == sizeof(double), "Quantity must be one double");
+    return std::memcmp(raw.data(), typed.data(), raw.size() * sizeof(double)) == 0;
+}
+
+} // namespace
+
+int main() {
+    const size_t elements = 1 << 20;
+    std::mt19937 rng(15);
+    std::uniform_real_distribution<double> moles(0.001, 2.0);
+    std::uniform_real_distribution<double> millilitres(5.0, 1000.0);
+    std::uniform_real_distribution<double> molarMass(2.0, 500.0);
+
+    RawColumns raw;
+    TypedColumns typed;
+    for (size_t i = 0; i < elements; ++i) {
+        double n = moles(rng), v = millilitres(rng), m = molarMass(rng);
+        raw.moles.push_back(n);
+        raw.millilitres.push_back(v);
+        raw.molarMass.push_back(m);
+        typed.moles.emplace_back(n);
+        typed.millilitres.emplace_back(v);
+        typed.molarMass.emplace_back(m);
+    }
+    raw.grams.resize(elements);
+    raw.molarity.resize(elements);
+    raw.dilutedMillilitres.resize(elements);
+    typed.grams.resize(elements);
+    typed.molarity.resize(elements);
+    typed.dilutedMillilitres.resize(elements);
+
+    // Interleave so both see the same machine state
+    double rawNs = 1e300, typedNs = 1e300;
+    for (int round = 0; round < 3; ++round) {
+        rawNs = std::min(rawNs, bestNsPerElement(rawKernel, raw, elements));
+        typedNs = std::min(typedNs, bestNsPerElement(typedKernel, typed, elements));
+    }
+
+    bool identical = sameBits(raw.grams, typed.grams) && sameBits(raw.molarity, typed.molarity) &&
+                     sameBits(raw.dilutedMillilitres, typed.dilutedMillilitres);
+
+    static_assert((1.0_L + 250.0_mL).value() == 1.25, "unit conversion folds at compile time");
+    static_assert(units::Millilitres(0.5_L).value() == 500.0, "unit conversion folds at compile time");
+
+    std::cout << std::fixed << std::setprecision(3) << "raw doubles:      " << rawNs << " ns/element\n"
+              << "units::Quantity:  " << typedNs << " ns/element\n"
+              << "outputs " << (identical ? "bit-identical" : "DIFFER") << "\n";
+    return identical ? 0 : 1;
+}
@@ -0,0 +1,113 @@
+#include "ReactionDatabase.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief ReactionDatabase load time and pathway queries over a synthetic
+ * library of 100,000 reactions between 30,000 species.
+ */
+
+namespace {
+
+double millisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+// Distinct CxHyNzOw formulas; about one in four has no nitrogen
+std::string speciesFormula(size_t index) {
+    size_t c = 1 + index % 40;
+    size_t h = 1 + (index / 40) % 60;
+    size_t n = (index / 2400) % 4;
+    size_t o = (index / 9600) % 8;
+    std::string formula = "C" + std::to_string(c) + "H" + std::to_string(h);
+    if (n != 0) formula += "N" + std::to_string(n);
+    if (o != 0) formula += "O" + std::to_string(o);
+    return formula;
+}
+
+// Reactions mostly lead from lighter-indexed to heavier-indexed species, like a synthesis tree
+std::string library(size_t species, size_t reactions) {
+    std::mt19937 rng(13);
+    std::uniform_int_distribution<int> arity(1, 3);
+    std::uniform_int_distribution<int> yieldPercent(30, 99);
+    std::ostringstream out;
+    out << "# synthetic library\n";
+    for (size_t r = 0; r < reactions; ++r) {
+        size_t product = 1 + rng() % (species - 1);
+        int reactants = arity(rng);
+        for (int i = 0; i < reactants; ++i) {
+            if (i > 0) out << " + ";
+            out << speciesFormula(rng() % product);
+        }
+        out << " -> " << speciesFormula(product);
+        if (rng() % 3 == 0) out << " + H2O";
+        out << " ; " << yieldPercent(rng) << "%\n";
+    }
+    return out.str();
+}
+
+} // namespace
+
+int main() {
+    const size_t speciesTotal = 30000;
+    const size_t reactionTotal = 100000;
+    std::string text = library(speciesTotal, reactionTotal);
+
+    ReactionDatabase database;
+    std::istringstream in(text);
+    auto start = std::chrono::steady_clock::now();
+    database.load(in);
+    double loadMs = millisSince(start);
+    std::cout << "loaded " << database.reactionCount() << " reactions, " << database.speciesCount() << " species in "
+              << std::fixed << std::setprecision(1) << loadMs << " ms\n\n";
+
+    std::vector<std::string> precursors = {"H2O"};
+    for (size_t i = 0; i < 200; ++i) {
+        precursors.push_back(speciesFormula(i));
+    }
+
+    struct Case {
+        const char* name;
+        ReactionDatabase::Objective objective;
+        ReactionDatabase::ElementSet allowed;
+    };
+    const Case cases[] = {
+        {"fewest steps", ReactionDatabase::Objective::FEWEST_STEPS, ReactionDatabase::ElementSet::all()},
+        {"best yield", ReactionDatabase::Objective::BEST_YIELD, ReactionDatabase::ElementSet::all()},
+        {"steps, C H O only", ReactionDatabase::Objective::FEWEST_STEPS, ReactionDatabase::ElementSet::fromSymbols("CHO")},
+    };
+
+    std::mt19937 rng(17);
+    std::vector<std::string> targets;
+    for (int i = 0; i < 200; ++i) {
+        targets.push_back(speciesFormula(1000 + rng() % (speciesTotal - 1000)));
+    }
+
+    std::cout << std::left << std::setw(20) << "query" << std::right << std::setw(12) << "ms/query" << std::setw(10)
+              << "found" << std::setw(12) << "avg steps" << std::setw(12) << "avg yield" << "\n";
+    for (const Case& c : cases) {
+        size_t found = 0;
+        size_t steps = 0;
+        double yield = 0.0;
+        start = std::chrono::steady_clock::now();
+        for (const std::string& target : targets) {
+            ReactionDatabase::Pathway pathway = database.findPathway(precursors, target, c.objective, c.allowed);
+            if (pathway.found) {
+                found++;
+                steps += pathway.reactions.size();
+                yield += pathway.cumulativeYield;
+            }
+        }
+        double ms = millisSince(start) / static_cast<double>(targets.size());
+        std::cout << std::left << std::setw(20) << c.name << std::right << std::setprecision(3) << std::setw(12) << ms
+                  << std::setw(10) << found << std::setprecision(1) << std::setw(12)
+                  << (found ? static_cast<double>(steps) / static_cast<double>(found) : 0.0) << std::setprecision(3)
+                  << std::setw(12) << (found ? yield / static_cast<double>(found) : 0.0) << "\n";
+    }
+    return 0;
+}
@@ -0,0 +1,115 @@
+#include "BulkBalancer.h"
+#include "EquationBalancer.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Redox and ionic balancing latency: a curriculum-sized library of
+ * skeleton equations balanced one at a time in acidic and basic media (the
+ * per-thread, allocation-free path), then in bulk on the thread pool. Known
+ * answers are checked first, including one overall equation assembled from
+ * half-reactions.
+ */
+
+namespace {
+
+using Medium = EquationBalancer::Medium;
+
+struct Known {
+    const char* equation;
+    Medium medium;
+    const char* expected; // BulkBalancer::formatOutcome
+};
+
+const Known KNOWN[] = {
+    {"MnO4^- + Fe^2+ -> Mn^2+ + Fe^3+", Medium::ACIDIC, "1 5 1 5 | 8 H^+ -> 4 H2O"},
+    {"Cr2O7^2- + Cl^- -> Cr^3+ + Cl2", Medium::ACIDIC, "1 6 2 3 | 14 H^+ -> 7 H2O"},
+    {"Cu + NO3^- -> Cu^2+ + NO", Medium::ACIDIC, "3 2 3 2 | 8 H^+ -> 4 H2O"},
+    {"MnO4^- + I^- -> MnO2 + I2", Medium::BASIC, "2 6 2 3 | 4 H2O -> 8 OH^-"},
+    {"Zn + NO3^- -> Zn(OH)4^2- + NH3", Medium::BASIC, "4 1 4 1 | 7 OH^- 6 H2O ->"},
+    {"Ag^+ + Cu -> Ag + Cu^2+", Medium::NONE, "2 1 2 1"},
+};
+
+const char* SKELETONS[] = {
+    "MnO4^- + Fe^2+ -> Mn^2+ + Fe^3+",
+    "MnO4^- + C2O4^2- -> Mn^2+ + CO2",
+    "MnO4^- + SO3^2- -> MnO2 + SO4^2-",
+    "MnO4^- + NO2^- -> Mn^2+ + NO3^-",
+    "Cr2O7^2- + Fe^2+ -> Cr^3+ + Fe^3+",
+    "Cr2O7^2- + C2H5OH -> Cr^3+ + CH3COOH",
+    "Cr(OH)3 + ClO3^- -> CrO4^2- + Cl^-",
+    "Cu + NO3^- -> Cu^2+ + NO2",
+    "Zn + NO3^- -> Zn^2+ + NH4^+",
+    "As2S3 + NO3^- -> H3AsO4 + SO4^2- + NO",
+    "I^- + IO3^- -> I2",
+    "Cl2 -> Cl^- + ClO3^-",
+    "P4 -> PH3 + H2PO2^-",
+    "Al + NO3^- -> Al(OH)4^- + NH3",
+    "Bi(OH)3 + SnO2^2- -> Bi + SnO3^2-",
+    "S2O3^2- + I2 -> S4O6^2- + I^-",
+};
+
+double microsecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main() {
+    bool ok = true;
+    BulkBalancer::Outcome outcome;
+    for (const Known& known : KNOWN) {
+        BulkBalancer::balanceOne(known.equation, outcome, known.medium);
+        std::string got = BulkBalancer::formatOutcome(outcome);
+        if (got != known.expected) {
+            std::cout << "MISMATCH " << known.equation << ": " << got << " (expected " << known.expected << ")\n";
+            ok = false;
+        }
+    }
+
+    auto oxidation = ChemistryEngine::parseEquation("Fe^2+ -> Fe^3+");
+    auto reduction = ChemistryEngine::parseEquation("Cr2O7^2- -> Cr^3+");
+    ChemistryEngine::ChemicalEquation overall;
+    EquationBalancer::Result combined =
+        EquationBalancer::combineHalfReactions(oxidation, reduction, Medium::ACIDIC, overall);
+    ok = ok && combined.ok() && overall.isBalanced();
+    std::cout << "half-reactions: " << oxidation.toString() << "  |  " << reduction.toString() << "\n"
+              << "overall:        " << overall.toString() << "\n";
+
+    // Library of 200k equations: every skeleton many times over
+    const size_t copies = 12500;
+    std::vector<std::string> library;
+    for (size_t copy = 0; copy < copies; ++copy) {
+        for (const char* skeleton : SKELETONS) library.emplace_back(skeleton);
+    }
+
+    for (Medium medium : {Medium::ACIDIC, Medium::BASIC}) {
+        size_t balanced = 0;
+        auto start = std::chrono::steady_clock::now();
+        for (const std::string& equation : library) {
+            BulkBalancer::balanceOne(equation, outcome, medium);
+            balanced += outcome.status == EquationBalancer::Status::BALANCED;
+        }
+        double oneUs = microsecondsSince(start) / library.size();
+
+        ThreadPool pool;
+        start = std::chrono::steady_clock::now();
+        std::vector<BulkBalancer::Outcome> outcomes = BulkBalancer::balanceAll(library, pool, 256, medium);
+        double bulkMs = microsecondsSince(start) / 1000.0;
+        size_t bulkBalanced = 0;
+        for (const auto& each : outcomes) bulkBalanced += each.status == EquationBalancer::Status::BALANCED;
+        ok = ok && balanced == library.size() && bulkBalanced == balanced;
+
+        std::cout << std::fixed << std::setprecision(2) << EquationBalancer::mediumName(medium) << ": "
+                  << library.size() << " equations, " << balanced << " balanced, " << oneUs
+                  << " us/equation on one thread; " << std::setprecision(1) << bulkMs << " ms on "
+                  << pool.size() << " threads\n";
+    }
+
+    std::cout << (ok ? "known answers agree" : "MISMATCH") << "\n";
+    return ok ? 0 : 1;
+}
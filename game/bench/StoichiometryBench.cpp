@@ -0,0 +1,85 @@
+#include "ChemistryEngine.h"
+#include "Stoichiometry.h"
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Batched what-if limiting-reagent scenarios through Stoichiometry::evaluateBatch
+ * versus one Stoichiometry::evaluate call per scenario.
+ */
+
+namespace {
+
+ChemistryEngine::ChemicalEquation phosphorusEquation() {
+    ChemistryEngine::ChemicalEquation equation = ChemistryEngine::parseEquation("Ca3(PO4)2 + SiO2 + C -> CaSiO3 + P4 + CO");
+    ChemistryEngine::balanceEquation(equation);
+    return equation;
+}
+
+double millisSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+bool sameBits(double a, double b) {
+    return std::memcmp(&a, &b, sizeof(double)) == 0;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    size_t count = argc > 1 ? std::stoul(argv[1]) : 1000000;
+    Stoichiometry stoichiometry(phosphorusEquation());
+
+    std::mt19937 rng(7);
+    std::uniform_real_distribution<double> amount(0.1, 20.0);
+    std::vector<std::vector<double>> columns(stoichiometry.reactantCount(), std::vector<double>(count));
+    for (size_t s = 0; s < count; ++s) {
+        for (auto& column : columns) {
+            column[s] = amount(rng);
+        }
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    std::vector<Stoichiometry::Result> single(count);
+    std::vector<double> amounts(stoichiometry.reactantCount());
+    for (size_t s = 0; s < count; ++s) {
+        for (size_t r = 0; r < amounts.size(); ++r) {
+            amounts[r] = columns[r][s];
+        }
+        single[s] = stoichiometry.evaluate(amounts);
+    }
+    double singleMs = millisSince(start);
+
+    // First call sizes the output columns; time the steady state
+    Stoichiometry::BatchResult batch;
+    stoichiometry.evaluateBatch(columns, batch);
+    start = std::chrono::steady_clock::now();
+    stoichiometry.evaluateBatch(columns, batch);
+    double batchMs = millisSince(start);
+
+    size_t mismatches = 0;
+    for (size_t s = 0; s < count; ++s) {
+        bool same = single[s].limitingReagent == batch.limitingReagent[s] &&
+                    sameBits(single[s].extent, batch.extent[s]);
+        for (size_t p = 0; p < stoichiometry.productCount(); ++p) {
+            same = same && sameBits(single[s].productMoles[p], batch.productMoles[p][s]);
+        }
+        for (size_t r = 0; r < stoichiometry.reactantCount(); ++r) {
+            same = same && sameBits(single[s].leftoverMoles[r], batch.leftoverMoles[r][s]);
+        }
+        if (!same) mismatches++;
+    }
+
+    std::cout << std::fixed << std::setprecision(2)
+              << "scenarios:       " << count << "\n"
+              << "per-scenario:    " << singleMs << " ms\n"
+              << "batch:           " << batchMs << " ms (" << singleMs / batchMs << "x, "
+              << std::setprecision(1) << batchMs * 1e6 / count << " ns/scenario)\n"
+              << "bit mismatches:  " << mismatches << "\n";
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,83 @@
+#include "SynthesisSimulator.h"
+#include "ThreadPool.h"
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+
+/**
+ * @brief Monte Carlo synthesis throughput: the level-5 impurity task as a
+ * zero-variance sanity check, then millions of trials of a three-step route on
+ * one thread and on the whole pool (the results must match bit for bit).
+ */
+
+using namespace units::literals;
+
+namespace {
+
+bool sameResult(const SynthesisSimulator::Result& a, const SynthesisSimulator::Result& b) {
+    const SynthesisSimulator::Distribution* left[] = {&a.yield, &a.purity, &a.pureMass};
+    const SynthesisSimulator::Distribution* right[] = {&b.yield, &b.purity, &b.pureMass};
+    for (int q = 0; q < 3; ++q) {
+        const double x[] = {left[q]->mean, left[q]->stdDev, left[q]->min, left[q]->max};
+        const double y[] = {right[q]->mean, right[q]->stdDev, right[q]->min, right[q]->max};
+        if (std::memcmp(x, y, sizeof(x)) != 0 || left[q]->histogram != right[q]->histogram) return false;
+    }
+    return true;
+}
+
+void print(const char* name, const SynthesisSimulator::Distribution& d) {
+    std::cout << "  " << std::setw(10) << std::left << name << std::right << " mean " << d.mean << "  sd " << d.stdDev
+              << "  p5 " << d.percentile(0.05) << "  p50 " << d.percentile(0.5) << "  p95 " << d.percentile(0.95)
+              << "\n";
+}
+
+} // namespace
+
+int main() {
+    bool ok = true;
+    std::cout << std::fixed << std::setprecision(4);
+
+    // Level 5: 100 g sample, 5% impurities, nothing random -> 95 g pure
+    SynthesisSimulator::Route level5;
+    level5.startingMass = 100.0_g;
+    level5.impurityFraction = 0.05;
+    level5.steps.push_back({"C10H15N", "C10H15N", 1, 1, 1.0, 0.0, 1.0, 0.0});
+    ThreadPool pool;
+    SynthesisSimulator::Result exact = SynthesisSimulator(level5).run(1000, 5, pool);
+    std::cout << "level 5: pure mass " << exact.pureMass.mean << " g, purity " << exact.purity.mean << "\n";
+    ok = ok && std::fabs(exact.pureMass.mean - 95.0) < 1e-9 && exact.pureMass.stdDev < 1e-9;
+
+    // Toluene -> benzoic acid -> methyl benzoate -> benzamide
+    SynthesisSimulator::Route route;
+    route.startingMass = 100.0_g;
+    route.weighingStdDev = 0.005;
+    route.impurityFraction = 0.05;
+    route.impurityStdDev = 0.01;
+    route.steps.push_back({"C7H8", "C7H6O2", 1, 1, 0.80, 0.06, 0.30, 0.05});
+    route.steps.push_back({"C7H6O2", "C8H8O2", 1, 1, 0.90, 0.03, 0.50, 0.02});
+    route.steps.push_back({"C8H8O2", "C7H7NO", 1, 1, 0.75, 0.08, 0.40, 0.10});
+    SynthesisSimulator simulator(route);
+    std::cout << "route: theoretical " << simulator.theoreticalMass().value() << " g, expected "
+              << simulator.expectedMass().value() << " g\n";
+
+    const size_t trials = 2000000;
+    ThreadPool single(1);
+    auto start = std::chrono::steady_clock::now();
+    SynthesisSimulator::Result serial = simulator.run(trials, 2024, single);
+    double serialMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+    start = std::chrono::steady_clock::now();
+    SynthesisSimulator::Result parallel = simulator.run(trials, 2024, pool);
+    double parallelMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+    bool identical = sameResult(serial, parallel);
+    ok = ok && identical;
+    print("yield", parallel.yield);
+    print("purity", parallel.purity);
+    print("pure g", parallel.pureMass);
+    std::cout << std::setprecision(1) << trials << " trials: 1 thread " << serialMs << " ms, " << pool.size()
+              << " threads " << parallelMs << " ms (" << std::setprecision(1) << parallelMs * 1e6 / trials
+              << " ns/trial), " << (identical ? "bit-identical" : "DIFFER") << "\n";
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,95 @@
+#include "ThreadPool.h"
+#include "Titration.h"
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <vector>
+
+/**
+ * @brief Titration curve throughput: textbook sanity points, one volume at a
+ * time versus blocks of lanes (results must match bit for bit), adaptive
+ * sampling around the equivalence points, and many curves on the pool.
+ */
+
+using namespace units::literals;
+
+namespace {
+
+Titration::Problem acidProblem(std::vector<double> pKa, units::Molarity concentration) {
+    Titration::Problem problem;
+    problem.analytes.push_back({std::move(pKa), 0, concentration});
+    problem.sampleVolume = 25.0_mL;
+    problem.titrant = Titration::Titrant::STRONG_BASE;
+    problem.titrantConcentration = 0.1_M;
+    return problem;
+}
+
+double millisecondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+} // namespace
+
+int main() {
+    bool ok = true;
+    std::cout << std::fixed << std::setprecision(3);
+
+    // 0.1 M acetic acid, 25 mL, 0.1 M NaOH: pH 2.88 at the start, pKa at half-equivalence
+    Titration acetic(acidProblem({4.76}, 0.1_M));
+    double start = acetic.pH(0.0_mL), half = acetic.pH(12.5_mL), equivalence = acetic.pH(25.0_mL);
+    std::cout << "acetic acid: pH " << start << " at 0 mL, " << half << " at 12.5 mL, " << equivalence
+              << " at 25 mL\n";
+    ok = ok && std::fabs(start - 2.88) < 0.01 && std::fabs(half - 4.76) < 0.01 && std::fabs(equivalence - 8.73) < 0.02;
+
+    // 0.1 M H3PO4: equivalence points at 25, 50 (and 75, not visible) mL
+    Titration phosphoric(acidProblem({2.15, 7.20, 12.35}, 0.1_M));
+    std::cout << "H3PO4 equivalence volumes:";
+    for (units::Millilitres volume : phosphoric.equivalenceVolumes()) std::cout << " " << volume.value();
+    std::cout << " mL\n";
+
+    // Scalar versus batch on a uniform grid
+    const size_t points = 1 << 16;
+    Titration::Curve grid = phosphoric.curve(100.0_mL, points);
+    std::vector<double> scalar(points);
+    double scalarMs = 1e300, batchMs = 1e300;
+    for (int run = 0; run < 5; ++run) {
+        auto begin = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < points; ++i) scalar[i] = phosphoric.pH(grid.volumes[i]);
+        scalarMs = std::min(scalarMs, millisecondsSince(begin));
+        begin = std::chrono::steady_clock::now();
+        phosphoric.pH(grid.volumes.data(), grid.pH.data(), points);
+        batchMs = std::min(batchMs, millisecondsSince(begin));
+    }
+    bool identical = std::memcmp(scalar.data(), grid.pH.data(), points * sizeof(double)) == 0;
+    ok = ok && identical;
+    std::cout << "H3PO4, " << points << " volumes: scalar " << scalarMs * 1e6 / points << " ns/point, batch "
+              << batchMs * 1e6 / points << " ns/point, " << (identical ? "bit-identical" : "DIFFER") << "\n";
+
+    // Adaptive sampling: points needed to keep every pH step under 0.05
+    Titration::Curve adaptive = phosphoric.adaptiveCurve(100.0_mL);
+    double largestStep = 0.0;
+    for (size_t i = 0; i + 1 < adaptive.pH.size(); ++i) {
+        largestStep = std::max(largestStep, std::fabs(adaptive.pH[i + 1] - adaptive.pH[i]));
+    }
+    std::cout << "H3PO4 adaptive curve: " << adaptive.volumes.size() << " points, largest pH step " << largestStep
+              << "\n";
+
+    // Many titrations on the pool
+    std::vector<Titration> titrations;
+    for (int i = 0; i < 256; ++i) {
+        double shift = 0.01 * i;
+        titrations.emplace_back(acidProblem({2.15 + shift, 7.20 + shift, 12.35}, units::Molarity(0.05 + 0.0002 * i)));
+    }
+    ThreadPool pool;
+    auto begin = std::chrono::steady_clock::now();
+    std::vector<Titration::Curve> curves = Titration::adaptiveCurves(titrations, 100.0_mL, 0.05, pool);
+    double poolMs = millisecondsSince(begin);
+    size_t total = 0;
+    for (const Titration::Curve& curve : curves) total += curve.volumes.size();
+    std::cout << titrations.size() << " adaptive curves on the pool: " << poolMs << " ms, " << total << " points\n";
+
+    return ok ? 0 : 1;
+}
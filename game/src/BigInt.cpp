@@ -0,0 +1,280 @@
+#include "BigInt.h"
+#include <algorithm>
+#include <stdexcept>
+
+BigInt::BigInt(std::int64_t value) : negative(value < 0) {
+    // Negate in unsigned arithmetic so INT64_MIN works
+    std::uint64_t magnitude = negative ? ~static_cast<std::uint64_t>(value) + 1 : static_cast<std::uint64_t>(value);
+    while (magnitude != 0) {
+        limbs.push_back(static_cast<std::uint32_t>(magnitude));
+        magnitude >>= 32;
+    }
+}
+
+void BigInt::trim() {
+    while (!limbs.empty() && limbs.back() == 0) {
+        limbs.pop_back();
+    }
+    if (limbs.empty()) {
+        negative = false;
+    }
+}
+
+BigInt BigInt::abs() const {
+    BigInt result = *this;
+    result.negative = false;
+    return result;
+}
+
+bool BigInt::fitsInt64() const {
+    if (limbs.size() <= 1) return true;
+    if (limbs.size() > 2) return false;
+    std::uint64_t magnitude = (static_cast<std::uint64_t>(limbs[1]) << 32) | limbs[0];
+    return negative ? magnitude <= (std::uint64_t(1) << 63) : magnitude < (std::uint64_t(1) << 63);
+}
+
+std::int64_t BigInt::toInt64() const {
+    std::uint64_t magnitude = 0;
+    for (size_t i = limbs.size(); i-- > 0;) {
+        magnitude = (magnitude << 32) | limbs[i];
+    }
+    return negative ? static_cast<std::int64_t>(~magnitude + 1) : static_cast<std::int64_t>(magnitude);
+}
+
+std::string BigInt::toString() const {
+    if (isZero()) return "0";
+
+    // Peel off nine decimal digits at a time
+    std::string digits;
+    Limbs rest = limbs;
+    while (!rest.empty()) {
+        std::uint64_t remainder = 0;
+        for (size_t i = rest.size(); i-- > 0;) {
+            std::uint64_t current = (remainder << 32) | rest[i];
+            rest[i] = static_cast<std::uint32_t>(current / 1000000000u);
+            remainder = current % 1000000000u;
+        }
+        while (!rest.empty() && rest.back() == 0) rest.pop_back();
+        for (int d = 0; d < 9 && (remainder != 0 || !rest.empty()); ++d) {
+            digits.push_back(static_cast<char>('0' + remainder % 10));
+            remainder /= 10;
+        }
+    }
+    if (negative) digits.push_back('-');
+    std::reverse(digits.begin(), digits.end());
+    return digits;
+}
+
+int BigInt::compareMagnitude(const Limbs& a, const Limbs& b) {
+    if (a.size() != b.size()) return a.size() < b.size() ? -1 : 1;
+    for (size_t i = a.size(); i-- > 0;) {
+        if (a[i] != b[i]) return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+BigInt::Limbs BigInt::addMagnitude(const Limbs& a, const Limbs& b) {
+    const Limbs& longer = a.size() >= b.size() ? a : b;
+    const Limbs& shorter = a.size() >= b.size() ? b : a;
+    Limbs result(longer.size() + 1);
+    std::uint64_t carry = 0;
+    for (size_t i = 0; i < longer.size(); ++i) {
+        std::uint64_t sum = carry + longer[i] + (i < shorter.size() ? shorter[i] : 0);
+        result[i] = static_cast<std::uint32_t>(sum);
+        carry = sum >> 32;
+    }
+    result[longer.size()] = static_cast<std::uint32_t>(carry);
+    return result;
+}
+
+BigInt::Limbs BigInt::subtractMagnitude(const Limbs& a, const Limbs& b) {
+    Limbs result(a.size());
+    std::int64_t borrow = 0;
+    for (size_t i = 0; i < a.size(); ++i) {
+        std::int64_t diff = static_cast<std::int64_t>(a[i]) - borrow - (i < b.size() ? b[i] : 0);
+        borrow = diff < 0 ? 1 : 0;
+        result[i] = static_cast<std::uint32_t>(diff + (borrow << 32));
+    }
+    return result;
+}
+
+BigInt::Limbs BigInt::multiplyMagnitude(const Limbs& a, const Limbs& b) {
+    if (a.empty() || b.empty()) return Limbs();
+    Limbs result(a.size() + b.size());
+    for (size_t i = 0; i < a.size(); ++i) {
+        std::uint64_t carry = 0;
+        for (size_t j = 0; j < b.size(); ++j) {
+            std::uint64_t current = static_cast<std::uint64_t>(a[i]) * b[j] + result[i + j] + carry;
+            result[i + j] = static_cast<std::uint32_t>(current);
+            carry = current >> 32;
+        }
+        result[i + b.size()] = static_cast<std::uint32_t>(carry);
+    }
+    return result;
+}
+
+// Knuth, TAOCP vol. 2, 4.3.1 Algorithm D
+void BigInt::divideMagnitude(const Limbs& a, const Limbs& b, Limbs& quotient, Limbs& remainder) {
+    if (compareMagnitude(a, b) < 0) {
+        quotient.clear();
+        remainder = a;
+        return;
+    }
+
+    if (b.size() == 1) {
+        quotient.assign(a.size(), 0);
+        std::uint64_t rest = 0;
+        for (size_t i = a.size(); i-- > 0;) {
+            std::uint64_t current = (rest << 32) | a[i];
+            quotient[i] = static_cast<std::uint32_t>(current / b[0]);
+            rest = current % b[0];
+        }
+        remainder.assign(1, static_cast<std::uint32_t>(rest));
+        return;
+    }
+
+    // Normalize so the divisor's top limb has its high bit set
+    int shift = 0;
+    for (std::uint32_t top = b.back(); (top & 0x80000000u) == 0; top <<= 1) shift++;
+
+    auto shiftLeft = [shift](const Limbs& x, size_t extra) {
+        Limbs result(x.size() + extra, 0);
+        for (size_t i = 0; i < x.size(); ++i) {
+            std::uint64_t v = static_cast<std::uint64_t>(x[i]) << shift;
+            result[i] |= static_cast<std::uint32_t>(v);
+            if (i + 1 < result.size()) result[i + 1] |= static_cast<std::uint32_t>(v >> 32);
+        }
+        return result;
+    };
+
+    Limbs v = shiftLeft(b, 0);
+    Limbs u = shiftLeft(a, 1);
+    const size_t n = v.size();
+    const size_t m = a.size() - n;
+    quotient.assign(m + 1, 0);
+
+    for (size_t j = m + 1; j-- > 0;) {
+        std::uint64_t numerator = (static_cast<std::uint64_t>(u[j + n]) << 32) | u[j + n - 1];
+        std::uint64_t qhat = numerator / v[n - 1];
+        std::uint64_t rhat = numerator % v[n - 1];
+        while (qhat > 0xFFFFFFFFu || qhat * v[n - 2] > ((rhat << 32) | u[j + n - 2])) {
+            qhat--;
+            rhat += v[n - 1];
+            if (rhat > 0xFFFFFFFFu) break;
+        }
+
+        // u[j..j+n] -= qhat * v
+        std::int64_t borrow = 0;
+        std::uint64_t carry = 0;
+        for (size_t i = 0; i < n; ++i) {
+            std::uint64_t product = qhat * v[i] + carry;
+            carry = product >> 32;
+            std::int64_t diff = static_cast<std::int64_t>(u[i + j]) - borrow - static_cast<std::uint32_t>(product);
+            borrow = diff < 0 ? 1 : 0;
+            u[i + j] = static_cast<std::uint32_t>(diff + (borrow << 32));
+        }
+        std::int64_t diff = static_cast<std::int64_t>(u[j + n]) - borrow - static_cast<std::int64_t>(carry);
+        u[j + n] = static_cast<std::uint32_t>(diff);
+
+        if (diff < 0) {
+            // qhat was one too large: add v back
+            qhat--;
+            std::uint64_t addCarry = 0;
+            for (size_t i = 0; i < n; ++i) {
+                std::uint64_t sum = static_cast<std::uint64_t>(u[i + j]) + v[i] + addCarry;
+                u[i + j] = static_cast<std::uint32_t>(sum);
+                addCarry = sum >> 32;
+            }
+            u[j + n] = static_cast<std::uint32_t>(u[j + n] + addCarry);
+        }
+        quotient[j] = static_cast<std::uint32_t>(qhat);
+    }
+
+    // Unnormalize the remainder
+    remainder.assign(n, 0);
+    for (size_t i = 0; i < n; ++i) {
+        std::uint64_t v64 = (static_cast<std::uint64_t>(u[i + 1]) << 32) | u[i];
+        remainder[i] = static_cast<std::uint32_t>(v64 >> shift);
+    }
+}
+
+BigInt BigInt::operator-() const {
+    BigInt result = *this;
+    if (!result.isZero()) result.negative = !result.negative;
+    return result;
+}
+
+BigInt operator+(const BigInt& a, const BigInt& b) {
+    BigInt result;
+    if (a.negative == b.negative) {
+        result.limbs = BigInt::addMagnitude(a.limbs, b.limbs);
+        result.negative = a.negative;
+    } else if (BigInt::compareMagnitude(a.limbs, b.limbs) >= 0) {
+        result.limbs = BigInt::subtractMagnitude(a.limbs, b.limbs);
+        result.negative = a.negative;
+    } else {
+        result.limbs = BigInt::subtractMagnitude(b.limbs, a.limbs);
+        result.negative = b.negative;
+    }
+    result.trim();
+    return result;
+}
+
+BigInt operator-(const BigInt& a, const BigInt& b) {
+    return a + (-b);
+}
+
+BigInt operator*(const BigInt& a, const BigInt& b) {
+    BigInt result;
+    result.limbs = BigInt::multiplyMagnitude(a.limbs, b.limbs);
+    result.negative = a.negative != b.negative;
+    result.trim();
+    return result;
+}
+
+void BigInt::divMod(const BigInt& a, const BigInt& b, BigInt& quotient, BigInt& remainder) {
+    if (b.isZero()) {
+        throw std::domain_error("BigInt division by zero");
+    }
+    Limbs q, r;
+    divideMagnitude(a.limbs, b.limbs, q, r);
+    quotient.limbs = std::move(q);
+    quotient.negative = a.negative != b.negative;
+    quotient.trim();
+    remainder.limbs = std::move(r);
+    remainder.negative = a.negative;
+    remainder.trim();
+}
+
+BigInt operator/(const BigInt& a, const BigInt& b) {
+    BigInt quotient, remainder;
+    BigInt::divMod(a, b, quotient, remainder);
+    return quotient;
+}
+
+BigInt operator%(const BigInt& a, const BigInt& b) {
+    BigInt quotient, remainder;
+    BigInt::divMod(a, b, quotient, remainder);
+    return remainder;
+}
+
+bool operator==(const BigInt& a, const BigInt& b) {
+    return a.negative == b.negative && a.limbs == b.limbs;
+}
+
+bool operator<(const BigInt& a, const BigInt& b) {
+    if (a.negative != b.negative) return a.negative;
+    int cmp = BigInt::compareMagnitude(a.limbs, b.limbs);
+    return a.negative ? cmp > 0 : cmp < 0;
+}
+
+BigInt BigInt::gcd(BigInt a, BigInt b) {
+    a = a.abs();
+    b = b.abs();
+    while (!b.isZero()) {
+        BigInt r = a % b;
+        a = std::move(b);
+        b = std::move(r);
+    }
+    return a;
+}
@@ -0,0 +1,59 @@
+#ifndef BIGINT_H
+#define BIGINT_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief BigInt - Arbitrary-precision signed integer
+ * Sign-magnitude with 32-bit limbs (least significant first). Only what the exact
+ * solvers need: +, -, *, truncating / and %, gcd and int64 conversion.
+ */
+class BigInt {
+public:
+    BigInt() : negative(false) {}
+    BigInt(std::int64_t value);
+
+    bool isZero() const { return limbs.empty(); }
+    int sign() const { return isZero() ? 0 : (negative ? -1 : 1); }
+    BigInt abs() const;
+
+    bool fitsInt64() const;
+    std::int64_t toInt64() const; // Only valid when fitsInt64()
+    std::string toString() const;
+
+    BigInt operator-() const;
+    friend BigInt operator+(const BigInt& a, const BigInt& b);
+    friend BigInt operator-(const BigInt& a, const BigInt& b);
+    friend BigInt operator*(const BigInt& a, const BigInt& b);
+    friend BigInt operator/(const BigInt& a, const BigInt& b); // Truncates toward zero
+    friend BigInt operator%(const BigInt& a, const BigInt& b); // Sign follows the dividend
+
+    friend bool operator==(const BigInt& a, const BigInt& b);
+    friend bool operator!=(const BigInt& a, const BigInt& b) { return !(a == b); }
+    friend bool operator<(const BigInt& a, const BigInt& b);
+    friend bool operator>(const BigInt& a, const BigInt& b) { return b < a; }
+    friend bool operator<=(const BigInt& a, const BigInt& b) { return !(b < a); }
+    friend bool operator>=(const BigInt& a, const BigInt& b) { return !(a < b); }
+
+    // Quotient and remainder in one pass (truncating division); throws std::domain_error on division by zero
+    static void divMod(const BigInt& a, const BigInt& b, BigInt& quotient, BigInt& remainder);
+    static BigInt gcd(BigInt a, BigInt b);
+
+private:
+    using Limbs = std::vector<std::uint32_t>;
+
+    Limbs limbs;
+    bool negative;
+
+    void trim();
+
+    static int compareMagnitude(const Limbs& a, const Limbs& b);
+    static Limbs addMagnitude(const Limbs& a, const Limbs& b);
+    static Limbs subtractMagnitude(const Limbs& a, const Limbs& b); // Requires |a| >= |b|
+    static Limbs multiplyMagnitude(const Limbs& a, const Limbs& b);
+    static void divideMagnitude(const Limbs& a, const Limbs& b, Limbs& quotient, Limbs& remainder);
+};
+
+#endif // BIGINT_H
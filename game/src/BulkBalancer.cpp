@@ -0,0 +1,162 @@
+#include "BulkBalancer.h"
+#include "CheckedMath.h"
+#include "EquationParser.h"
+#include "FormulaParser.h"
+#include <sstream>
+#include <utility>
+
+namespace {
+
+// Per-thread parse buffers, grown to the largest equation seen and then reused
+struct Scratch {
+    EquationParser::Equation equation;
+    std::vector<FormulaParser::ElementCounts> species;
+    std::vector<const FormulaParser::ElementCounts*> pointers;
+    FormulaParser::ElementCounts net;
+};
+
+Scratch& threadScratch() {
+    thread_local Scratch scratch;
+    return scratch;
+}
+
+std::string_view trim(std::string_view text) {
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string_view::npos) return std::string_view();
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(begin, end - begin + 1);
+}
+
+} // namespace
+
+std::vector<std::string> BulkBalancer::readEquations(std::istream& in) {
+    std::vector<std::string> equations;
+    std::string line;
+    while (std::getline(in, line)) {
+        std::string_view text = trim(line);
+        if (text.empty() || text[0] == '#') continue;
+        equations.emplace_back(text);
+    }
+    return equations;
+}
+
+void BulkBalancer::balanceOne(std::string_view equation, Outcome& outcome, EquationBalancer::Medium medium) {
+    Scratch& scratch = threadScratch();
+    outcome.parsed = false;
+    outcome.inputBalanced = false;
+    outcome.status = EquationBalancer::Status::INVALID_INPUT;
+    outcome.coefficients.clear();
+    outcome.added = EquationBalancer::Added();
+    outcome.medium = medium;
+    outcome.error.clear();
+
+    EquationParser::Result parsed = EquationParser::parse(equation, scratch.equation, scratch.species);
+    if (!parsed.ok()) {
+        outcome.error = std::string(parsed.error == EquationParser::Error::BAD_FORMULA
+                                        ? FormulaParser::errorMessage(parsed.formulaError)
+                                        : EquationParser::errorMessage(parsed.error)) +
+                        " at position " + std::to_string(parsed.position);
+        return;
+    }
+    outcome.parsed = true;
+
+    const size_t reactants = scratch.equation.reactantCount;
+    const size_t total = scratch.equation.terms.size();
+    scratch.pointers.clear();
+    for (size_t i = 0; i < total; ++i) {
+        scratch.pointers.push_back(&scratch.species[i]);
+    }
+
+    // Do the coefficients as written already balance? Sums past the int64 range count as not balanced
+    scratch.net.clear();
+    bool fits = true;
+    for (size_t i = 0; i < total && fits; ++i) {
+        const std::int64_t written = scratch.equation.terms[i].coefficient;
+        std::int64_t coefficient = i < reactants ? written : -written;
+        scratch.species[i].forEach([&scratch, &fits, coefficient](int z, std::int64_t n) {
+            std::int64_t atoms = 0, sum = 0;
+            if (fits && checkedMul(n, coefficient, atoms) && checkedAdd(scratch.net[z], atoms, sum)) {
+                scratch.net.add(z, atoms);
+            } else {
+                fits = false;
+            }
+        });
+        std::int64_t charge = 0;
+        fits = fits && checkedMul(scratch.species[i].charge, coefficient, charge) &&
+               checkedAdd(scratch.net.charge, charge, scratch.net.charge);
+    }
+    bool balanced = fits && scratch.net.charge == 0;
+    scratch.net.forEach([&balanced](int, std::int64_t n) { balanced = balanced && n == 0; });
+    outcome.inputBalanced = balanced;
+
+    EquationBalancer::Result result;
+    result.coefficients.swap(outcome.coefficients);
+    EquationBalancer::balanceRedox(scratch.pointers.data(), total, reactants, medium, false, result);
+    outcome.status = result.status;
+    outcome.coefficients.swap(result.coefficients);
+    outcome.added = result.added;
+}
+
+std::vector<BulkBalancer::Outcome> BulkBalancer::balanceAll(const std::vector<std::string>& equations,
+                                                            ThreadPool& pool, size_t grain,
+                                                            EquationBalancer::Medium medium) {
+    std::vector<Outcome> outcomes(equations.size());
+    pool.parallelFor(equations.size(), grain, [&equations, &outcomes, medium](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            balanceOne(equations[i], outcomes[i], medium);
+        }
+    });
+    return outcomes;
+}
+
+std::uint64_t BulkBalancer::digest(const std::vector<Outcome>& outcomes) {
+    // FNV-1a over status, flags and coefficients
+    std::uint64_t hash = 1469598103934665603ull;
+    auto mix = [&hash](std::uint64_t value) {
+        for (int byte = 0; byte < 8; ++byte) {
+            hash ^= (value >> (byte * 8)) & 0xFF;
+            hash *= 1099511628211ull;
+        }
+    };
+    for (const auto& outcome : outcomes) {
+        mix(static_cast<std::uint64_t>(outcome.status));
+        mix((outcome.parsed ? 1u : 0u) | (outcome.inputBalanced ? 2u : 0u));
+        mix(outcome.coefficients.size());
+        for (std::int64_t coefficient : outcome.coefficients) {
+            mix(static_cast<std::uint64_t>(coefficient));
+        }
+        if (outcome.added.any()) {
+            mix(static_cast<std::uint64_t>(outcome.added.water));
+            mix(static_cast<std::uint64_t>(outcome.added.ion));
+        }
+    }
+    return hash;
+}
+
+std::string BulkBalancer::formatOutcome(const Outcome& outcome) {
+    if (!outcome.parsed) {
+        return "parse error: " + outcome.error;
+    }
+    if (outcome.status != EquationBalancer::Status::BALANCED) {
+        return EquationBalancer::statusMessage(outcome.status);
+    }
+    std::ostringstream ss;
+    for (size_t i = 0; i < outcome.coefficients.size(); ++i) {
+        if (i > 0) ss << ' ';
+        ss << outcome.coefficients[i];
+    }
+    if (outcome.added.any()) {
+        // Added reactants, an arrow, then added products
+        const std::pair<std::int64_t, const char*> added[] = {
+            {outcome.added.ion, outcome.medium == EquationBalancer::Medium::BASIC ? "OH^-" : "H^+"},
+            {outcome.added.water, "H2O"}};
+        ss << " |";
+        for (int side = 1; side >= -1; side -= 2) {
+            if (side < 0) ss << " ->";
+            for (const auto& species : added) {
+                if (species.first * side > 0) ss << ' ' << species.first * side << ' ' << species.second;
+            }
+        }
+    }
+    return ss.str();
+}
@@ -0,0 +1,52 @@
+#ifndef BULKBALANCER_H
+#define BULKBALANCER_H
+
+#include "EquationBalancer.h"
+#include "ThreadPool.h"
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief BulkBalancer - Checks and balances large equation lists in parallel
+ * Equations are sharded across a work-stealing ThreadPool. Each worker parses
+ * and solves in per-thread scratch buffers, and every result is written to
+ * the slot of its input line, so the output does not depend on thread count.
+ * Ionic equations conserve charge too. Given a medium, redox equations are
+ * balanced with H2O and H^+ or OH^- added (see EquationBalancer::balanceRedox).
+ */
+class BulkBalancer {
+public:
+    struct Outcome {
+        EquationBalancer::Status status = EquationBalancer::Status::INVALID_INPUT;
+        bool parsed = false;         // false: the text is not a well-formed equation (see error)
+        bool inputBalanced = false;  // Coefficients as written already conserve every element and the charge
+        std::vector<std::int64_t> coefficients; // Reactants then products, when balanced
+        EquationBalancer::Added added;          // Solvent species added in an acidic or basic medium
+        EquationBalancer::Medium medium = EquationBalancer::Medium::NONE;
+        std::string error;
+    };
+
+    // One equation per line; blank lines and lines starting with '#' are skipped
+    static std::vector<std::string> readEquations(std::istream& in);
+
+    // Text like "C3H8 + O2 -> CO2 + H2O" (see EquationParser); leading numbers are coefficients
+    static void balanceOne(std::string_view equation, Outcome& outcome,
+                           EquationBalancer::Medium medium = EquationBalancer::Medium::NONE);
+
+    // Balances every equation; outcomes[i] belongs to equations[i]
+    static std::vector<Outcome> balanceAll(const std::vector<std::string>& equations,
+                                           ThreadPool& pool, size_t grain = 256,
+                                           EquationBalancer::Medium medium = EquationBalancer::Medium::NONE);
+
+    // Order-sensitive hash of all outcomes, for comparing runs
+    static std::uint64_t digest(const std::vector<Outcome>& outcomes);
+
+    // "1 5 3 4" for balanced outcomes, then any added species ("2 16 10 2 8 | 16 H^+ -> 8 H2O"),
+    // otherwise the status or parse error
+    static std::string formatOutcome(const Outcome& outcome);
+};
+
+#endif // BULKBALANCER_H
@@ -0,0 +1,221 @@
+#include "CanonicalFormula.h"
+#include "IsotopeTable.h"
+#include "PeriodicTable.h"
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+// Section markers of the byte key; element bytes are atomic numbers 1..118
+constexpr unsigned char LABELS_MARKER = 0xFE;
+constexpr unsigned char CHARGE_MARKER = 0xFF;
+
+using Label = FormulaParser::IsotopeCount;
+
+// Labels with a non-zero count, by isotope table index (which is by element, then mass number)
+int sortedLabels(const FormulaParser::ElementCounts& counts, Label* labels) {
+    int size = 0;
+    for (int i = 0; i < counts.isotopeCount; ++i) {
+        if (counts.isotopes[i].count != 0) labels[size++] = counts.isotopes[i];
+    }
+    std::sort(labels, labels + size, [](const Label& a, const Label& b) { return a.isotope < b.isotope; });
+    return size;
+}
+
+std::uint64_t zigzag(std::int64_t value) {
+    return (static_cast<std::uint64_t>(value) << 1) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+void appendVarint(std::string& out, std::uint64_t value) {
+    while (value >= 0x80) {
+        out += static_cast<char>((value & 0x7F) | 0x80);
+        value >>= 7;
+    }
+    out += static_cast<char>(value);
+}
+
+// One absorption step: xor, multiply, fold the high half down (all arithmetic is fixed width)
+std::uint64_t absorb(std::uint64_t state, std::uint64_t word) {
+    state = (state ^ word) * 0x9E3779B97F4A7C15ull;
+    return state ^ (state >> 32);
+}
+
+std::uint64_t finish(std::uint64_t state) {
+    state ^= state >> 30;
+    state *= 0xBF58476D1CE4E5B9ull;
+    state ^= state >> 27;
+    state *= 0x94D049BB133111EBull;
+    return state ^ (state >> 31);
+}
+
+std::uint64_t readVarint(std::string_view key, size_t& position) {
+    std::uint64_t value = 0;
+    for (int shift = 0; position < key.size(); shift += 7) {
+        const unsigned char byte = static_cast<unsigned char>(key[position++]);
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) break;
+    }
+    return value;
+}
+
+std::int64_t unzigzag(std::uint64_t value) {
+    return static_cast<std::int64_t>(value >> 1) ^ -static_cast<std::int64_t>(value & 1);
+}
+
+void appendCount(std::string& out, std::int64_t n) {
+    if (n != 1) out += std::to_string(n);
+}
+
+} // namespace
+
+std::string CanonicalFormula::hill(const FormulaParser::ElementCounts& counts) {
+    std::string out;
+    hill(counts, out);
+    return out;
+}
+
+void CanonicalFormula::hill(const FormulaParser::ElementCounts& counts, std::string& out) {
+    out.clear();
+    int elements[PeriodicTable::ELEMENT_COUNT];
+    int size = 0;
+    const bool hasCarbon = counts[6] != 0;
+    counts.forEach([&](int z, std::int64_t n) {
+        if (n != 0 && !(hasCarbon && (z == 6 || z == 1))) elements[size++] = z;
+    });
+    std::sort(elements, elements + size, [](int a, int b) {
+        return std::strcmp(PeriodicTable::symbol(a), PeriodicTable::symbol(b)) < 0;
+    });
+
+    Label labels[FormulaParser::MAX_ISOTOPES];
+    const int labelCount = sortedLabels(counts, labels);
+
+    // Unlabelled atoms under the element symbol, then each labelled nuclide as [A X]
+    auto append = [&](int z) {
+        std::int64_t plain = counts[z];
+        for (int i = 0; i < labelCount; ++i) {
+            if (IsotopeTable::ISOTOPES[labels[i].isotope].atomicNumber == z) plain -= labels[i].count;
+        }
+        if (plain != 0) {
+            out += PeriodicTable::symbol(z);
+            appendCount(out, plain);
+        }
+        for (int i = 0; i < labelCount; ++i) {
+            const IsotopeTable::Isotope& nuclide = IsotopeTable::ISOTOPES[labels[i].isotope];
+            if (nuclide.atomicNumber != z) continue;
+            out += '[';
+            out += std::to_string(nuclide.massNumber);
+            out += PeriodicTable::symbol(z);
+            out += ']';
+            appendCount(out, labels[i].count);
+        }
+    };
+    if (hasCarbon) {
+        append(6);
+        if (counts[1] != 0) append(1);
+    }
+    for (int i = 0; i < size; ++i) {
+        append(elements[i]);
+    }
+
+    if (counts.charge != 0) {
+        out += '^';
+        const std::uint64_t magnitude =
+            counts.charge < 0 ? 0 - static_cast<std::uint64_t>(counts.charge) : static_cast<std::uint64_t>(counts.charge);
+        if (magnitude != 1) out += std::to_string(magnitude);
+        out += counts.charge < 0 ? '-' : '+';
+    }
+}
+
+std::uint64_t CanonicalFormula::hash(const FormulaParser::ElementCounts& counts) {
+    std::uint64_t state = 0x243F6A8885A308D3ull;
+    counts.forEach([&state](int z, std::int64_t n) {
+        if (n != 0) {
+            state = absorb(state, static_cast<std::uint64_t>(z));
+            state = absorb(state, static_cast<std::uint64_t>(n));
+        }
+    });
+    if (counts.isotopeCount != 0) {
+        Label labels[FormulaParser::MAX_ISOTOPES];
+        const int labelCount = sortedLabels(counts, labels);
+        for (int i = 0; i < labelCount; ++i) {
+            state = absorb(state, 0x100 + static_cast<std::uint64_t>(labels[i].isotope));
+            state = absorb(state, static_cast<std::uint64_t>(labels[i].count));
+        }
+    }
+    if (counts.charge != 0) {
+        state = absorb(state, 0x200);
+        state = absorb(state, static_cast<std::uint64_t>(counts.charge));
+    }
+    return finish(state);
+}
+
+bool CanonicalFormula::equal(const FormulaParser::ElementCounts& a, const FormulaParser::ElementCounts& b) {
+    if (a.charge != b.charge) {
+        return false;
+    }
+    // Union of the touched slots; an untouched slot counts as zero
+    for (int word = 0; word < 2; ++word) {
+        std::uint64_t bits = a.present[word] | b.present[word];
+        while (bits != 0) {
+            const int z = word * 64 + FormulaParser::lowestBit(bits);
+            bits &= bits - 1;
+            if (a.counts[z] != b.counts[z]) return false;
+        }
+    }
+    if (a.isotopeCount == 0 && b.isotopeCount == 0) {
+        return true;
+    }
+    Label left[FormulaParser::MAX_ISOTOPES], right[FormulaParser::MAX_ISOTOPES];
+    const int leftCount = sortedLabels(a, left), rightCount = sortedLabels(b, right);
+    if (leftCount != rightCount) return false;
+    for (int i = 0; i < leftCount; ++i) {
+        if (left[i].isotope != right[i].isotope || left[i].count != right[i].count) return false;
+    }
+    return true;
+}
+
+void CanonicalFormula::encode(const FormulaParser::ElementCounts& counts, std::string& out) {
+    counts.forEach([&out](int z, std::int64_t n) {
+        if (n != 0) {
+            out += static_cast<char>(z);
+            appendVarint(out, zigzag(n));
+        }
+    });
+    if (counts.isotopeCount != 0) {
+        Label labels[FormulaParser::MAX_ISOTOPES];
+        const int labelCount = sortedLabels(counts, labels);
+        if (labelCount != 0) {
+            out += static_cast<char>(LABELS_MARKER);
+            appendVarint(out, static_cast<std::uint64_t>(labelCount));
+        }
+        for (int i = 0; i < labelCount; ++i) {
+            appendVarint(out, static_cast<std::uint64_t>(labels[i].isotope));
+            appendVarint(out, zigzag(labels[i].count));
+        }
+    }
+    if (counts.charge != 0) {
+        out += static_cast<char>(CHARGE_MARKER);
+        appendVarint(out, zigzag(counts.charge));
+    }
+}
+
+void CanonicalFormula::decode(std::string_view key, FormulaParser::ElementCounts& out) {
+    out.clear();
+    size_t position = 0;
+    while (position < key.size()) {
+        const unsigned char tag = static_cast<unsigned char>(key[position++]);
+        if (tag == LABELS_MARKER) {
+            // Label atoms are already part of the element counts
+            const std::uint64_t labelCount = readVarint(key, position);
+            for (std::uint64_t i = 0; i < labelCount && out.isotopeCount < FormulaParser::MAX_ISOTOPES; ++i) {
+                const auto isotope = static_cast<std::int16_t>(readVarint(key, position));
+                const std::int64_t count = unzigzag(readVarint(key, position));
+                out.isotopes[out.isotopeCount++] = FormulaParser::IsotopeCount{isotope, count};
+            }
+        } else if (tag == CHARGE_MARKER) {
+            out.charge = unzigzag(readVarint(key, position));
+        } else {
+            out.add(tag, unzigzag(readVarint(key, position)));
+        }
+    }
+}
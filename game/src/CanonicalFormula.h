@@ -0,0 +1,41 @@
+#ifndef CANONICALFORMULA_H
+#define CANONICALFORMULA_H
+
+#include "FormulaParser.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+
+/**
+ * @brief CanonicalFormula - Order-independent identity of a parsed formula
+ * Two formulas are the same compound formula when they have the same element
+ * counts, the same isotope labels and the same charge, however they were
+ * written: "CH4", "H4C" and "C(H2)2" are one formula. Elements with a zero
+ * count are ignored.
+ *
+ * - hill() writes the Hill-order text: C, then H, then the other elements
+ *   alphabetically. Without carbon, every element is alphabetical. Isotope
+ *   labels follow their element, then the charge comes last:
+ *   "C2H6O", "[13C]H4", "SO4^2-". The text parses back to the same counts.
+ * - hash() is a 64-bit structural hash built from fixed arithmetic only. It is
+ *   the same on every run, build and platform, so it may be stored.
+ * - encode() writes the compact byte key that FormulaSet stores. Equal
+ *   formulas, and only equal formulas, get equal bytes.
+ */
+class CanonicalFormula {
+public:
+    static std::string hill(const FormulaParser::ElementCounts& counts);
+    static void hill(const FormulaParser::ElementCounts& counts, std::string& out); // Reuses out's storage
+
+    static std::uint64_t hash(const FormulaParser::ElementCounts& counts);
+
+    // Same elements, labels and charge (hash() first when comparing many)
+    static bool equal(const FormulaParser::ElementCounts& a, const FormulaParser::ElementCounts& b);
+
+    // Appends the canonical byte key: element/count pairs, then sorted labels, then the charge (varints)
+    static void encode(const FormulaParser::ElementCounts& counts, std::string& out);
+    // Rebuilds counts from a key written by encode() (out is cleared first)
+    static void decode(std::string_view key, FormulaParser::ElementCounts& out);
+};
+
+#endif // CANONICALFORMULA_H
@@ -0,0 +1,50 @@
+#ifndef CHECKEDMATH_H
+#define CHECKEDMATH_H
+
+#include <cstdint>
+#include <limits>
+
+// Checked int64 arithmetic shared by the parsers and the bulk balancer:
+// each returns false (out untouched) on overflow
+
+inline bool checkedAdd(std::int64_t a, std::int64_t b, std::int64_t& out) {
+#if defined(_MSC_VER)
+    constexpr std::int64_t high = std::numeric_limits<std::int64_t>::max();
+    constexpr std::int64_t low = std::numeric_limits<std::int64_t>::min();
+    if ((b > 0 && a > high - b) || (b < 0 && a < low - b)) {
+        return false;
+    }
+    out = a + b;
+    return true;
+#else
+    std::int64_t sum;
+    if (__builtin_add_overflow(a, b, &sum)) {
+        return false; // The builtin stores the wrapped sum, so it must not reach out
+    }
+    out = sum;
+    return true;
+#endif
+}
+
+inline bool checkedMul(std::int64_t a, std::int64_t b, std::int64_t& out) {
+#if defined(_MSC_VER)
+    constexpr std::int64_t high = std::numeric_limits<std::int64_t>::max();
+    constexpr std::int64_t low = std::numeric_limits<std::int64_t>::min();
+    bool overflow = a > 0 ? (b > 0 ? a > high / b : b < low / a)
+                          : (b > 0 ? a < low / b : a != 0 && b < high / a);
+    if (overflow) {
+        return false;
+    }
+    out = a * b;
+    return true;
+#else
+    std::int64_t product;
+    if (__builtin_mul_overflow(a, b, &product)) {
+        return false;
+    }
+    out = product;
+    return true;
+#endif
+}
+
+#endif // CHECKEDMATH_H
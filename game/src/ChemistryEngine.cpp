@@ -1,24 +1,30 @@
 #include "ChemistryEngine.h"
+#include "CanonicalFormula.h"
+#include "PeriodicTable.h"
+#include "FormulaCache.h"
+#include "FormulaMatrix.h"
+#include "EquationBalancer.h"
 #include <regex>
 #include <sstream>
 #include <algorithm>
 #include <cctype>
+#include <stdexcept>
+#include <limits>
 
-// Atomic masses database (common elements)
-const std::map<std::string, double> ChemistryEngine::ATOMIC_MASSES = {
-    {"H", 1.008},   {"He", 4.003},  {"Li", 6.941},  {"Be", 9.012},
-    {"B", 10.81},   {"C", 12.01},   {"N", 14.01},   {"O", 16.00},
-    {"F", 19.00},   {"Ne", 20.18},  {"Na", 22.99},  {"Mg", 24.31},
-    {"Al", 27.98},  {"Si", 28.09},  {"P", 30.97},   {"S", 32.07},
-    {"Cl", 35.45},  {"Ar", 39.95},  {"K", 39.10},   {"Ca", 40.08},
-    {"Fe", 55.85},  {"Cu", 63.55},  {"Zn", 65.38},  {"Br", 79.90},
-    {"I", 126.90},  {"Pb", 207.2}
-};
+// Atomic masses come from the compile-time periodic table
+double ChemistryEngine::getAtomicMass(const std::string& symbol) {
+    int z = PeriodicTable::atomicNumber(symbol);
+    if (z == 0) {
+        throw std::invalid_argument("Unknown element symbol: " + symbol);
+    }
+    return PeriodicTable::atomicMass(z);
+}
 
 // ChemicalFormula implementation
-ChemistryEngine::ChemicalFormula::ChemicalFormula(const std::string& formula)
-    : originalFormula(formula) {
-    elements = ChemistryEngine::parseFormula(formula).elements;
+ChemistryEngine::ChemicalFormula::ChemicalFormula() : structuralHash(CanonicalFormula::hash(elementCounts)) {}
+
+ChemistryEngine::ChemicalFormula::ChemicalFormula(const std::string& formula) {
+    *this = ChemistryEngine::parseFormula(formula);
 }
 
 double ChemistryEngine::ChemicalFormula::calculateMolarMass() const {
@@ -29,124 +35,263 @@ std::string ChemistryEngine::ChemicalFormula::toString() const {
     return originalFormula;
 }
 
-// Parse chemical formula (handles basic formulas like H2O, CH4, C10H15N)
-ChemistryEngine::ChemicalFormula ChemistryEngine::parseFormula(const std::string& formula) {
+std::string ChemistryEngine::ChemicalFormula::hillFormula() const {
+    return CanonicalFormula::hill(elementCounts);
+}
+
+bool ChemistryEngine::ChemicalFormula::operator==(const ChemicalFormula& other) const {
+    return structuralHash == other.structuralHash && CanonicalFormula::equal(elementCounts, other.elementCounts);
+}
+
+void ChemistryEngine::ChemicalFormula::setCount(const std::string& symbol, int count) {
+    int z = PeriodicTable::atomicNumber(symbol);
+    if (z == 0) {
+        throw std::invalid_argument("Unknown element symbol: " + symbol);
+    }
+    if (count < 0) {
+        throw std::invalid_argument("Negative count of " + symbol);
+    }
+    
+    // Labelled atoms are part of counts[z], so the element's labels cannot survive a new count
+    int kept = 0;
+    for (int i = 0; i < elementCounts.isotopeCount; ++i) {
+        if (IsotopeTable::ISOTOPES[elementCounts.isotopes[i].isotope].atomicNumber != z) {
+            elementCounts.isotopes[kept++] = elementCounts.isotopes[i];
+        }
+    }
+    elementCounts.isotopeCount = kept;
+    elementCounts.add(z, count - elementCounts[z]);
+    if (count == 0) {
+        elementCounts.present[z >> 6] &= ~(std::uint64_t(1) << (z & 63));
+    }
+    
+    originalFormula = CanonicalFormula::hill(elementCounts);
+    deriveFromCounts();
+}
+
+void ChemistryEngine::ChemicalFormula::deriveFromCounts() {
+    // The symbol-keyed map holds int counts, which must not wrap
+    std::map<std::string, int> symbols;
+    elementCounts.forEach([this, &symbols](int z, std::int64_t n) {
+        if (n > std::numeric_limits<int>::max()) {
+            throw std::invalid_argument(std::string("Count of ") + PeriodicTable::symbol(z) +
+                                        " does not fit ChemicalFormula in formula \"" + originalFormula +
+                                        "\"; use FormulaParser for counts this large");
+        }
+        symbols[PeriodicTable::symbol(z)] = static_cast<int>(n);
+    });
+    symbolCounts = std::move(symbols);
+    structuralHash = CanonicalFormula::hash(elementCounts);
+}
+
+// Parse chemical formula (H2O, (NH4)2SO4, K4[Fe(CN)6], CuSO4.5H2O, SO4^2-, [13C]H4, or the electron e^-)
+ChemistryEngine::ChemicalFormula ChemistryEngine::parseFormula(std::string_view formula) {
     ChemicalFormula result;
-    result.originalFormula = formula;
+    result.originalFormula = std::string(formula);
     
-    // Remove spaces and convert to standard format
-    std::string cleanFormula = formula;
-    cleanFormula.erase(std::remove_if(cleanFormula.begin(), cleanFormula.end(), ::isspace), cleanFormula.end());
+    if (EquationParser::isElectron(formula)) {
+        result.elementCounts.charge = -1;
+        result.deriveFromCounts();
+        return result;
+    }
     
-    size_t pos = 0;
-    parseFormulaRecursive(cleanFormula, pos, result.elements, 1);
+    FormulaParser::Result parsed = FormulaParser::parse(formula, result.elementCounts);
+    if (!parsed.ok()) {
+        throwParseError(formula, parsed);
+    }
+    result.deriveFromCounts();
     
     return result;
 }
 
-void ChemistryEngine::parseFormulaRecursive(const std::string& formula, 
-                                           size_t& pos, 
-                                           std::map<std::string, int>& elements,
-                                           int multiplier) {
-    while (pos < formula.length()) {
-        if (formula[pos] == '(') {
-            // Handle parentheses (e.g., (NH4)2SO4)
-            pos++; // skip '('
-            std::map<std::string, int> subElements;
-            parseFormulaRecursive(formula, pos, subElements, 1);
-            
-            if (pos < formula.length() && formula[pos] == ')') {
-                pos++; // skip ')'
-                int subMultiplier = readNumber(formula, pos);
-                if (subMultiplier == 0) subMultiplier = 1;
-                
-                // Multiply sub-elements by multiplier
-                for (auto& elem : subElements) {
-                    elements[elem.first] += elem.second * subMultiplier * multiplier;
-                }
-            }
-        } else if (std::isupper(formula[pos])) {
-            // Read element symbol
-            std::string symbol = readElementSymbol(formula, pos);
-            int count = readNumber(formula, pos);
-            if (count == 0) count = 1;
-            
-            elements[symbol] += count * multiplier;
-        } else {
-            break;
-        }
-    }
+void ChemistryEngine::throwParseError(std::string_view formula, const FormulaParser::Result& result) {
+    std::ostringstream message;
+    message << FormulaParser::errorMessage(result.error) << " at position " << result.position
+            << " in formula \"" << formula << "\"";
+    throw std::invalid_argument(message.str());
 }
 
-std::string ChemistryEngine::readElementSymbol(const std::string& formula, size_t& pos) {
-    std::string symbol;
-    if (pos < formula.length()) {
-        symbol += formula[pos++];
-        // Check if next character is lowercase (two-letter elements)
-        if (pos < formula.length() && std::islower(formula[pos])) {
-            symbol += formula[pos++];
-        }
+void ChemistryEngine::throwEquationError(std::string_view equation, const EquationParser::Result& result) {
+    std::ostringstream message;
+    if (result.error == EquationParser::Error::BAD_FORMULA) {
+        message << FormulaParser::errorMessage(result.formulaError);
+    } else {
+        message << EquationParser::errorMessage(result.error);
     }
-    return symbol;
+    message << " at position " << result.position << " in equation \"" << equation << "\"";
+    throw std::invalid_argument(message.str());
+}
+
+ChemistryEngine::FormulaRef ChemistryEngine::internFormula(const std::string& formula) {
+    FormulaCache::EntryPtr entry = FormulaCache::instance().get(formula);
+    return FormulaRef(entry, &entry->formula); // Shares ownership of the cache entry
 }
 
-int ChemistryEngine::readNumber(const std::string& formula, size_t& pos) {
-    int number = 0;
-    while (pos < formula.length() && std::isdigit(formula[pos])) {
-        number = number * 10 + (formula[pos] - '0');
-        pos++;
+// Parse equation text; each distinct formula is parsed once and shared through FormulaCache
+ChemistryEngine::ChemicalEquation ChemistryEngine::parseEquation(std::string_view equation) {
+    EquationParser::Equation parsed;
+    EquationParser::Result result = EquationParser::parse(equation, parsed);
+    if (!result.ok()) {
+        throwEquationError(equation, result);
+    }
+    
+    ChemicalEquation out;
+    out.reversible = parsed.reversible;
+    out.reactants.reserve(parsed.reactantCount);
+    out.products.reserve(parsed.productCount());
+    for (size_t i = 0; i < parsed.terms.size(); ++i) {
+        const EquationParser::Term& term = parsed.terms[i];
+        if (term.coefficient > std::numeric_limits<int>::max()) {
+            result.error = EquationParser::Error::BAD_COEFFICIENT;
+            result.position = term.position;
+            throwEquationError(equation, result);
+        }
+        FormulaRef formula;
+        try {
+            formula = internFormula(std::string(term.formula));
+        } catch (const std::invalid_argument&) {
+            // Report the position within the whole equation
+            FormulaParser::ElementCounts counts;
+            FormulaParser::Result bad = FormulaParser::parse(term.formula, counts);
+            if (bad.ok()) {
+                throw;
+            }
+            result.error = EquationParser::Error::BAD_FORMULA;
+            result.formulaError = bad.error;
+            result.position = term.position + bad.position;
+            throwEquationError(equation, result);
+        }
+        auto& side = i < parsed.reactantCount ? out.reactants : out.products;
+        side.emplace_back(std::move(formula), static_cast<int>(term.coefficient), term.state);
     }
-    return number;
+    return out;
 }
 
 // Calculate molar mass
 double ChemistryEngine::calculateMolarMass(const std::string& formula) {
-    ChemicalFormula parsed = parseFormula(formula);
-    return calculateMolarMass(parsed);
+    // Parse straight into per-thread scratch counts: no ChemicalFormula, no allocations
+    thread_local FormulaParser::ElementCounts counts;
+    FormulaParser::Result parsed = FormulaParser::parse(formula, counts);
+    if (!parsed.ok()) {
+        throwParseError(formula, parsed);
+    }
+    return counts.molarMass();
+}
+
+double ChemistryEngine::calculateMolarMass(std::istream& formula) {
+    FormulaParser::ElementCounts counts;
+    FormulaParser::Result parsed = FormulaParser::parse(formula, counts);
+    if (!parsed.ok()) {
+        std::ostringstream message;
+        message << FormulaParser::errorMessage(parsed.error) << " at position " << parsed.position
+                << " in streamed formula";
+        throw std::invalid_argument(message.str());
+    }
+    return counts.molarMass();
 }
 
 double ChemistryEngine::calculateMolarMass(const ChemicalFormula& formula) {
-    double totalMass = 0.0;
-    
-    for (const auto& elem : formula.elements) {
-        auto it = ATOMIC_MASSES.find(elem.first);
-        if (it != ATOMIC_MASSES.end()) {
-            totalMass += it->second * elem.second;
-        }
+    return formula.counts().molarMass();
+}
+
+std::uint64_t ChemistryEngine::formulaHash(const ChemicalFormula& formula) {
+    return formula.hash();
+}
+
+double ChemistryEngine::monoisotopicMass(const ChemicalFormula& formula) {
+    return IsotopePattern::monoisotopicMass(formula.counts());
+}
+
+IsotopePattern::Pattern ChemistryEngine::isotopePattern(const ChemicalFormula& formula,
+                                                        const IsotopePattern::Options& options) {
+    return IsotopePattern::compute(formula.counts(), options);
+}
+
+std::vector<EmpiricalFormula::Candidate> ChemistryEngine::empiricalFormula(std::string_view composition,
+                                                                          double molarMass) {
+    EmpiricalFormula::Query query;
+    if (!EmpiricalFormula::parseComposition(composition, query.composition)) {
+        throw std::invalid_argument("Cannot read percent composition \"" + std::string(composition) + "\"");
     }
-    
-    return totalMass;
+    query.molarMass = molarMass;
+    EmpiricalFormula::Status status;
+    std::vector<EmpiricalFormula::Candidate> candidates = EmpiricalFormula::solve(query, &status);
+    if (status == EmpiricalFormula::Status::INVALID_QUERY) {
+        throw std::invalid_argument(std::string(EmpiricalFormula::statusMessage(status)) + " \"" +
+                                    std::string(composition) + "\"");
+    }
+    return candidates;
+}
+
+std::vector<double> ChemistryEngine::calculateMolarMasses(const std::vector<ChemicalFormula>& formulas) {
+    return FormulaMatrix(formulas).molarMasses();
+}
+
+// Molar mass through the intern cache: repeated formulas are parsed once
+double ChemistryEngine::cachedMolarMass(const std::string& formula) {
+    return FormulaCache::instance().get(formula)->molarMass;
 }
 
 // Moles <-> grams conversion
-double ChemistryEngine::molesToGrams(double moles, const std::string& formula) {
-    double molarMass = calculateMolarMass(formula);
-    return moles * molarMass;
+units::GramsPerMole ChemistryEngine::molarMass(const std::string& formula) {
+    return units::GramsPerMole(cachedMolarMass(formula));
 }
 
-double ChemistryEngine::gramsToMoles(double grams, const std::string& formula) {
-    double molarMass = calculateMolarMass(formula);
-    if (molarMass == 0.0) return 0.0;
-    return grams / molarMass;
+units::Grams ChemistryEngine::molesToGrams(units::Moles moles, const std::string& formula) {
+    return moles * molarMass(formula);
 }
 
-// Simplified equation balancing (works for basic equations)
+units::Moles ChemistryEngine::gramsToMoles(units::Grams grams, const std::string& formula) {
+    units::GramsPerMole perMole = molarMass(formula);
+    if (perMole.value() == 0.0) return units::Moles(0.0);
+    return grams / perMole;
+}
+
+// Equation balancing via exact integer nullspace
 bool ChemistryEngine::balanceEquation(ChemicalEquation& equation) {
-    // Collect all unique elements
-    std::map<std::string, int> elementCounts;
+    EquationBalancer::Result result = EquationBalancer::balance(equation);
+    if (!result.ok()) {
+        return false;
+    }
+    
+    // EquationComponent stores int coefficients
+    for (std::int64_t coefficient : result.coefficients) {
+        if (coefficient > std::numeric_limits<int>::max()) {
+            return false;
+        }
+    }
+    
+    size_t index = 0;
+    for (auto& comp : equation.reactants) {
+        comp.coefficient = static_cast<int>(result.coefficients[index++]);
+    }
+    for (auto& comp : equation.products) {
+        comp.coefficient = static_cast<int>(result.coefficients[index++]);
+    }
+    return true;
+}
+
+bool ChemistryEngine::isEquationBalanced(const ChemicalEquation& equation) {
+    // Net element counts and charge: products positive, reactants negative
+    std::map<std::string, long long> elementCounts;
+    long long charge = 0;
     
-    // Count elements in products (with positive sign)
     for (const auto& comp : equation.products) {
-        for (const auto& elem : comp.formula.elements) {
-            elementCounts[elem.first] += elem.second * comp.coefficient;
+        for (const auto& elem : comp.formula->elements()) {
+            elementCounts[elem.first] += static_cast<long long>(elem.second) * comp.coefficient;
         }
+        charge += comp.formula->counts().charge * comp.coefficient;
     }
     
-    // Count elements in reactants (with negative sign)
     for (const auto& comp : equation.reactants) {
-        for (const auto& elem : comp.formula.elements) {
-            elementCounts[elem.first] -= elem.second * comp.coefficient;
+        for (const auto& elem : comp.formula->elements()) {
+            elementCounts[elem.first] -= static_cast<long long>(elem.second) * comp.coefficient;
         }
+        charge -= comp.formula->counts().charge * comp.coefficient;
+    }
+    
+    if (charge != 0) {
+        return false;
     }
     
     // Check if all counts are zero (balanced)
@@ -160,13 +305,13 @@ bool ChemistryEngine::balanceEquation(ChemicalEquation& equation) {
 }
 
 // Stoichiometry: calculate product yield
-double ChemistryEngine::calculateProductYield(const std::string& reactantFormula,
-                                              double reactantMoles,
-                                              const std::string& productFormula,
-                                              int reactantCoeff,
-                                              int productCoeff) {
+units::Grams ChemistryEngine::calculateProductYield(const std::string& reactantFormula,
+                                                    units::Moles reactantMoles,
+                                                    const std::string& productFormula,
+                                                    int reactantCoeff,
+                                                    int productCoeff) {
     // Using stoichiometric ratio: (reactantMoles / reactantCoeff) * (productCoeff / 1) = productMoles
-    double productMoles = (reactantMoles / reactantCoeff) * productCoeff;
+    units::Moles productMoles = (reactantMoles / reactantCoeff) * productCoeff;
     return molesToGrams(productMoles, productFormula);
 }
 
@@ -179,20 +324,20 @@ std::string ChemistryEngine::ChemicalEquation::toString() const {
         if (reactants[i].coefficient > 1) {
             ss << reactants[i].coefficient;
         }
-        ss << reactants[i].formula.toString();
+        ss << reactants[i].formula->toString() << EquationParser::stateTag(reactants[i].state);
         if (i < reactants.size() - 1) {
             ss << " + ";
         }
     }
     
-    ss << " -> ";
+    ss << (reversible ? " <=> " : " -> ");
     
     // Products
     for (size_t i = 0; i < products.size(); ++i) {
         if (products[i].coefficient > 1) {
             ss << products[i].coefficient;
         }
-        ss << products[i].formula.toString();
+        ss << products[i].formula->toString() << EquationParser::stateTag(products[i].state);
         if (i < products.size() - 1) {
             ss << " + ";
         }
@@ -202,8 +347,20 @@ std::string ChemistryEngine::ChemicalEquation::toString() const {
 }
 
 bool ChemistryEngine::ChemicalEquation::isBalanced() const {
-    ChemicalEquation eq = *this;
-    return ChemistryEngine::balanceEquation(eq);
+    return ChemistryEngine::isEquationBalanced(*this);
+}
+
+std::string ChemistryEngine::ChemicalEquation::coefficientsToString() const {
+    std::stringstream ss;
+    for (const auto* side : {&reactants, &products}) {
+        for (const auto& comp : *side) {
+            if (ss.tellp() > 0) {
+                ss << ' ';
+            }
+            ss << comp.coefficient;
+        }
+    }
+    return ss.str();
 }
 
 
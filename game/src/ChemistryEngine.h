@@ -1,7 +1,17 @@
 #ifndef CHEMISTRYENGINE_H
 #define CHEMISTRYENGINE_H
 
+#include "EmpiricalFormula.h"
+#include "EquationParser.h"
+#include "FormulaParser.h"
+#include "IsotopePattern.h"
+#include "Quantity.h"
+#include <cstdint>
+#include <iosfwd>
+#include <memory>
 #include <string>
+#include <string_view>
+#include <utility>
 #include <vector>
 #include <map>
 #include <cmath>
@@ -23,67 +33,131 @@ public:
         double atomicMass;
     };
 
-    // Chemical formula representation
+    // Chemical formula representation. The flat counts are the only copy of the composition;
+    // the symbol map and the hash are derived from them whenever they change.
     struct ChemicalFormula {
-        std::map<std::string, int> elements; // element symbol -> count
         std::string originalFormula;
         
-        ChemicalFormula() = default;
+        ChemicalFormula();
         explicit ChemicalFormula(const std::string& formula);
         double calculateMolarMass() const;
         std::string toString() const;
+        std::string hillFormula() const; // Canonical text: "CH4" for "H4C"
+        int charge() const { return static_cast<int>(elementCounts.charge); } // Ionic charge
+        bool isElectron() const { return elementCounts.charge == -1 && elementCounts.empty(); }
+        
+        const std::map<std::string, int>& elements() const { return symbolCounts; } // element symbol -> count
+        const FormulaParser::ElementCounts& counts() const { return elementCounts; } // atomic number -> count
+        std::uint64_t hash() const { return structuralHash; }                        // CanonicalFormula::hash of counts()
+        
+        // Builds or edits a formula by hand: sets an element's count (0 removes it, along with any
+        // isotope labels of that element) and rewrites originalFormula in Hill order.
+        // Throws std::invalid_argument for an unknown symbol or a negative count.
+        void setCount(const std::string& symbol, int count);
+        
+        // Same composition however written ("CH4" == "H4C"); hashes are compared first
+        bool operator==(const ChemicalFormula& other) const;
+        bool operator!=(const ChemicalFormula& other) const { return !(*this == other); }
+        
+    private:
+        friend class ChemistryEngine;
+        
+        FormulaParser::ElementCounts elementCounts;
+        std::map<std::string, int> symbolCounts;
+        std::uint64_t structuralHash;
+        
+        // Rebuilds the symbol map and the hash from elementCounts
+        void deriveFromCounts();
     };
 
+    // Shared, immutable formula; interned ones live in FormulaCache
+    using FormulaRef = std::shared_ptr<const ChemicalFormula>;
+    using State = EquationParser::State;
+
     // Chemical equation component
     struct EquationComponent {
-        ChemicalFormula formula;
+        FormulaRef formula;
         int coefficient;
+        State state = State::NONE;
         
         EquationComponent(const ChemicalFormula& f, int coeff = 1) 
-            : formula(f), coefficient(coeff) {}
+            : formula(std::make_shared<const ChemicalFormula>(f)), coefficient(coeff) {}
+        EquationComponent(FormulaRef f, int coeff, State s = State::NONE)
+            : formula(std::move(f)), coefficient(coeff), state(s) {}
     };
 
     // Chemical equation representation
     struct ChemicalEquation {
         std::vector<EquationComponent> reactants;
         std::vector<EquationComponent> products;
+        bool reversible = false; // Written with <=>, <-> or ⇌
         
         bool isBalanced() const;
         std::string toString() const;
+        std::string coefficientsToString() const; // "1 5 3 4": reactants then products
     };
 
-    // Atomic masses database (simplified - common elements)
-    static const std::map<std::string, double> ATOMIC_MASSES;
+    // Atomic mass lookup (full periodic table, see PeriodicTable.h)
+    // Throws std::invalid_argument for an unknown element symbol
+    static double getAtomicMass(const std::string& symbol);
 
-    // Formula parsing
-    static ChemicalFormula parseFormula(const std::string& formula);
+    // Formula parsing (throws std::invalid_argument on malformed formulas)
+    static ChemicalFormula parseFormula(std::string_view formula);
+    
+    // Equation parsing, e.g. "C3H8 + 5O2 -> 3CO2 + 4H2O" or "NaCl(s) <=> Na^+(aq) + Cl^-(aq)"
+    // (see EquationParser). Components share interned formulas from FormulaCache.
+    // Throws std::invalid_argument naming the position of the first error.
+    static ChemicalEquation parseEquation(std::string_view equation);
+    
+    // The interned formula for this text (throws std::invalid_argument if malformed)
+    static FormulaRef internFormula(const std::string& formula);
+    
+    // Stable structural hash (see CanonicalFormula), the same as formula.hash()
+    static std::uint64_t formulaHash(const ChemicalFormula& formula);
     
     // Molar mass calculation
     static double calculateMolarMass(const std::string& formula);
     static double calculateMolarMass(const ChemicalFormula& formula);
+    static double calculateMolarMass(std::istream& formula); // Any length, read in chunks (FormulaParser::Stream)
+    static double cachedMolarMass(const std::string& formula); // Via FormulaCache
+    
+    // Monoisotopic mass and isotope distribution (see IsotopePattern); throw std::invalid_argument
+    // for elements without natural isotope data
+    static double monoisotopicMass(const ChemicalFormula& formula);
+    static IsotopePattern::Pattern isotopePattern(const ChemicalFormula& formula,
+                                                  const IsotopePattern::Options& options = IsotopePattern::Options());
     
-    // Moles <-> grams conversion
-    static double molesToGrams(double moles, const std::string& formula);
-    static double gramsToMoles(double grams, const std::string& formula);
+    // Empirical and molecular formula from mass percents like "C 40.0, H 6.7, O 53.3", with an
+    // optional molar mass (see EmpiricalFormula); ranked, best first, empty when nothing fits.
+    // Throws std::invalid_argument for unreadable or inconsistent percents.
+    static std::vector<EmpiricalFormula::Candidate> empiricalFormula(std::string_view composition,
+                                                                     double molarMass = 0.0);
     
-    // Equation balancing (simplified algorithm for basic equations)
+    // Batch molar masses through the SIMD FormulaMatrix kernel (same results as one by one)
+    static std::vector<double> calculateMolarMasses(const std::vector<ChemicalFormula>& formulas);
+    
+    // Moles <-> grams conversion (molar mass via FormulaCache)
+    static units::Grams molesToGrams(units::Moles moles, const std::string& formula);
+    static units::Moles gramsToMoles(units::Grams grams, const std::string& formula);
+    static units::GramsPerMole molarMass(const std::string& formula);
+    
+    // Equation balancing: finds the smallest positive integer coefficients (see EquationBalancer).
+    // Returns false and leaves the coefficients untouched if no unique balance exists.
     static bool balanceEquation(ChemicalEquation& equation);
     
-    // Stoichiometry calculations
-    static double calculateProductYield(const std::string& reactantFormula, 
-                                       double reactantMoles,
+    // Checks whether the current coefficients conserve every element and the total charge
+    static bool isEquationBalanced(const ChemicalEquation& equation);
+    
+    // Stoichiometry for one reactant and one product (see Stoichiometry for whole equations)
+    static units::Grams calculateProductYield(const std::string& reactantFormula, 
+                                       units::Moles reactantMoles,
                                        const std::string& productFormula,
                                        int reactantCoeff = 1,
                                        int productCoeff = 1);
 
 private:
-    // Helper functions for formula parsing
-    static void parseFormulaRecursive(const std::string& formula, 
-                                     size_t& pos, 
-                                     std::map<std::string, int>& elements,
-                                     int multiplier = 1);
-    static std::string readElementSymbol(const std::string& formula, size_t& pos);
-    static int readNumber(const std::string& formula, size_t& pos);
+    static void throwParseError(std::string_view formula, const FormulaParser::Result& result);
+    static void throwEquationError(std::string_view equation, const EquationParser::Result& result);
 };
 
 #endif // CHEMISTRYENGINE_H
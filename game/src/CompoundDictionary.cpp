@@ -0,0 +1,474 @@
+#include "CompoundDictionary.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+/*
+ * Image layout (all fields little-endian):
+ *   Header   magic "BBD1", version, nodeCount, entryCount, labelBytes, stringBytes (u32 each)
+ *   Nodes    nodeCount x 24 bytes, root first, children of a node contiguous
+ *   Entries  entryCount x 16 bytes, in normalized-name order
+ *   Labels   edge label bytes
+ *   Strings  display names and formulas
+ */
+
+namespace {
+
+constexpr char MAGIC[4] = {'B', 'B', 'D', '1'};
+constexpr std::uint32_t VERSION = 1;
+constexpr size_t HEADER_BYTES = 24;
+constexpr size_t NODE_BYTES = 24;
+constexpr size_t ENTRY_BYTES = 16;
+constexpr std::uint16_t HAS_ENTRY = 1;
+
+template <typename T>
+T load(const char* at) {
+    T value;
+    std::memcpy(&value, at, sizeof(T));
+    return value;
+}
+
+template <typename T>
+void store(std::vector<char>& out, T value) {
+    char raw[sizeof(T)];
+    std::memcpy(raw, &value, sizeof(T));
+    out.insert(out.end(), raw, raw + sizeof(T));
+}
+
+// Names of the compounds that appear in the game's tasks and dialogs, plus everyday chemicals
+struct BuiltInName {
+    const char* name;
+    const char* formula;
+    std::uint32_t score;
+};
+
+constexpr BuiltInName BUILT_IN_NAMES[] = {
+    {"вода", "H2O", 100}, {"water", "H2O", 100}, {"оксид водорода", "H2O", 10},
+    {"углекислый газ", "CO2", 90}, {"диоксид углерода", "CO2", 60}, {"carbon dioxide", "CO2", 90},
+    {"угарный газ", "CO", 70}, {"монооксид углерода", "CO", 40}, {"carbon monoxide", "CO", 70},
+    {"кислород", "O2", 90}, {"oxygen", "O2", 90}, {"озон", "O3", 40}, {"ozone", "O3", 40},
+    {"водород", "H2", 90}, {"hydrogen", "H2", 90}, {"азот", "N2", 80}, {"nitrogen", "N2", 80},
+    {"хлор", "Cl2", 60}, {"chlorine", "Cl2", 60}, {"йод", "I2", 60}, {"iodine", "I2", 60},
+    {"красный фосфор", "P", 50}, {"red phosphorus", "P", 50}, {"алюминий", "Al", 50}, {"aluminium", "Al", 50},
+    {"aluminum", "Al", 50}, {"ртуть", "Hg", 50}, {"mercury", "Hg", 50}, {"литий", "Li", 40}, {"lithium", "Li", 40},
+    {"натрий", "Na", 40}, {"sodium", "Na", 40}, {"палладий", "Pd", 30}, {"palladium", "Pd", 30},
+    {"аммиак", "NH3", 80}, {"ammonia", "NH3", 80}, {"метан", "CH4", 80}, {"methane", "CH4", 80},
+    {"этан", "C2H6", 50}, {"ethane", "C2H6", 50}, {"пропан", "C3H8", 70}, {"propane", "C3H8", 70},
+    {"бутан", "C4H10", 50}, {"butane", "C4H10", 50}, {"этилен", "C2H4", 50}, {"ethylene", "C2H4", 50},
+    {"ацетилен", "C2H2", 50}, {"acetylene", "C2H2", 50},
+    {"бензол", "C6H6", 80}, {"benzene", "C6H6", 80}, {"толуол", "C7H8", 60}, {"toluene", "C7H8", 60},
+    {"нитробензол", "C6H5NO2", 50}, {"nitrobenzene", "C6H5NO2", 50}, {"анилин", "C6H7N", 50},
+    {"aniline", "C6H7N", 50}, {"фенол", "C6H6O", 50}, {"phenol", "C6H6O", 50},
+    {"этанол", "C2H6O", 80}, {"этиловый спирт", "C2H6O", 70}, {"ethanol", "C2H6O", 80},
+    {"метанол", "CH4O", 60}, {"метиловый спирт", "CH4O", 50}, {"methanol", "CH4O", 60},
+    {"ацетон", "C3H6O", 60}, {"acetone", "C3H6O", 60}, {"уксусная кислота", "C2H4O2", 70},
+    {"acetic acid", "C2H4O2", 70}, {"муравьиная кислота", "CH2O2", 40}, {"formic acid", "CH2O2", 40},
+    {"формальдегид", "CH2O", 40}, {"formaldehyde", "CH2O", 40}, {"глюкоза", "C6H12O6", 70},
+    {"glucose", "C6H12O6", 70}, {"сахароза", "C12H22O11", 60}, {"sucrose", "C12H22O11", 60},
+    {"сахар", "C12H22O11", 50}, {"sugar", "C12H22O11", 50}, {"мочевина", "CH4N2O", 40}, {"urea", "CH4N2O", 40},
+    {"аспирин", "C9H8O4", 50}, {"aspirin", "C9H8O4", 50}, {"кофеин", "C8H10N4O2", 50},
+    {"caffeine", "C8H10N4O2", 50},
+    {"метамфетамин", "C10H15N", 100}, {"methamphetamine", "C10H15N", 100}, {"мет", "C10H15N", 30},
+    {"псевдоэфедрин", "C10H15NO", 80}, {"pseudoephedrine", "C10H15NO", 80}, {"эфедрин", "C10H15NO", 60},
+    {"ephedrine", "C10H15NO", 60}, {"метиламин", "CH5N", 80}, {"methylamine", "CH5N", 80},
+    {"фенилацетон", "C9H10O", 70}, {"phenylacetone", "C9H10O", 70}, {"P2P", "C9H10O", 60},
+    {"фенилуксусная кислота", "C8H8O2", 40}, {"phenylacetic acid", "C8H8O2", 40},
+    {"фульминат ртути", "C2HgN2O2", 60}, {"гремучая ртуть", "C2HgN2O2", 60},
+    {"mercury fulminate", "C2HgN2O2", 60}, {"фосфин", "PH3", 50}, {"phosphine", "PH3", 50},
+    {"хлорид натрия", "NaCl", 80}, {"поваренная соль", "NaCl", 70}, {"sodium chloride", "NaCl", 80},
+    {"table salt", "NaCl", 60}, {"гидроксид натрия", "NaOH", 70}, {"едкий натр", "NaOH", 50},
+    {"каустическая сода", "NaOH", 50}, {"sodium hydroxide", "NaOH", 70}, {"lye", "NaOH", 40},
+    {"гидроксид калия", "KOH", 50}, {"potassium hydroxide", "KOH", 50},
+    {"пищевая сода", "NaHCO3", 60}, {"гидрокарбонат натрия", "NaHCO3", 50}, {"baking soda", "NaHCO3", 60},
+    {"sodium bicarbonate", "NaHCO3", 50}, {"карбонат натрия", "Na2CO3", 50}, {"sodium carbonate", "Na2CO3", 50},
+    {"карбонат кальция", "CaCO3", 50}, {"мел", "CaCO3", 40}, {"calcium carbonate", "CaCO3", 50},
+    {"chalk", "CaCO3", 40}, {"негашёная известь", "CaO", 40}, {"quicklime", "CaO", 40},
+    {"соляная кислота", "HCl", 80}, {"хлороводород", "HCl", 60}, {"hydrochloric acid", "HCl", 80},
+    {"hydrogen chloride", "HCl", 60}, {"серная кислота", "H2SO4", 80}, {"sulfuric acid", "H2SO4", 80},
+    {"азотная кислота", "HNO3", 70}, {"nitric acid", "HNO3", 70}, {"фосфорная кислота", "H3PO4", 60},
+    {"phosphoric acid", "H3PO4", 60}, {"плавиковая кислота", "HF", 70}, {"фтороводород", "HF", 50},
+    {"hydrofluoric acid", "HF", 70}, {"иодоводородная кислота", "HI", 50}, {"hydroiodic acid", "HI", 50},
+    {"перекись водорода", "H2O2", 60}, {"пероксид водорода", "H2O2", 50}, {"hydrogen peroxide", "H2O2", 60},
+    {"перманганат калия", "KMnO4", 60}, {"марганцовка", "KMnO4", 50}, {"potassium permanganate", "KMnO4", 60},
+    {"медный купорос", "CuSO4.5H2O", 50}, {"сульфат меди", "CuSO4", 50}, {"copper sulfate", "CuSO4", 50},
+    {"сероводород", "H2S", 50}, {"hydrogen sulfide", "H2S", 50}, {"диоксид серы", "SO2", 40},
+    {"сернистый газ", "SO2", 40}, {"sulfur dioxide", "SO2", 40}, {"хлороформ", "CHCl3", 40},
+    {"chloroform", "CHCl3", 40}, {"диэтиловый эфир", "C4H10O", 40}, {"эфир", "C4H10O", 30},
+    {"diethyl ether", "C4H10O", 40}, {"ржавчина", "Fe2O3", 40}, {"оксид железа(III)", "Fe2O3", 30},
+    {"rust", "Fe2O3", 40}, {"iron(III) oxide", "Fe2O3", 30}, {"тротил", "C7H5N3O6", 40},
+    {"тринитротолуол", "C7H5N3O6", 40}, {"TNT", "C7H5N3O6", 40}, {"trinitrotoluene", "C7H5N3O6", 40},
+    {"нитроглицерин", "C3H5N3O9", 40}, {"nitroglycerin", "C3H5N3O9", 40},
+};
+
+// Lower-cases one UTF-8 sequence in place: Latin A-Z, Cyrillic А-Я and Ё (to е)
+void appendLower(std::string& out, std::string_view text, size_t& i) {
+    const unsigned char c = static_cast<unsigned char>(text[i]);
+    if (c < 0x80) {
+        out += static_cast<char>(c >= 'A' && c <= 'Z' ? c + ('a' - 'A') : c);
+        ++i;
+        return;
+    }
+    if ((c == 0xD0 || c == 0xD1) && i + 1 < text.size()) {
+        const unsigned char d = static_cast<unsigned char>(text[i + 1]);
+        i += 2;
+        if (c == 0xD0 && d >= 0x90 && d <= 0x9F) { // А-П -> а-п
+            out += '\xD0';
+            out += static_cast<char>(d + 0x20);
+        } else if (c == 0xD0 && d >= 0xA0 && d <= 0xAF) { // Р-Я -> р-я
+            out += '\xD1';
+            out += static_cast<char>(d - 0x20);
+        } else if ((c == 0xD0 && d == 0x81) || (c == 0xD1 && d == 0x91)) { // Ё, ё -> е
+            out += "\xD0\xB5";
+        } else {
+            out += static_cast<char>(c);
+            out += static_cast<char>(d);
+        }
+        return;
+    }
+    out += static_cast<char>(c);
+    ++i;
+}
+
+} // namespace
+
+struct CompoundDictionary::Node {
+    std::uint32_t labelOffset;
+    std::uint16_t labelLength;
+    std::uint16_t flags;
+    std::uint32_t childCount;
+    std::uint32_t firstChild;
+    std::uint32_t entryBegin; // Entries of the subtree are [entryBegin, ...); the node's own is entryBegin
+    std::uint32_t bestScore;  // Highest score in the subtree
+};
+
+void CompoundDictionary::normalize(std::string_view text, std::string& out) {
+    out.clear();
+    bool pendingSpace = false;
+    for (size_t i = 0; i < text.size();) {
+        const char c = text[i];
+        if (c == ' ' || c == '\t' || c == '\n' || c == '\r') {
+            pendingSpace = !out.empty();
+            ++i;
+            continue;
+        }
+        if (pendingSpace) {
+            out += ' ';
+            pendingSpace = false;
+        }
+        appendLower(out, text, i);
+    }
+}
+
+void CompoundDictionary::Builder::add(std::string_view name, std::string_view formula, std::uint32_t score) {
+    names.emplace_back(name);
+    formulas.emplace_back(formula);
+    scores.push_back(score);
+}
+
+void CompoundDictionary::Builder::load(std::istream& in) {
+    std::string line;
+    size_t lineNumber = 0;
+    while (std::getline(in, line)) {
+        ++lineNumber;
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        size_t first = line.find_first_not_of(" \t");
+        if (first == std::string::npos || line[first] == '#') continue;
+
+        const size_t tab = line.find('\t');
+        if (tab == std::string::npos || tab == 0 || tab + 1 == line.size()) {
+            throw std::invalid_argument("Line " + std::to_string(lineNumber) + ": expected name<TAB>formula");
+        }
+        const size_t scoreTab = line.find('\t', tab + 1);
+        std::uint32_t score = 0;
+        if (scoreTab != std::string::npos) {
+            const std::string text = line.substr(scoreTab + 1);
+            size_t used = 0;
+            unsigned long value = 0;
+            try {
+                value = std::stoul(text, &used);
+            } catch (const std::exception&) {
+                used = 0;
+            }
+            if (used == 0 || used != text.size() || value > 0xFFFFFFFFul) {
+                throw std::invalid_argument("Line " + std::to_string(lineNumber) + ": bad score \"" + text + "\"");
+            }
+            score = static_cast<std::uint32_t>(value);
+        }
+        const size_t formulaEnd = scoreTab == std::string::npos ? line.size() : scoreTab;
+        add(std::string_view(line).substr(0, tab), std::string_view(line).substr(tab + 1, formulaEnd - tab - 1), score);
+    }
+}
+
+std::vector<char> CompoundDictionary::Builder::build() const {
+    // Normalized keys, sorted; a repeated key keeps its best-scored (then first) entry
+    std::vector<std::string> keys(names.size());
+    for (size_t i = 0; i < names.size(); ++i) normalize(names[i], keys[i]);
+    std::vector<std::uint32_t> order;
+    for (std::uint32_t i = 0; i < names.size(); ++i) {
+        if (!keys[i].empty()) order.push_back(i);
+    }
+    std::stable_sort(order.begin(), order.end(), [&](std::uint32_t a, std::uint32_t b) {
+        return keys[a] != keys[b] ? keys[a] < keys[b] : scores[a] > scores[b];
+    });
+    order.erase(std::unique(order.begin(), order.end(),
+                            [&](std::uint32_t a, std::uint32_t b) { return keys[a] == keys[b]; }),
+                order.end());
+
+    // Breadth-first radix trie over order[lo, hi), so the children of a node are contiguous
+    struct Pending {
+        std::uint32_t node, lo, hi, depth;
+    };
+    std::vector<Node> trie(1, Node{0, 0, 0, 0, 0, 0, 0});
+    std::string labelPool;
+    std::queue<Pending> queue;
+    queue.push({0, 0, static_cast<std::uint32_t>(order.size()), 0});
+    while (!queue.empty()) {
+        const Pending item = queue.front();
+        queue.pop();
+        std::uint32_t lo = item.lo;
+        trie[item.node].entryBegin = lo;
+        if (lo < item.hi && keys[order[lo]].size() == item.depth) {
+            trie[item.node].flags |= HAS_ENTRY;
+            ++lo;
+        }
+        trie[item.node].firstChild = static_cast<std::uint32_t>(trie.size());
+        while (lo < item.hi) {
+            const std::string& first = keys[order[lo]];
+            std::uint32_t hi = lo + 1;
+            while (hi < item.hi && keys[order[hi]][item.depth] == first[item.depth]) ++hi;
+            // Sorted, so the group's common prefix is that of its first and last keys
+            const std::string& last = keys[order[hi - 1]];
+            size_t length = 1;
+            const size_t limit = std::min<size_t>(std::min(first.size(), last.size()) - item.depth, 0xFFFF);
+            while (length < limit && first[item.depth + length] == last[item.depth + length]) ++length;
+
+            Node child{static_cast<std::uint32_t>(labelPool.size()), static_cast<std::uint16_t>(length), 0, 0, 0, 0, 0};
+            labelPool.append(first, item.depth, length);
+            queue.push({static_cast<std::uint32_t>(trie.size()), lo, hi,
+                        item.depth + static_cast<std::uint32_t>(length)});
+            trie.push_back(child);
+            trie[item.node].childCount++;
+            lo = hi;
+        }
+    }
+    // Children come after their parent, so one backward pass settles every subtree maximum
+    for (size_t i = trie.size(); i-- > 0;) {
+        Node& n = trie[i];
+        n.bestScore = (n.flags & HAS_ENTRY) ? scores[order[n.entryBegin]] : 0;
+        for (std::uint32_t c = 0; c < n.childCount; ++c) {
+            n.bestScore = std::max(n.bestScore, trie[n.firstChild + c].bestScore);
+        }
+    }
+
+    std::string stringPool;
+    std::vector<char> image(MAGIC, MAGIC + 4);
+    image.reserve(HEADER_BYTES + trie.size() * NODE_BYTES + order.size() * ENTRY_BYTES + labelPool.size());
+    store(image, VERSION);
+    store(image, static_cast<std::uint32_t>(trie.size()));
+    store(image, static_cast<std::uint32_t>(order.size()));
+    store(image, static_cast<std::uint32_t>(labelPool.size()));
+    const size_t stringSizeAt = image.size();
+    store(image, std::uint32_t{0});
+    for (const Node& n : trie) {
+        store(image, n.labelOffset);
+        store(image, n.labelLength);
+        store(image, n.flags);
+        store(image, n.childCount);
+        store(image, n.firstChild);
+        store(image, n.entryBegin);
+        store(image, n.bestScore);
+    }
+    for (std::uint32_t index : order) {
+        store(image, static_cast<std::uint32_t>(stringPool.size()));
+        store(image, static_cast<std::uint32_t>(names[index].size()));
+        stringPool += names[index];
+        store(image, static_cast<std::uint32_t>(formulas[index].size()));
+        stringPool += formulas[index];
+        store(image, scores[index]);
+    }
+    image.insert(image.end(), labelPool.begin(), labelPool.end());
+    image.insert(image.end(), stringPool.begin(), stringPool.end());
+    const auto stringSize = static_cast<std::uint32_t>(stringPool.size());
+    std::memcpy(image.data() + stringSizeAt, &stringSize, sizeof(stringSize));
+    return image;
+}
+
+CompoundDictionary::CompoundDictionary() : CompoundDictionary(Builder().build()) {}
+
+CompoundDictionary::CompoundDictionary(std::vector<char> image) : owned(std::move(image)) {
+    attach(owned.data(), owned.size());
+}
+
+CompoundDictionary CompoundDictionary::open(const std::string& path) {
+    CompoundDictionary dictionary;
+    dictionary.owned.clear();
+    dictionary.mapped = MappedFile(path);
+    dictionary.attach(dictionary.mapped.data(), dictionary.mapped.size());
+    return dictionary;
+}
+
+void CompoundDictionary::save(const std::vector<char>& image, const std::string& path) {
+    std::ofstream out(path, std::ios::binary);
+    out.write(image.data(), static_cast<std::streamsize>(image.size()));
+    if (!out) {
+        throw std::invalid_argument("Cannot write " + path);
+    }
+}
+
+CompoundDictionary CompoundDictionary::builtIn() {
+    Builder builder;
+    for (const BuiltInName& name : BUILT_IN_NAMES) {
+        builder.add(name.name, name.formula, name.score);
+    }
+    return CompoundDictionary(builder.build());
+}
+
+void CompoundDictionary::attach(const char* data, size_t size) {
+    if (size < HEADER_BYTES || std::memcmp(data, MAGIC, 4) != 0 || load<std::uint32_t>(data + 4) != VERSION) {
+        throw std::invalid_argument("Not a compound dictionary image");
+    }
+    nodeCount = load<std::uint32_t>(data + 8);
+    entryCount = load<std::uint32_t>(data + 12);
+    labelBytes = load<std::uint32_t>(data + 16);
+    stringBytes = load<std::uint32_t>(data + 20);
+    const std::uint64_t expected = HEADER_BYTES + std::uint64_t{nodeCount} * NODE_BYTES +
+                                   std::uint64_t{entryCount} * ENTRY_BYTES + labelBytes + stringBytes;
+    if (nodeCount == 0 || expected != size) {
+        throw std::invalid_argument("Compound dictionary image is truncated or has the wrong size");
+    }
+    base = data;
+    bytes = size;
+    nodes = data + HEADER_BYTES;
+    entries = nodes + size_t{nodeCount} * NODE_BYTES;
+    labels = entries + size_t{entryCount} * ENTRY_BYTES;
+    strings = labels + labelBytes;
+
+    // Every reference must stay inside the image, so lookups need no checks
+    for (std::uint32_t i = 0; i < nodeCount; ++i) {
+        const Node n = node(i);
+        const bool childrenInside = n.childCount == 0 || (n.firstChild > i && n.firstChild <= nodeCount &&
+                                                          n.childCount <= nodeCount - n.firstChild);
+        if (!childrenInside || std::uint64_t{n.labelOffset} + n.labelLength > labelBytes ||
+            ((n.flags & HAS_ENTRY) && n.entryBegin >= entryCount) || (i > 0 && n.labelLength == 0)) {
+            throw std::invalid_argument("Compound dictionary image is corrupt (node " + std::to_string(i) + ")");
+        }
+    }
+    for (std::uint32_t i = 0; i < entryCount; ++i) {
+        const char* at = entries + size_t{i} * ENTRY_BYTES;
+        const std::uint64_t end = std::uint64_t{load<std::uint32_t>(at)} + load<std::uint32_t>(at + 4) +
+                                  load<std::uint32_t>(at + 8);
+        if (end > stringBytes) {
+            throw std::invalid_argument("Compound dictionary image is corrupt (entry " + std::to_string(i) + ")");
+        }
+    }
+}
+
+CompoundDictionary::Node CompoundDictionary::node(std::uint32_t index) const {
+    const char* at = nodes + size_t{index} * NODE_BYTES;
+    return Node{load<std::uint32_t>(at),      load<std::uint16_t>(at + 4),  load<std::uint16_t>(at + 6),
+                load<std::uint32_t>(at + 8),  load<std::uint32_t>(at + 12), load<std::uint32_t>(at + 16),
+                load<std::uint32_t>(at + 20)};
+}
+
+CompoundDictionary::Entry CompoundDictionary::entry(std::uint32_t index) const {
+    const char* at = entries + size_t{index} * ENTRY_BYTES;
+    const std::uint32_t offset = load<std::uint32_t>(at);
+    const std::uint32_t nameLength = load<std::uint32_t>(at + 4);
+    const std::uint32_t formulaLength = load<std::uint32_t>(at + 8);
+    return Entry{std::string_view(strings + offset, nameLength),
+                 std::string_view(strings + offset + nameLength, formulaLength), load<std::uint32_t>(at + 12)};
+}
+
+bool CompoundDictionary::descend(std::string_view key, std::uint32_t& index, bool& exact) const {
+    index = 0;
+    size_t position = 0;
+    while (position < key.size()) {
+        const Node current = node(index);
+        // Children are ordered by their first label byte
+        std::uint32_t lo = current.firstChild, hi = current.firstChild + current.childCount;
+        const unsigned char wanted = static_cast<unsigned char>(key[position]);
+        while (lo < hi) {
+            const std::uint32_t mid = lo + (hi - lo) / 2;
+            if (static_cast<unsigned char>(labels[node(mid).labelOffset]) < wanted) {
+                lo = mid + 1;
+            } else {
+                hi = mid;
+            }
+        }
+        if (lo == current.firstChild + current.childCount) return false;
+        const Node child = node(lo);
+        if (static_cast<unsigned char>(labels[child.labelOffset]) != wanted) return false;
+        const size_t compared = std::min<size_t>(child.labelLength, key.size() - position);
+        if (std::memcmp(labels + child.labelOffset, key.data() + position, compared) != 0) return false;
+        index = lo;
+        position += compared;
+        if (compared < child.labelLength) {
+            exact = false; // The key ends inside this edge
+            return true;
+        }
+    }
+    exact = true;
+    return true;
+}
+
+bool CompoundDictionary::lookup(std::string_view name, Entry& out) const {
+    thread_local std::string key;
+    normalize(name, key);
+    std::uint32_t index = 0;
+    bool exact = false;
+    if (key.empty() || !descend(key, index, exact) || !exact) return false;
+    const Node n = node(index);
+    if (!(n.flags & HAS_ENTRY)) return false;
+    out = entry(n.entryBegin);
+    return true;
+}
+
+size_t CompoundDictionary::complete(std::string_view prefix, size_t k, std::vector<Entry>& out) const {
+    out.clear();
+    thread_local std::string key;
+    normalize(prefix, key);
+    std::uint32_t start = 0;
+    bool exact = false;
+    if (k == 0 || entryCount == 0 || !descend(key, start, exact)) return 0;
+
+    // Best-first: an item's key never beats its parent's, so entries leave the queue in output order
+    struct Item {
+        std::uint32_t score;
+        std::uint32_t entry; // Smallest entry index under the item, for name order among equal scores
+        bool isEntry;
+        std::uint32_t index;
+    };
+    auto later = [](const Item& a, const Item& b) {
+        if (a.score != b.score) return a.score < b.score;
+        if (a.entry != b.entry) return a.entry > b.entry;
+        return !a.isEntry && b.isEntry;
+    };
+    thread_local std::vector<Item> heap;
+    heap.clear();
+    const Node root = node(start);
+    heap.push_back({root.bestScore, root.entryBegin, false, start});
+    while (!heap.empty() && out.size() < k) {
+        std::pop_heap(heap.begin(), heap.end(), later);
+        const Item item = heap.back();
+        heap.pop_back();
+        if (item.isEntry) {
+            out.push_back(entry(item.index));
+            continue;
+        }
+        const Node n = node(item.index);
+        if (n.flags & HAS_ENTRY) {
+            heap.push_back({entry(n.entryBegin).score, n.entryBegin, true, n.entryBegin});
+            std::push_heap(heap.begin(), heap.end(), later);
+        }
+        for (std::uint32_t c = 0; c < n.childCount; ++c) {
+            const Node child = node(n.firstChild + c);
+            heap.push_back({child.bestScore, child.entryBegin, false, n.firstChild + c});
+            std::push_heap(heap.begin(), heap.end(), later);
+        }
+    }
+    return out.size();
+}
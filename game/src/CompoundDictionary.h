@@ -0,0 +1,99 @@
+#ifndef COMPOUNDDICTIONARY_H
+#define COMPOUNDDICTIONARY_H
+
+#include "MappedFile.h"
+#include <cstdint>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief CompoundDictionary - Common compound names to formulas, with autocomplete
+ * Maps names and synonyms in any language ("вода", "water", "нитробензол") to
+ * formulas. Matching ignores case (Latin and Cyrillic), treats "ё" as "е" and
+ * collapses runs of whitespace.
+ *
+ * The dictionary is one flat, position-independent image. It holds a radix
+ * trie over the normalized UTF-8 names: fixed-size node records whose children
+ * are contiguous and ordered by their first byte. Each node also stores the
+ * best score in its subtree, so a top-k completion is a best-first search that
+ * visits only the branches that can still contribute. The image can be used
+ * straight from a memory-mapped file, with nothing to parse or allocate, or
+ * from a buffer in memory. Numbers are little-endian.
+ */
+class CompoundDictionary {
+public:
+    struct Entry {
+        std::string_view name;    // As given to the builder
+        std::string_view formula;
+        std::uint32_t score = 0;  // Higher first in completions
+    };
+
+    class Builder {
+    public:
+        // Empty names are ignored; for a repeated name the higher score wins
+        void add(std::string_view name, std::string_view formula, std::uint32_t score = 0);
+
+        // Lines "name<TAB>formula[<TAB>score]"; blank lines and '#' comments are skipped.
+        // Throws std::invalid_argument("Line N: ...") for a malformed line.
+        void load(std::istream& in);
+
+        size_t size() const { return names.size(); }
+
+        std::vector<char> build() const;
+
+    private:
+        std::vector<std::string> names;
+        std::vector<std::string> formulas;
+        std::vector<std::uint32_t> scores;
+    };
+
+    CompoundDictionary(); // Empty
+    // Takes ownership of an image from Builder::build(); throws std::invalid_argument if it is malformed
+    explicit CompoundDictionary(std::vector<char> image);
+
+    // Maps an image file written by save(); throws std::invalid_argument if unreadable or malformed
+    static CompoundDictionary open(const std::string& path);
+    static void save(const std::vector<char>& image, const std::string& path);
+
+    // Common names of the compounds used in the game (Russian and English)
+    static CompoundDictionary builtIn();
+
+    // Exact (normalized) name
+    bool lookup(std::string_view name, Entry& out) const;
+
+    // Up to k entries whose normalized name starts with prefix: highest score first, then by name.
+    // Reuses out's storage; returns the number found.
+    size_t complete(std::string_view prefix, size_t k, std::vector<Entry>& out) const;
+
+    size_t size() const { return entryCount; }
+    size_t imageBytes() const { return bytes; }
+
+    // Lower case (Latin and Cyrillic), "ё" -> "е", whitespace runs -> one space, trimmed
+    static void normalize(std::string_view text, std::string& out);
+
+private:
+    struct Node;
+
+    std::vector<char> owned;
+    MappedFile mapped;
+    const char* base = nullptr;
+    size_t bytes = 0;
+    std::uint32_t nodeCount = 0;
+    std::uint32_t entryCount = 0;
+    const char* nodes = nullptr;
+    const char* entries = nullptr;
+    const char* labels = nullptr;
+    const char* strings = nullptr;
+    std::uint32_t labelBytes = 0;
+    std::uint32_t stringBytes = 0;
+
+    void attach(const char* data, size_t size);
+    Node node(std::uint32_t index) const;
+    Entry entry(std::uint32_t index) const;
+    // Deepest node whose path covers key; false if no name starts with key
+    bool descend(std::string_view key, std::uint32_t& index, bool& exact) const;
+};
+
+#endif // COMPOUNDDICTIONARY_H
@@ -0,0 +1,332 @@
+#include "ContentPack.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <numeric>
+#include <stdexcept>
+#include <utility>
+
+/*
+ * Image layout (all fields little-endian):
+ *   Header   magic "BBP1", version, taskCount, dialogCount, indexCount, stringBytes (u32 each),
+ *            body checksum, header checksum (u64 each, FNV-1a)
+ *   Tasks    taskCount x 80 bytes, in level order: level, type, reactantCoeff, productCoeff (u32),
+ *            tolerance, inputMoles (f64), description, question, answer, formula1, formula2
+ *            (offset and length, u32 each), checksum (u64)
+ *   Dialogs  dialogCount x 40 bytes, in level order: level, character (u32), text, correct,
+ *            incorrect (offset and length), checksum (u64)
+ *   Index    indexCount x 12 bytes, ascending: level, task, dialog (u32, NONE if the level has none)
+ *   Strings  UTF-8 text, each distinct string once
+ *
+ * Tasks cover levels 1..taskCount without gaps, so index entry level - 1 belongs to any level
+ * up to taskCount; only levels with just a dialog need a search.
+ */
+
+namespace {
+
+constexpr char MAGIC[4] = {'B', 'B', 'P', '1'};
+constexpr std::uint32_t VERSION = 1;
+constexpr size_t HEADER_BYTES = 40;
+constexpr size_t HEADER_CHECKED_BYTES = 32; // Everything before the header checksum
+constexpr size_t TASK_BYTES = 80;
+constexpr size_t TASK_STRINGS_AT = 32;
+constexpr int TASK_STRING_COUNT = 5;
+constexpr size_t DIALOG_BYTES = 40;
+constexpr size_t DIALOG_STRINGS_AT = 8;
+constexpr int DIALOG_STRING_COUNT = 3;
+constexpr size_t INDEX_BYTES = 12;
+constexpr std::uint32_t NONE = 0xFFFFFFFFu;
+
+constexpr std::uint64_t FNV_OFFSET = 14695981039346656037ull;
+constexpr std::uint64_t FNV_PRIME = 1099511628211ull;
+
+template <typename T>
+T load(const char* at) {
+    T value;
+    std::memcpy(&value, at, sizeof(T));
+    return value;
+}
+
+template <typename T>
+void store(std::vector<char>& out, T value) {
+    char raw[sizeof(T)];
+    std::memcpy(raw, &value, sizeof(T));
+    out.insert(out.end(), raw, raw + sizeof(T));
+}
+
+template <typename T>
+void storeAt(char* at, T value) {
+    std::memcpy(at, &value, sizeof(T));
+}
+
+std::uint64_t fnv1a(const char* data, size_t size, std::uint64_t hash = FNV_OFFSET) {
+    for (size_t i = 0; i < size; ++i) {
+        hash = (hash ^ static_cast<unsigned char>(data[i])) * FNV_PRIME;
+    }
+    return hash;
+}
+
+// Over the record up to its checksum and then its strings; the references must be in bounds
+std::uint64_t recordChecksum(const char* record, size_t recordBytes, size_t stringsAt, int stringCount,
+                             const char* strings) {
+    std::uint64_t hash = fnv1a(record, recordBytes - sizeof(std::uint64_t));
+    for (int i = 0; i < stringCount; ++i) {
+        const char* ref = record + stringsAt + 8 * static_cast<size_t>(i);
+        hash = fnv1a(strings + load<std::uint32_t>(ref), load<std::uint32_t>(ref + 4), hash);
+    }
+    return hash;
+}
+
+// Record positions ordered by their level (the first field); throws on a repeated level
+std::vector<std::uint32_t> levelOrder(const std::vector<char>& records, size_t recordBytes, const char* what) {
+    std::vector<std::uint32_t> order(records.size() / recordBytes);
+    std::iota(order.begin(), order.end(), 0u);
+    auto level = [&records, recordBytes](std::uint32_t i) {
+        return load<std::uint32_t>(records.data() + i * recordBytes);
+    };
+    std::stable_sort(order.begin(), order.end(),
+                     [&level](std::uint32_t a, std::uint32_t b) { return level(a) < level(b); });
+    for (size_t i = 1; i < order.size(); ++i) {
+        if (level(order[i]) == level(order[i - 1])) {
+            throw std::invalid_argument(std::string("Second ") + what + " for level " +
+                                        std::to_string(level(order[i])));
+        }
+    }
+    return order;
+}
+
+} // namespace
+
+void ContentPack::Builder::addString(std::vector<char>& record, std::string_view text) {
+    auto found = stringOffsets.find(std::string(text));
+    std::uint32_t offset;
+    if (found != stringOffsets.end()) {
+        offset = found->second;
+    } else {
+        if (strings.size() + text.size() > NONE) {
+            throw std::invalid_argument("Content pack strings exceed 4 GiB");
+        }
+        offset = static_cast<std::uint32_t>(strings.size());
+        strings += text;
+        stringOffsets.emplace(std::string(text), offset);
+    }
+    store(record, offset);
+    store(record, static_cast<std::uint32_t>(text.size()));
+}
+
+void ContentPack::Builder::addTask(const TaskView& task) {
+    if (task.level < 1) {
+        throw std::invalid_argument("Task level must be positive");
+    }
+    const size_t at = taskRecords.size();
+    store(taskRecords, task.level);
+    store(taskRecords, task.type);
+    store(taskRecords, task.reactantCoeff);
+    store(taskRecords, task.productCoeff);
+    store(taskRecords, task.tolerance);
+    store(taskRecords, task.inputMoles);
+    for (std::string_view text : {task.description, task.question, task.answer, task.formula1, task.formula2}) {
+        addString(taskRecords, text);
+    }
+    store(taskRecords, std::uint64_t{0});
+    const std::uint64_t checksum =
+        recordChecksum(taskRecords.data() + at, TASK_BYTES, TASK_STRINGS_AT, TASK_STRING_COUNT, strings.data());
+    storeAt(taskRecords.data() + at + TASK_BYTES - sizeof(checksum), checksum);
+}
+
+void ContentPack::Builder::addDialog(const DialogView& dialog) {
+    if (dialog.level < 1) {
+        throw std::invalid_argument("Dialog level must be positive");
+    }
+    const size_t at = dialogRecords.size();
+    store(dialogRecords, dialog.level);
+    store(dialogRecords, dialog.character);
+    for (std::string_view text : {dialog.text, dialog.correctResponse, dialog.incorrectResponse}) {
+        addString(dialogRecords, text);
+    }
+    store(dialogRecords, std::uint64_t{0});
+    const std::uint64_t checksum = recordChecksum(dialogRecords.data() + at, DIALOG_BYTES, DIALOG_STRINGS_AT,
+                                                  DIALOG_STRING_COUNT, strings.data());
+    storeAt(dialogRecords.data() + at + DIALOG_BYTES - sizeof(checksum), checksum);
+}
+
+std::vector<char> ContentPack::Builder::build() const {
+    const std::vector<std::uint32_t> taskOrder = levelOrder(taskRecords, TASK_BYTES, "task");
+    const std::vector<std::uint32_t> dialogOrder = levelOrder(dialogRecords, DIALOG_BYTES, "dialog");
+    if (taskOrder.empty()) {
+        throw std::invalid_argument("Content pack has no tasks");
+    }
+    for (size_t i = 0; i < taskOrder.size(); ++i) {
+        if (load<std::uint32_t>(taskRecords.data() + taskOrder[i] * TASK_BYTES) != i + 1) {
+            throw std::invalid_argument("No task for level " + std::to_string(i + 1));
+        }
+    }
+
+    std::vector<char> body;
+    body.reserve(taskRecords.size() + dialogRecords.size() + (taskOrder.size() + dialogOrder.size()) * INDEX_BYTES +
+                 strings.size());
+    for (std::uint32_t i : taskOrder) {
+        body.insert(body.end(), taskRecords.begin() + i * TASK_BYTES, taskRecords.begin() + (i + 1) * TASK_BYTES);
+    }
+    for (std::uint32_t i : dialogOrder) {
+        body.insert(body.end(), dialogRecords.begin() + i * DIALOG_BYTES,
+                    dialogRecords.begin() + (i + 1) * DIALOG_BYTES);
+    }
+
+    // Merge the two level-ordered lists into the index
+    std::uint32_t indexCount = 0;
+    std::uint32_t t = 0, d = 0;
+    const auto taskCount = static_cast<std::uint32_t>(taskOrder.size());
+    const auto dialogCount = static_cast<std::uint32_t>(dialogOrder.size());
+    while (t < taskCount || d < dialogCount) {
+        const std::uint32_t taskLevel = t < taskCount ? t + 1 : NONE;
+        const std::uint32_t dialogLevel =
+            d < dialogCount ? load<std::uint32_t>(dialogRecords.data() + dialogOrder[d] * DIALOG_BYTES) : NONE;
+        const std::uint32_t level = std::min(taskLevel, dialogLevel);
+        store(body, level);
+        store(body, taskLevel == level ? t++ : NONE);
+        store(body, dialogLevel == level ? d++ : NONE);
+        indexCount++;
+    }
+    body.insert(body.end(), strings.begin(), strings.end());
+
+    std::vector<char> image(MAGIC, MAGIC + 4);
+    image.reserve(HEADER_BYTES + body.size());
+    store(image, VERSION);
+    store(image, taskCount);
+    store(image, dialogCount);
+    store(image, indexCount);
+    store(image, static_cast<std::uint32_t>(strings.size()));
+    store(image, fnv1a(body.data(), body.size()));
+    store(image, fnv1a(image.data(), HEADER_CHECKED_BYTES));
+    image.insert(image.end(), body.begin(), body.end());
+    return image;
+}
+
+ContentPack::ContentPack(std::vector<char> image) : owned(std::move(image)) {
+    attach(owned.data(), owned.size());
+}
+
+ContentPack ContentPack::open(const std::string& path) {
+    ContentPack pack;
+    pack.mapped = MappedFile(path);
+    pack.attach(pack.mapped.data(), pack.mapped.size());
+    return pack;
+}
+
+void ContentPack::save(const std::vector<char>& image, const std::string& path) {
+    std::ofstream out(path, std::ios::binary);
+    out.write(image.data(), static_cast<std::streamsize>(image.size()));
+    if (!out) {
+        throw std::invalid_argument("Cannot write " + path);
+    }
+}
+
+void ContentPack::attach(const char* data, size_t size) {
+    if (size < HEADER_BYTES || std::memcmp(data, MAGIC, 4) != 0 || load<std::uint32_t>(data + 4) != VERSION) {
+        throw std::invalid_argument("Not a content pack");
+    }
+    if (fnv1a(data, HEADER_CHECKED_BYTES) != load<std::uint64_t>(data + HEADER_CHECKED_BYTES)) {
+        throw std::invalid_argument("Content pack header is corrupt");
+    }
+    taskTotal = load<std::uint32_t>(data + 8);
+    dialogTotal = load<std::uint32_t>(data + 12);
+    indexCount = load<std::uint32_t>(data + 16);
+    stringBytes = load<std::uint32_t>(data + 20);
+    const std::uint64_t expected = HEADER_BYTES + std::uint64_t{taskTotal} * TASK_BYTES +
+                                   std::uint64_t{dialogTotal} * DIALOG_BYTES + std::uint64_t{indexCount} * INDEX_BYTES +
+                                   stringBytes;
+    if (taskTotal == 0 || indexCount < taskTotal || indexCount > std::uint64_t{taskTotal} + dialogTotal ||
+        expected != size) {
+        throw std::invalid_argument("Content pack is truncated or has the wrong size");
+    }
+    base = data;
+    bytes = size;
+    tasks = data + HEADER_BYTES;
+    dialogs = tasks + size_t{taskTotal} * TASK_BYTES;
+    index = dialogs + size_t{dialogTotal} * DIALOG_BYTES;
+    strings = index + size_t{indexCount} * INDEX_BYTES;
+}
+
+bool ContentPack::verify() const {
+    return base != nullptr &&
+           fnv1a(base + HEADER_BYTES, bytes - HEADER_BYTES) == load<std::uint64_t>(base + 24);
+}
+
+int ContentPack::levelAt(size_t position) const {
+    return static_cast<int>(load<std::uint32_t>(index + position * INDEX_BYTES));
+}
+
+std::uint32_t ContentPack::find(int level) const {
+    if (level < 1) return indexCount;
+    const auto wanted = static_cast<std::uint32_t>(level);
+    if (wanted <= taskTotal) {
+        return load<std::uint32_t>(index + (wanted - 1) * INDEX_BYTES) == wanted ? wanted - 1 : indexCount;
+    }
+    // Levels with only a dialog follow the task levels
+    std::uint32_t lo = taskTotal, hi = indexCount;
+    while (lo < hi) {
+        const std::uint32_t mid = lo + (hi - lo) / 2;
+        if (load<std::uint32_t>(index + mid * INDEX_BYTES) < wanted) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return lo < indexCount && load<std::uint32_t>(index + lo * INDEX_BYTES) == wanted ? lo : indexCount;
+}
+
+bool ContentPack::readString(const char* at, std::string_view& out) const {
+    const std::uint32_t offset = load<std::uint32_t>(at);
+    const std::uint32_t length = load<std::uint32_t>(at + 4);
+    if (offset > stringBytes || length > stringBytes - offset) return false;
+    out = std::string_view(strings + offset, length);
+    return true;
+}
+
+bool ContentPack::task(int level, TaskView& out) const {
+    const std::uint32_t position = find(level);
+    if (position == indexCount) return false;
+    const std::uint32_t record = load<std::uint32_t>(index + size_t{position} * INDEX_BYTES + 4);
+    if (record >= taskTotal) return false;
+
+    const char* at = tasks + size_t{record} * TASK_BYTES;
+    std::string_view* texts[TASK_STRING_COUNT] = {&out.description, &out.question, &out.answer, &out.formula1,
+                                                  &out.formula2};
+    for (int i = 0; i < TASK_STRING_COUNT; ++i) {
+        if (!readString(at + TASK_STRINGS_AT + 8 * static_cast<size_t>(i), *texts[i])) return false;
+    }
+    if (load<std::uint32_t>(at) != static_cast<std::uint32_t>(level) ||
+        recordChecksum(at, TASK_BYTES, TASK_STRINGS_AT, TASK_STRING_COUNT, strings) !=
+            load<std::uint64_t>(at + TASK_BYTES - 8)) {
+        return false;
+    }
+    out.level = load<std::uint32_t>(at);
+    out.type = load<std::uint32_t>(at + 4);
+    out.reactantCoeff = load<std::uint32_t>(at + 8);
+    out.productCoeff = load<std::uint32_t>(at + 12);
+    out.tolerance = load<double>(at + 16);
+    out.inputMoles = load<double>(at + 24);
+    return true;
+}
+
+bool ContentPack::dialog(int level, DialogView& out) const {
+    const std::uint32_t position = find(level);
+    if (position == indexCount) return false;
+    const std::uint32_t record = load<std::uint32_t>(index + size_t{position} * INDEX_BYTES + 8);
+    if (record >= dialogTotal) return false;
+
+    const char* at = dialogs + size_t{record} * DIALOG_BYTES;
+    std::string_view* texts[DIALOG_STRING_COUNT] = {&out.text, &out.correctResponse, &out.incorrectResponse};
+    for (int i = 0; i < DIALOG_STRING_COUNT; ++i) {
+        if (!readString(at + DIALOG_STRINGS_AT + 8 * static_cast<size_t>(i), *texts[i])) return false;
+    }
+    if (load<std::uint32_t>(at) != static_cast<std::uint32_t>(level) ||
+        recordChecksum(at, DIALOG_BYTES, DIALOG_STRINGS_AT, DIALOG_STRING_COUNT, strings) !=
+            load<std::uint64_t>(at + DIALOG_BYTES - 8)) {
+        return false;
+    }
+    out.level = load<std::uint32_t>(at);
+    out.character = load<std::uint32_t>(at + 4);
+    return true;
+}
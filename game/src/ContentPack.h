@@ -0,0 +1,112 @@
+#ifndef CONTENTPACK_H
+#define CONTENTPACK_H
+
+#include "MappedFile.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief ContentPack - Precompiled levels: tasks and dialogs in a binary image
+ * The offline form of a JSON content pack. One flat, position-independent
+ * image holds fixed-width task and dialog records, a level index sorted by
+ * level and a string table (repeated texts are stored once). Records refer to
+ * their strings by offset and length, so a memory-mapped pack is served as it
+ * is: nothing is parsed or allocated, and opening it costs the same for five
+ * levels or a hundred thousand.
+ *
+ * Opening checks only the header (with its own checksum) and the section
+ * sizes. Each record carries a checksum over its fields and its strings that
+ * is checked whenever the record is read, so a damaged record reads as
+ * missing instead of as wrong content. verify() checks the checksum of the
+ * whole body, for tools that can afford to read everything. Numbers are
+ * little-endian.
+ */
+class ContentPack {
+public:
+    struct TaskView {
+        std::uint32_t level = 0;
+        std::uint32_t type = 0; // DialogSystem::TaskType
+        double tolerance = 0.0;
+        double inputMoles = 0.0;
+        std::uint32_t reactantCoeff = 1;
+        std::uint32_t productCoeff = 1;
+        std::string_view description;
+        std::string_view question;
+        std::string_view answer;
+        std::string_view formula1;
+        std::string_view formula2;
+    };
+
+    struct DialogView {
+        std::uint32_t level = 0;
+        std::uint32_t character = 0; // DialogSystem::Character
+        std::string_view text;
+        std::string_view correctResponse;
+        std::string_view incorrectResponse;
+    };
+
+    class Builder {
+    public:
+        void addTask(const TaskView& task);
+        void addDialog(const DialogView& dialog);
+
+        // Throws std::invalid_argument unless task levels run 1, 2, 3, ... and dialog levels do not repeat
+        std::vector<char> build() const;
+
+    private:
+        std::vector<char> taskRecords; // Encoded, in the order added
+        std::vector<char> dialogRecords;
+        std::string strings;
+        std::unordered_map<std::string, std::uint32_t> stringOffsets;
+
+        void addString(std::vector<char>& record, std::string_view text);
+    };
+
+    ContentPack() = default; // Empty
+    // Takes ownership of an image from Builder::build(); throws std::invalid_argument if it is malformed
+    explicit ContentPack(std::vector<char> image);
+
+    // Maps a pack written by save(); throws std::invalid_argument if unreadable or malformed
+    static ContentPack open(const std::string& path);
+    static void save(const std::vector<char>& image, const std::string& path);
+
+    // False if the level has no task (or dialog) or its record is damaged
+    bool task(int level, TaskView& out) const;
+    bool dialog(int level, DialogView& out) const;
+
+    // Levels with a task or a dialog, ascending: levelAt(i) for i < levelCount()
+    size_t levelCount() const { return indexCount; }
+    int levelAt(size_t index) const;
+
+    size_t taskCount() const { return taskTotal; }
+    size_t dialogCount() const { return dialogTotal; }
+    size_t imageBytes() const { return bytes; }
+    bool empty() const { return taskTotal == 0; }
+
+    // Reads the whole image: true if the body checksum matches
+    bool verify() const;
+
+private:
+    std::vector<char> owned;
+    MappedFile mapped;
+    const char* base = nullptr;
+    size_t bytes = 0;
+    std::uint32_t taskTotal = 0;
+    std::uint32_t dialogTotal = 0;
+    std::uint32_t indexCount = 0;
+    std::uint32_t stringBytes = 0;
+    const char* tasks = nullptr;
+    const char* dialogs = nullptr;
+    const char* index = nullptr;
+    const char* strings = nullptr;
+
+    void attach(const char* data, size_t size);
+    // Position of level in the index, or indexCount
+    std::uint32_t find(int level) const;
+    bool readString(const char* at, std::string_view& out) const;
+};
+
+#endif // CONTENTPACK_H
@@ -1,13 +1,259 @@
 #include "DialogSystem.h"
 #include "ChemistryEngine.h"
+#include "PeriodicTable.h"
+#include "FormulaCache.h"
+#include "JsonReader.h"
+#include "MappedFile.h"
 #include <sstream>
 #include <iomanip>
 #include <cmath>
 #include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstdlib>
+#include <limits>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+
+bool isSpace(char c) { return std::isspace(static_cast<unsigned char>(c)) != 0; }
+
+char lower(char c) { return static_cast<char>(std::tolower(static_cast<unsigned char>(c))); }
+
+// Compares without building cleaned copies of either string
+bool sameIgnoringSpaceAndCase(std::string_view a, std::string_view b) {
+    size_t i = 0, j = 0;
+    while (true) {
+        while (i < a.size() && isSpace(a[i])) ++i;
+        while (j < b.size() && isSpace(b[j])) ++j;
+        if (i == a.size() || j == b.size()) {
+            return i == a.size() && j == b.size();
+        }
+        if (lower(a[i++]) != lower(b[j++])) {
+            return false;
+        }
+    }
+}
+
+// Leading number of text, like std::stod but without exceptions
+bool parseNumber(const std::string& text, double& out) {
+    const char* begin = text.c_str();
+    char* end = nullptr;
+    errno = 0;
+    out = std::strtod(begin, &end);
+    return end != begin && errno != ERANGE;
+}
+
+using Character = DialogSystem::Character;
+using TaskType = DialogSystem::TaskType;
+
+// Names used in content packs, matched ignoring case
+const std::pair<const char*, Character> CHARACTER_NAMES[] = {
+    {"walter", Character::WALTER}, {"jesse", Character::JESSE}, {"mike", Character::MIKE},
+    {"gus", Character::GUS},       {"gale", Character::GALE},   {"saul", Character::SAUL},
+};
+
+const std::pair<const char*, TaskType> TASK_TYPE_NAMES[] = {
+    {"molar_mass", TaskType::MOLAR_MASS},
+    {"moles_conversion", TaskType::MOLES_CONVERSION},
+    {"equation_balance", TaskType::EQUATION_BALANCE},
+    {"stoichiometry", TaskType::STOICHIOMETRY},
+    {"formula_parse", TaskType::FORMULA_PARSE},
+};
+
+template <typename Enum, size_t N>
+bool readName(JsonReader& reader, const std::pair<const char*, Enum> (&names)[N], const char* what, Enum& out) {
+    const size_t offset = reader.position();
+    std::string_view name;
+    if (!reader.readString(name)) return false;
+    for (const auto& entry : names) {
+        if (sameIgnoringSpaceAndCase(name, entry.first)) {
+            out = entry.second;
+            return true;
+        }
+    }
+    return reader.failAt(offset, std::string("Unknown ") + what + " \"" + std::string(name) + "\"");
+}
+
+// Copies a string value out of the reader's view
+bool readText(JsonReader& reader, std::string& out) {
+    std::string_view view;
+    if (!reader.readString(view)) return false;
+    out.assign(view.data(), view.size());
+    return true;
+}
+
+bool readPositiveInt(JsonReader& reader, const char* what, int& out) {
+    const size_t offset = reader.position();
+    std::int64_t value = 0;
+    if (!reader.readInteger(value)) return false;
+    if (value < 1 || value > std::numeric_limits<int>::max()) {
+        return reader.failAt(offset, std::string(what) + " must be a positive integer");
+    }
+    out = static_cast<int>(value);
+    return true;
+}
+
+// Finite and not negative: a negative or NaN tolerance would reject every numeric answer
+bool readTolerance(JsonReader& reader, double& out) {
+    const size_t offset = reader.position();
+    double value = 0.0;
+    if (!reader.readNumber(value)) return false;
+    if (!std::isfinite(value) || value < 0.0) {
+        return reader.failAt(offset, "Tolerance must be a non-negative number");
+    }
+    out = value;
+    return true;
+}
+
+bool readDialog(JsonReader& reader, std::map<int, DialogSystem::Dialog>& dialogs) {
+    const size_t offset = reader.position();
+    DialogSystem::Dialog dialog;
+    int level = 0;
+    std::string_view key;
+    if (!reader.beginObject()) return false;
+    while (reader.nextKey(key)) {
+        bool ok;
+        if (key == "level") ok = readPositiveInt(reader, "Level", level);
+        else if (key == "character") ok = readName(reader, CHARACTER_NAMES, "character", dialog.character);
+        else if (key == "text") ok = readText(reader, dialog.text);
+        else if (key == "correct") ok = readText(reader, dialog.correctResponse);
+        else if (key == "incorrect") ok = readText(reader, dialog.incorrectResponse);
+        else ok = reader.skipValue();
+        if (!ok) return false;
+    }
+    if (reader.failed()) return false;
+    if (level == 0) return reader.failAt(offset, "Dialog without \"level\"");
+    if (!dialogs.emplace(level, std::move(dialog)).second) {
+        return reader.failAt(offset, "Second dialog for level " + std::to_string(level));
+    }
+    return true;
+}
+
+// Fills in the answer of a task that does not give one, as initializeDefaultTasks does
+void computeAnswer(DialogSystem::Task& task, const std::string& equation) {
+    switch (task.type) {
+        case TaskType::MOLAR_MASS:
+            task.answer = std::to_string(ChemistryEngine::cachedMolarMass(task.formula1));
+            break;
+        case TaskType::MOLES_CONVERSION:
+            task.answer = std::to_string(ChemistryEngine::molesToGrams(task.inputMoles, task.formula1).value());
+            break;
+        case TaskType::EQUATION_BALANCE: {
+            if (equation.empty()) throw std::invalid_argument("needs \"answer\" or \"equation\"");
+            ChemistryEngine::ChemicalEquation parsed = ChemistryEngine::parseEquation(equation);
+            if (!ChemistryEngine::balanceEquation(parsed)) {
+                throw std::invalid_argument("equation \"" + equation + "\" has no unique balance");
+            }
+            task.answer = parsed.coefficientsToString();
+            break;
+        }
+        case TaskType::STOICHIOMETRY:
+            task.answer = std::to_string(ChemistryEngine::calculateProductYield(task.formula1, task.inputMoles,
+                                                                                task.formula2, task.reactantCoeff,
+                                                                                task.productCoeff).value());
+            break;
+        default:
+            throw std::invalid_argument("needs \"answer\"");
+    }
+}
+
+bool readTask(JsonReader& reader, std::vector<DialogSystem::Task>& tasks, std::vector<size_t>& offsets) {
+    const size_t offset = reader.position();
+    DialogSystem::Task task;
+    std::string equation;
+    bool hasType = false, hasAnswer = false;
+    std::string_view key;
+    if (!reader.beginObject()) return false;
+    while (reader.nextKey(key)) {
+        bool ok;
+        if (key == "level") {
+            ok = readPositiveInt(reader, "Level", task.level);
+        } else if (key == "type") {
+            ok = hasType = readName(reader, TASK_TYPE_NAMES, "task type", task.type);
+        } else if (key == "description") {
+            ok = readText(reader, task.description);
+        } else if (key == "question") {
+            ok = readText(reader, task.question);
+        } else if (key == "answer") {
+            // A number keeps its text as written, so "18.015" stays "18.015"
+            std::string_view answer;
+            ok = reader.peek() == JsonReader::Kind::NUMBER ? reader.readNumberText(answer) : reader.readString(answer);
+            task.answer.assign(answer.data(), answer.size());
+            hasAnswer = ok;
+        } else if (key == "tolerance") {
+            ok = readTolerance(reader, task.tolerance);
+        } else if (key == "formula1") {
+            ok = readText(reader, task.formula1);
+        } else if (key == "formula2") {
+            ok = readText(reader, task.formula2);
+        } else if (key == "equation") {
+            ok = readText(reader, equation);
+        } else if (key == "inputMoles") {
+            double moles = 0.0;
+            ok = reader.readNumber(moles);
+            task.inputMoles = units::Moles(moles);
+        } else if (key == "reactantCoeff") {
+            ok = readPositiveInt(reader, "reactantCoeff", task.reactantCoeff);
+        } else if (key == "productCoeff") {
+            ok = readPositiveInt(reader, "productCoeff", task.productCoeff);
+        } else {
+            ok = reader.skipValue();
+        }
+        if (!ok) return false;
+    }
+    if (reader.failed()) return false;
+    if (task.level == 0) return reader.failAt(offset, "Task without \"level\"");
+    if (!hasType) return reader.failAt(offset, "Task without \"type\"");
+    if (!hasAnswer) {
+        try {
+            computeAnswer(task, equation);
+        } catch (const std::invalid_argument& e) {
+            return reader.failAt(offset, "Task for level " + std::to_string(task.level) + ": " + e.what());
+        }
+    }
+    tasks.push_back(std::move(task));
+    offsets.push_back(offset);
+    return true;
+}
+
+// Levels in a pack keep the enum values; anything past the last one is treated as damage
+bool taskFromPack(const ContentPack& pack, int level, DialogSystem::Task& out) {
+    ContentPack::TaskView view;
+    if (!pack.task(level, view) || view.type > static_cast<std::uint32_t>(TaskType::FORMULA_PARSE)) {
+        return false;
+    }
+    out.level = static_cast<int>(view.level);
+    out.type = static_cast<TaskType>(view.type);
+    out.description.assign(view.description.data(), view.description.size());
+    out.question.assign(view.question.data(), view.question.size());
+    out.answer.assign(view.answer.data(), view.answer.size());
+    out.tolerance = view.tolerance;
+    out.formula1.assign(view.formula1.data(), view.formula1.size());
+    out.formula2.assign(view.formula2.data(), view.formula2.size());
+    out.inputMoles = units::Moles(view.inputMoles);
+    out.reactantCoeff = static_cast<int>(view.reactantCoeff);
+    out.productCoeff = static_cast<int>(view.productCoeff);
+    return true;
+}
+
+bool dialogFromPack(const ContentPack& pack, int level, DialogSystem::Dialog& out) {
+    ContentPack::DialogView view;
+    if (!pack.dialog(level, view) || view.character > static_cast<std::uint32_t>(Character::SAUL)) {
+        return false;
+    }
+    out = DialogSystem::Dialog(static_cast<Character>(view.character), std::string(view.text),
+                               std::string(view.correctResponse), std::string(view.incorrectResponse));
+    return true;
+}
+
+} // namespace
 
 DialogSystem::DialogSystem() {
     initializeDefaultDialogs();
     initializeDefaultTasks();
+    prewarmFormulaCache();
 }
 
 void DialogSystem::initializeDefaultDialogs() {
@@ -65,6 +311,8 @@ void DialogSystem::initializeDefaultDialogs() {
 }
 
 void DialogSystem::initializeDefaultTasks() {
+    using namespace units::literals;
+
     // Task 1: Molar mass of water (Jesse level)
     Task task1;
     task1.level = 1;
@@ -72,7 +320,8 @@ void DialogSystem::initializeDefaultTasks() {
     task1.description = "Calculate molar mass of water";
     task1.question = "What is the molar mass of H2O? (in g/mol)";
     task1.formula1 = "H2O";
-    task1.answer = std::to_string(ChemistryEngine::calculateMolarMass("H2O"));
+    constexpr double waterMolarMass = PeriodicTable::formulaMass("H2O");
+    task1.answer = std::to_string(waterMolarMass);
     task1.tolerance = 0.1;
     task1.dialog = dialogs[1];
     tasks.push_back(task1);
@@ -83,10 +332,9 @@ void DialogSystem::initializeDefaultTasks() {
     task2.type = TaskType::MOLES_CONVERSION;
     task2.description = "Convert moles to grams for methamphetamine HI salt";
     task2.question = "Calculate the mass in grams for 2 moles of C10H15N•HI";
-    task2.formula1 = "C10H15N"; // Simplified - treating as single compound
-    // For C10H15N•HI, we approximate: C10H15N (149.23) + HI (127.91) = 277.14 g/mol
-    task2.inputValue = 2.0;
-    task2.answer = "554.28"; // Approximate
+    task2.formula1 = "C10H15N•HI"; // The parser reads the adduct dot: C10H15N + HI
+    task2.inputMoles = 2.0_mol;
+    task2.answer = std::to_string(ChemistryEngine::molesToGrams(task2.inputMoles, task2.formula1).value());
     task2.tolerance = 5.0;
     task2.dialog = dialogs[2];
     tasks.push_back(task2);
@@ -97,7 +345,9 @@ void DialogSystem::initializeDefaultTasks() {
     task3.type = TaskType::EQUATION_BALANCE;
     task3.description = "Balance combustion of propane";
     task3.question = "Balance: C3H8 + O2 -> CO2 + H2O\nEnter coefficients separated by spaces (C3H8 O2 CO2 H2O):";
-    task3.answer = "1 5 3 4"; // C3H8 + 5O2 -> 3CO2 + 4H2O
+    ChemistryEngine::ChemicalEquation propane = ChemistryEngine::parseEquation("C3H8 + O2 -> CO2 + H2O");
+    ChemistryEngine::balanceEquation(propane);
+    task3.answer = propane.coefficientsToString(); // C3H8 + 5O2 -> 3CO2 + 4H2O
     task3.tolerance = 0.0;
     task3.dialog = dialogs[3];
     tasks.push_back(task3);
@@ -110,14 +360,14 @@ void DialogSystem::initializeDefaultTasks() {
     task4.question = "If we have 5 moles of C6H6, how many grams of C6H5NO2 will we get? (1:1 ratio)";
     task4.formula1 = "C6H6";
     task4.formula2 = "C6H5NO2";
-    task4.inputValue = 5.0;
+    task4.inputMoles = 5.0_mol;
     task4.reactantCoeff = 1;
     task4.productCoeff = 1;
-    double expectedGrams = ChemistryEngine::calculateProductYield(
-        task4.formula1, task4.inputValue, task4.formula2, 
+    units::Grams expectedGrams = ChemistryEngine::calculateProductYield(
+        task4.formula1, task4.inputMoles, task4.formula2, 
         task4.reactantCoeff, task4.productCoeff
     );
-    task4.answer = std::to_string(expectedGrams);
+    task4.answer = std::to_string(expectedGrams.value());
     task4.tolerance = 1.0;
     task4.dialog = dialogs[4];
     tasks.push_back(task4);
@@ -134,13 +384,160 @@ void DialogSystem::initializeDefaultTasks() {
     tasks.push_back(task5);
 }
 
+std::vector<std::string> DialogSystem::getTaskFormulas() const {
+    std::vector<std::string> formulas;
+    auto add = [&formulas](std::string_view formula) {
+        if (!formula.empty() && std::find(formulas.begin(), formulas.end(), formula) == formulas.end()) {
+            formulas.emplace_back(formula);
+        }
+    };
+    for (const auto& task : tasks) {
+        add(task.formula1);
+        add(task.formula2);
+    }
+    ContentPack::TaskView view;
+    for (int level = 1; level <= static_cast<int>(pack.taskCount()); ++level) {
+        if (pack.task(level, view)) {
+            add(view.formula1);
+            add(view.formula2);
+        }
+    }
+    return formulas;
+}
+
+void DialogSystem::prewarmFormulaCache() const {
+    FormulaCache::instance().prewarm(getTaskFormulas());
+}
+
 bool DialogSystem::loadFromJSON(const std::string& filename) {
-    // TODO: Implement JSON loading if needed
-    // For now, using default initialization
+    MappedFile file;
+    try {
+        file = MappedFile(filename);
+    } catch (const std::invalid_argument& e) {
+        loadError = e.what();
+        return false;
+    }
+
+    // Everything is read into new containers, which replace the current ones only at the end
+    JsonReader reader(std::string_view(file.data(), file.size()));
+    std::vector<Task> loadedTasks;
+    std::vector<size_t> offsets;
+    std::map<int, Dialog> loadedDialogs;
+    std::string_view key;
+    bool ok = reader.beginObject();
+    while (ok && reader.nextKey(key)) {
+        if (key == "dialogs" || key == "tasks") {
+            const bool isTasks = key == "tasks";
+            ok = reader.beginArray();
+            while (ok && reader.nextElement()) {
+                ok = isTasks ? readTask(reader, loadedTasks, offsets) : readDialog(reader, loadedDialogs);
+            }
+        } else {
+            ok = reader.skipValue();
+        }
+    }
+    ok = !reader.failed() && reader.finish();
+
+    // getTask(level) indexes by level: levels must run 1, 2, 3, ... with no gaps
+    if (ok && loadedTasks.empty()) {
+        ok = reader.failAt(0, "Content file has no tasks");
+    }
+    if (ok) {
+        std::vector<size_t> order(loadedTasks.size());
+        for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+        std::stable_sort(order.begin(), order.end(), [&loadedTasks](size_t a, size_t b) {
+            return loadedTasks[a].level < loadedTasks[b].level;
+        });
+        std::vector<Task> sorted;
+        sorted.reserve(loadedTasks.size());
+        for (size_t i = 0; i < order.size() && ok; ++i) {
+            Task& task = loadedTasks[order[i]];
+            if (task.level != static_cast<int>(i) + 1) {
+                ok = reader.failAt(offsets[order[i]], task.level == static_cast<int>(i)
+                                                          ? "Second task for level " + std::to_string(task.level)
+                                                          : "No task for level " + std::to_string(i + 1));
+                break;
+            }
+            auto dialog = loadedDialogs.find(task.level);
+            if (dialog != loadedDialogs.end()) task.dialog = dialog->second;
+            sorted.push_back(std::move(task));
+        }
+        loadedTasks.swap(sorted);
+    }
+    if (!ok) {
+        loadError = filename + ":" + reader.error().toString();
+        return false;
+    }
+
+    tasks.swap(loadedTasks);
+    dialogs.swap(loadedDialogs);
+    pack = ContentPack();
+    loadError.clear();
+    prewarmFormulaCache();
     return true;
 }
 
-Dialog DialogSystem::getDialog(int level) const {
+bool DialogSystem::loadFromPack(const std::string& filename) {
+    try {
+        pack = ContentPack::open(filename);
+    } catch (const std::invalid_argument& e) {
+        loadError = filename + ": " + e.what();
+        return false;
+    }
+    // Formulas are parsed into FormulaCache on first use: prewarming would read every record
+    tasks.clear();
+    tasks.shrink_to_fit();
+    dialogs.clear();
+    loadError.clear();
+    return true;
+}
+
+std::vector<char> DialogSystem::buildPack() const {
+    ContentPack::Builder builder;
+    auto addTask = [&builder](const Task& task) {
+        ContentPack::TaskView view;
+        view.level = static_cast<std::uint32_t>(task.level);
+        view.type = static_cast<std::uint32_t>(task.type);
+        view.tolerance = task.tolerance;
+        view.inputMoles = task.inputMoles.value();
+        view.reactantCoeff = static_cast<std::uint32_t>(task.reactantCoeff);
+        view.productCoeff = static_cast<std::uint32_t>(task.productCoeff);
+        view.description = task.description;
+        view.question = task.question;
+        view.answer = task.answer;
+        view.formula1 = task.formula1;
+        view.formula2 = task.formula2;
+        builder.addTask(view);
+    };
+    auto addDialog = [&builder](int level, const Dialog& dialog) {
+        ContentPack::DialogView view;
+        view.level = static_cast<std::uint32_t>(level);
+        view.character = static_cast<std::uint32_t>(dialog.character);
+        view.text = dialog.text;
+        view.correctResponse = dialog.correctResponse;
+        view.incorrectResponse = dialog.incorrectResponse;
+        builder.addDialog(view);
+    };
+
+    for (const auto& task : tasks) addTask(task);
+    for (const auto& entry : dialogs) addDialog(entry.first, entry.second);
+    // Tasks before dialogs, as above, so a pack rebuilt from itself comes out byte for byte the same
+    Task task;
+    Dialog dialog;
+    for (size_t i = 0; i < pack.levelCount(); ++i) {
+        if (taskFromPack(pack, pack.levelAt(i), task)) addTask(task);
+    }
+    for (size_t i = 0; i < pack.levelCount(); ++i) {
+        if (dialogFromPack(pack, pack.levelAt(i), dialog)) addDialog(pack.levelAt(i), dialog);
+    }
+    return builder.build();
+}
+
+DialogSystem::Dialog DialogSystem::getDialog(int level) const {
+    Dialog dialog;
+    if (!pack.empty() && dialogFromPack(pack, level, dialog)) {
+        return dialog;
+    }
     auto it = dialogs.find(level);
     if (it != dialogs.end()) {
         return it->second;
@@ -148,7 +545,14 @@ Dialog DialogSystem::getDialog(int level) const {
     return Dialog(Character::WALTER, "Continue...", "Correct!", "Try again.");
 }
 
-Task DialogSystem::getTask(int level) const {
+DialogSystem::Task DialogSystem::getTask(int level) const {
+    if (!pack.empty()) {
+        Task task;
+        if (taskFromPack(pack, level, task) || taskFromPack(pack, 1, task)) {
+            dialogFromPack(pack, task.level, task.dialog);
+        }
+        return task;
+    }
     if (level > 0 && level <= static_cast<int>(tasks.size())) {
         return tasks[level - 1];
     }
@@ -156,29 +560,16 @@ Task DialogSystem::getTask(int level) const {
 }
 
 bool DialogSystem::checkAnswer(const Task& task, const std::string& userAnswer) const {
-    std::string cleanUser = userAnswer;
-    std::string cleanAnswer = task.answer;
-    
-    // Remove spaces and convert to lowercase for comparison
-    cleanUser.erase(std::remove_if(cleanUser.begin(), cleanUser.end(), ::isspace), cleanUser.end());
-    cleanAnswer.erase(std::remove_if(cleanAnswer.begin(), cleanAnswer.end(), ::isspace), cleanAnswer.end());
-    
-    std::transform(cleanUser.begin(), cleanUser.end(), cleanUser.begin(), ::tolower);
-    std::transform(cleanAnswer.begin(), cleanAnswer.end(), cleanAnswer.begin(), ::tolower);
-    
-    if (task.tolerance == 0.0) {
-        // Exact match for string answers
-        return cleanUser == cleanAnswer;
-    } else {
-        // Try numeric comparison
-        try {
-            double userNum = std::stod(userAnswer);
-            double answerNum = std::stod(task.answer);
+    if (task.tolerance != 0.0) {
+        // Numeric comparison; both sides are read in place, as std::stod would read them
+        double userNum = 0.0;
+        double answerNum = 0.0;
+        if (parseNumber(userAnswer, userNum) && parseNumber(task.answer, answerNum)) {
             return std::abs(userNum - answerNum) <= task.tolerance;
-        } catch (...) {
-            return cleanUser == cleanAnswer;
         }
     }
+    // Exact match for string answers, ignoring spaces and case
+    return sameIgnoringSpaceAndCase(userAnswer, task.answer);
 }
 
 bool DialogSystem::checkAnswer(const Task& task, double userAnswer) const {
@@ -1,6 +1,8 @@
 #ifndef DIALOGSYSTEM_H
 #define DIALOGSYSTEM_H
 
+#include "ContentPack.h"
+#include "Quantity.h"
 #include <string>
 #include <vector>
 #include <map>
@@ -45,27 +47,39 @@ public:
     };
 
     struct Task {
-        int level;
-        TaskType type;
+        int level = 0;
+        TaskType type = TaskType::MOLAR_MASS;
         std::string description;
         std::string question;
-        std::string answer; // Expected answer (can be numeric or formula string)
-        double tolerance;   // For numeric answers
+        std::string answer;      // Expected answer (can be numeric or formula string)
+        double tolerance = 0.0;  // For numeric answers
         Dialog dialog;
         
         // Task-specific data
         std::string formula1;      // For molar mass, conversion tasks
         std::string formula2;      // For stoichiometry
-        double inputValue;         // Input moles/grams
-        int reactantCoeff;
-        int productCoeff;
+        units::Moles inputMoles;   // Given amount for conversion and stoichiometry tasks
+        int reactantCoeff = 1;
+        int productCoeff = 1;
     };
 
     DialogSystem();
     ~DialogSystem() = default;
 
-    // Load dialogs and tasks from JSON file
+    // Replaces dialogs and tasks with a JSON content pack (format in README). The file is
+    // memory-mapped and read in one pass. On failure nothing changes, and getLoadError()
+    // tells what is wrong and where: "pack.json:12:5: Expected ':'".
     bool loadFromJSON(const std::string& filename);
+    const std::string& getLoadError() const { return loadError; }
+
+    // Serves dialogs and tasks straight from a precompiled pack (see ContentPack), which stays
+    // mapped: opening checks only its header, so it takes the same time for any number of
+    // levels. A damaged record reads as a missing level. On failure nothing changes.
+    bool loadFromPack(const std::string& filename);
+
+    // The current dialogs and tasks as a pack image for ContentPack::save(); throws
+    // std::invalid_argument if a level cannot be read (a damaged pack)
+    std::vector<char> buildPack() const;
     
     // Get dialog by level
     Dialog getDialog(int level) const;
@@ -84,11 +98,19 @@ public:
     static std::string getCharacterGreeting(Character c);
     
     // Get all tasks count
-    int getTaskCount() const { return tasks.size(); }
+    int getTaskCount() const { return static_cast<int>(pack.empty() ? tasks.size() : pack.taskCount()); }
+    
+    // Formulas referenced by the task list (formula1/formula2, no duplicates)
+    std::vector<std::string> getTaskFormulas() const;
+    
+    // Parse every task formula into FormulaCache ahead of grading
+    void prewarmFormulaCache() const;
 
 private:
     std::vector<Task> tasks;
     std::map<int, Dialog> dialogs;
+    std::string loadError;
+    ContentPack pack; // Empty unless loaded by loadFromPack(); then tasks and dialogs are empty
     
     void initializeDefaultTasks(); // Initialize with default Breaking Bad themed tasks
     void initializeDefaultDialogs();
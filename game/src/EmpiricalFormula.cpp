@@ -0,0 +1,206 @@
+#include "EmpiricalFormula.h"
+#include "CanonicalFormula.h"
+#include "PeriodicTable.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+
+namespace {
+
+// Percents may add up to 100 +- this much before they are rejected rather than rescaled
+constexpr double SUM_SLACK = 5.0;
+
+// Score added per step of the smallest subscript, against over-fitting noise
+constexpr double SUBSCRIPT_PENALTY = 0.1;
+
+// Mole ratios this large (a trace element against a major one) are not formulas
+constexpr double MAX_COUNT = 1e6;
+
+std::int64_t gcdOf(std::int64_t a, std::int64_t b) {
+    while (b != 0) {
+        std::int64_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a;
+}
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+} // namespace
+
+std::vector<EmpiricalFormula::Candidate> EmpiricalFormula::solve(const Query& query, Status* status) {
+    std::vector<Candidate> candidates;
+    if (status) *status = Status::INVALID_QUERY;
+
+    const size_t n = query.composition.size();
+    if (n == 0 || query.tolerance <= 0.0 || query.maxSubscript < 1 || query.molarMass < 0.0 ||
+        query.massTolerance < 0.0) {
+        return candidates;
+    }
+
+    // Rescale to 100 percent
+    double total = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        const Component& component = query.composition[i];
+        const int z = component.atomicNumber;
+        if (z < 1 || z > PeriodicTable::ELEMENT_COUNT || PeriodicTable::atomicMass(z) <= 0.0 ||
+            !(component.percent > 0.0)) {
+            return candidates;
+        }
+        for (size_t j = 0; j < i; ++j) {
+            if (query.composition[j].atomicNumber == z) return candidates;
+        }
+        total += component.percent;
+    }
+    if (std::abs(total - 100.0) > SUM_SLACK) {
+        return candidates;
+    }
+
+    std::vector<double> percents(n), moles(n), masses(n);
+    for (size_t i = 0; i < n; ++i) {
+        percents[i] = query.composition[i].percent * 100.0 / total;
+        masses[i] = PeriodicTable::atomicMass(query.composition[i].atomicNumber);
+        moles[i] = percents[i] / masses[i];
+    }
+
+    std::vector<std::int64_t> counts(n);
+    for (size_t anchor = 0; anchor < n; ++anchor) {
+        for (int k = 1; k <= query.maxSubscript; ++k) {
+            // Nearest integers at the scale that gives the anchor k atoms; a common factor
+            // means a smaller k found the same formula already
+            const double scale = k / moles[anchor];
+            std::int64_t divisor = 0, fewest = 0;
+            bool fits = true;
+            for (size_t i = 0; i < n && fits; ++i) {
+                const double exact = scale * moles[i];
+                fits = exact <= MAX_COUNT;
+                counts[i] = i == anchor ? k : std::max<std::int64_t>(1, std::llround(exact));
+                divisor = gcdOf(counts[i], divisor);
+                fewest = i == 0 ? counts[i] : std::min(fewest, counts[i]);
+            }
+            if (!fits || divisor != 1) continue;
+
+            // Another anchor may have found it
+            bool seen = false;
+            for (size_t c = 0; c < candidates.size() && !seen; ++c) {
+                seen = true;
+                for (size_t i = 0; i < n && seen; ++i) {
+                    seen = candidates[c].empirical[query.composition[i].atomicNumber] == counts[i];
+                }
+            }
+            if (seen) continue;
+
+            double mass = 0.0;
+            for (size_t i = 0; i < n; ++i) mass += counts[i] * masses[i];
+            double percentError = 0.0;
+            for (size_t i = 0; i < n; ++i) {
+                percentError = std::max(percentError, std::abs(100.0 * counts[i] * masses[i] / mass - percents[i]));
+            }
+            if (percentError > query.tolerance) continue;
+
+            std::int64_t multiplier = 1;
+            double massError = 0.0;
+            if (query.molarMass > 0.0) {
+                multiplier = std::llround(query.molarMass / mass);
+                if (multiplier < 1 || multiplier > MAX_COUNT) continue;
+                massError = std::abs(multiplier * mass - query.molarMass) / query.molarMass;
+                if (massError > query.massTolerance) continue;
+            }
+
+            Candidate candidate;
+            for (size_t i = 0; i < n; ++i) {
+                candidate.empirical.add(query.composition[i].atomicNumber, counts[i]);
+            }
+            candidate.molecular.addScaled(candidate.empirical, multiplier);
+            candidate.empiricalFormula = CanonicalFormula::hill(candidate.empirical);
+            candidate.molecularFormula =
+                multiplier == 1 ? candidate.empiricalFormula : CanonicalFormula::hill(candidate.molecular);
+            candidate.multiplier = static_cast<int>(multiplier);
+            candidate.empiricalMass = mass;
+            candidate.molecularMass = mass * multiplier;
+            candidate.percentError = percentError;
+            candidate.massError = massError;
+
+            const double percentTerm = percentError / query.tolerance;
+            const double massTerm = query.massTolerance > 0.0 ? massError / query.massTolerance : 0.0;
+            candidate.score = percentTerm * percentTerm + massTerm * massTerm +
+                              SUBSCRIPT_PENALTY * static_cast<double>(fewest - 1);
+            candidates.push_back(std::move(candidate));
+        }
+    }
+
+    std::stable_sort(candidates.begin(), candidates.end(),
+                     [](const Candidate& a, const Candidate& b) { return a.score < b.score; });
+    if (candidates.size() > query.maxCandidates) {
+        candidates.resize(query.maxCandidates);
+    }
+    if (status) *status = candidates.empty() ? Status::NO_MATCH : Status::OK;
+    return candidates;
+}
+
+std::vector<EmpiricalFormula::Component> EmpiricalFormula::percentComposition(
+    const FormulaParser::ElementCounts& counts) {
+    std::vector<Component> composition;
+    const double mass = counts.molarMass();
+    if (mass <= 0.0) {
+        return composition;
+    }
+    counts.forEach([&composition, mass](int z, std::int64_t count) {
+        composition.push_back({z, 100.0 * count * PeriodicTable::atomicMass(z) / mass});
+    });
+    return composition;
+}
+
+bool EmpiricalFormula::parseComposition(std::string_view text, std::vector<Component>& out) {
+    out.clear();
+    size_t i = 0;
+    auto skip = [&text, &i](bool separators) {
+        while (i < text.size() && (isSpace(text[i]) || (separators && (text[i] == ',' || text[i] == ';')))) i++;
+    };
+
+    for (skip(true); i < text.size(); skip(true)) {
+        // Symbol: an uppercase letter and an optional lowercase one
+        if (text[i] < 'A' || text[i] > 'Z') return false;
+        const size_t start = i++;
+        if (i < text.size() && text[i] >= 'a' && text[i] <= 'z') i++;
+        const int z = PeriodicTable::atomicNumber(text.substr(start, i - start));
+        if (z == 0) return false;
+
+        skip(false);
+        if (i < text.size() && (text[i] == ':' || text[i] == '=')) i++;
+        skip(false);
+
+        // strtod needs a terminated string; percents are short
+        char number[32];
+        size_t length = 0;
+        while (i < text.size() && length + 1 < sizeof(number) &&
+               ((text[i] >= '0' && text[i] <= '9') || text[i] == '.' || text[i] == ',')) {
+            // A comma right before a space or the end separates components; otherwise it is a decimal comma
+            if (text[i] == ',' && (i + 1 == text.size() || text[i + 1] < '0' || text[i + 1] > '9')) break;
+            number[length++] = text[i] == ',' ? '.' : text[i];
+            i++;
+        }
+        number[length] = '\0';
+        char* end = nullptr;
+        const double percent = std::strtod(number, &end);
+        if (length == 0 || end != number + length) return false;
+
+        skip(false);
+        if (i < text.size() && text[i] == '%') i++;
+        out.push_back({z, percent});
+    }
+    return !out.empty();
+}
+
+const char* EmpiricalFormula::statusMessage(Status status) {
+    switch (status) {
+        case Status::OK: return "OK";
+        case Status::NO_MATCH: return "No formula matches the composition within the tolerance";
+        case Status::INVALID_QUERY: return "Invalid composition";
+        default: return "Unknown status";
+    }
+}
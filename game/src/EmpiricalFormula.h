@@ -0,0 +1,72 @@
+#ifndef EMPIRICALFORMULA_H
+#define EMPIRICALFORMULA_H
+
+#include "FormulaParser.h"
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief EmpiricalFormula - Formula from mass percent composition
+ * The inverse of percentComposition(): percents become moles per 100 g, and
+ * each element in turn anchors the search. Its subscript k runs from 1 to
+ * maxSubscript, the other subscripts are the nearest integers at the same
+ * scale, and a formula is kept when the percents it implies are all within
+ * the tolerance of the measured ones. Anchoring on every element matters when
+ * the scarcest one is also the least precise (one H in a heavy compound).
+ * With a molar mass, the molecular formula is the integer multiple of the
+ * empirical one closest to it.
+ *
+ * Candidates are ranked by their misfit (in units of the tolerance) plus a
+ * small penalty per step of the smallest subscript, so noisy data still gives
+ * CH2O rather than an over-fitted C7H15O7 unless the data really asks for it.
+ */
+class EmpiricalFormula {
+public:
+    struct Component {
+        int atomicNumber = 0;
+        double percent = 0.0; // Mass percent
+    };
+
+    struct Query {
+        std::vector<Component> composition; // Need not add up to exactly 100 (measurement noise)
+        double molarMass = 0.0;             // g/mol; 0 when unknown: empirical formula only
+        double tolerance = 0.5;             // Largest deviation of any mass percent, in percentage points
+        double massTolerance = 0.02;        // Relative molar mass error
+        int maxSubscript = 12;              // Largest subscript of the anchor element
+        size_t maxCandidates = 5;
+    };
+
+    struct Candidate {
+        FormulaParser::ElementCounts empirical;
+        FormulaParser::ElementCounts molecular; // empirical times multiplier
+        std::string empiricalFormula;           // Hill order
+        std::string molecularFormula;
+        int multiplier = 1;                     // 1 when no molar mass is given
+        double empiricalMass = 0.0;
+        double molecularMass = 0.0;
+        double percentError = 0.0; // Largest deviation from the measured percents, in percentage points
+        double massError = 0.0;    // Relative molar mass error, 0 without a molar mass
+        double score = 0.0;        // Lower ranks first
+    };
+
+    enum class Status {
+        OK,
+        NO_MATCH,     // No formula within the tolerances
+        INVALID_QUERY // No elements, an unknown or repeated element, a non-positive percent, or percents far from 100 in total
+    };
+
+    // Best candidate first, at most query.maxCandidates
+    static std::vector<Candidate> solve(const Query& query, Status* status = nullptr);
+
+    // Mass percent of each element, by atomic number (the input of a "find the formula" task)
+    static std::vector<Component> percentComposition(const FormulaParser::ElementCounts& counts);
+
+    // Reads "C 40.0, H 6.7, O 53.3" or "C: 40%; H: 6.7%; O: 53.3%" (out is cleared first)
+    static bool parseComposition(std::string_view text, std::vector<Component>& out);
+
+    static const char* statusMessage(Status status);
+};
+
+#endif // EMPIRICALFORMULA_H
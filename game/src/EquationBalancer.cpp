@@ -0,0 +1,495 @@
+#include "EquationBalancer.h"
+#include "BigInt.h"
+#include "CanonicalFormula.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#if defined(_MSC_VER) && defined(_M_X64)
+#include <intrin.h>
+#endif
+
+namespace {
+
+// Thrown by the 64-bit arithmetic below; caught to switch to BigInt
+struct Int64Overflow {};
+
+std::int64_t mulExact(std::int64_t a, std::int64_t b) {
+#if defined(__GNUC__) || defined(__clang__)
+    std::int64_t result;
+    if (__builtin_mul_overflow(a, b, &result)) throw Int64Overflow();
+    return result;
+#elif defined(_MSC_VER) && defined(_M_X64)
+    std::int64_t high;
+    std::int64_t low = _mul128(a, b, &high);
+    if (high != (low >> 63)) throw Int64Overflow();
+    return low;
+#else
+    if (a != 0 && b != 0) {
+        std::int64_t result = static_cast<std::int64_t>(static_cast<std::uint64_t>(a) * static_cast<std::uint64_t>(b));
+        if (result / b != a || (a == -1 && b == std::numeric_limits<std::int64_t>::min()) ||
+            (b == -1 && a == std::numeric_limits<std::int64_t>::min())) {
+            throw Int64Overflow();
+        }
+        return result;
+    }
+    return 0;
+#endif
+}
+
+std::int64_t subExact(std::int64_t a, std::int64_t b) {
+    if ((b > 0 && a < std::numeric_limits<std::int64_t>::min() + b) ||
+        (b < 0 && a > std::numeric_limits<std::int64_t>::max() + b)) {
+        throw Int64Overflow();
+    }
+    return a - b;
+}
+
+std::int64_t divExact(std::int64_t a, std::int64_t b) {
+    if (b == -1 && a == std::numeric_limits<std::int64_t>::min()) throw Int64Overflow();
+    return a / b;
+}
+
+std::int64_t absValue(std::int64_t a) {
+    if (a == std::numeric_limits<std::int64_t>::min()) throw Int64Overflow();
+    return a < 0 ? -a : a;
+}
+
+BigInt mulExact(const BigInt& a, const BigInt& b) { return a * b; }
+BigInt subExact(const BigInt& a, const BigInt& b) { return a - b; }
+BigInt divExact(const BigInt& a, const BigInt& b) { return a / b; }
+BigInt absValue(const BigInt& a) { return a.abs(); }
+bool isZero(std::int64_t a) { return a == 0; }
+bool isZero(const BigInt& a) { return a.isZero(); }
+int signOf(std::int64_t a) { return (a > 0) - (a < 0); }
+int signOf(const BigInt& a) { return a.sign(); }
+
+std::int64_t gcdOf(std::int64_t a, std::int64_t b) {
+    while (b != 0) {
+        std::int64_t r = a % b;
+        a = b;
+        b = r;
+    }
+    return a < 0 ? -a : a;
+}
+BigInt gcdOf(const BigInt& a, const BigInt& b) { return BigInt::gcd(a, b); }
+
+bool toInt64(std::int64_t value, std::int64_t& out) { out = value; return true; }
+bool toInt64(const BigInt& value, std::int64_t& out) {
+    if (!value.fitsInt64()) return false;
+    out = value.toInt64();
+    return true;
+}
+
+/**
+ * Fraction-free Gauss-Jordan elimination on a row-major rows x cols matrix.
+ * Every division by the previous pivot is exact, and on exit every pivot row
+ * has the same pivot value (the determinant of the leading pivot minor), so a
+ * one-dimensional nullspace can be read straight from the free column.
+ * Fills the pivot column of each pivot row; `pivot` receives the final pivot.
+ */
+template <typename Int>
+void eliminate(std::vector<Int>& a, int rows, int cols, Int& pivot, std::vector<int>& pivotColumns) {
+    pivotColumns.clear();
+    Int previous = Int(1);
+    int rank = 0;
+
+    for (int c = 0; c < cols && rank < rows; ++c) {
+        // Smallest non-zero entry keeps intermediate growth down
+        int best = -1;
+        for (int i = rank; i < rows; ++i) {
+            if (!isZero(a[i * cols + c]) &&
+                (best < 0 || absValue(a[i * cols + c]) < absValue(a[best * cols + c]))) {
+                best = i;
+            }
+        }
+        if (best < 0) continue;
+        if (best != rank) {
+            std::swap_ranges(a.begin() + best * cols, a.begin() + (best + 1) * cols, a.begin() + rank * cols);
+        }
+
+        const Int p = a[rank * cols + c];
+        for (int i = 0; i < rows; ++i) {
+            if (i == rank) continue;
+            const Int factor = a[i * cols + c];
+            for (int j = 0; j < cols; ++j) {
+                Int& entry = a[i * cols + j];
+                entry = divExact(subExact(mulExact(p, entry), mulExact(factor, a[rank * cols + j])), previous);
+            }
+        }
+
+        previous = p;
+        pivotColumns.push_back(c);
+        rank++;
+    }
+
+    pivot = previous;
+}
+
+// Working buffers for one solve; the 64-bit path reuses a per-thread set
+template <typename Int>
+struct SolveBuffers {
+    std::vector<Int> matrix;
+    std::vector<Int> solution;
+    std::vector<int> pivotColumns;
+    std::vector<char> isPivot;
+};
+
+// Columns from fixedColumns on may take either sign (added solvent species)
+template <typename Int>
+void solve(const std::vector<std::int64_t>& matrix, int rows, int cols, int fixedColumns,
+           SolveBuffers<Int>& buffers, EquationBalancer::Result& result) {
+    using Status = EquationBalancer::Status;
+
+    std::vector<Int>& a = buffers.matrix;
+    a.assign(matrix.begin(), matrix.end());
+    Int pivot;
+    eliminate(a, rows, cols, pivot, buffers.pivotColumns);
+    const std::vector<int>& pivotColumns = buffers.pivotColumns;
+
+    result.nullity = cols - static_cast<int>(pivotColumns.size());
+    if (result.nullity == 0) {
+        result.status = Status::INFEASIBLE;
+        return;
+    }
+    if (result.nullity > 1) {
+        result.status = Status::MULTIPLE_SOLUTIONS;
+        return;
+    }
+
+    // The single free column f: x_f = pivot, x_(pivot column of row i) = -a[i][f]
+    buffers.isPivot.assign(cols, 0);
+    for (int c : pivotColumns) buffers.isPivot[c] = 1;
+    int free = static_cast<int>(std::find(buffers.isPivot.begin(), buffers.isPivot.end(), 0) - buffers.isPivot.begin());
+
+    std::vector<Int>& x = buffers.solution;
+    x.assign(cols, Int(0));
+    x[free] = pivot;
+    for (size_t i = 0; i < pivotColumns.size(); ++i) {
+        x[pivotColumns[i]] = subExact(Int(0), a[i * cols + free]);
+    }
+
+    // Reduce to the smallest integers and make the given species positive
+    Int divisor = Int(0);
+    for (const Int& value : x) divisor = gcdOf(divisor, value);
+    int sign = signOf(x[0]);
+    for (int c = 0; c < cols; ++c) {
+        Int& value = x[c];
+        value = divExact(value, divisor);
+        if (c < fixedColumns && (sign == 0 || signOf(value) != sign)) {
+            result.status = Status::NO_POSITIVE_SOLUTION;
+            return;
+        }
+        if (sign < 0) value = subExact(Int(0), value);
+    }
+
+    result.coefficients.resize(cols);
+    for (int c = 0; c < cols; ++c) {
+        if (!toInt64(x[c], result.coefficients[c])) {
+            result.coefficients.clear();
+            result.status = Status::COEFFICIENT_OVERFLOW;
+            return;
+        }
+    }
+    result.status = Status::BALANCED;
+}
+
+// Per-thread buffers, so steady-state balancing on the 64-bit path does not allocate
+struct Scratch {
+    std::vector<int> elements;
+    std::vector<std::int64_t> matrix;
+    std::vector<const FormulaParser::ElementCounts*> columns;
+    SolveBuffers<std::int64_t> buffers;
+};
+
+Scratch& threadScratch() {
+    thread_local Scratch scratch;
+    return scratch;
+}
+
+// Species redox balancing may add
+struct Solvent {
+    FormulaParser::ElementCounts water, hydron, hydroxide, electron;
+
+    Solvent() {
+        FormulaParser::parse("H2O", water);
+        FormulaParser::parse("H^+", hydron);
+        FormulaParser::parse("OH^-", hydroxide);
+        electron.charge = -1;
+    }
+};
+
+const Solvent& solvent() {
+    static const Solvent species;
+    return species;
+}
+
+/**
+ * Balances columns [0, columnCount): reactants, then products up to fixedColumns,
+ * then added species that may land on either side. One row per element, plus a
+ * charge row when anything is charged.
+ */
+void balanceColumns(const FormulaParser::ElementCounts* const* species, size_t columnCount,
+                    size_t reactantCount, size_t fixedColumns, EquationBalancer::Result& result) {
+    using Status = EquationBalancer::Status;
+    result.status = Status::INVALID_INPUT;
+    result.coefficients.clear();
+    result.nullity = 0;
+    result.usedBigInt = false;
+
+    const int cols = static_cast<int>(columnCount);
+    if (fixedColumns < 2 || reactantCount == 0 || reactantCount >= fixedColumns) {
+        return;
+    }
+
+    // One row per element present anywhere in the equation
+    std::uint64_t present[2] = {0, 0};
+    bool charged = false;
+    for (size_t c = 0; c < columnCount; ++c) {
+        if (species[c]->empty() && species[c]->charge == 0) return;
+        present[0] |= species[c]->present[0];
+        present[1] |= species[c]->present[1];
+        charged = charged || species[c]->charge != 0;
+    }
+
+    Scratch& scratch = threadScratch();
+    std::vector<int>& elements = scratch.elements;
+    elements.clear();
+    for (int word = 0; word < 2; ++word) {
+        for (std::uint64_t bits = present[word]; bits != 0; bits &= bits - 1) {
+            elements.push_back(word * 64 + FormulaParser::lowestBit(bits));
+        }
+    }
+    const int rows = static_cast<int>(elements.size()) + (charged ? 1 : 0);
+
+    std::vector<std::int64_t>& matrix = scratch.matrix;
+    matrix.resize(static_cast<size_t>(rows) * cols);
+    for (int r = 0; r < rows; ++r) {
+        for (int c = 0; c < cols; ++c) {
+            std::int64_t count = r < static_cast<int>(elements.size()) ? (*species[c])[elements[r]]
+                                                                        : species[c]->charge;
+            bool product = static_cast<size_t>(c) >= reactantCount && static_cast<size_t>(c) < fixedColumns;
+            matrix[r * cols + c] = product ? -count : count;
+        }
+    }
+
+    const int fixed = static_cast<int>(fixedColumns);
+    try {
+        solve(matrix, rows, cols, fixed, scratch.buffers, result);
+    } catch (const Int64Overflow&) {
+        SolveBuffers<BigInt> bigBuffers;
+        solve(matrix, rows, cols, fixed, bigBuffers, result);
+        result.usedBigInt = true;
+    }
+}
+
+bool fitsInt(std::int64_t value) {
+    return value >= std::numeric_limits<int>::min() && value <= std::numeric_limits<int>::max();
+}
+
+// Net electrons taken (positive) or released (negative) by a balanced equation
+std::int64_t electronsTaken(const ChemistryEngine::ChemicalEquation& equation) {
+    std::int64_t taken = 0;
+    for (const auto& component : equation.reactants) {
+        if (component.formula->isElectron()) taken += component.coefficient;
+    }
+    for (const auto& component : equation.products) {
+        if (component.formula->isElectron()) taken -= component.coefficient;
+    }
+    return taken;
+}
+
+// Species of an equation as counts, reactants first
+void collectSpecies(const ChemistryEngine::ChemicalEquation& equation,
+                    std::vector<const FormulaParser::ElementCounts*>& species) {
+    species.reserve(equation.reactants.size() + equation.products.size());
+    for (const auto* side : {&equation.reactants, &equation.products}) {
+        for (const auto& component : *side) {
+            species.push_back(&component.formula->counts());
+        }
+    }
+}
+
+} // namespace
+
+EquationBalancer::Result EquationBalancer::balance(const std::vector<const FormulaParser::ElementCounts*>& species,
+                                                   size_t reactantCount) {
+    Result result;
+    balance(species.data(), species.size(), reactantCount, result);
+    return result;
+}
+
+void EquationBalancer::balance(const FormulaParser::ElementCounts* const* species, size_t speciesCount,
+                               size_t reactantCount, Result& result) {
+    result.added = Added();
+    balanceColumns(species, speciesCount, reactantCount, speciesCount, result);
+}
+
+void EquationBalancer::balanceRedox(const FormulaParser::ElementCounts* const* species, size_t speciesCount,
+                                    size_t reactantCount, Medium medium, bool halfReaction, Result& result) {
+    result.added = Added();
+    const Solvent& added = solvent();
+    const FormulaParser::ElementCounts* candidates[3] = {
+        medium == Medium::NONE ? nullptr : &added.water,
+        medium == Medium::ACIDIC ? &added.hydron : medium == Medium::BASIC ? &added.hydroxide : nullptr,
+        halfReaction ? &added.electron : nullptr};
+
+    // Given species, then the solvent species not among them
+    std::vector<const FormulaParser::ElementCounts*>& columns = threadScratch().columns;
+    columns.assign(species, species + speciesCount);
+    int slot[3] = {-1, -1, -1};
+    for (int k = 0; k < 3; ++k) {
+        if (candidates[k] == nullptr) continue;
+        bool listed = false;
+        for (size_t c = 0; c < speciesCount && !listed; ++c) {
+            listed = CanonicalFormula::equal(*species[c], *candidates[k]);
+        }
+        if (!listed) {
+            slot[k] = static_cast<int>(columns.size());
+            columns.push_back(candidates[k]);
+        }
+    }
+
+    balanceColumns(columns.data(), columns.size(), reactantCount, speciesCount, result);
+    if (!result.ok()) {
+        return;
+    }
+    std::int64_t* targets[3] = {&result.added.water, &result.added.ion, &result.added.electrons};
+    for (int k = 0; k < 3; ++k) {
+        if (slot[k] >= 0) *targets[k] = result.coefficients[slot[k]];
+    }
+    result.coefficients.resize(speciesCount);
+}
+
+EquationBalancer::Result EquationBalancer::balance(const ChemistryEngine::ChemicalEquation& equation) {
+    std::vector<const FormulaParser::ElementCounts*> species;
+    collectSpecies(equation, species);
+    return balance(species, equation.reactants.size());
+}
+
+EquationBalancer::Result EquationBalancer::balanceRedox(ChemistryEngine::ChemicalEquation& equation, Medium medium,
+                                                        bool halfReaction) {
+    std::vector<const FormulaParser::ElementCounts*> species;
+    collectSpecies(equation, species);
+
+    Result result;
+    balanceRedox(species.data(), species.size(), equation.reactants.size(), medium, halfReaction, result);
+    if (!result.ok()) {
+        return result;
+    }
+
+    // EquationComponent stores int coefficients
+    const std::int64_t added[3] = {result.added.water, result.added.ion, result.added.electrons};
+    bool fits = fitsInt(added[0]) && fitsInt(added[1]) && fitsInt(added[2]);
+    for (std::int64_t coefficient : result.coefficients) fits = fits && fitsInt(coefficient);
+    if (!fits) {
+        result.status = Status::COEFFICIENT_OVERFLOW;
+        return result;
+    }
+
+    size_t index = 0;
+    for (auto* side : {&equation.reactants, &equation.products}) {
+        for (auto& component : *side) {
+            component.coefficient = static_cast<int>(result.coefficients[index++]);
+        }
+    }
+    const char* formulas[3] = {"H2O", medium == Medium::BASIC ? "OH^-" : "H^+", "e^-"};
+    for (int k = 0; k < 3; ++k) {
+        if (added[k] == 0) continue;
+        auto& side = added[k] > 0 ? equation.reactants : equation.products;
+        side.emplace_back(ChemistryEngine::internFormula(formulas[k]),
+                          static_cast<int>(added[k] > 0 ? added[k] : -added[k]));
+    }
+    return result;
+}
+
+EquationBalancer::Result EquationBalancer::combineHalfReactions(ChemistryEngine::ChemicalEquation& oxidation,
+                                                                ChemistryEngine::ChemicalEquation& reduction,
+                                                                Medium medium,
+                                                                ChemistryEngine::ChemicalEquation& overall) {
+    Result result = balanceRedox(oxidation, medium, true);
+    if (!result.ok()) return result;
+    result = balanceRedox(reduction, medium, true);
+    if (!result.ok()) return result;
+
+    const std::int64_t released = -electronsTaken(oxidation);
+    const std::int64_t taken = electronsTaken(reduction);
+    result.coefficients.clear();
+    result.added = Added();
+    if (released <= 0 || taken <= 0) {
+        result.status = Status::NOT_REDOX_PAIR;
+        return result;
+    }
+    const std::int64_t common = gcdOf(released, taken);
+
+    // Net coefficient of every distinct species: reactants positive
+    struct Net {
+        ChemistryEngine::FormulaRef formula;
+        ChemistryEngine::State state;
+        std::int64_t coefficient;
+    };
+    std::vector<Net> nets;
+    auto accumulate = [&nets](const ChemistryEngine::ChemicalEquation& equation, std::int64_t scale) {
+        for (const auto* side : {&equation.reactants, &equation.products}) {
+            const std::int64_t sign = side == &equation.reactants ? scale : -scale;
+            for (const auto& component : *side) {
+                auto same = std::find_if(nets.begin(), nets.end(), [&component](const Net& net) {
+                    return *net.formula == *component.formula;
+                });
+                if (same == nets.end()) {
+                    nets.push_back({component.formula, component.state, component.coefficient * sign});
+                } else {
+                    same->coefficient += component.coefficient * sign;
+                }
+            }
+        }
+    };
+    accumulate(oxidation, taken / common);
+    accumulate(reduction, released / common);
+
+    std::int64_t divisor = 0;
+    for (const Net& net : nets) divisor = gcdOf(divisor, net.coefficient);
+
+    ChemistryEngine::ChemicalEquation sum;
+    for (const Net& net : nets) {
+        if (net.coefficient == 0) continue;
+        const std::int64_t coefficient = net.coefficient / divisor;
+        if (!fitsInt(coefficient)) {
+            result.status = Status::COEFFICIENT_OVERFLOW;
+            return result;
+        }
+        auto& side = coefficient > 0 ? sum.reactants : sum.products;
+        side.emplace_back(net.formula, static_cast<int>(coefficient > 0 ? coefficient : -coefficient), net.state);
+    }
+    if (sum.reactants.empty() || sum.products.empty()) {
+        result.status = Status::INFEASIBLE;
+        return result;
+    }
+    for (const auto* side : {&sum.reactants, &sum.products}) {
+        for (const auto& component : *side) result.coefficients.push_back(component.coefficient);
+    }
+    overall = std::move(sum);
+    result.status = Status::BALANCED;
+    return result;
+}
+
+const char* EquationBalancer::statusMessage(Status status) {
+    switch (status) {
+        case Status::BALANCED: return "Balanced";
+        case Status::INVALID_INPUT: return "Equation needs at least one reactant and one product, each with atoms or charge";
+        case Status::INFEASIBLE: return "Atoms cannot be conserved by any coefficients";
+        case Status::NO_POSITIVE_SOLUTION: return "No solution with all coefficients positive";
+        case Status::MULTIPLE_SOLUTIONS: return "Underdetermined: several independent balanced equations exist";
+        case Status::COEFFICIENT_OVERFLOW: return "Coefficients exceed the 64-bit range";
+        case Status::NOT_REDOX_PAIR: return "Half-reactions must release electrons on one side and take them on the other";
+        default: return "Unknown status";
+    }
+}
+
+const char* EquationBalancer::mediumName(Medium medium) {
+    switch (medium) {
+        case Medium::ACIDIC: return "acidic";
+        case Medium::BASIC: return "basic";
+        default: return "neutral";
+    }
+}
@@ -0,0 +1,92 @@
+#ifndef EQUATIONBALANCER_H
+#define EQUATIONBALANCER_H
+
+#include "ChemistryEngine.h"
+#include "FormulaParser.h"
+#include <cstdint>
+#include <vector>
+
+/**
+ * @brief EquationBalancer - Exact integer balancer for chemical equations
+ * Builds the element-by-species matrix (reactants positive, products negative)
+ * and finds its integer nullspace with fraction-free Gauss-Jordan elimination
+ * (Bareiss). Runs in 64-bit arithmetic with overflow detection and repeats the
+ * elimination with BigInt when an intermediate value does not fit.
+ * Reentrant: working buffers are per thread.
+ *
+ * When any species is charged, charge gets a row of its own, so ionic
+ * equations conserve it like an element. Redox balancing adds H2O and H^+
+ * (acidic) or OH^- (basic) as extra columns whose coefficients may take
+ * either sign: the sign tells which side the species goes on. Half-reactions
+ * get an electron column the same way, and combineHalfReactions() scales two
+ * of them so the electrons cancel.
+ */
+class EquationBalancer {
+public:
+    enum class Status {
+        BALANCED,              // Unique smallest positive integer solution found
+        INVALID_INPUT,         // Fewer than two species, or a species with neither atoms nor charge
+        INFEASIBLE,            // Only the zero solution: atoms cannot be conserved
+        NO_POSITIVE_SOLUTION,  // Conserving atoms needs a zero or wrong-side coefficient
+        MULTIPLE_SOLUTIONS,    // Underdetermined: independent reactions are mixed together
+        COEFFICIENT_OVERFLOW,  // Solution exists but does not fit in 64-bit coefficients
+        NOT_REDOX_PAIR         // Half-reactions that do not release electrons on one side and take them on the other
+    };
+
+    // Species redox balancing may add besides the given ones
+    enum class Medium {
+        NONE,   // None: atoms and charge must balance as written
+        ACIDIC, // H2O and H^+
+        BASIC   // H2O and OH^-
+    };
+
+    // Coefficients of added species: positive on the reactant side, negative on the product side
+    struct Added {
+        std::int64_t water = 0;
+        std::int64_t ion = 0;       // H^+ (acidic) or OH^- (basic)
+        std::int64_t electrons = 0; // Half-reactions only
+
+        bool any() const { return water != 0 || ion != 0 || electrons != 0; }
+    };
+
+    struct Result {
+        Status status = Status::INVALID_INPUT;
+        std::vector<std::int64_t> coefficients; // Reactants first, then products
+        Added added;                            // balanceRedox only
+        int nullity = 0;                        // Dimension of the solution space
+        bool usedBigInt = false;                // 64-bit elimination overflowed
+
+        bool ok() const { return status == Status::BALANCED; }
+    };
+
+    // species lists the reactants first, then the products
+    static Result balance(const std::vector<const FormulaParser::ElementCounts*>& species, size_t reactantCount);
+    static Result balance(const ChemistryEngine::ChemicalEquation& equation);
+
+    // Allocation-free form: reuses result.coefficients and per-thread working buffers
+    static void balance(const FormulaParser::ElementCounts* const* species, size_t speciesCount,
+                        size_t reactantCount, Result& result);
+
+    // Balances in an aqueous medium, adding H2O, H^+ or OH^- (and e^- for a half-reaction) where
+    // needed; result.coefficients covers the given species only. A solvent species already listed
+    // is not added again. Allocation-free like balance().
+    static void balanceRedox(const FormulaParser::ElementCounts* const* species, size_t speciesCount,
+                             size_t reactantCount, Medium medium, bool halfReaction, Result& result);
+
+    // Same on an equation, which gets the added species appended to the side they belong on
+    // and all its coefficients set. Left untouched unless balanced.
+    static Result balanceRedox(ChemistryEngine::ChemicalEquation& equation, Medium medium,
+                               bool halfReaction = false);
+
+    // Balances both half-reactions in place, then writes their sum to overall: each is scaled so
+    // the electrons released by the oxidation match those taken by the reduction, and species
+    // on both sides (electrons, H2O, H^+...) cancel. result.coefficients are those of overall.
+    static Result combineHalfReactions(ChemistryEngine::ChemicalEquation& oxidation,
+                                       ChemistryEngine::ChemicalEquation& reduction, Medium medium,
+                                       ChemistryEngine::ChemicalEquation& overall);
+
+    static const char* statusMessage(Status status);
+    static const char* mediumName(Medium medium); // "neutral", "acidic", "basic"
+};
+
+#endif // EQUATIONBALANCER_H
@@ -0,0 +1,209 @@
+#include "EquationParser.h"
+
+namespace {
+
+struct Arrow {
+    std::string_view text;
+    bool reversible;
+};
+
+// Longer arrows first, so "<=>" is not read as "<" and "=>"
+constexpr Arrow ARROWS[] = {
+    {"<=>", true},
+    {"<->", true},
+    {"\xE2\x87\x8C", true}, // ⇌
+    {"->", false},
+    {"=>", false},
+    {"\xE2\x86\x92", false}, // →
+    {"=", false},
+};
+
+bool isSpace(char c) {
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+// Length of the arrow starting at text[i], 0 if there is none
+size_t arrowAt(std::string_view text, size_t i, bool& reversible) {
+    const char c = text[i];
+    if (c != '<' && c != '-' && c != '=' && c != '\xE2') {
+        return 0;
+    }
+    for (const Arrow& arrow : ARROWS) {
+        if (text.compare(i, arrow.text.size(), arrow.text) == 0) {
+            reversible = arrow.reversible;
+            return arrow.text.size();
+        }
+    }
+    return 0;
+}
+
+EquationParser::State stateFromTag(std::string_view tag) {
+    if (tag == "s") return EquationParser::State::SOLID;
+    if (tag == "l") return EquationParser::State::LIQUID;
+    if (tag == "g") return EquationParser::State::GAS;
+    if (tag == "aq") return EquationParser::State::AQUEOUS;
+    return EquationParser::State::NONE;
+}
+
+EquationParser::Result failure(EquationParser::Error error, size_t position) {
+    EquationParser::Result result;
+    result.error = error;
+    result.position = position;
+    return result;
+}
+
+// Reads text[begin, end) as "[coefficient] formula [(state)]"
+EquationParser::Result readTerm(std::string_view text, size_t begin, size_t end, EquationParser::Term& term) {
+    while (begin < end && isSpace(text[begin])) begin++;
+    while (end > begin && isSpace(text[end - 1])) end--;
+    if (begin == end) {
+        return failure(EquationParser::Error::EMPTY_TERM, begin);
+    }
+
+    term.coefficient = 1;
+    if (isDigit(text[begin])) {
+        const size_t start = begin;
+        std::int64_t coefficient = 0;
+        for (; begin < end && isDigit(text[begin]); ++begin) {
+            const int digit = text[begin] - '0';
+            if (coefficient > (INT64_MAX - digit) / 10) {
+                return failure(EquationParser::Error::BAD_COEFFICIENT, start);
+            }
+            coefficient = coefficient * 10 + digit;
+        }
+        if (coefficient == 0) {
+            return failure(EquationParser::Error::BAD_COEFFICIENT, start);
+        }
+        term.coefficient = coefficient;
+        while (begin < end && isSpace(text[begin])) begin++;
+    }
+
+    // A trailing group of lowercase letters is a state tag, not part of the formula
+    term.state = EquationParser::State::NONE;
+    if (text[end - 1] == ')') {
+        size_t open = end - 1;
+        while (open > begin && text[open - 1] >= 'a' && text[open - 1] <= 'z') open--;
+        if (open > begin && open < end - 1 && text[open - 1] == '(') {
+            term.state = stateFromTag(text.substr(open, end - 1 - open));
+            if (term.state == EquationParser::State::NONE) {
+                return failure(EquationParser::Error::UNKNOWN_STATE, open - 1);
+            }
+            end = open - 1;
+            while (end > begin && isSpace(text[end - 1])) end--;
+        }
+    }
+    if (begin == end) {
+        return failure(EquationParser::Error::EMPTY_TERM, begin);
+    }
+    term.formula = text.substr(begin, end - begin);
+    term.position = begin;
+    return EquationParser::Result();
+}
+
+} // namespace
+
+EquationParser::Result EquationParser::parse(std::string_view text, Equation& out) {
+    out.terms.clear();
+    out.reactantCount = 0;
+    out.reversible = false;
+
+    bool arrowSeen = false;
+    size_t termStart = 0;
+    auto closeTerm = [&](size_t end) {
+        out.terms.emplace_back();
+        return readTerm(text, termStart, end, out.terms.back());
+    };
+
+    for (size_t i = 0; i < text.size(); ++i) {
+        const char c = text[i];
+        if (c == '^') {
+            // Charge: digits and a sign, in either order
+            while (i + 1 < text.size() && isDigit(text[i + 1])) i++;
+            if (i + 1 < text.size() && (text[i + 1] == '+' || text[i + 1] == '-')) i++;
+            while (i + 1 < text.size() && isDigit(text[i + 1])) i++;
+            continue;
+        }
+        bool reversible = false;
+        size_t arrow = arrowAt(text, i, reversible);
+        if (arrow != 0) {
+            if (arrowSeen) {
+                return failure(Error::EXTRA_ARROW, i);
+            }
+            Result result = closeTerm(i);
+            if (!result.ok()) return result;
+            arrowSeen = true;
+            out.reactantCount = out.terms.size();
+            out.reversible = reversible;
+            i += arrow - 1;
+            termStart = i + 1;
+        } else if (c == '+') {
+            Result result = closeTerm(i);
+            if (!result.ok()) return result;
+            termStart = i + 1;
+        }
+    }
+    if (!arrowSeen) {
+        return failure(Error::NO_ARROW, text.size());
+    }
+    return closeTerm(text.size());
+}
+
+EquationParser::Result EquationParser::parse(std::string_view text, Equation& out,
+                                             std::vector<FormulaParser::ElementCounts>& species) {
+    Result result = parse(text, out);
+    if (!result.ok()) {
+        return result;
+    }
+    if (species.size() < out.terms.size()) {
+        species.resize(out.terms.size());
+    }
+    for (size_t i = 0; i < out.terms.size(); ++i) {
+        const Term& term = out.terms[i];
+        if (isElectron(term.formula)) {
+            species[i].clear();
+            species[i].charge = -1;
+            continue;
+        }
+        FormulaParser::Result parsed = FormulaParser::parse(term.formula, species[i]);
+        if (!parsed.ok()) {
+            result = failure(Error::BAD_FORMULA, term.position + parsed.position);
+            result.formulaError = parsed.error;
+            return result;
+        }
+        if (species[i].empty()) {
+            return failure(Error::EMPTY_TERM, term.position);
+        }
+    }
+    return result;
+}
+
+bool EquationParser::isElectron(std::string_view formula) {
+    return formula == "e^-" || formula == "e-" || formula == "e";
+}
+
+const char* EquationParser::errorMessage(Error error) {
+    switch (error) {
+        case Error::NONE: return "OK";
+        case Error::NO_ARROW: return "No reaction arrow";
+        case Error::EXTRA_ARROW: return "More than one reaction arrow";
+        case Error::EMPTY_TERM: return "Empty term";
+        case Error::BAD_COEFFICIENT: return "Coefficient must be a positive integer";
+        case Error::UNKNOWN_STATE: return "Unknown state tag (expected s, l, g or aq)";
+        case Error::BAD_FORMULA: return "Bad formula";
+        default: return "Parse error";
+    }
+}
+
+const char* EquationParser::stateTag(State state) {
+    switch (state) {
+        case State::SOLID: return "(s)";
+        case State::LIQUID: return "(l)";
+        case State::GAS: return "(g)";
+        case State::AQUEOUS: return "(aq)";
+        default: return "";
+    }
+}
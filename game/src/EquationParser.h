@@ -0,0 +1,78 @@
+#ifndef EQUATIONPARSER_H
+#define EQUATIONPARSER_H
+
+#include "FormulaParser.h"
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief EquationParser - Single-pass splitter for reaction equations
+ * Reads text like "C3H8 + 5O2 -> 3CO2 + 4H2O" or "NH4^+(aq) + OH^-(aq) <=> NH3(g) + H2O(l)".
+ * It walks the text once, left to right, and emits one Term per species.
+ * Each term holds a string_view into the input, so nothing is copied.
+ *
+ * Arrows: ->, =>, =, → (U+2192), and the reversible <=>, <-> and ⇌ (U+21CC).
+ * A '+' inside a charge (NH4^+, Fe^3+) belongs to the formula. Any other '+'
+ * separates terms. Leading digits are the coefficient. A trailing lowercase
+ * tag (s), (l), (g) or (aq) is the physical state. Every error carries the
+ * offset of the offending character in the whole text.
+ *
+ * Half-reactions may list electrons as e^-, e- or e: a species with no atoms
+ * and charge -1 ("Fe^3+ + e^- -> Fe^2+").
+ */
+class EquationParser {
+public:
+    enum class State : std::uint8_t { NONE, SOLID, LIQUID, GAS, AQUEOUS };
+
+    enum class Error {
+        NONE,
+        NO_ARROW,
+        EXTRA_ARROW,     // A second arrow
+        EMPTY_TERM,      // Nothing between separators, or a coefficient without a formula
+        BAD_COEFFICIENT, // Zero, or outside the int64 range
+        UNKNOWN_STATE,   // A lowercase tag other than (s), (l), (g), (aq)
+        BAD_FORMULA      // See formulaError
+    };
+
+    struct Term {
+        std::string_view formula;      // Without coefficient, state tag or surrounding spaces
+        std::int64_t coefficient = 1;  // 1 when none is written
+        State state = State::NONE;
+        size_t position = 0;           // Offset of formula in the text
+    };
+
+    struct Equation {
+        std::vector<Term> terms; // Reactants, then products
+        size_t reactantCount = 0;
+        bool reversible = false;
+
+        size_t productCount() const { return terms.size() - reactantCount; }
+    };
+
+    struct Result {
+        Error error = Error::NONE;
+        size_t position = 0; // Offset in the text when error != NONE
+        FormulaParser::Error formulaError = FormulaParser::Error::NONE;
+
+        bool ok() const { return error == Error::NONE; }
+    };
+
+    // Splits the text into terms (out is cleared first). Formulas are located but not checked.
+    static Result parse(std::string_view text, Equation& out);
+
+    // Also parses every formula: species[i] holds the atoms of out.terms[i]. The vector only
+    // grows, so reusing it between calls avoids allocations.
+    static Result parse(std::string_view text, Equation& out, std::vector<FormulaParser::ElementCounts>& species);
+
+    // "e^-", "e-" or "e": the electron of a half-reaction, which FormulaParser does not read
+    static bool isElectron(std::string_view formula);
+
+    static const char* errorMessage(Error error);
+
+    // "(aq)" etc., empty for State::NONE
+    static const char* stateTag(State state);
+};
+
+#endif // EQUATIONPARSER_H
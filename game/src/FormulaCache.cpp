@@ -0,0 +1,106 @@
+#include "FormulaCache.h"
+#include <functional>
+#include <stdexcept>
+
+FormulaCache::FormulaCache(size_t capacity) {
+    setCapacity(capacity);
+}
+
+FormulaCache& FormulaCache::instance() {
+    static FormulaCache cache;
+    return cache;
+}
+
+// The shard comes from the top bits of the hash: the shard maps bucket on the same
+// hash, and picking by the low bits would leave most of their buckets empty
+FormulaCache::Shard& FormulaCache::shardFor(std::string_view formula) {
+    size_t hash = std::hash<std::string_view>()(formula);
+    return shards[hash >> (sizeof(size_t) * 8 - SHARD_BITS)];
+}
+
+FormulaCache::EntryPtr FormulaCache::get(const std::string& formula) {
+    Shard& shard = shardFor(formula);
+    {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        auto it = shard.index.find(formula);
+        if (it != shard.index.end()) {
+            // Move to the front of the LRU list
+            shard.lru.splice(shard.lru.begin(), shard.lru, it->second);
+            hits.fetch_add(1, std::memory_order_relaxed);
+            return it->second->second;
+        }
+    }
+
+    // Parse outside the lock so misses on different formulas run in parallel
+    misses.fetch_add(1, std::memory_order_relaxed);
+    ChemistryEngine::ChemicalFormula parsed = ChemistryEngine::parseFormula(formula);
+    double molarMass = ChemistryEngine::calculateMolarMass(parsed);
+    EntryPtr entry = std::make_shared<const Entry>(Entry{std::move(parsed), molarMass});
+
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    auto it = shard.index.find(formula);
+    if (it != shard.index.end()) {
+        // Another thread interned it first; keep theirs so everyone shares one entry
+        return it->second->second;
+    }
+    shard.lru.emplace_front(formula, entry);
+    shard.index.emplace(shard.lru.front().first, shard.lru.begin());
+    trim(shard);
+    return entry;
+}
+
+void FormulaCache::prewarm(const std::vector<std::string>& formulas) {
+    for (const auto& formula : formulas) {
+        if (formula.empty()) continue;
+        try {
+            get(formula);
+        } catch (const std::invalid_argument&) {
+            // Not a parsable formula - nothing to cache
+        }
+    }
+}
+
+void FormulaCache::trim(Shard& shard) {
+    while (shard.lru.size() > shard.capacity) {
+        shard.index.erase(shard.lru.back().first);
+        shard.lru.pop_back();
+        evictions.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+FormulaCache::Stats FormulaCache::getStats() const {
+    Stats stats{};
+    stats.hits = hits.load(std::memory_order_relaxed);
+    stats.misses = misses.load(std::memory_order_relaxed);
+    stats.evictions = evictions.load(std::memory_order_relaxed);
+    for (const auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        stats.size += shard.lru.size();
+        stats.capacity += shard.capacity;
+    }
+    return stats;
+}
+
+void FormulaCache::resetStats() {
+    hits.store(0, std::memory_order_relaxed);
+    misses.store(0, std::memory_order_relaxed);
+    evictions.store(0, std::memory_order_relaxed);
+}
+
+void FormulaCache::clear() {
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.index.clear();
+        shard.lru.clear();
+    }
+}
+
+void FormulaCache::setCapacity(size_t capacity) {
+    size_t perShard = capacity / SHARD_COUNT;
+    if (perShard == 0) perShard = 1;
+    for (auto& shard : shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.capacity = perShard;
+        trim(shard);
+    }
+}
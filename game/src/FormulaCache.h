@@ -0,0 +1,79 @@
+#ifndef FORMULACACHE_H
+#define FORMULACACHE_H
+
+#include "ChemistryEngine.h"
+#include <atomic>
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief FormulaCache - Thread-safe intern cache of parsed formulas
+ * Maps a formula string to an immutable parsed formula with its molar mass.
+ * Entries are shared (std::shared_ptr<const Entry>), so an evicted formula stays
+ * valid for whoever still holds it. The cache is split into independently locked
+ * shards, each with its own LRU list, so concurrent lookups rarely contend.
+ */
+class FormulaCache {
+public:
+    struct Entry {
+        ChemistryEngine::ChemicalFormula formula;
+        double molarMass;
+    };
+    using EntryPtr = std::shared_ptr<const Entry>;
+
+    struct Stats {
+        std::uint64_t hits;
+        std::uint64_t misses;
+        std::uint64_t evictions;
+        size_t size;
+        size_t capacity;
+    };
+
+    static constexpr size_t DEFAULT_CAPACITY = 4096;
+
+    explicit FormulaCache(size_t capacity = DEFAULT_CAPACITY);
+
+    // Process-wide cache used by ChemistryEngine
+    static FormulaCache& instance();
+
+    // Returns the interned formula, parsing it on a miss (throws std::invalid_argument if malformed)
+    EntryPtr get(const std::string& formula);
+
+    // Parses and inserts formulas ahead of time; malformed entries are skipped
+    void prewarm(const std::vector<std::string>& formulas);
+
+    Stats getStats() const;
+    void resetStats();
+    void clear();
+
+    // Total capacity across all shards (at least one entry per shard)
+    void setCapacity(size_t capacity);
+
+private:
+    static constexpr size_t SHARD_BITS = 4;
+    static constexpr size_t SHARD_COUNT = size_t(1) << SHARD_BITS;
+
+    struct Shard {
+        mutable std::mutex mutex;
+        // Most recently used first; the index keys are views into the list nodes
+        std::list<std::pair<std::string, EntryPtr>> lru;
+        std::unordered_map<std::string_view, std::list<std::pair<std::string, EntryPtr>>::iterator> index;
+        size_t capacity = 1;
+    };
+
+    Shard shards[SHARD_COUNT];
+    std::atomic<std::uint64_t> hits{0};
+    std::atomic<std::uint64_t> misses{0};
+    std::atomic<std::uint64_t> evictions{0};
+
+    Shard& shardFor(std::string_view formula);
+    void trim(Shard& shard);
+};
+
+#endif // FORMULACACHE_H
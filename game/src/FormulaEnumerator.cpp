@@ -0,0 +1,357 @@
+#include "FormulaEnumerator.h"
+#include "CanonicalFormula.h"
+#include "IsotopeTable.h"
+#include "PeriodicTable.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <utility>
+
+namespace {
+
+// Slack added to the mass window while pruning, so rounding in the partial sums
+// never cuts a formula whose exact mass is inside the tolerance
+constexpr double PRUNE_EPSILON = 1e-9;
+
+// Same for the count bounds derived from element ratios
+constexpr double RATIO_EPSILON = 1e-9;
+constexpr double UNBOUNDED = std::numeric_limits<double>::infinity();
+
+constexpr std::array<std::int8_t, PeriodicTable::ELEMENT_COUNT + 1> buildValences() {
+    std::array<std::int8_t, PeriodicTable::ELEMENT_COUNT + 1> valences{};
+    for (auto& v : valences) v = 2; // Transition metals and the rest: no effect on the DBE
+    for (int z : {1, 3, 11, 19, 37, 55, 87, 9, 17, 35, 53, 85}) valences[z] = 1;
+    for (int z : {4, 12, 20, 38, 56, 88, 8, 16, 34, 52, 84}) valences[z] = 2;
+    for (int z : {5, 13, 31, 49, 81, 7, 15, 33, 51, 83}) valences[z] = 3;
+    for (int z : {6, 14, 32, 50, 82}) valences[z] = 4;
+    for (int z : {2, 10, 18, 36, 54, 86}) valences[z] = 0;
+    return valences;
+}
+
+constexpr std::array<std::int8_t, PeriodicTable::ELEMENT_COUNT + 1> VALENCES = buildValences();
+
+struct Level {
+    int z;
+    double mass;
+    std::int64_t minCount;
+    std::int64_t maxCount;
+    int valenceExcess; // valence - 2: contribution of one atom to 2 * DBE
+    int nominalMass;
+};
+
+// A ratio limit seen from whichever of its two levels is assigned second: the
+// count of the other one is fixed by then, so it bounds this level's count
+struct RatioCut {
+    size_t other;     // Level assigned earlier
+    bool isReference; // This level is the ratio's denominator
+    double minRatio;
+    double maxRatio;
+};
+
+class Search {
+public:
+    Search(const FormulaEnumerator::Query& query, std::vector<Level> levels,
+           const std::function<bool(const FormulaEnumerator::Candidate&)>& onResult)
+        : query(query), levels(std::move(levels)), onResult(onResult) {
+        lo = query.targetMass - query.tolerance - PRUNE_EPSILON;
+        hi = query.targetMass + query.tolerance + PRUNE_EPSILON;
+        counts.assign(this->levels.size(), 0);
+
+        cuts.resize(this->levels.size());
+        for (const FormulaEnumerator::RatioLimit& limit : query.ratios) {
+            size_t element = levelOf(limit.atomicNumber);
+            size_t reference = levelOf(limit.referenceNumber);
+            if (element > reference) {
+                cuts[element].push_back(RatioCut{reference, false, limit.minRatio, limit.maxRatio});
+            } else {
+                cuts[reference].push_back(RatioCut{element, true, limit.minRatio, limit.maxRatio});
+            }
+        }
+
+        // Lightest and heaviest mass the levels from i on can still add
+        restMin.assign(this->levels.size() + 1, 0.0);
+        restMax.assign(this->levels.size() + 1, 0.0);
+        for (size_t i = this->levels.size(); i-- > 0;) {
+            const Level& level = this->levels[i];
+            restMin[i] = restMin[i + 1] + static_cast<double>(level.minCount) * level.mass;
+            restMax[i] = restMax[i + 1] + static_cast<double>(level.maxCount) * level.mass;
+        }
+    }
+
+    FormulaEnumerator::Summary run() {
+        visit(0, 0.0, 2);
+        return summary;
+    }
+
+private:
+    const FormulaEnumerator::Query& query;
+    std::vector<Level> levels;
+    const std::function<bool(const FormulaEnumerator::Candidate&)>& onResult;
+    std::vector<double> restMin, restMax;
+    std::vector<std::vector<RatioCut>> cuts; // Per level
+    std::vector<std::int64_t> counts;
+    double lo = 0.0, hi = 0.0;
+    bool stopped = false;
+    FormulaEnumerator::Summary summary;
+    FormulaEnumerator::Candidate candidate;
+
+    // Count range of level i that keeps the total inside [lo, hi]
+    void massRange(size_t i, double massSoFar, std::int64_t& from, std::int64_t& to) const {
+        const Level& level = levels[i];
+        double low = std::ceil((lo - massSoFar - restMax[i + 1]) / level.mass);
+        double high = std::floor((hi - massSoFar - restMin[i + 1]) / level.mass);
+        from = std::max(level.minCount, static_cast<std::int64_t>(std::max(low, -1.0)));
+        to = std::min(level.maxCount, static_cast<std::int64_t>(std::max(high, -1.0)));
+    }
+
+    size_t levelOf(int z) const {
+        size_t i = 0;
+        while (levels[i].z != z) ++i;
+        return i;
+    }
+
+    // Narrows level i's count range to the ratio limits it closes
+    void ratioRange(size_t i, std::int64_t& from, std::int64_t& to) const {
+        for (const RatioCut& cut : cuts[i]) {
+            double other = static_cast<double>(counts[cut.other]);
+            double low, high;
+            if (!cut.isReference) {
+                low = cut.minRatio * other;
+                high = std::isfinite(cut.maxRatio) ? cut.maxRatio * other : UNBOUNDED;
+            } else {
+                // other / maxRatio <= n <= other / minRatio
+                low = cut.maxRatio > 0.0 ? other / cut.maxRatio : (other > 0.0 ? UNBOUNDED : 0.0);
+                high = cut.minRatio > 0.0 ? other / cut.minRatio : UNBOUNDED;
+            }
+            if (low > static_cast<double>(to)) {
+                to = from - 1;
+                return;
+            }
+            from = std::max(from, static_cast<std::int64_t>(std::ceil(low - RATIO_EPSILON)));
+            if (high < static_cast<double>(to)) {
+                to = static_cast<std::int64_t>(std::floor(high + RATIO_EPSILON));
+            }
+        }
+    }
+
+    bool countNode() {
+        if (query.maxNodes != 0 && summary.nodes == query.maxNodes) {
+            summary.status = FormulaEnumerator::Status::WORK_LIMIT;
+            stopped = true;
+            return false;
+        }
+        summary.nodes++;
+        return true;
+    }
+
+    void visit(size_t i, double massSoFar, std::int64_t dbe2SoFar) {
+        std::int64_t from, to;
+        massRange(i, massSoFar, from, to);
+        ratioRange(i, from, to);
+        const Level& level = levels[i];
+
+        if (i + 1 == levels.size()) {
+            // Last level: also cut the count to the DBE window, 2 * DBE = dbe2SoFar + n * valenceExcess
+            double minDbe2 = 2.0 * query.minDbe - static_cast<double>(dbe2SoFar);
+            double maxDbe2 = 2.0 * query.maxDbe - static_cast<double>(dbe2SoFar);
+            if (level.valenceExcess != 0) {
+                double step = level.valenceExcess;
+                double a = (step > 0 ? minDbe2 : maxDbe2) / step;
+                double b = (step > 0 ? maxDbe2 : minDbe2) / step;
+                if (std::isfinite(a)) from = std::max(from, static_cast<std::int64_t>(std::max(std::ceil(a), -1.0)));
+                if (std::isfinite(b)) to = std::min(to, static_cast<std::int64_t>(std::max(std::floor(b), -1.0)));
+            } else if (minDbe2 > 0.0 || maxDbe2 < 0.0) {
+                return;
+            }
+            for (std::int64_t n = from; n <= to && !stopped; ++n) {
+                if (!countNode()) return;
+                counts[i] = n;
+                emit(dbe2SoFar + n * level.valenceExcess);
+            }
+            return;
+        }
+
+        for (std::int64_t n = from; n <= to && !stopped; ++n) {
+            if (!countNode()) return;
+            counts[i] = n;
+            visit(i + 1, massSoFar + static_cast<double>(n) * level.mass, dbe2SoFar + n * level.valenceExcess);
+        }
+    }
+
+    void emit(std::int64_t dbe2) {
+        FormulaParser::ElementCounts& out = candidate.counts;
+        out.clear();
+        std::int64_t nominal = 0;
+        for (size_t i = 0; i < levels.size(); ++i) {
+            if (counts[i] != 0) {
+                out.add(levels[i].z, counts[i]);
+                nominal += counts[i] * levels[i].nominalMass;
+            }
+        }
+        if (out.empty()) return;
+
+        // Exact mass in ascending atomic number, the same sum calculateMolarMass performs
+        double mass = 0.0;
+        if (query.massType == FormulaEnumerator::MassType::AVERAGE) {
+            mass = out.molarMass();
+        } else {
+            out.forEach([&mass](int z, std::int64_t n) {
+                mass += IsotopeTable::ISOTOPES[IsotopeTable::mostAbundant(z)].mass * static_cast<double>(n);
+            });
+        }
+        if (std::fabs(mass - query.targetMass) > query.tolerance) return;
+
+        if (query.nitrogenRule && (nominal & 1) != (out[7] & 1)) return;
+        if (query.integerDbe && (dbe2 & 1) != 0) return;
+        double dbe = static_cast<double>(dbe2) / 2.0;
+        if (dbe < query.minDbe || dbe > query.maxDbe) return;
+        for (const FormulaEnumerator::RatioLimit& limit : query.ratios) {
+            double n = static_cast<double>(out[limit.atomicNumber]);
+            double reference = static_cast<double>(out[limit.referenceNumber]);
+            if (n < limit.minRatio * reference || n > limit.maxRatio * reference) return;
+        }
+
+        candidate.formula = FormulaEnumerator::hillFormula(out);
+        candidate.mass = mass;
+        candidate.error = mass - query.targetMass;
+        candidate.dbe = dbe;
+        summary.results++;
+        if (!onResult(candidate)) {
+            summary.status = FormulaEnumerator::Status::STOPPED;
+            stopped = true;
+        } else if (query.maxResults != 0 && summary.results >= query.maxResults) {
+            summary.status = FormulaEnumerator::Status::RESULT_LIMIT;
+            stopped = true;
+        }
+    }
+};
+
+} // namespace
+
+FormulaEnumerator::Summary FormulaEnumerator::enumerate(const Query& query,
+                                                        const std::function<bool(const Candidate&)>& onResult) {
+    Summary invalid;
+    invalid.status = Status::INVALID_QUERY;
+    if (query.elements.empty() || !(query.tolerance >= 0.0) || !(query.targetMass > 0.0)) {
+        return invalid;
+    }
+
+    std::vector<Level> levels;
+    for (const ElementRange& range : query.elements) {
+        int z = range.atomicNumber;
+        if (z <= 0 || z > PeriodicTable::ELEMENT_COUNT || range.minCount < 0 ||
+            (range.maxCount >= 0 && range.maxCount < range.minCount)) {
+            return invalid;
+        }
+        for (const Level& level : levels) {
+            if (level.z == z) return invalid;
+        }
+
+        int isotope = IsotopeTable::mostAbundant(z);
+        if (query.massType == MassType::MONOISOTOPIC && isotope < 0) {
+            return invalid;
+        }
+        Level level;
+        level.z = z;
+        level.mass = query.massType == MassType::AVERAGE ? PeriodicTable::atomicMass(z)
+                                                         : IsotopeTable::ISOTOPES[isotope].mass;
+        level.minCount = range.minCount;
+        // Without an explicit cap the count is bounded by the mass window alone
+        std::int64_t massCap = static_cast<std::int64_t>((query.targetMass + query.tolerance) / level.mass);
+        level.maxCount = range.maxCount >= 0 ? std::min<std::int64_t>(range.maxCount, massCap) : massCap;
+        level.valenceExcess = VALENCES[z] - 2;
+        level.nominalMass = isotope >= 0 ? IsotopeTable::ISOTOPES[isotope].massNumber
+                                         : static_cast<int>(std::lround(PeriodicTable::atomicMass(z)));
+        if (level.maxCount < level.minCount) {
+            return Summary{}; // Nothing fits: complete, no results
+        }
+        levels.push_back(level);
+    }
+    for (const RatioLimit& limit : query.ratios) {
+        auto inAlphabet = [&levels](int z) {
+            return std::any_of(levels.begin(), levels.end(), [z](const Level& level) { return level.z == z; });
+        };
+        if (limit.atomicNumber == limit.referenceNumber || !inAlphabet(limit.atomicNumber) ||
+            !inAlphabet(limit.referenceNumber) || !(limit.minRatio >= 0.0) || !(limit.maxRatio >= limit.minRatio)) {
+            return invalid;
+        }
+    }
+
+    // Heaviest first: few choices near the root, and the light element that closes the gap last
+    std::sort(levels.begin(), levels.end(), [](const Level& a, const Level& b) {
+        return a.mass != b.mass ? a.mass > b.mass : a.z < b.z;
+    });
+
+    Search search(query, std::move(levels), onResult);
+    return search.run();
+}
+
+std::vector<FormulaEnumerator::Candidate> FormulaEnumerator::find(const Query& query, Summary* summary) {
+    std::vector<Candidate> results;
+    Summary done = enumerate(query, [&results](const Candidate& candidate) {
+        results.push_back(candidate);
+        return true;
+    });
+    std::sort(results.begin(), results.end(), [](const Candidate& a, const Candidate& b) {
+        double ea = std::fabs(a.error), eb = std::fabs(b.error);
+        return ea != eb ? ea < eb : a.formula < b.formula;
+    });
+    if (summary) {
+        *summary = done;
+    }
+    return results;
+}
+
+FormulaEnumerator::Query FormulaEnumerator::organicQuery(double targetMass, double tolerance,
+                                                         const std::vector<int>& extraElements) {
+    Query query;
+    query.targetMass = targetMass;
+    query.tolerance = tolerance;
+    for (int z : {6, 1, 7, 8, 16}) {
+        query.elements.push_back(ElementRange{z, 0, -1});
+    }
+    for (int z : extraElements) {
+        query.elements.push_back(ElementRange{z, 0, -1});
+    }
+    query.elements[0].minCount = 1; // At least one carbon
+    query.nitrogenRule = true;
+    query.integerDbe = true;
+    query.minDbe = 0.0;
+
+    // Element/carbon ranges of Kind & Fiehn, BMC Bioinformatics 8:105 (2007), rule 4
+    query.ratios = {{1, 6, 0.2, 3.1}, {7, 6, 0.0, 1.3}, {8, 6, 0.0, 1.2}, {16, 6, 0.0, 0.8}};
+    const std::pair<int, double> extraLimits[] = {{9, 1.5}, {17, 0.8}, {35, 0.8}, {14, 0.5}, {15, 0.3}};
+    for (int z : extraElements) {
+        for (const auto& extra : extraLimits) {
+            if (extra.first == z) {
+                query.ratios.push_back(RatioLimit{z, 6, 0.0, extra.second});
+            }
+        }
+    }
+    return query;
+}
+
+double FormulaEnumerator::degreeOfUnsaturation(const FormulaParser::ElementCounts& counts) {
+    std::int64_t dbe2 = 2;
+    counts.forEach([&dbe2](int z, std::int64_t n) { dbe2 += n * (VALENCES[z] - 2); });
+    return static_cast<double>(dbe2) / 2.0;
+}
+
+int FormulaEnumerator::valence(int atomicNumber) {
+    return VALENCES[atomicNumber];
+}
+
+std::string FormulaEnumerator::hillFormula(const FormulaParser::ElementCounts& counts) {
+    return CanonicalFormula::hill(counts);
+}
+
+const char* FormulaEnumerator::statusMessage(Status status) {
+    switch (status) {
+        case Status::COMPLETE: return "Complete";
+        case Status::RESULT_LIMIT: return "Stopped at the result limit";
+        case Status::WORK_LIMIT: return "Stopped at the work limit: results may be incomplete";
+        case Status::STOPPED: return "Stopped by the caller";
+        case Status::INVALID_QUERY: return "Invalid query";
+        default: return "Unknown status";
+    }
+}
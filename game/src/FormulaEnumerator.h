@@ -0,0 +1,109 @@
+#ifndef FORMULAENUMERATOR_H
+#define FORMULAENUMERATOR_H
+
+#include "FormulaParser.h"
+#include <cstdint>
+#include <functional>
+#include <limits>
+#include <string>
+#include <vector>
+
+/**
+ * @brief FormulaEnumerator - Finds every formula whose mass matches a target
+ * The inverse of ChemistryEngine::calculateMolarMass: a depth-first
+ * branch-and-bound search over the chosen elements. Elements are assigned
+ * heaviest first. At every level the count range is cut to what the remaining
+ * mass window still allows, given the least and most mass the lighter elements
+ * can add. The last (lightest) element's count is then solved directly,
+ * together with the degree-of-unsaturation window. Results are streamed to a
+ * callback in a fixed order, and the search stops early at a result cap or a
+ * work cap.
+ */
+class FormulaEnumerator {
+public:
+    enum class MassType {
+        AVERAGE,      // Standard atomic weights, as in calculateMolarMass
+        MONOISOTOPIC  // Most abundant isotope of each element (IsotopeTable)
+    };
+
+    struct ElementRange {
+        int atomicNumber = 0;
+        int minCount = 0;
+        int maxCount = -1; // -1: limited only by the target mass
+    };
+
+    // Keeps minRatio * n(reference) <= n(element) <= maxRatio * n(reference), e.g. H/C.
+    // Both elements must be in the query's alphabet.
+    struct RatioLimit {
+        int atomicNumber = 0;
+        int referenceNumber = 6;
+        double minRatio = 0.0;
+        double maxRatio = std::numeric_limits<double>::infinity();
+    };
+
+    struct Query {
+        double targetMass = 0.0;
+        double tolerance = 0.01; // Absolute, in g/mol (or u)
+        std::vector<ElementRange> elements;
+        MassType massType = MassType::AVERAGE;
+
+        // Plausibility filters
+        bool nitrogenRule = false; // Nominal mass and nitrogen count have the same parity
+        bool integerDbe = false;   // Even-electron species only (no half-integer unsaturation)
+        double minDbe = -std::numeric_limits<double>::infinity(); // Degree of unsaturation window
+        double maxDbe = std::numeric_limits<double>::infinity();
+        std::vector<RatioLimit> ratios;
+
+        // Limits (0 = none)
+        size_t maxResults = 0;
+        std::uint64_t maxNodes = 0; // Count assignments tried before giving up
+    };
+
+    struct Candidate {
+        FormulaParser::ElementCounts counts;
+        std::string formula; // Hill order: C, H, then alphabetical
+        double mass = 0.0;   // Exact mass of the formula for the query's MassType
+        double error = 0.0;  // mass - targetMass
+        double dbe = 0.0;    // Rings plus double bonds
+    };
+
+    enum class Status {
+        COMPLETE,      // Every matching formula was reported
+        RESULT_LIMIT,  // Stopped at maxResults
+        WORK_LIMIT,    // Stopped at maxNodes: the answer may be incomplete
+        STOPPED,       // The callback asked to stop
+        INVALID_QUERY  // Empty alphabet, unknown element, negative tolerance, bad ratio or missing isotope data
+    };
+
+    struct Summary {
+        Status status = Status::COMPLETE;
+        size_t results = 0;
+        std::uint64_t nodes = 0;
+    };
+
+    // Streams every match to onResult (return false to stop)
+    static Summary enumerate(const Query& query, const std::function<bool(const Candidate&)>& onResult);
+
+    // Collects the matches, closest to the target first
+    static std::vector<Candidate> find(const Query& query, Summary* summary = nullptr);
+
+    // CHNOS (plus optional extra elements) restricted to plausible organic molecules: the
+    // nitrogen rule, a non-negative integer DBE, and the element/carbon ratio ranges that
+    // cover nearly all known compounds (Kind & Fiehn's "Seven Golden Rules"): H/C 0.2-3.1,
+    // N/C <= 1.3, O/C <= 1.2, S/C <= 0.8, plus F, Cl, Br, Si and P when requested.
+    // The H/C floor also caps the DBE at 1 + 0.9 C + N/2.
+    static Query organicQuery(double targetMass, double tolerance, const std::vector<int>& extraElements = {});
+
+    // Degree of unsaturation, 1 + sum of n * (valence - 2) / 2 with each element's usual valence
+    static double degreeOfUnsaturation(const FormulaParser::ElementCounts& counts);
+
+    // Usual (lowest common) valence used for the DBE: H 1, C 4, N 3, O 2, ...
+    static int valence(int atomicNumber);
+
+    // Formula text in Hill order (same as CanonicalFormula::hill)
+    static std::string hillFormula(const FormulaParser::ElementCounts& counts);
+
+    static const char* statusMessage(Status status);
+};
+
+#endif // FORMULAENUMERATOR_H
@@ -0,0 +1,209 @@
+#include "FormulaMatrix.h"
+#include "FormulaMatrixKernels.h"
+#include <algorithm>
+#include <limits>
+#include <stdexcept>
+
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+#include <intrin.h>
+#endif
+
+namespace {
+
+// Rows processed per block, so the output block stays in L1 while all columns stream past
+constexpr size_t BLOCK_ROWS = 1024;
+
+// out[i] += double(counts[i]) * mass for i in [0, n)
+void accumulateScalar(const std::int32_t* counts, double mass, double* out, size_t n) {
+    for (size_t i = 0; i < n; ++i) {
+        double product = static_cast<double>(counts[i]) * mass;
+        out[i] += product;
+    }
+}
+
+enum class CpuLevel { BASE, AVX2, AVX512 };
+
+// Widest vector extension both the CPU and the operating system support
+CpuLevel detectCpu() {
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return CpuLevel::BASE;
+    }
+    constexpr int OSXSAVE = 1 << 27, AVX = 1 << 28;
+    __cpuid(info, 1);
+    if ((info[2] & (OSXSAVE | AVX)) != (OSXSAVE | AVX)) {
+        return CpuLevel::BASE;
+    }
+    unsigned long long xcr0 = _xgetbv(0);
+    if ((xcr0 & 0x6) != 0x6) { // The OS must save the XMM and YMM registers
+        return CpuLevel::BASE;
+    }
+    __cpuidex(info, 7, 0);
+    if (!(info[1] & (1 << 5))) {
+        return CpuLevel::BASE;
+    }
+    // AVX-512F also needs the opmask and ZMM state saved
+    return (info[1] & (1 << 16)) && (xcr0 & 0xE6) == 0xE6 ? CpuLevel::AVX512 : CpuLevel::AVX2;
+#elif (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) {
+        return CpuLevel::AVX512;
+    }
+    return __builtin_cpu_supports("avx2") ? CpuLevel::AVX2 : CpuLevel::BASE;
+#else
+    return CpuLevel::BASE;
+#endif
+}
+
+struct Kernel {
+    FormulaMatrixKernels::Accumulate accumulate;
+    const char* name;
+};
+
+Kernel pickKernel() {
+    CpuLevel cpu = detectCpu();
+    if (cpu == CpuLevel::AVX512 && FormulaMatrixKernels::avx512) {
+        return {FormulaMatrixKernels::avx512, "avx512"};
+    }
+    if (cpu != CpuLevel::BASE && FormulaMatrixKernels::avx2) {
+        return {FormulaMatrixKernels::avx2, "avx2"};
+    }
+    return {accumulateScalar, "scalar"};
+}
+
+// Chosen once, on first use
+const Kernel& kernel() {
+    static const Kernel selected = pickKernel();
+    return selected;
+}
+
+} // namespace
+
+FormulaMatrix::FormulaMatrix() : rowCount(0), rowCapacity(0) {
+    std::fill(std::begin(columnOfElement), std::end(columnOfElement), -1);
+}
+
+FormulaMatrix::FormulaMatrix(const std::vector<ChemistryEngine::ChemicalFormula>& formulas)
+    : FormulaMatrix() {
+    reserve(formulas.size());
+    for (const auto& formula : formulas) {
+        add(formula);
+    }
+}
+
+std::vector<std::int32_t>& FormulaMatrix::columnFor(int z) {
+    if (columnOfElement[z] < 0) {
+        columnOfElement[z] = static_cast<int>(columnElements.size());
+        columnElements.push_back(z);
+        columnData.emplace_back();
+        std::vector<std::int32_t>& column = columnData.back();
+        column.reserve(rowCapacity);
+        column.resize(rowCount, 0);
+    }
+    return columnData[columnOfElement[z]];
+}
+
+size_t FormulaMatrix::add(const FormulaParser::ElementCounts& counts) {
+    // Validate first so a failed add leaves the matrix unchanged
+    counts.forEach([](int, std::int64_t n) {
+        if (n > std::numeric_limits<std::int32_t>::max() || n < std::numeric_limits<std::int32_t>::min()) {
+            throw std::overflow_error("Element count does not fit the formula matrix");
+        }
+    });
+    counts.forEach([this](int z, std::int64_t) { columnFor(z); });
+
+    for (auto& column : columnData) {
+        column.push_back(0);
+    }
+    counts.forEach([this](int z, std::int64_t n) {
+        columnData[columnOfElement[z]][rowCount] = static_cast<std::int32_t>(n);
+    });
+    if (counts.isotopeCount != 0 && massCorrections.empty()) {
+        massCorrections.reserve(rowCapacity);
+        massCorrections.resize(rowCount, 0.0);
+    }
+    if (!massCorrections.empty() || counts.isotopeCount != 0) {
+        massCorrections.push_back(counts.isotopeCount != 0 ? counts.isotopeMassCorrection() : 0.0);
+    }
+    return rowCount++;
+}
+
+size_t FormulaMatrix::add(const ChemistryEngine::ChemicalFormula& formula) {
+    return add(formula.counts());
+}
+
+size_t FormulaMatrix::add(std::string_view formula) {
+    thread_local FormulaParser::ElementCounts counts;
+    FormulaParser::Result result = FormulaParser::parse(formula, counts);
+    if (!result.ok()) {
+        throw std::invalid_argument(std::string(FormulaParser::errorMessage(result.error)) +
+                                    " in formula \"" + std::string(formula) + "\"");
+    }
+    return add(counts);
+}
+
+void FormulaMatrix::reserve(size_t rows) {
+    rowCapacity = std::max(rowCapacity, rows);
+    for (auto& column : columnData) {
+        column.reserve(rows);
+    }
+    if (!massCorrections.empty()) {
+        massCorrections.reserve(rows);
+    }
+}
+
+void FormulaMatrix::clear() {
+    columnElements.clear();
+    columnData.clear();
+    massCorrections.clear();
+    std::fill(std::begin(columnOfElement), std::end(columnOfElement), -1);
+    rowCount = 0;
+    rowCapacity = 0;
+}
+
+std::int32_t FormulaMatrix::count(size_t row, int z) const {
+    if (z <= 0 || z > PeriodicTable::ELEMENT_COUNT || columnOfElement[z] < 0) {
+        return 0;
+    }
+    return columnData[columnOfElement[z]][row];
+}
+
+std::vector<double> FormulaMatrix::molarMasses() const {
+    std::vector<double> masses(rowCount);
+    molarMasses(masses.data());
+    return masses;
+}
+
+void FormulaMatrix::molarMasses(double* out) const {
+    // Same summation order as ElementCounts::molarMass: ascending atomic number
+    std::vector<int> order(columnElements.size());
+    for (size_t c = 0; c < order.size(); ++c) {
+        order[c] = static_cast<int>(c);
+    }
+    std::sort(order.begin(), order.end(), [this](int a, int b) {
+        return columnElements[a] < columnElements[b];
+    });
+
+    const FormulaMatrixKernels::Accumulate accumulateColumn = kernel().accumulate;
+    for (size_t start = 0; start < rowCount; start += BLOCK_ROWS) {
+        size_t n = std::min(BLOCK_ROWS, rowCount - start);
+        std::fill(out + start, out + start + n, 0.0);
+        for (int c : order) {
+            double mass = PeriodicTable::atomicMass(columnElements[c]);
+            accumulateColumn(columnData[c].data() + start, mass, out + start, n);
+        }
+        if (!massCorrections.empty()) {
+            for (size_t i = start; i < start + n; ++i) {
+                if (massCorrections[i] != 0.0) {
+                    out[i] += massCorrections[i];
+                }
+            }
+        }
+    }
+}
+
+const char* FormulaMatrix::kernelName() {
+    return kernel().name;
+}
@@ -0,0 +1,61 @@
+#ifndef FORMULAMATRIX_H
+#define FORMULAMATRIX_H
+
+#include "ChemistryEngine.h"
+#include "FormulaParser.h"
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief FormulaMatrix - Column-oriented element-count matrix for batch molar masses
+ * Each element that occurs in the batch owns one column of 32-bit counts (one row
+ * per formula). Molar masses are the dot product of every row with the atomic-mass
+ * vector, computed column by column so the inner loop is a straight SIMD
+ * multiply-add over contiguous counts. The AVX-512 or AVX2 kernel is picked at
+ * run time from what the CPU supports, with a scalar kernel as the fallback.
+ *
+ * Columns are visited in ascending atomic number and each product is rounded
+ * before it is added (no FMA), so the results are bit-identical to
+ * ChemistryEngine::calculateMolarMass on the same formula. Rows with explicit
+ * isotopes carry their isotope mass correction, added after the last column.
+ */
+class FormulaMatrix {
+public:
+    FormulaMatrix();
+    explicit FormulaMatrix(const std::vector<ChemistryEngine::ChemicalFormula>& formulas);
+
+    // Append one formula as a new row; returns the row index.
+    // Throws std::overflow_error if a count does not fit in 32 bits.
+    size_t add(const FormulaParser::ElementCounts& counts);
+    size_t add(const ChemistryEngine::ChemicalFormula& formula);
+    size_t add(std::string_view formula); // Throws std::invalid_argument if malformed
+
+    void reserve(size_t rows);
+    void clear();
+
+    size_t rows() const { return rowCount; }
+    size_t columns() const { return columnElements.size(); }
+
+    // Count of element z in a row (0 if the element has no column)
+    std::int32_t count(size_t row, int z) const;
+
+    // Molar mass of every row, in row order
+    std::vector<double> molarMasses() const;
+    void molarMasses(double* out) const;
+
+    // Name of the kernel this CPU runs ("avx512", "avx2" or "scalar")
+    static const char* kernelName();
+
+private:
+    std::vector<int> columnElements;                 // Atomic number of each column
+    std::vector<std::vector<std::int32_t>> columnData; // One count column per element
+    std::vector<double> massCorrections;             // Per row; empty until a row has isotopes
+    int columnOfElement[PeriodicTable::ELEMENT_COUNT + 1];
+    size_t rowCount;
+    size_t rowCapacity; // From reserve(), applied to columns created later
+
+    std::vector<std::int32_t>& columnFor(int z);
+};
+
+#endif // FORMULAMATRIX_H
@@ -0,0 +1,29 @@
+#include "FormulaMatrixKernels.h"
+
+// Built with AVX2 enabled (see CMakeLists.txt and the vcxproj). Keep this file free of
+// inline functions from other headers: their AVX2 copies could be linked in for everyone.
+#if defined(__AVX2__)
+#include <immintrin.h>
+
+namespace {
+
+void accumulateAvx2(const std::int32_t* counts, double mass, double* out, size_t n) {
+    size_t i = 0;
+    const __m256d massVec = _mm256_set1_pd(mass);
+    for (; i + 4 <= n; i += 4) {
+        __m128i packed = _mm_loadu_si128(reinterpret_cast<const __m128i*>(counts + i));
+        __m256d product = _mm256_mul_pd(_mm256_cvtepi32_pd(packed), massVec);
+        _mm256_storeu_pd(out + i, _mm256_add_pd(_mm256_loadu_pd(out + i), product));
+    }
+    for (; i < n; ++i) {
+        double product = static_cast<double>(counts[i]) * mass;
+        out[i] += product;
+    }
+}
+
+} // namespace
+
+const FormulaMatrixKernels::Accumulate FormulaMatrixKernels::avx2 = accumulateAvx2;
+#else
+const FormulaMatrixKernels::Accumulate FormulaMatrixKernels::avx2 = nullptr;
+#endif
@@ -0,0 +1,30 @@
+#include "FormulaMatrixKernels.h"
+
+// Built with AVX-512F enabled (see CMakeLists.txt and the vcxproj). Keep this file free of
+// inline functions from other headers: their AVX-512 copies could be linked in for everyone.
+#if defined(__AVX512F__)
+#include <immintrin.h>
+
+namespace {
+
+void accumulateAvx512(const std::int32_t* counts, double mass, double* out, size_t n) {
+    size_t i = 0;
+    const __m512d massVec = _mm512_set1_pd(mass);
+    for (; i + 8 <= n; i += 8) {
+        __m256i packed = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(counts + i));
+        // Full-mask maskz form: GCC warns about the undefined source inside _mm512_cvtepi32_pd
+        __m512d product = _mm512_mul_pd(_mm512_maskz_cvtepi32_pd(0xFF, packed), massVec);
+        _mm512_storeu_pd(out + i, _mm512_add_pd(_mm512_loadu_pd(out + i), product));
+    }
+    for (; i < n; ++i) {
+        double product = static_cast<double>(counts[i]) * mass;
+        out[i] += product;
+    }
+}
+
+} // namespace
+
+const FormulaMatrixKernels::Accumulate FormulaMatrixKernels::avx512 = accumulateAvx512;
+#else
+const FormulaMatrixKernels::Accumulate FormulaMatrixKernels::avx512 = nullptr;
+#endif
@@ -0,0 +1,24 @@
+#ifndef FORMULAMATRIXKERNELS_H
+#define FORMULAMATRIXKERNELS_H
+
+#include <cstddef>
+#include <cstdint>
+
+/**
+ * @brief FormulaMatrixKernels - SIMD column kernels used by FormulaMatrix
+ * Each kernel computes out[i] += double(counts[i]) * mass for i in [0, n), rounding
+ * the product before the add. The AVX2 and AVX-512 kernels live in their own
+ * translation units, the only ones built with those instruction sets; FormulaMatrix
+ * calls them only after checking the CPU. A pointer is null when the compiler
+ * could not build that kernel (e.g. on a non-x86 target).
+ */
+namespace FormulaMatrixKernels {
+
+using Accumulate = void (*)(const std::int32_t* counts, double mass, double* out, size_t n);
+
+extern const Accumulate avx2;
+extern const Accumulate avx512;
+
+} // namespace FormulaMatrixKernels
+
+#endif // FORMULAMATRIXKERNELS_H
@@ -0,0 +1,579 @@
+#include "FormulaParser.h"
+#include "CheckedMath.h"
+#include <algorithm>
+#include <istream>
+#include <limits>
+
+namespace {
+
+constexpr std::int64_t INT64_LIMIT = std::numeric_limits<std::int64_t>::max();
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+bool isLower(char c) { return c >= 'a' && c <= 'z'; }
+bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+// Appends a decimal digit to a count; false once the count no longer fits
+bool appendDigit(std::int64_t& count, char digit) {
+    std::int64_t value = digit - '0';
+    if (count > (INT64_LIMIT - value) / 10) {
+        return false;
+    }
+    count = count * 10 + value;
+    return true;
+}
+
+// Reads an optional count; a missing count means 1, and -1 means it overflowed
+std::int64_t readCount(std::string_view formula, size_t& pos) {
+    if (pos >= formula.size() || !isDigit(formula[pos])) {
+        return 1;
+    }
+    std::int64_t count = 0;
+    while (pos < formula.size() && isDigit(formula[pos])) {
+        if (!appendDigit(count, formula[pos])) {
+            return -1;
+        }
+        pos++;
+    }
+    return count;
+}
+
+// parent += multiplier * group, like ElementCounts::addScaled but with overflow checks.
+// On failure parent is left partly updated, which is fine: the parse is abandoned.
+FormulaParser::Error foldGroup(FormulaParser::ElementCounts& parent, const FormulaParser::ElementCounts& group,
+                               std::int64_t multiplier) {
+    bool fits = true;
+    group.forEach([&](int z, std::int64_t n) {
+        std::int64_t scaled = 0;
+        std::int64_t sum = 0;
+        if (checkedMul(n, multiplier, scaled) && checkedAdd(parent[z], scaled, sum)) {
+            parent.add(z, scaled);
+        } else {
+            fits = false;
+        }
+    });
+    std::int64_t charge = 0;
+    if (!fits || !checkedMul(group.charge, multiplier, charge) || !checkedAdd(parent.charge, charge, parent.charge)) {
+        return FormulaParser::Error::COUNT_OVERFLOW;
+    }
+    // Label counts never exceed their element's count, so they cannot overflow here
+    if (group.isotopeCount != 0 && !parent.addScaledLabels(group, multiplier)) {
+        return FormulaParser::Error::TOO_MANY_ISOTOPES;
+    }
+    return FormulaParser::Error::NONE;
+}
+
+// Character classes: the DFA dispatches on the class of the byte that starts a token
+enum CharClass : std::uint8_t {
+    C_OTHER,
+    C_UPPER,
+    C_DIGIT,
+    C_OPEN_PAREN,
+    C_CLOSE_PAREN,
+    C_OPEN_BRACKET,
+    C_CLOSE_BRACKET,
+    C_DOT,      // '.' or '*'
+    C_CARET,
+    C_SPACE,
+    C_LEAD_C2,  // First byte of U+00B7 (middle dot)
+    C_LEAD_E2,  // First byte of U+2022 (bullet)
+    C_CONT_80,
+    C_CONT_A2,
+    C_CONT_B7,
+    CLASS_COUNT
+};
+
+enum State : std::uint8_t {
+    S_BEGIN,      // Start of the formula: no dot or charge yet
+    S_MULTIPLIER, // Right after a dot: the component's multiplier may follow
+    S_COMPONENT,  // After a dot and its multiplier: something must follow
+    S_READY,      // After a complete token
+    S_DOT_C2,     // Inside the UTF-8 middle dot
+    S_DOT_E2,     // Inside the UTF-8 bullet, one byte read
+    S_DOT_E2_80,  // Inside the UTF-8 bullet, two bytes read
+    STATE_COUNT
+};
+
+// Every action consumes a whole token (symbol and count, bracket and multiplier, ...)
+enum Action : std::uint8_t {
+    A_ERROR,         // Unexpected character
+    A_SKIP,
+    A_ELEMENT,
+    A_OPEN_PAREN,
+    A_OPEN_BRACKET,  // A group, or an isotope when a digit follows
+    A_CLOSE_PAREN,
+    A_CLOSE_BRACKET,
+    A_CHARGE,
+    A_DOT,           // Single-byte dot
+    A_DOT_LEAD,      // First byte of a UTF-8 dot
+    A_DOT_END,       // Last byte of a UTF-8 dot
+    A_MULTIPLIER     // Leading multiplier of a dot component, e.g. the 5 in CuSO4.5H2O
+};
+
+struct Transition {
+    std::uint8_t next = S_READY;
+    std::uint8_t action = A_ERROR;
+};
+
+using TransitionTable = std::array<std::array<Transition, CLASS_COUNT>, STATE_COUNT>;
+
+constexpr std::array<std::uint8_t, 256> buildCharClasses() {
+    std::array<std::uint8_t, 256> classes{};
+    for (int c = 'A'; c <= 'Z'; ++c) classes[c] = C_UPPER;
+    for (int c = '0'; c <= '9'; ++c) classes[c] = C_DIGIT;
+    classes['('] = C_OPEN_PAREN;
+    classes[')'] = C_CLOSE_PAREN;
+    classes['['] = C_OPEN_BRACKET;
+    classes[']'] = C_CLOSE_BRACKET;
+    classes['.'] = C_DOT;
+    classes['*'] = C_DOT;
+    classes['^'] = C_CARET;
+    classes[' '] = C_SPACE;
+    classes['\t'] = C_SPACE;
+    classes['\n'] = C_SPACE;
+    classes['\r'] = C_SPACE;
+    classes[0xC2] = C_LEAD_C2;
+    classes[0xE2] = C_LEAD_E2;
+    classes[0x80] = C_CONT_80;
+    classes[0xA2] = C_CONT_A2;
+    classes[0xB7] = C_CONT_B7;
+    return classes;
+}
+
+constexpr void set(TransitionTable& table, State from, CharClass cls, State next, Action action) {
+    table[from][cls] = Transition{next, action};
+}
+
+constexpr TransitionTable buildTransitions() {
+    TransitionTable table{};
+    for (State state : {S_BEGIN, S_MULTIPLIER, S_COMPONENT, S_READY}) {
+        set(table, state, C_UPPER, S_READY, A_ELEMENT);
+        set(table, state, C_OPEN_PAREN, S_READY, A_OPEN_PAREN);
+        set(table, state, C_OPEN_BRACKET, S_READY, A_OPEN_BRACKET);
+        set(table, state, C_CLOSE_PAREN, S_READY, A_CLOSE_PAREN);
+        set(table, state, C_CLOSE_BRACKET, S_READY, A_CLOSE_BRACKET);
+        set(table, state, C_SPACE, state, A_SKIP);
+    }
+    // Charges and dots need something before them
+    set(table, S_READY, C_CARET, S_READY, A_CHARGE);
+    set(table, S_READY, C_DOT, S_MULTIPLIER, A_DOT);
+    set(table, S_MULTIPLIER, C_DIGIT, S_COMPONENT, A_MULTIPLIER);
+    set(table, S_READY, C_LEAD_C2, S_DOT_C2, A_DOT_LEAD);
+    set(table, S_READY, C_LEAD_E2, S_DOT_E2, A_DOT_LEAD);
+
+    set(table, S_DOT_C2, C_CONT_B7, S_MULTIPLIER, A_DOT_END);
+    set(table, S_DOT_E2, C_CONT_80, S_DOT_E2_80, A_SKIP);
+    set(table, S_DOT_E2_80, C_CONT_A2, S_MULTIPLIER, A_DOT_END);
+    return table;
+}
+
+constexpr std::array<std::uint8_t, 256> CHAR_CLASS = buildCharClasses();
+
+// The class table folded into the transition table, so each token costs a single lookup
+constexpr std::array<std::array<Transition, 256>, STATE_COUNT> buildByteTransitions() {
+    const TransitionTable byClass = buildTransitions();
+    std::array<std::array<Transition, 256>, STATE_COUNT> table{};
+    for (int state = 0; state < STATE_COUNT; ++state) {
+        for (int c = 0; c < 256; ++c) {
+            table[state][c] = byClass[state][CHAR_CLASS[c]];
+        }
+    }
+    return table;
+}
+
+constexpr std::array<std::array<Transition, 256>, STATE_COUNT> TRANSITIONS = buildByteTransitions();
+
+// States in which the input may end
+constexpr bool isAccepting(std::uint8_t state) { return state == S_BEGIN || state == S_READY; }
+
+} // namespace
+
+FormulaParser::Result FormulaParser::run(std::string_view text, size_t base, bool last, Cursor& cursor,
+                                         std::vector<GroupFrame>& frames, ElementCounts& out, size_t& consumed) {
+    size_t depth = cursor.depth;
+    std::int64_t componentScale = cursor.componentScale;
+    std::int64_t scale = cursor.scale; // componentScale at depth 0, else 1
+    std::uint8_t state = cursor.state;
+    size_t dotStart = cursor.dotStart;
+    ElementCounts* current = depth == 0 ? &out : &frames[depth - 1].counts;
+
+    // Leaves the frames clean for the next parse; position is an input offset
+    auto fail = [&](Error error, size_t position) {
+        for (size_t i = 0; i < depth; ++i) {
+            frames[i].counts.clear();
+        }
+        cursor = Cursor{};
+        consumed = text.size();
+        return Result{error, position};
+    };
+
+    // Stops before the token at start, to be read again with the next chunk
+    auto suspend = [&](size_t start, std::uint8_t previous) {
+        cursor = Cursor{depth, componentScale, scale, previous, dotStart};
+        consumed = start;
+        return Result{};
+    };
+
+    auto pushFrame = [&](char open, size_t position) {
+        if (frames.size() == depth) {
+            frames.emplace_back();
+        }
+        frames[depth].openPosition = position;
+        frames[depth].open = open;
+        current = &frames[depth].counts;
+        depth++;
+        scale = 1;
+    };
+
+    const size_t size = text.size();
+
+    // A token runs to the end of the text: in a chunk, more letters or digits may follow
+    auto endOfText = [&](size_t start, std::uint8_t previous) {
+        return last ? fail(Error::UNEXPECTED_END, base + size) : suspend(start, previous);
+    };
+
+    // Whitespace may separate a symbol or a closing bracket from its count ("H 2O", "(OH) 2"):
+    // moves pos onto the count when digits follow. False when the text ends inside the
+    // whitespace of a chunk, as a count may still follow in the next one.
+    auto skipToCount = [&](size_t& pos) {
+        if (pos >= size || !isSpace(text[pos])) {
+            return true;
+        }
+        size_t next = pos;
+        while (next < size && isSpace(text[next])) {
+            next++;
+        }
+        if (next == size) {
+            return last;
+        }
+        if (isDigit(text[next])) {
+            pos = next;
+        }
+        return true;
+    };
+
+    size_t pos = 0;
+    while (pos < size) {
+        const size_t start = pos;
+        const char c = text[pos++];
+        const std::uint8_t previous = state;
+        const Transition transition = TRANSITIONS[previous][static_cast<unsigned char>(c)];
+        state = transition.next;
+
+        switch (transition.action) {
+            case A_SKIP:
+                break;
+            case A_ELEMENT: {
+                char second = (pos < size && isLower(text[pos])) ? text[pos] : '\0';
+                pos += second == '\0' ? 0 : 1;
+                if (!skipToCount(pos)) {
+                    return suspend(start, previous);
+                }
+                // Hot path: the count is read here rather than through readCount
+                std::int64_t count = 1;
+                if (pos < size && isDigit(text[pos])) {
+                    const size_t digits = pos;
+                    std::uint64_t value = 0;
+                    do {
+                        value = value * 10 + static_cast<std::uint64_t>(text[pos] - '0');
+                        pos++;
+                    } while (pos < size && isDigit(text[pos]));
+                    count = static_cast<std::int64_t>(value);
+                    // Up to 18 digits always fit; a longer count is read again with overflow checks
+                    if (pos - digits > 18) {
+                        pos = digits;
+                        count = readCount(text, pos);
+                        if (count < 0) {
+                            return fail(Error::COUNT_OVERFLOW, base + start);
+                        }
+                    }
+                }
+                if (pos == size && !last) {
+                    return suspend(start, previous);
+                }
+                int z = PeriodicTable::atomicNumber(c, second);
+                if (z == 0) {
+                    return fail(Error::UNKNOWN_ELEMENT, base + start);
+                }
+                if (count == 0) {
+                    return fail(Error::ZERO_COUNT, base + start);
+                }
+                std::int64_t atoms = 0;
+                std::int64_t total = 0;
+                if (!checkedMul(count, scale, atoms) || !checkedAdd((*current)[z], atoms, total)) {
+                    return fail(Error::COUNT_OVERFLOW, base + start);
+                }
+                current->add(z, atoms);
+                break;
+            }
+            case A_OPEN_PAREN:
+                pushFrame('(', base + start);
+                break;
+            case A_OPEN_BRACKET: {
+                if (pos == size && !last) {
+                    return suspend(start, previous);
+                }
+                if (pos >= size || !isDigit(text[pos])) {
+                    pushFrame('[', base + start);
+                    break;
+                }
+                // Isotope: [mass number, symbol] then an optional count
+                std::int64_t massNumber = readCount(text, pos);
+                if (massNumber < 0) {
+                    return fail(Error::UNKNOWN_ISOTOPE, base + start);
+                }
+                if (pos >= size) {
+                    return endOfText(start, previous);
+                }
+                char first = text[pos];
+                if (CHAR_CLASS[static_cast<unsigned char>(first)] != C_UPPER) {
+                    return fail(Error::UNEXPECTED_CHARACTER, base + pos);
+                }
+                if (pos + 1 >= size) {
+                    return endOfText(start, previous);
+                }
+                char second = isLower(text[pos + 1]) ? text[pos + 1] : '\0';
+                int z = PeriodicTable::atomicNumber(first, second);
+                if (z == 0) {
+                    return fail(Error::UNKNOWN_ELEMENT, base + pos);
+                }
+                pos += second == '\0' ? 1 : 2;
+                if (pos >= size) {
+                    return endOfText(start, previous);
+                }
+                if (text[pos] != ']') {
+                    return fail(Error::UNEXPECTED_CHARACTER, base + pos);
+                }
+                pos++;
+                int isotope = massNumber <= 0xFFFF ? IsotopeTable::find(z, static_cast<int>(massNumber)) : -1;
+                if (isotope < 0) {
+                    return fail(Error::UNKNOWN_ISOTOPE, base + start);
+                }
+                if (!skipToCount(pos)) {
+                    return suspend(start, previous);
+                }
+                std::int64_t count = readCount(text, pos);
+                if (count < 0) {
+                    return fail(Error::COUNT_OVERFLOW, base + start);
+                }
+                if (pos == size && !last) {
+                    return suspend(start, previous);
+                }
+                if (count == 0) {
+                    return fail(Error::ZERO_COUNT, base + start);
+                }
+                std::int64_t atoms = 0;
+                std::int64_t total = 0;
+                if (!checkedMul(count, scale, atoms) || !checkedAdd((*current)[z], atoms, total)) {
+                    return fail(Error::COUNT_OVERFLOW, base + start);
+                }
+                if (!current->addIsotope(isotope, atoms)) {
+                    return fail(Error::TOO_MANY_ISOTOPES, base + start);
+                }
+                break;
+            }
+            case A_CLOSE_PAREN:
+            case A_CLOSE_BRACKET: {
+                char open = transition.action == A_CLOSE_PAREN ? '(' : '[';
+                if (depth == 0 || frames[depth - 1].open != open) {
+                    return fail(Error::UNBALANCED_PARENTHESES, base + start);
+                }
+                if (!skipToCount(pos)) {
+                    return suspend(start, previous);
+                }
+                std::int64_t multiplier = readCount(text, pos);
+                if (multiplier < 0) {
+                    return fail(Error::COUNT_OVERFLOW, base + start);
+                }
+                if (pos == size && !last) {
+                    return suspend(start, previous);
+                }
+                if (multiplier == 0) {
+                    return fail(Error::ZERO_COUNT, base + start);
+                }
+
+                // Fold the closed group into its parent and clear it for reuse
+                ElementCounts& group = frames[depth - 1].counts;
+                ElementCounts* parent = depth == 1 ? &out : &frames[depth - 2].counts;
+                if (depth == 1 && !checkedMul(multiplier, componentScale, multiplier)) {
+                    return fail(Error::COUNT_OVERFLOW, base + start);
+                }
+                Error folded = foldGroup(*parent, group, multiplier);
+                group.clear();
+                depth--;
+                current = parent;
+                if (depth == 0) {
+                    scale = componentScale;
+                }
+                if (folded != Error::NONE) {
+                    return fail(folded, base + start);
+                }
+                break;
+            }
+            case A_CHARGE: {
+                // ^2-, ^+ : magnitude (default 1), then the sign
+                std::int64_t magnitude = readCount(text, pos);
+                if (magnitude < 0) {
+                    return fail(Error::COUNT_OVERFLOW, base + start);
+                }
+                if (pos >= size) {
+                    return endOfText(start, previous);
+                }
+                if (text[pos] != '+' && text[pos] != '-') {
+                    return fail(Error::UNEXPECTED_CHARACTER, base + pos);
+                }
+                std::int64_t charge = 0;
+                if (!checkedMul(magnitude, scale, charge) ||
+                    !checkedAdd(current->charge, text[pos] == '+' ? charge : -charge, current->charge)) {
+                    return fail(Error::COUNT_OVERFLOW, base + start);
+                }
+                pos++;
+                break;
+            }
+            case A_DOT_LEAD:
+                dotStart = base + start;
+                break;
+            case A_DOT:
+            case A_DOT_END:
+                if (transition.action == A_DOT) {
+                    dotStart = base + start;
+                }
+                if (depth != 0) {
+                    return fail(Error::UNEXPECTED_CHARACTER, dotStart);
+                }
+                componentScale = 1;
+                scale = 1;
+                break;
+            case A_MULTIPLIER: {
+                pos = start;
+                std::int64_t multiplier = readCount(text, pos);
+                if (multiplier < 0) {
+                    return fail(Error::COUNT_OVERFLOW, base + start);
+                }
+                if (pos == size && !last) {
+                    return suspend(start, previous);
+                }
+                if (multiplier == 0) {
+                    return fail(Error::ZERO_COUNT, base + start);
+                }
+                componentScale = multiplier;
+                scale = multiplier;
+                break;
+            }
+            case A_ERROR:
+            default:
+                // A byte that breaks a UTF-8 dot is reported at the start of the dot
+                return fail(Error::UNEXPECTED_CHARACTER,
+                            (previous == S_DOT_C2 || previous == S_DOT_E2 || previous == S_DOT_E2_80) ? dotStart : base + start);
+        }
+    }
+
+    if (last) {
+        if (!isAccepting(state)) {
+            return fail(Error::UNEXPECTED_END, base + size);
+        }
+        if (depth != 0) {
+            return fail(Error::UNBALANCED_PARENTHESES, frames[depth - 1].openPosition);
+        }
+    }
+    cursor = Cursor{depth, componentScale, scale, state, dotStart};
+    consumed = size;
+    return Result{};
+}
+
+FormulaParser::Result FormulaParser::parse(std::string_view formula, ElementCounts& out) {
+    // Per-thread frame stack, grown to the deepest nesting seen and then reused.
+    // Frames are always left cleared, so a new group starts from zero without a memset.
+    thread_local std::vector<GroupFrame> frames;
+
+    out.clear();
+    Cursor cursor;
+    size_t consumed = 0;
+    return run(formula, 0, true, cursor, frames, out, consumed);
+}
+
+FormulaParser::Result FormulaParser::parse(std::istream& input, ElementCounts& out, size_t chunkSize) {
+    Stream stream(out);
+    std::string buffer(std::max<size_t>(chunkSize, 1), '\0');
+    while (input.read(&buffer[0], static_cast<std::streamsize>(buffer.size())) || input.gcount() > 0) {
+        Result result = stream.feed(std::string_view(buffer.data(), static_cast<size_t>(input.gcount())));
+        if (!result.ok()) {
+            return result;
+        }
+    }
+    return stream.finish();
+}
+
+FormulaParser::Stream::Stream(ElementCounts& out) : out(out) {
+    out.clear();
+}
+
+FormulaParser::Result FormulaParser::Stream::feed(std::string_view chunk) {
+    if (!status.ok()) {
+        return status;
+    }
+
+    if (!pending.empty()) {
+        // Finish the carried token with the start of this chunk, without copying the rest
+        const size_t carried = pending.size();
+        const size_t take = std::min(chunk.size(), MAX_TOKEN_LENGTH);
+        pending.append(chunk.data(), take);
+        size_t consumed = 0;
+        status = run(pending, offset, false, cursor, frames, out, consumed);
+        if (!status.ok()) {
+            return status;
+        }
+        if (consumed == 0) {
+            if (take == chunk.size() && pending.size() <= MAX_TOKEN_LENGTH) {
+                return status; // Still inside the token: wait for more
+            }
+            status = Result{Error::TOKEN_TOO_LONG, offset};
+            return status;
+        }
+        // Tokens after the carried one that started in this chunk are read again from it
+        offset += consumed;
+        chunk.remove_prefix(consumed - carried);
+        pending.clear();
+    }
+
+    size_t consumed = 0;
+    status = run(chunk, offset, false, cursor, frames, out, consumed);
+    if (!status.ok()) {
+        return status;
+    }
+    offset += consumed;
+    if (chunk.size() - consumed > MAX_TOKEN_LENGTH) {
+        status = Result{Error::TOKEN_TOO_LONG, offset};
+        return status;
+    }
+    pending.assign(chunk.substr(consumed));
+    return status;
+}
+
+FormulaParser::Result FormulaParser::Stream::finish() {
+    if (!status.ok()) {
+        return status;
+    }
+    size_t consumed = 0;
+    status = run(pending, offset, true, cursor, frames, out, consumed);
+    if (status.ok()) {
+        offset += pending.size();
+        pending.clear();
+    }
+    return status;
+}
+
+const char* FormulaParser::errorMessage(Error error) {
+    switch (error) {
+        case Error::NONE: return "OK";
+        case Error::UNKNOWN_ELEMENT: return "Unknown element symbol";
+        case Error::UNEXPECTED_CHARACTER: return "Unexpected character";
+        case Error::UNBALANCED_PARENTHESES: return "Unbalanced parentheses";
+        case Error::UNKNOWN_ISOTOPE: return "Unknown isotope";
+        case Error::TOO_MANY_ISOTOPES: return "Too many different isotopes";
+        case Error::UNEXPECTED_END: return "Unexpected end of formula";
+        case Error::COUNT_OVERFLOW: return "Count out of range";
+        case Error::TOKEN_TOO_LONG: return "Token too long";
+        case Error::ZERO_COUNT: return "Count of zero";
+        default: return "Parse error";
+    }
+}
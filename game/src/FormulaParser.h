@@ -0,0 +1,241 @@
+#ifndef FORMULAPARSER_H
+#define FORMULAPARSER_H
+
+#include "IsotopeTable.h"
+#include "PeriodicTable.h"
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+/**
+ * @brief FormulaParser - Allocation-free, table-driven chemical formula parser
+ * Reads a std::string_view directly into a flat, atomic-number-indexed count array
+ * in one left-to-right pass of a deterministic finite automaton: the byte that
+ * starts each token is mapped to a character class, the (state, class) transition
+ * table picks the action, and the action consumes the rest of the token (symbol
+ * letters, counts) in a tight loop. Nothing is ever re-read. Besides plain formulas it accepts
+ *   - groups in parentheses or square brackets:   Ca3(PO4)2, [Fe(CN)6]^4-
+ *   - hydrate/adduct dots with leading multipliers: CuSO4.5H2O, C10H15N*HI
+ *     (the dot may be '.', '*', U+00B7 or U+2022 encoded as UTF-8)
+ *   - ionic charges after a caret:                SO4^2-, NH4^+
+ *   - explicit isotopes in square brackets:       [13C]H4, [2H]2O
+ * Group frames live on a per-thread stack that is reused between calls, so
+ * steady-state parsing performs no heap allocations. Nesting depth is limited only
+ * by memory (one frame of about 1 KB per open group, never the call stack), and
+ * every count and multiplication is checked against the int64 range.
+ *
+ * Stream (and parse(std::istream&)) runs the same automaton over input that
+ * arrives in chunks, so multi-megabyte polymer formulas never have to be held
+ * in memory: only the open group frames and one unfinished token are kept.
+ */
+class FormulaParser {
+public:
+    // Atoms of one explicitly labelled nuclide; they are also included in counts[z]
+    struct IsotopeCount {
+        std::int16_t isotope = 0; // Index into IsotopeTable::ISOTOPES
+        std::int64_t count = 0;
+    };
+
+    static constexpr int MAX_ISOTOPES = 8; // Distinct labelled nuclides per formula
+
+    // Element counts indexed by atomic number (slot 0 is unused)
+    struct ElementCounts {
+        std::array<std::int64_t, PeriodicTable::ELEMENT_COUNT + 1> counts{};
+        std::uint64_t present[2] = {0, 0}; // Bit Z set when slot Z has been touched
+        std::array<IsotopeCount, MAX_ISOTOPES> isotopes{};
+        int isotopeCount = 0;
+        std::int64_t charge = 0; // Net ionic charge in units of e
+
+        void add(int z, std::int64_t n) {
+            counts[z] += n;
+            present[z >> 6] |= std::uint64_t(1) << (z & 63);
+        }
+
+        // Adds n atoms of a labelled nuclide; false if MAX_ISOTOPES distinct nuclides are already in use
+        bool addIsotope(int isotope, std::int64_t n) {
+            add(IsotopeTable::ISOTOPES[isotope].atomicNumber, n);
+            return addLabel(isotope, n);
+        }
+
+        // Adds multiplier copies of other (elements, isotope labels and charge)
+        bool addScaled(const ElementCounts& other, std::int64_t multiplier) {
+            other.forEach([this, multiplier](int z, std::int64_t n) { add(z, n * multiplier); });
+            charge += other.charge * multiplier;
+            return addScaledLabels(other, multiplier);
+        }
+
+        // Adds multiplier copies of other's isotope labels only (their atoms are already in counts)
+        bool addScaledLabels(const ElementCounts& other, std::int64_t multiplier) {
+            for (int i = 0; i < other.isotopeCount; ++i) {
+                if (!addLabel(other.isotopes[i].isotope, other.isotopes[i].count * multiplier)) {
+                    return false;
+                }
+            }
+            return true;
+        }
+
+        std::int64_t operator[](int z) const { return counts[z]; }
+        bool empty() const { return (present[0] | present[1]) == 0; }
+
+        // Resets only the touched slots
+        void clear() {
+            forEach([this](int z, std::int64_t) { counts[z] = 0; });
+            present[0] = present[1] = 0;
+            isotopeCount = 0;
+            charge = 0;
+        }
+
+        // Calls f(atomicNumber, count) for every touched element in ascending atomic number
+        template <typename F>
+        void forEach(F&& f) const {
+            for (int word = 0; word < 2; ++word) {
+                std::uint64_t bits = present[word];
+                while (bits != 0) {
+                    int z = word * 64 + lowestBit(bits);
+                    bits &= bits - 1;
+                    f(z, counts[z]);
+                }
+            }
+        }
+
+        // Sum of count * atomic mass in ascending atomic number, then the isotope correction.
+        // Electron mass is not included for ions.
+        double molarMass() const {
+            double total = 0.0;
+            forEach([&total](int z, std::int64_t n) {
+                total += PeriodicTable::atomicMass(z) * static_cast<double>(n);
+            });
+            if (isotopeCount != 0) {
+                total += isotopeMassCorrection();
+            }
+            return total;
+        }
+
+        // Mass difference between the labelled atoms and the same atoms at standard atomic weight
+        double isotopeMassCorrection() const {
+            double correction = 0.0;
+            for (int i = 0; i < isotopeCount; ++i) {
+                const IsotopeTable::Isotope& nuclide = IsotopeTable::ISOTOPES[isotopes[i].isotope];
+                correction += (nuclide.mass - PeriodicTable::atomicMass(nuclide.atomicNumber)) *
+                              static_cast<double>(isotopes[i].count);
+            }
+            return correction;
+        }
+
+    private:
+        bool addLabel(int isotope, std::int64_t n) {
+            for (int i = 0; i < isotopeCount; ++i) {
+                if (isotopes[i].isotope == isotope) {
+                    isotopes[i].count += n;
+                    return true;
+                }
+            }
+            if (isotopeCount == MAX_ISOTOPES) {
+                return false;
+            }
+            isotopes[isotopeCount++] = IsotopeCount{static_cast<std::int16_t>(isotope), n};
+            return true;
+        }
+    };
+
+    enum class Error {
+        NONE,
+        UNKNOWN_ELEMENT,
+        UNEXPECTED_CHARACTER,
+        UNBALANCED_PARENTHESES,  // Also mismatched ( ] and [ )
+        UNKNOWN_ISOTOPE,         // [A X] names a nuclide missing from IsotopeTable
+        TOO_MANY_ISOTOPES,       // More than MAX_ISOTOPES distinct labelled nuclides
+        UNEXPECTED_END,          // Input stops inside a token, e.g. "SO4^2" or "CuSO4."
+        COUNT_OVERFLOW,          // A count, or counts times multipliers, outside the int64 range
+        TOKEN_TOO_LONG,          // Stream only: a token over Stream::MAX_TOKEN_LENGTH bytes (a zero-padded count)
+        ZERO_COUNT               // An explicit count or multiplier of 0, e.g. "H0" or "(OH)0"
+    };
+
+    struct Result {
+        Error error = Error::NONE;
+        size_t position = 0; // Offset of the offending character when error != NONE
+
+        bool ok() const { return error == Error::NONE; }
+    };
+
+private:
+    // One open group: its running counts, where it was opened and with which bracket
+    struct GroupFrame {
+        ElementCounts counts;
+        size_t openPosition = 0;
+        char open = '(';
+    };
+
+    // Automaton state carried from one chunk to the next
+    struct Cursor {
+        size_t depth = 0;                // Open groups
+        std::int64_t componentScale = 1; // Multiplier of the current dot component
+        std::int64_t scale = 1;          // Multiplier for atoms added at this depth
+        std::uint8_t state = 0;
+        size_t dotStart = 0;             // Offset of the UTF-8 dot being read
+    };
+
+    // Runs the automaton over text, whose first byte is at offset base of the whole input.
+    // Unless last is set, a token that reaches the end of text is left for the next chunk;
+    // consumed tells where the unread part starts.
+    static Result run(std::string_view text, size_t base, bool last, Cursor& cursor,
+                      std::vector<GroupFrame>& frames, ElementCounts& out, size_t& consumed);
+
+public:
+    /**
+     * @brief Incremental parser for formulas read piece by piece
+     * feed() accepts chunks split anywhere, even inside a token or a UTF-8 dot;
+     * finish() ends the input. Results and error positions (offsets into the whole
+     * input) are the same as parsing the concatenated text in one call. The first
+     * error is final and is returned again by every later call.
+     */
+    class Stream {
+    public:
+        static constexpr size_t MAX_TOKEN_LENGTH = 64; // Longest token carried between chunks
+
+        explicit Stream(ElementCounts& out);
+
+        Result feed(std::string_view chunk);
+        Result finish();
+
+        size_t bytesParsed() const { return offset; }
+
+    private:
+        ElementCounts& out;
+        Cursor cursor;
+        std::vector<GroupFrame> frames;
+        std::string pending; // Unfinished token from the previous chunk
+        size_t offset = 0;   // Input offset of pending[0]
+        Result status;
+    };
+
+    // Parses formula into out (which is cleared first). Whitespace between tokens is ignored,
+    // and may also separate a symbol or a closing bracket from its count ("C 6 H 12 O 6").
+    // Explicit zero counts and multipliers are rejected with ZERO_COUNT.
+    static Result parse(std::string_view formula, ElementCounts& out);
+
+    // Reads the whole stream chunk by chunk through Stream
+    static Result parse(std::istream& input, ElementCounts& out, size_t chunkSize = 64 * 1024);
+
+    static const char* errorMessage(Error error);
+
+    static int lowestBit(std::uint64_t bits) {
+#if defined(_MSC_VER)
+        unsigned long index;
+        _BitScanForward64(&index, bits);
+        return static_cast<int>(index);
+#else
+        return __builtin_ctzll(bits);
+#endif
+    }
+};
+
+#endif // FORMULAPARSER_H
@@ -0,0 +1,124 @@
+#include "FormulaSet.h"
+#include "CanonicalFormula.h"
+#include <stdexcept>
+
+namespace {
+
+constexpr std::uint64_t EMPTY_SLOT = ~std::uint64_t{0};
+constexpr size_t MIN_SLOTS = 16;
+
+std::uint64_t slotValue(std::uint64_t hash, std::uint32_t id) {
+    return (hash & 0xFFFFFFFF00000000ull) | id;
+}
+
+void parseOrThrow(std::string_view formula, FormulaParser::ElementCounts& counts) {
+    FormulaParser::Result result = FormulaParser::parse(formula, counts);
+    if (!result.ok()) {
+        throw std::invalid_argument(std::string(FormulaParser::errorMessage(result.error)) + " at position " +
+                                    std::to_string(result.position) + " in formula \"" + std::string(formula) +
+                                    "\"");
+    }
+}
+
+} // namespace
+
+std::uint32_t FormulaSet::lookup(std::uint64_t hash, std::string_view key, size_t& slot) const {
+    const size_t mask = slots.size() - 1;
+    const std::uint64_t tag = hash & 0xFFFFFFFF00000000ull;
+    for (slot = static_cast<size_t>(hash) & mask; slots[slot] != EMPTY_SLOT; slot = (slot + 1) & mask) {
+        if ((slots[slot] & 0xFFFFFFFF00000000ull) != tag) continue;
+        const auto id = static_cast<std::uint32_t>(slots[slot]);
+        if (hashes[id] == hash &&
+            std::string_view(arena).substr(keyBegin[id], keyBegin[id + 1] - keyBegin[id]) == key) {
+            return id;
+        }
+    }
+    return NPOS;
+}
+
+std::pair<std::uint32_t, bool> FormulaSet::insert(const FormulaParser::ElementCounts& counts) {
+    thread_local std::string key;
+    key.clear();
+    CanonicalFormula::encode(counts, key);
+    const std::uint64_t hash = CanonicalFormula::hash(counts);
+
+    // Load factor at most 1/2 keeps linear probe runs short
+    if ((hashes.size() + 1) * 2 > slots.size()) {
+        rehash(slots.empty() ? MIN_SLOTS : slots.size() * 2);
+    }
+    size_t slot = 0;
+    std::uint32_t id = lookup(hash, key, slot);
+    if (id != NPOS) {
+        return {id, false};
+    }
+    if (hashes.size() >= NPOS) {
+        throw std::invalid_argument("FormulaSet holds at most 2^32 - 1 formulas");
+    }
+    id = static_cast<std::uint32_t>(hashes.size());
+    hashes.push_back(hash);
+    arena += key;
+    keyBegin.push_back(arena.size());
+    slots[slot] = slotValue(hash, id);
+    return {id, true};
+}
+
+std::pair<std::uint32_t, bool> FormulaSet::insert(std::string_view formula) {
+    thread_local FormulaParser::ElementCounts counts;
+    parseOrThrow(formula, counts);
+    return insert(counts);
+}
+
+std::uint32_t FormulaSet::find(const FormulaParser::ElementCounts& counts) const {
+    if (hashes.empty()) {
+        return NPOS;
+    }
+    thread_local std::string key;
+    key.clear();
+    CanonicalFormula::encode(counts, key);
+    size_t slot = 0;
+    return lookup(CanonicalFormula::hash(counts), key, slot);
+}
+
+std::uint32_t FormulaSet::find(std::string_view formula) const {
+    thread_local FormulaParser::ElementCounts counts;
+    parseOrThrow(formula, counts);
+    return find(counts);
+}
+
+std::string FormulaSet::hillFormula(std::uint32_t id) const {
+    FormulaParser::ElementCounts counts;
+    CanonicalFormula::decode(std::string_view(arena).substr(keyBegin[id], keyBegin[id + 1] - keyBegin[id]), counts);
+    return CanonicalFormula::hill(counts);
+}
+
+void FormulaSet::reserve(size_t count) {
+    size_t wanted = MIN_SLOTS;
+    while (wanted < count * 2) wanted *= 2;
+    if (wanted > slots.size()) {
+        rehash(wanted);
+    }
+    hashes.reserve(count);
+    keyBegin.reserve(count + 1);
+}
+
+void FormulaSet::clear() {
+    slots.clear();
+    hashes.clear();
+    keyBegin.assign(1, 0);
+    arena.clear();
+}
+
+size_t FormulaSet::memoryUsage() const {
+    return slots.capacity() * sizeof(std::uint64_t) + hashes.capacity() * sizeof(std::uint64_t) +
+           keyBegin.capacity() * sizeof(std::uint64_t) + arena.capacity();
+}
+
+void FormulaSet::rehash(size_t slotCount) {
+    slots.assign(slotCount, EMPTY_SLOT);
+    const size_t mask = slotCount - 1;
+    for (std::uint32_t id = 0; id < hashes.size(); ++id) {
+        size_t slot = static_cast<size_t>(hashes[id]) & mask;
+        while (slots[slot] != EMPTY_SLOT) slot = (slot + 1) & mask;
+        slots[slot] = slotValue(hashes[id], id);
+    }
+}
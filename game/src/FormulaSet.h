@@ -0,0 +1,64 @@
+#ifndef FORMULASET_H
+#define FORMULASET_H
+
+#include "FormulaParser.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief FormulaSet - Compact hash set of formulas, identified by composition
+ * Every distinct formula (see CanonicalFormula) gets a dense id in insertion
+ * order. This makes the set an index for parallel arrays: a map from formula
+ * to value is a FormulaSet plus a std::vector indexed by id.
+ *
+ * Keys are stored once, as canonical byte strings in one shared arena. Each
+ * key also keeps its 64-bit CanonicalFormula::hash. The table is open
+ * addressing with linear probing. Each 64-bit slot packs an id with the upper
+ * half of its hash, so a probe rejects a mismatch without leaving the table.
+ * Key bytes are compared only when the hashes match. Each entry costs about 40
+ * bytes plus its key, so millions of formulas fit comfortably.
+ */
+class FormulaSet {
+public:
+    static constexpr std::uint32_t NPOS = 0xFFFFFFFFu;
+
+    FormulaSet() = default;
+
+    // Id of the formula and whether it was new
+    std::pair<std::uint32_t, bool> insert(const FormulaParser::ElementCounts& counts);
+    // Parses first; throws std::invalid_argument for a malformed formula
+    std::pair<std::uint32_t, bool> insert(std::string_view formula);
+
+    // NPOS if absent
+    std::uint32_t find(const FormulaParser::ElementCounts& counts) const;
+    std::uint32_t find(std::string_view formula) const; // Throws std::invalid_argument for a malformed formula
+
+    bool contains(const FormulaParser::ElementCounts& counts) const { return find(counts) != NPOS; }
+
+    size_t size() const { return hashes.size(); }
+    bool empty() const { return hashes.empty(); }
+
+    std::uint64_t hash(std::uint32_t id) const { return hashes[id]; }
+    // Hill-order text of an entry
+    std::string hillFormula(std::uint32_t id) const;
+
+    void reserve(size_t count);
+    void clear();
+
+    // Bytes held by the table, hashes and keys
+    size_t memoryUsage() const;
+
+private:
+    std::vector<std::uint64_t> slots;    // Hash high half << 32 | id, all ones when empty; power-of-two size
+    std::vector<std::uint64_t> hashes;   // Per id
+    std::vector<std::uint64_t> keyBegin{0}; // Key of id i is arena[keyBegin[i], keyBegin[i + 1])
+    std::string arena;
+
+    std::uint32_t lookup(std::uint64_t hash, std::string_view key, size_t& slot) const;
+    void rehash(size_t slotCount);
+};
+
+#endif // FORMULASET_H
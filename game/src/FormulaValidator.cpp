@@ -0,0 +1,595 @@
+#include "FormulaValidator.h"
+#include "CheckedMath.h"
+#include <limits>
+
+namespace {
+
+using Error = FormulaParser::Error;
+using Result = FormulaParser::Result;
+
+constexpr std::int64_t INT64_LIMIT = std::numeric_limits<std::int64_t>::max();
+
+// Automaton states, as in FormulaParser
+enum State : std::uint8_t {
+    S_BEGIN,      // Start of the formula: no dot or charge yet
+    S_MULTIPLIER, // Right after a dot: the component's multiplier may follow
+    S_COMPONENT,  // After a dot and its multiplier: something must follow
+    S_READY,      // After a complete token
+    S_DOT_C2,     // Inside the UTF-8 middle dot
+    S_DOT_E2,     // Inside the UTF-8 bullet, one byte read
+    S_DOT_E2_80   // Inside the UTF-8 bullet, two bytes read
+};
+
+// Token being read; FormulaParser reads each of these in one go
+enum Phase : std::uint8_t {
+    P_NONE,
+    P_ELEMENT,         // One letter of a symbol
+    P_ELEMENT_SECOND,  // Two letters
+    P_ELEMENT_COUNT,   // Digits after the symbol
+    P_GROUP_COUNT,     // After ')' or ']': the group multiplier
+    P_BRACKET,         // '[': a group, or an isotope label if a digit follows
+    P_ISOTOPE_MASS,
+    P_ISOTOPE_SYMBOL,
+    P_ISOTOPE_SYMBOL2,
+    P_ISOTOPE_COUNT,   // After the label's ']'
+    P_CHARGE,          // After '^': magnitude digits, then the sign
+    P_MULTIPLIER       // Leading multiplier of a dot component
+};
+
+enum ChangeKind : std::uint8_t {
+    K_ATOMS,
+    K_ISOTOPE,
+    K_FOLD,
+    K_CHARGE,
+    K_OPEN,
+    K_CLOSE
+};
+
+bool isDigit(char c) { return c >= '0' && c <= '9'; }
+bool isLower(char c) { return c >= 'a' && c <= 'z'; }
+bool isUpper(char c) { return c >= 'A' && c <= 'Z'; }
+bool isSpace(char c) { return c == ' ' || c == '\t' || c == '\n' || c == '\r'; }
+
+// The first digit replaces the implicit count of 1
+bool appendDigit(std::int64_t& value, bool& hasDigits, char digit) {
+    const std::int64_t d = digit - '0';
+    if (!hasDigits) {
+        hasDigits = true;
+        value = d;
+        return true;
+    }
+    if (value > (INT64_LIMIT - d) / 10) {
+        return false;
+    }
+    value = value * 10 + d;
+    return true;
+}
+
+int findLabel(const FormulaParser::ElementCounts& counts, int isotope) {
+    for (int i = 0; i < counts.isotopeCount; ++i) {
+        if (counts.isotopes[i].isotope == isotope) return i;
+    }
+    return -1;
+}
+
+} // namespace
+
+FormulaValidator::FormulaValidator() : frames(1) {}
+
+void FormulaValidator::push(std::string_view text) {
+    for (char c : text) push(c);
+}
+
+void FormulaValidator::assign(std::string_view text) {
+    clear();
+    push(text);
+}
+
+void FormulaValidator::clear() {
+    for (size_t i = 0; i < frameCount; ++i) {
+        frames[i].counts.clear();
+        frames[i].mass = 0.0;
+    }
+    frameCount = 1;
+    openGroups.clear();
+    steps.clear();
+    changes.clear();
+    buffer.clear();
+    cursor = Cursor{};
+}
+
+void FormulaValidator::push(char c) {
+    const size_t position = buffer.size();
+    steps.push_back(Step{cursor, changes.size()});
+    buffer += c;
+    if (!cursor.error.ok()) {
+        return;
+    }
+    if (cursor.phase != P_NONE && continueToken(c, position)) {
+        return;
+    }
+    if (cursor.error.ok()) {
+        dispatch(c, position);
+    }
+}
+
+void FormulaValidator::pop() {
+    if (buffer.empty()) {
+        return;
+    }
+    const Step& step = steps.back();
+    while (changes.size() > step.changesBegin) {
+        undo(changes.back());
+        changes.pop_back();
+    }
+    cursor = step.before;
+    steps.pop_back();
+    buffer.pop_back();
+}
+
+bool FormulaValidator::fail(Error error, size_t position) {
+    cursor.error = Result{error, position};
+    cursor.phase = P_NONE;
+    return false;
+}
+
+FormulaValidator::Change FormulaValidator::record(std::uint8_t kind, std::uint32_t index, std::uint32_t frame,
+                                                  std::int64_t amount) const {
+    const Frame& f = frames[frame];
+    return Change{kind, index, frame, amount, f.mass, {f.counts.present[0], f.counts.present[1]}, f.counts.isotopeCount};
+}
+
+bool FormulaValidator::addAtoms(int element, std::int64_t amount, bool isotope) {
+    const std::uint32_t id = currentFrame();
+    Frame& f = frames[id];
+    const int z = isotope ? IsotopeTable::ISOTOPES[element].atomicNumber : element;
+    std::int64_t total = 0;
+    if (!checkedAdd(f.counts[z], amount, total)) {
+        return fail(Error::COUNT_OVERFLOW, cursor.tokenStart);
+    }
+    if (isotope && findLabel(f.counts, element) < 0 && f.counts.isotopeCount == FormulaParser::MAX_ISOTOPES) {
+        return fail(Error::TOO_MANY_ISOTOPES, cursor.tokenStart);
+    }
+    changes.push_back(record(isotope ? K_ISOTOPE : K_ATOMS, static_cast<std::uint32_t>(element), id, amount));
+    if (isotope) {
+        f.counts.addIsotope(element, amount);
+    } else {
+        f.counts.add(z, amount);
+    }
+    return true;
+}
+
+bool FormulaValidator::fold(std::uint32_t group, std::int64_t multiplier) {
+    const std::uint32_t id = currentFrame();
+    Frame& parent = frames[id];
+    const FormulaParser::ElementCounts& counts = frames[group].counts;
+
+    // Checked before anything changes, so a failed fold leaves nothing to undo
+    bool fits = true;
+    counts.forEach([&](int z, std::int64_t n) {
+        std::int64_t scaled = 0, sum = 0;
+        fits = fits && checkedMul(n, multiplier, scaled) && checkedAdd(parent.counts[z], scaled, sum);
+    });
+    std::int64_t charge = 0, sum = 0;
+    if (!fits || !checkedMul(counts.charge, multiplier, charge) || !checkedAdd(parent.counts.charge, charge, sum)) {
+        return fail(Error::COUNT_OVERFLOW, cursor.tokenStart);
+    }
+    int newLabels = 0;
+    for (int i = 0; i < counts.isotopeCount; ++i) {
+        newLabels += findLabel(parent.counts, counts.isotopes[i].isotope) < 0;
+    }
+    if (parent.counts.isotopeCount + newLabels > FormulaParser::MAX_ISOTOPES) {
+        return fail(Error::TOO_MANY_ISOTOPES, cursor.tokenStart);
+    }
+
+    changes.push_back(record(K_FOLD, group, id, multiplier));
+    parent.counts.addScaled(counts, multiplier);
+    return true;
+}
+
+bool FormulaValidator::applyCount(std::int64_t value) {
+    if (cursor.phase == P_GROUP_COUNT) {
+        std::int64_t multiplier = 0;
+        if (!checkedMul(value, cursor.depth == 0 ? cursor.componentScale : 1, multiplier)) {
+            return fail(Error::COUNT_OVERFLOW, cursor.tokenStart);
+        }
+        if (!fold(cursor.group, multiplier - cursor.applied)) {
+            return false;
+        }
+        cursor.applied = multiplier;
+        frames[currentFrame()].mass = cursor.baseMass + frames[cursor.group].mass * static_cast<double>(multiplier);
+        return true;
+    }
+    const bool isotope = cursor.phase == P_ISOTOPE_COUNT;
+    if (!isotope && cursor.element == 0) {
+        return true; // Unknown symbol: reported when the token ends
+    }
+    std::int64_t atoms = 0;
+    if (!checkedMul(value, cursor.scale, atoms)) {
+        return fail(Error::COUNT_OVERFLOW, cursor.tokenStart);
+    }
+    if (!addAtoms(cursor.element, atoms - cursor.applied, isotope)) {
+        return false;
+    }
+    cursor.applied = atoms;
+    const double unit = isotope ? IsotopeTable::ISOTOPES[cursor.element].mass : PeriodicTable::atomicMass(cursor.element);
+    frames[currentFrame()].mass = cursor.baseMass + unit * static_cast<double>(atoms);
+    return true;
+}
+
+void FormulaValidator::openGroup(char open, size_t position) {
+    if (frameCount == frames.size()) {
+        frames.emplace_back();
+    }
+    const auto id = static_cast<std::uint32_t>(frameCount++);
+    frames[id].openPosition = position;
+    frames[id].open = open;
+    changes.push_back(record(K_OPEN, 0, id, 0));
+    openGroups.push_back(id);
+    cursor.depth++;
+    cursor.scale = 1;
+}
+
+bool FormulaValidator::continueToken(char c, size_t position) {
+    switch (cursor.phase) {
+        case P_ELEMENT:
+            if (isLower(c)) {
+                // The one-letter element read so far becomes part of a two-letter symbol
+                if (cursor.element != 0) {
+                    const Change added = changes.back();
+                    if (!addAtoms(cursor.element, -cursor.applied, false)) return true;
+                    Frame& f = frames[added.frame];
+                    f.mass = added.previousMass;
+                    f.counts.present[0] = added.previousPresent[0];
+                    f.counts.present[1] = added.previousPresent[1];
+                    cursor.applied = 0;
+                }
+                cursor.phase = P_ELEMENT_SECOND;
+                cursor.element = static_cast<std::int16_t>(PeriodicTable::atomicNumber(cursor.symbol, c));
+                applyCount(1);
+                return true;
+            }
+            // fall through
+        case P_ELEMENT_SECOND:
+        case P_ELEMENT_COUNT:
+            if (isDigit(c)) {
+                cursor.phase = P_ELEMENT_COUNT;
+                if (!appendDigit(cursor.value, cursor.hasDigits, c)) {
+                    fail(Error::COUNT_OVERFLOW, cursor.tokenStart);
+                } else {
+                    applyCount(cursor.value);
+                }
+                return true;
+            }
+            if (cursor.element == 0) {
+                fail(Error::UNKNOWN_ELEMENT, cursor.tokenStart);
+                return true;
+            }
+            if (isSpace(c) && !cursor.hasDigits) {
+                // The symbol is complete, but its count may still follow ("H 2O")
+                cursor.phase = P_ELEMENT_COUNT;
+                return true;
+            }
+            if (cursor.hasDigits && cursor.value == 0) {
+                fail(Error::ZERO_COUNT, cursor.tokenStart);
+                return true;
+            }
+            break;
+        case P_GROUP_COUNT:
+        case P_ISOTOPE_COUNT:
+            if (isDigit(c)) {
+                if (!appendDigit(cursor.value, cursor.hasDigits, c)) {
+                    fail(Error::COUNT_OVERFLOW, cursor.tokenStart);
+                } else {
+                    applyCount(cursor.value);
+                }
+                return true;
+            }
+            if (isSpace(c) && !cursor.hasDigits) {
+                return true;
+            }
+            if (cursor.hasDigits && cursor.value == 0) {
+                fail(Error::ZERO_COUNT, cursor.tokenStart);
+                return true;
+            }
+            break;
+        case P_BRACKET:
+            if (isDigit(c)) {
+                cursor.phase = P_ISOTOPE_MASS;
+                cursor.value = c - '0';
+                cursor.hasDigits = true;
+                return true;
+            }
+            openGroup('[', cursor.tokenStart);
+            break;
+        case P_ISOTOPE_MASS:
+            if (isDigit(c)) {
+                if (!appendDigit(cursor.value, cursor.hasDigits, c)) {
+                    fail(Error::UNKNOWN_ISOTOPE, cursor.tokenStart);
+                }
+            } else if (isUpper(c)) {
+                cursor.phase = P_ISOTOPE_SYMBOL;
+                cursor.symbol = c;
+                cursor.symbolStart = position;
+            } else {
+                fail(Error::UNEXPECTED_CHARACTER, position);
+            }
+            return true;
+        case P_ISOTOPE_SYMBOL:
+        case P_ISOTOPE_SYMBOL2: {
+            if (cursor.phase == P_ISOTOPE_SYMBOL && isLower(c)) {
+                cursor.phase = P_ISOTOPE_SYMBOL2;
+                cursor.element = static_cast<std::int16_t>(PeriodicTable::atomicNumber(cursor.symbol, c));
+                return true;
+            }
+            const int z = cursor.phase == P_ISOTOPE_SYMBOL ? PeriodicTable::atomicNumber(cursor.symbol, '\0')
+                                                           : cursor.element;
+            if (z == 0) {
+                fail(Error::UNKNOWN_ELEMENT, cursor.symbolStart);
+                return true;
+            }
+            if (c != ']') {
+                fail(Error::UNEXPECTED_CHARACTER, position);
+                return true;
+            }
+            const int isotope = cursor.value <= 0xFFFF ? IsotopeTable::find(z, static_cast<int>(cursor.value)) : -1;
+            if (isotope < 0) {
+                fail(Error::UNKNOWN_ISOTOPE, cursor.tokenStart);
+                return true;
+            }
+            cursor.phase = P_ISOTOPE_COUNT;
+            cursor.element = static_cast<std::int16_t>(isotope);
+            cursor.hasDigits = false;
+            cursor.value = 1;
+            cursor.applied = 0;
+            cursor.baseMass = frames[currentFrame()].mass;
+            applyCount(1);
+            return true;
+        }
+        case P_CHARGE:
+            if (isDigit(c)) {
+                if (!appendDigit(cursor.value, cursor.hasDigits, c)) {
+                    fail(Error::COUNT_OVERFLOW, cursor.tokenStart);
+                }
+            } else if (c == '+' || c == '-') {
+                const std::uint32_t id = currentFrame();
+                std::int64_t charge = 0, total = 0;
+                if (!checkedMul(cursor.value, cursor.scale, charge) ||
+                    !checkedAdd(frames[id].counts.charge, c == '+' ? charge : -charge, total)) {
+                    fail(Error::COUNT_OVERFLOW, cursor.tokenStart);
+                    return true;
+                }
+                changes.push_back(record(K_CHARGE, 0, id, c == '+' ? charge : -charge));
+                frames[id].counts.charge = total;
+                cursor.phase = P_NONE;
+            } else {
+                fail(Error::UNEXPECTED_CHARACTER, position);
+            }
+            return true;
+        case P_MULTIPLIER:
+            if (isDigit(c)) {
+                if (!appendDigit(cursor.value, cursor.hasDigits, c)) {
+                    fail(Error::COUNT_OVERFLOW, cursor.tokenStart);
+                } else {
+                    cursor.componentScale = cursor.scale = cursor.value;
+                }
+                return true;
+            }
+            if (cursor.value == 0) {
+                fail(Error::ZERO_COUNT, cursor.tokenStart);
+                return true;
+            }
+            break;
+        default:
+            break;
+    }
+    cursor.phase = P_NONE;
+    return false;
+}
+
+void FormulaValidator::dispatch(char c, size_t position) {
+    const std::uint8_t state = cursor.state;
+    const bool boundary = state == S_BEGIN || state == S_MULTIPLIER || state == S_COMPONENT || state == S_READY;
+    auto startToken = [&](std::uint8_t phase) {
+        cursor.state = S_READY;
+        cursor.phase = phase;
+        cursor.tokenStart = position;
+        cursor.hasDigits = false;
+        cursor.value = 1;
+        cursor.applied = 0;
+        cursor.baseMass = frames[currentFrame()].mass;
+    };
+
+    if (boundary) {
+        if (isUpper(c)) {
+            startToken(P_ELEMENT);
+            cursor.symbol = c;
+            cursor.element = static_cast<std::int16_t>(PeriodicTable::atomicNumber(c, '\0'));
+            applyCount(1);
+            return;
+        }
+        if (isSpace(c)) {
+            return;
+        }
+        if (c == '(') {
+            cursor.state = S_READY;
+            openGroup('(', position);
+            return;
+        }
+        if (c == '[') {
+            startToken(P_BRACKET);
+            return;
+        }
+        if (c == ')' || c == ']') {
+            const char open = c == ')' ? '(' : '[';
+            if (openGroups.empty() || frames[openGroups.back()].open != open) {
+                fail(Error::UNBALANCED_PARENTHESES, position);
+                return;
+            }
+            startToken(P_GROUP_COUNT);
+            cursor.group = openGroups.back();
+            changes.push_back(record(K_CLOSE, 0, cursor.group, 0));
+            openGroups.pop_back();
+            if (--cursor.depth == 0) {
+                cursor.scale = cursor.componentScale;
+            }
+            cursor.baseMass = frames[currentFrame()].mass;
+            applyCount(1);
+            return;
+        }
+    }
+
+    // Dots, multipliers and charges
+    const unsigned char byte = static_cast<unsigned char>(c);
+    bool dotEnd = false;
+    if (state == S_READY && c == '^') {
+        startToken(P_CHARGE);
+        return;
+    } else if (state == S_READY && (c == '.' || c == '*')) {
+        cursor.dotStart = position;
+        dotEnd = true;
+    } else if (state == S_READY && (byte == 0xC2 || byte == 0xE2)) {
+        cursor.dotStart = position;
+        cursor.state = byte == 0xC2 ? S_DOT_C2 : S_DOT_E2;
+        return;
+    } else if (state == S_DOT_E2 && byte == 0x80) {
+        cursor.state = S_DOT_E2_80;
+        return;
+    } else if ((state == S_DOT_C2 && byte == 0xB7) || (state == S_DOT_E2_80 && byte == 0xA2)) {
+        dotEnd = true;
+    } else if (state == S_MULTIPLIER && isDigit(c)) {
+        startToken(P_MULTIPLIER);
+        cursor.state = S_COMPONENT;
+        cursor.value = c - '0';
+        cursor.hasDigits = true;
+        cursor.componentScale = cursor.scale = cursor.value;
+        return;
+    }
+
+    if (dotEnd) {
+        if (cursor.depth != 0) {
+            fail(Error::UNEXPECTED_CHARACTER, cursor.dotStart);
+            return;
+        }
+        cursor.state = S_MULTIPLIER;
+        cursor.componentScale = 1;
+        cursor.scale = 1;
+        return;
+    }
+    // A byte that breaks a UTF-8 dot is reported at the start of the dot
+    const bool inDot = state == S_DOT_C2 || state == S_DOT_E2 || state == S_DOT_E2_80;
+    fail(Error::UNEXPECTED_CHARACTER, inDot ? cursor.dotStart : position);
+}
+
+void FormulaValidator::undo(const Change& change) {
+    Frame& f = frames[change.frame];
+    switch (change.kind) {
+        case K_ATOMS:
+            f.counts.counts[change.index] -= change.amount;
+            break;
+        case K_ISOTOPE: {
+            const IsotopeTable::Isotope& nuclide = IsotopeTable::ISOTOPES[change.index];
+            f.counts.counts[nuclide.atomicNumber] -= change.amount;
+            f.counts.isotopes[findLabel(f.counts, static_cast<int>(change.index))].count -= change.amount;
+            break;
+        }
+        case K_FOLD: {
+            const FormulaParser::ElementCounts& group = frames[change.index].counts;
+            group.forEach([&](int z, std::int64_t n) { f.counts.counts[z] -= n * change.amount; });
+            f.counts.charge -= group.charge * change.amount;
+            for (int i = 0; i < group.isotopeCount; ++i) {
+                f.counts.isotopes[findLabel(f.counts, group.isotopes[i].isotope)].count -=
+                    group.isotopes[i].count * change.amount;
+            }
+            break;
+        }
+        case K_CHARGE:
+            f.counts.charge -= change.amount;
+            return;
+        case K_OPEN:
+            openGroups.pop_back();
+            f.counts.clear();
+            f.mass = 0.0;
+            frameCount--;
+            return;
+        case K_CLOSE:
+            openGroups.push_back(change.frame);
+            return;
+        default:
+            return;
+    }
+    f.mass = change.previousMass;
+    f.counts.present[0] = change.previousPresent[0];
+    f.counts.present[1] = change.previousPresent[1];
+    f.counts.isotopeCount = change.previousLabels;
+}
+
+Result FormulaValidator::result() const {
+    if (!cursor.error.ok()) {
+        return cursor.error;
+    }
+    size_t depth = cursor.depth;
+    size_t innermost = openGroups.empty() ? 0 : frames[openGroups.back()].openPosition;
+    switch (cursor.phase) {
+        case P_ELEMENT:
+        case P_ELEMENT_SECOND:
+        case P_ELEMENT_COUNT:
+            if (cursor.element == 0) return Result{Error::UNKNOWN_ELEMENT, cursor.tokenStart};
+            if (cursor.hasDigits && cursor.value == 0) return Result{Error::ZERO_COUNT, cursor.tokenStart};
+            break;
+        case P_GROUP_COUNT:
+        case P_ISOTOPE_COUNT:
+        case P_MULTIPLIER:
+            if (cursor.hasDigits && cursor.value == 0) return Result{Error::ZERO_COUNT, cursor.tokenStart};
+            break;
+        case P_BRACKET:
+            depth++;
+            innermost = cursor.tokenStart;
+            break;
+        case P_ISOTOPE_SYMBOL2:
+            if (cursor.element == 0) return Result{Error::UNKNOWN_ELEMENT, cursor.symbolStart};
+            return Result{Error::UNEXPECTED_END, buffer.size()};
+        case P_ISOTOPE_MASS:
+        case P_ISOTOPE_SYMBOL:
+        case P_CHARGE:
+            return Result{Error::UNEXPECTED_END, buffer.size()};
+        default:
+            break;
+    }
+    if (cursor.state != S_BEGIN && cursor.state != S_READY) {
+        return Result{Error::UNEXPECTED_END, buffer.size()};
+    }
+    if (depth != 0) {
+        return Result{Error::UNBALANCED_PARENTHESES, innermost};
+    }
+    return Result{};
+}
+
+FormulaValidator::Status FormulaValidator::status() const {
+    const Result verdict = result();
+    if (verdict.ok()) {
+        return cursor.state == S_BEGIN ? Status::EMPTY : Status::VALID;
+    }
+    switch (verdict.error) {
+        case Error::UNEXPECTED_END:
+        case Error::UNBALANCED_PARENTHESES:
+            // Open groups can still be closed; a stray closing bracket cannot be taken back
+            return cursor.error.ok() ? Status::INCOMPLETE : Status::INVALID;
+        case Error::ZERO_COUNT:
+            // "H0" may still become "H05"
+            return cursor.error.ok() ? Status::INCOMPLETE : Status::INVALID;
+        case Error::UNKNOWN_ELEMENT:
+            // "X" may still become "Xe"
+            return cursor.error.ok() && cursor.phase == P_ELEMENT ? Status::INCOMPLETE : Status::INVALID;
+        default:
+            return Status::INVALID;
+    }
+}
+
+double FormulaValidator::molarMass() const {
+    double open = 0.0;
+    for (std::uint32_t id : openGroups) {
+        open += frames[id].mass;
+    }
+    return frames[0].mass + open * static_cast<double>(cursor.componentScale);
+}
@@ -0,0 +1,122 @@
+#ifndef FORMULAVALIDATOR_H
+#define FORMULAVALIDATOR_H
+
+#include "FormulaParser.h"
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief FormulaValidator - Formula parser state that follows a text box as it is edited
+ * The player types and deletes one byte at a time at the end of the buffer.
+ * push() feeds one byte to the same automaton FormulaParser uses. Element
+ * counts, open groups and the running molar mass are updated in place, and
+ * an undo record is kept for every byte. pop() restores the state before the
+ * last byte from that record. Both take constant time whatever the length of
+ * the buffer. Closing a group costs one pass over its elements.
+ *
+ * result() is the verdict FormulaParser::parse would give for the current
+ * buffer, error position included. status() also tells an error that more
+ * typing can fix (an open group, "SO4^2") from one that it cannot ("Xq").
+ *
+ * Counts and charge after pop() are exact. The running mass is restored
+ * bit-for-bit too, because every undo record carries the mass it replaced.
+ */
+class FormulaValidator {
+public:
+    enum class Status {
+        EMPTY,      // Nothing but whitespace
+        VALID,      // A complete formula
+        INCOMPLETE, // Not a formula yet, but more input can make it one
+        INVALID     // No continuation can make it a formula
+    };
+
+    FormulaValidator();
+
+    void push(char c);
+    void push(std::string_view text);
+    void pop();                  // Removes the last byte (no-op when empty)
+    void assign(std::string_view text);
+    void clear();
+
+    const std::string& text() const { return buffer; }
+
+    Status status() const;
+    // Same as FormulaParser::parse(text(), ...) would return
+    FormulaParser::Result result() const;
+
+    // Counts of the complete part: atoms inside still-open groups are not included
+    const FormulaParser::ElementCounts& counts() const { return frames[0].counts; }
+
+    // Running molar mass, with still-open groups counted once (what "Ca3(PO4" shows before the ")2")
+    double molarMass() const;
+
+private:
+    // One group: the root formula is frames[0]
+    struct Frame {
+        FormulaParser::ElementCounts counts;
+        double mass = 0.0;
+        size_t openPosition = 0;
+        char open = '(';
+    };
+
+    // Automaton state between bytes, copied into every undo record
+    struct Cursor {
+        std::uint8_t state = 0;
+        std::uint8_t phase = 0;      // Token being read, if any
+        char symbol = 0;             // First letter of the element being read
+        bool hasDigits = false;
+        std::int16_t element = 0;    // Atomic number (0 while unknown) or isotope index
+        std::uint32_t group = 0;     // Frame of the group whose multiplier is being read
+        std::int64_t value = 0;      // Count, multiplier, charge magnitude or mass number being read
+        std::int64_t applied = 0;    // Atoms (or group multiplier) already added by the current token
+        std::int64_t componentScale = 1;
+        std::int64_t scale = 1;
+        double baseMass = 0.0;       // Mass of the frame before the current token, to recompute rather than accumulate
+        size_t tokenStart = 0;
+        size_t symbolStart = 0;      // Element symbol inside an isotope label
+        size_t dotStart = 0;
+        size_t depth = 0;
+        FormulaParser::Result error; // First error; later bytes are kept but not parsed
+    };
+
+    // One reversible change to the frames
+    struct Change {
+        std::uint8_t kind;
+        std::uint32_t index;   // Atomic number, isotope or folded frame
+        std::uint32_t frame;   // Frame changed
+        std::int64_t amount;
+        double previousMass;
+        std::uint64_t previousPresent[2];
+        int previousLabels;    // isotopeCount before, so labels created by the change can be dropped
+    };
+
+    struct Step {
+        Cursor before;
+        size_t changesBegin;
+    };
+
+    std::string buffer;
+    Cursor cursor;
+    std::vector<Frame> frames;           // frames[0] plus every group opened so far, closed ones included
+    size_t frameCount = 1;               // frames in use; the rest are cleared spares
+    std::vector<std::uint32_t> openGroups;
+    std::vector<Step> steps;
+    std::vector<Change> changes;
+
+    std::uint32_t currentFrame() const { return openGroups.empty() ? 0 : openGroups.back(); }
+    bool fail(FormulaParser::Error error, size_t position);
+    Change record(std::uint8_t kind, std::uint32_t index, std::uint32_t frame, std::int64_t amount) const;
+    // Brings the atoms (or group multiplier) added by the current token to value
+    bool applyCount(std::int64_t value);
+    bool addAtoms(int element, std::int64_t amount, bool isotope);
+    bool fold(std::uint32_t group, std::int64_t multiplier);
+    void openGroup(char open, size_t position);
+    // Reads c as part of the current token; false when c starts something new
+    bool continueToken(char c, size_t position);
+    void dispatch(char c, size_t position);
+    void undo(const Change& change);
+};
+
+#endif // FORMULAVALIDATOR_H
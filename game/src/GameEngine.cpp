@@ -66,5 +66,13 @@ void GameEngine::reset() {
     lastFeedback = "";
 }
 
-
-
+bool GameEngine::loadContent(const std::string& filename) {
+    const std::string extension = ".pack";
+    const bool precompiled = filename.size() >= extension.size() &&
+                             filename.compare(filename.size() - extension.size(), extension.size(), extension) == 0;
+    if (!(precompiled ? dialogSystem.loadFromPack(filename) : dialogSystem.loadFromJSON(filename))) {
+        return false;
+    }
+    reset();
+    return true;
+}
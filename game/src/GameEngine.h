@@ -43,6 +43,11 @@ public:
     
     // Reset game
     void reset();
+    
+    // Content pack replacing the built-in dialogs and tasks: a ".pack" file is precompiled
+    // (DialogSystem::loadFromPack), anything else is JSON (DialogSystem::loadFromJSON)
+    bool loadContent(const std::string& filename);
+    const std::string& getContentError() const { return dialogSystem.getLoadError(); }
 
 private:
     DialogSystem dialogSystem;
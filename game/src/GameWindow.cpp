@@ -1,7 +1,11 @@
 #include "GameWindow.h"
+#include "TextLayout.h"
 #include <sstream>
 #include <algorithm>
 #include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
 
 // Color constants
 const sf::Color GameWindow::BG_COLOR(30, 30, 30);           // Dark gray #1e1e1e
@@ -31,6 +35,25 @@ GameWindow::GameWindow()
         }
     }
     
+    // Levels: a content pack next to the executable (precompiled first), else the built-in ones
+    for (const char* content : {"content.pack", "content.json"}) {
+        if (!std::ifstream(content).good()) continue;
+        if (gameEngine.loadContent(content)) break;
+        std::cerr << "Warning: " << gameEngine.getContentError() << std::endl;
+    }
+    
+    // Compound names: a prebuilt image next to the executable, else the built-in list
+    if (std::ifstream("compounds.dict").good()) {
+        try {
+            dictionary = CompoundDictionary::open("compounds.dict");
+        } catch (const std::invalid_argument& e) {
+            std::cerr << "Warning: " << e.what() << std::endl;
+            dictionary = CompoundDictionary::builtIn();
+        }
+    } else {
+        dictionary = CompoundDictionary::builtIn();
+    }
+
     // Setup buttons
     setupButtons();
     updateButtonVisibility();
@@ -169,6 +192,8 @@ void GameWindow::handleMouseClick(int x, int y) {
                 if (!inputText.empty()) {
                     gameEngine.checkAnswer(inputText);
                     inputText.clear();
+                    validator.clear();
+                    suggestions.clear();
                     inputActive = false;
                     gameEngine.setState(GameEngine::GameState::RESULT);
                     updateButtonVisibility();
@@ -186,6 +211,8 @@ void GameWindow::handleMouseClick(int x, int y) {
             case 4: // Restart
                 gameEngine.reset();
                 inputText.clear();
+                validator.clear();
+                suggestions.clear();
                 inputActive = false;
                 updateButtonVisibility();
                 break;
@@ -198,12 +225,57 @@ void GameWindow::handleMouseClick(int x, int y) {
 
 void GameWindow::handleTextInput(sf::Uint32 unicode) {
     if (unicode == '\b' && !inputText.empty()) {
-        // Backspace
-        inputText.pop_back();
+        // Backspace: drop the whole UTF-8 sequence of the last character
+        size_t end = inputText.size() - 1;
+        while (end > 0 && (static_cast<unsigned char>(inputText[end]) & 0xC0) == 0x80) {
+            --end;
+        }
+        while (inputText.size() > end) {
+            inputText.pop_back();
+            validator.pop();
+        }
+    }
+    else if (unicode == '\t') {
+        // Tab: replace a compound name with the formula of the best completion
+        if (!suggestions.empty()) {
+            inputText = std::string(suggestions.front().formula);
+            validator.assign(inputText);
+        }
     }
-    else if (unicode >= 32 && unicode < 128) {
-        // Printable ASCII characters
-        inputText += static_cast<char>(unicode);
+    else if (unicode >= 32 && unicode != 127 && unicode < 0x110000) {
+        // Printable characters, stored as UTF-8 (names may be Cyrillic)
+        char encoded[4];
+        size_t length = 0;
+        if (unicode < 0x80) {
+            encoded[length++] = static_cast<char>(unicode);
+        } else if (unicode < 0x800) {
+            encoded[length++] = static_cast<char>(0xC0 | (unicode >> 6));
+            encoded[length++] = static_cast<char>(0x80 | (unicode & 0x3F));
+        } else if (unicode < 0x10000) {
+            encoded[length++] = static_cast<char>(0xE0 | (unicode >> 12));
+            encoded[length++] = static_cast<char>(0x80 | ((unicode >> 6) & 0x3F));
+            encoded[length++] = static_cast<char>(0x80 | (unicode & 0x3F));
+        } else {
+            encoded[length++] = static_cast<char>(0xF0 | (unicode >> 18));
+            encoded[length++] = static_cast<char>(0x80 | ((unicode >> 12) & 0x3F));
+            encoded[length++] = static_cast<char>(0x80 | ((unicode >> 6) & 0x3F));
+            encoded[length++] = static_cast<char>(0x80 | (unicode & 0x3F));
+        }
+        // The validator follows the buffer byte by byte, so a keystroke never re-parses the whole input
+        inputText.append(encoded, length);
+        validator.push(std::string_view(encoded, length));
+    }
+    updateSuggestions();
+}
+
+void GameWindow::updateSuggestions() {
+    suggestions.clear();
+    if (!inputText.empty()) {
+        dictionary.complete(inputText, 5, suggestions);
+    }
+    // Nothing to suggest once the input is already the formula
+    if (suggestions.size() == 1 && suggestions.front().formula == inputText) {
+        suggestions.clear();
     }
 }
 
@@ -212,6 +284,8 @@ void GameWindow::handleKeyPress(sf::Keyboard::Key key) {
         if (!inputText.empty()) {
             gameEngine.checkAnswer(inputText);
             inputText.clear();
+            validator.clear();
+            suggestions.clear();
             inputActive = false;
             gameEngine.setState(GameEngine::GameState::RESULT);
             updateButtonVisibility();
@@ -278,7 +352,7 @@ void GameWindow::renderMenu() {
         "Нажмите 'НАЧАТЬ ИГРУ' чтобы начать обучение.";
     
     float textY = 200.0f;
-    auto lines = wrapText(welcomeText, WINDOW_WIDTH - 100.0f, 16);
+    auto lines = TextLayout::wrapText(welcomeText, WINDOW_WIDTH - 100.0f, 16);
     for (const auto& line : lines) {
         drawText(line, WINDOW_WIDTH / 2.0f, textY, 16, TEXT_COLOR, true);
         textY += 25.0f;
@@ -295,7 +369,7 @@ void GameWindow::renderDialog() {
     // Dialog text
     std::string dialogText = formatDialogText(dialog);
     float textY = 120.0f;
-    auto lines = wrapText(dialogText, WINDOW_WIDTH - 100.0f, 16);
+    auto lines = TextLayout::wrapText(dialogText, WINDOW_WIDTH - 100.0f, 16);
     for (const auto& line : lines) {
         drawText(line, 50.0f, textY, 16, TEXT_COLOR, false);
         textY += 25.0f;
@@ -324,7 +398,7 @@ void GameWindow::renderTask() {
     // Dialog text
     std::string dialogText = formatDialogText(dialog);
     float textY = 80.0f;
-    auto lines = wrapText(dialogText, WINDOW_WIDTH - 100.0f, 14);
+    auto lines = TextLayout::wrapText(dialogText, WINDOW_WIDTH - 100.0f, 14);
     for (const auto& line : lines) {
         drawText(line, 50.0f, textY, 14, TEXT_COLOR, false);
         textY += 22.0f;
@@ -336,7 +410,7 @@ void GameWindow::renderTask() {
     drawRectangle(50.0f, 260.0f, WINDOW_WIDTH - 100.0f, 80.0f, 
                  sf::Color(26, 26, 26), sf::Color(102, 102, 102));
     textY = 280.0f;
-    auto descLines = wrapText(taskDesc, WINDOW_WIDTH - 120.0f, 14);
+    auto descLines = TextLayout::wrapText(taskDesc, WINDOW_WIDTH - 120.0f, 14);
     for (const auto& line : descLines) {
         drawText(line, 60.0f, textY, 14, sf::Color::White, false);
         textY += 22.0f;
@@ -344,7 +418,7 @@ void GameWindow::renderTask() {
     
     // Question
     textY = 360.0f;
-    auto questionLines = wrapText(task.question, WINDOW_WIDTH - 100.0f, 16);
+    auto questionLines = TextLayout::wrapText(task.question, WINDOW_WIDTH - 100.0f, 16);
     for (const auto& line : questionLines) {
         drawText(line, 50.0f, textY, 16, TEXT_COLOR, false);
         textY += 24.0f;
@@ -355,6 +429,7 @@ void GameWindow::renderTask() {
     drawRectangle(50.0f, inputY, WINDOW_WIDTH - 100.0f, 40.0f, 
                  sf::Color(42, 42, 42), ACCENT_COLOR);
     drawText(inputText + "_", 60.0f, inputY + 10.0f, 18, sf::Color::White, false);
+    drawFormulaStatus(task, WINDOW_WIDTH - 320.0f, inputY + 12.0f);
     
     // Progress
     int current = gameEngine.getCurrentLevel();
@@ -366,6 +441,11 @@ void GameWindow::renderTask() {
         float progress = static_cast<float>(current) / static_cast<float>(max);
         drawProgressBar(100.0f, inputY + 85.0f, WINDOW_WIDTH - 200.0f, 15.0f, progress);
     }
+
+    // Completions drop down over the progress line
+    if (gameEngine.getCurrentState() == GameEngine::GameState::TASK) {
+        drawSuggestions(50.0f, inputY + 42.0f);
+    }
 }
 
 void GameWindow::renderResult() {
@@ -380,7 +460,7 @@ void GameWindow::renderResult() {
     drawRectangle(50.0f, feedbackY, WINDOW_WIDTH - 100.0f, 60.0f, 
                  sf::Color(26, 26, 26), feedbackColor);
     
-    auto feedbackLines = wrapText(feedback, WINDOW_WIDTH - 120.0f, 16);
+    auto feedbackLines = TextLayout::wrapText(feedback, WINDOW_WIDTH - 120.0f, 16);
     float textY = feedbackY + 15.0f;
     for (const auto& line : feedbackLines) {
         drawText(line, WINDOW_WIDTH / 2.0f, textY, 16, feedbackColor, true);
@@ -399,7 +479,7 @@ void GameWindow::renderGameOver() {
         "Наука, вот в чем суть!";
     
     float textY = 250.0f;
-    auto lines = wrapText(gameOverText, WINDOW_WIDTH - 100.0f, 18);
+    auto lines = TextLayout::wrapText(gameOverText, WINDOW_WIDTH - 100.0f, 18);
     for (const auto& line : lines) {
         drawText(line, WINDOW_WIDTH / 2.0f, textY, 18, TEXT_COLOR, true);
         textY += 30.0f;
@@ -412,6 +492,51 @@ void GameWindow::renderGameOver() {
     drawText(levelText, WINDOW_WIDTH / 2.0f, WINDOW_HEIGHT - 150.0f, 16, TEXT_COLOR, true);
 }
 
+void GameWindow::drawFormulaStatus(const DialogSystem::Task& task, float x, float y) {
+    // Numbers and equations are not formulas: only input that starts like one gets a verdict
+    const std::string& text = validator.text();
+    const size_t first = text.find_first_not_of(" \t");
+    if (task.type == DialogSystem::TaskType::EQUATION_BALANCE || first == std::string::npos ||
+        (text[first] >= '0' && text[first] <= '9')) {
+        return;
+    }
+    std::ostringstream line;
+    line << std::fixed << std::setprecision(3);
+    sf::Color color = TEXT_COLOR;
+    switch (validator.status()) {
+        case FormulaValidator::Status::VALID:
+            line << "M = " << validator.molarMass() << " г/моль";
+            color = ACCENT_COLOR;
+            break;
+        case FormulaValidator::Status::INCOMPLETE:
+            line << "... " << validator.molarMass() << " г/моль";
+            break;
+        case FormulaValidator::Status::INVALID:
+            line << FormulaParser::errorMessage(validator.result().error);
+            color = sf::Color(255, 80, 80);
+            break;
+        default:
+            return;
+    }
+    drawText(line.str(), x, y, 14, color, false);
+}
+
+void GameWindow::drawSuggestions(float x, float y) {
+    if (suggestions.empty()) {
+        return;
+    }
+    const float rowHeight = 24.0f;
+    drawRectangle(x, y, WINDOW_WIDTH - 2.0f * x, rowHeight * suggestions.size() + 8.0f,
+                 sf::Color(42, 42, 42), BUTTON_COLOR);
+    for (size_t i = 0; i < suggestions.size(); ++i) {
+        std::string line = std::string(suggestions[i].name) + "  ->  " + std::string(suggestions[i].formula);
+        if (i == 0) {
+            line += "   [Tab]";
+        }
+        drawText(line, x + 10.0f, y + 4.0f + rowHeight * i, 16, i == 0 ? ACCENT_COLOR : TEXT_COLOR, false);
+    }
+}
+
 void GameWindow::drawText(const std::string& text, float x, float y, int size, 
                           const sf::Color& color, bool centered) {
     sf::Text sfText;
@@ -484,49 +609,6 @@ void GameWindow::drawProgressBar(float x, float y, float width, float height, fl
     }
 }
 
-std::vector<std::string> GameWindow::wrapText(const std::string& text, float maxWidth, int fontSize) {
-    std::vector<std::string> lines;
-    
-    // Approximate character width (monospace font)
-    float charWidth = fontSize * 0.6f;
-    int charsPerLine = static_cast<int>(maxWidth / charWidth);
-    
-    // Split by newlines first
-    std::istringstream textStream(text);
-    std::string paragraph;
-    
-    while (std::getline(textStream, paragraph)) {
-        // Handle each paragraph separately
-        if (paragraph.empty()) {
-            lines.push_back(""); // Empty line
-            continue;
-        }
-        
-        // Word wrap within paragraph
-        std::istringstream paraStream(paragraph);
-        std::string word;
-        std::string currentLine;
-        
-        while (paraStream >> word) {
-            std::string testLine = currentLine.empty() ? word : currentLine + " " + word;
-            if (static_cast<int>(testLine.length()) <= charsPerLine || currentLine.empty()) {
-                currentLine = testLine;
-            } else {
-                if (!currentLine.empty()) {
-                    lines.push_back(currentLine);
-                }
-                currentLine = word;
-            }
-        }
-        
-        if (!currentLine.empty()) {
-            lines.push_back(currentLine);
-        }
-    }
-    
-    return lines;
-}
-
 std::string GameWindow::formatDialogText(const DialogSystem::Dialog& dialog) {
     std::string greeting = DialogSystem::getCharacterGreeting(dialog.character);
     return greeting + "\n\n" + dialog.text;
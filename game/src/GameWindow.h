@@ -5,6 +5,8 @@
 #include <SFML/Window.hpp>
 #include <string>
 #include <vector>
+#include "CompoundDictionary.h"
+#include "FormulaValidator.h"
 #include "GameEngine.h"
 
 /**
@@ -26,9 +28,14 @@ private:
     
     // Game engine
     GameEngine gameEngine;
+
+    // Compound names for input autocomplete
+    CompoundDictionary dictionary;
+    std::vector<CompoundDictionary::Entry> suggestions;
     
     // UI state
     std::string inputText;
+    FormulaValidator validator; // Parser state of inputText, kept in step with every keystroke
     bool inputActive;
     int selectedButton;
     
@@ -56,6 +63,7 @@ private:
     void handleMouseClick(int x, int y);
     void handleTextInput(sf::Uint32 unicode);
     void handleKeyPress(sf::Keyboard::Key key);
+    void updateSuggestions();
     
     // Rendering
     void render();
@@ -72,6 +80,8 @@ private:
     void drawRectangle(float x, float y, float width, float height, 
                       const sf::Color& fillColor, const sf::Color& outlineColor = sf::Color::Transparent);
     void drawProgressBar(float x, float y, float width, float height, float progress);
+    void drawSuggestions(float x, float y);
+    void drawFormulaStatus(const DialogSystem::Task& task, float x, float y);
     
     // UI state management
     void setupButtons();
@@ -81,9 +91,6 @@ private:
     // Text formatting
     std::string formatDialogText(const DialogSystem::Dialog& dialog);
     std::string formatTaskText(const DialogSystem::Task& task);
-    
-    // Word wrapping helper
-    std::vector<std::string> wrapText(const std::string& text, float maxWidth, int fontSize);
 };
 
 #endif // GAMEWINDOW_H
@@ -0,0 +1,384 @@
+#include "IsotopePattern.h"
+#include "IsotopeTable.h"
+#include "PeriodicTable.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <complex>
+#include <stdexcept>
+#include <string>
+
+namespace {
+
+using Complex = std::complex<double>;
+
+constexpr double PI = 3.14159265358979323846;
+
+// Grid step is resolution / 16 and every peak is a Gaussian two steps wide, which
+// the grid samples exactly enough (aliasing ~1e-9) for centroids and areas, while
+// peaks one resolution apart stay eight widths apart.
+constexpr double STEPS_PER_RESOLUTION = 16.0;
+constexpr double PEAK_SIGMA_STEPS = 2.0;
+
+// The mass window spans the mean +/- this many standard deviations (plus 1 u),
+// clipped to the lightest and heaviest possible molecule
+constexpr double WINDOW_SIGMAS = 10.0;
+
+constexpr size_t MAX_POINTS = size_t(1) << 22;
+
+// Segments lighter than this share of the total are FFT round-off, not peaks
+constexpr double NOISE_FLOOR = 1e-13;
+
+// Natural isotopes of one element of the formula, as offsets from their mean mass
+struct ElementTerm {
+    double atoms = 0.0;
+    double mean = 0.0;
+    double variance = 0.0;
+    int isotopeCount = 0;
+    std::array<double, 10> offsets{};
+    std::array<double, 10> abundances{};
+    std::array<Complex, 10> phasors{};   // e^(-i omega offset) at the current frequency
+    std::array<Complex, 10> rotations{}; // Phasor change from one frequency to the next
+    Complex value;                       // Characteristic function at the current frequency
+};
+
+// Frequencies whose amplitude is below e^-50 contribute nothing measurable
+constexpr double NEGLIGIBLE_LOG_AMPLITUDE = -50.0;
+
+// Phasors are advanced by multiplication and recomputed exactly this often
+constexpr size_t PHASOR_RESEED = 64;
+
+constexpr int maxNaturalIsotopes() {
+    int most = 0;
+    for (int z = 1; z <= PeriodicTable::ELEMENT_COUNT; ++z) {
+        int natural = 0;
+        for (int i = IsotopeTable::first(z); i < IsotopeTable::first(z) + IsotopeTable::count(z); ++i) {
+            natural += IsotopeTable::ISOTOPES[i].abundance > 0.0 ? 1 : 0;
+        }
+        most = std::max(most, natural);
+    }
+    return most;
+}
+
+static_assert(maxNaturalIsotopes() <= 10, "ElementTerm holds at most 10 natural isotopes");
+
+std::string missingDataMessage(int z) {
+    return std::string("No natural isotope data for ") + PeriodicTable::symbol(z);
+}
+
+// Atoms of each element that carry an explicit isotope label
+std::array<std::int64_t, PeriodicTable::ELEMENT_COUNT + 1> labelledAtoms(const FormulaParser::ElementCounts& counts) {
+    std::array<std::int64_t, PeriodicTable::ELEMENT_COUNT + 1> labelled{};
+    for (int i = 0; i < counts.isotopeCount; ++i) {
+        labelled[IsotopeTable::ISOTOPES[counts.isotopes[i].isotope].atomicNumber] += counts.isotopes[i].count;
+    }
+    return labelled;
+}
+
+double labelledMass(const FormulaParser::ElementCounts& counts) {
+    double mass = 0.0;
+    for (int i = 0; i < counts.isotopeCount; ++i) {
+        mass += IsotopeTable::ISOTOPES[counts.isotopes[i].isotope].mass * static_cast<double>(counts.isotopes[i].count);
+    }
+    return mass;
+}
+
+ElementTerm makeTerm(int z, std::int64_t atoms) {
+    ElementTerm term;
+    term.atoms = static_cast<double>(atoms);
+    double total = 0.0;
+    for (int i = IsotopeTable::first(z); i < IsotopeTable::first(z) + IsotopeTable::count(z); ++i) {
+        const IsotopeTable::Isotope& isotope = IsotopeTable::ISOTOPES[i];
+        if (isotope.abundance > 0.0) {
+            term.offsets[term.isotopeCount] = isotope.mass;
+            term.abundances[term.isotopeCount] = isotope.abundance;
+            term.isotopeCount++;
+            total += isotope.abundance;
+        }
+    }
+    if (term.isotopeCount == 0) {
+        throw std::invalid_argument(missingDataMessage(z));
+    }
+    // Tabulated abundances may not add up to exactly 1
+    for (int i = 0; i < term.isotopeCount; ++i) {
+        term.abundances[i] /= total;
+        term.mean += term.abundances[i] * term.offsets[i];
+    }
+    for (int i = 0; i < term.isotopeCount; ++i) {
+        term.offsets[i] -= term.mean;
+        term.variance += term.abundances[i] * term.offsets[i] * term.offsets[i];
+    }
+    return term;
+}
+
+// Twiddles of every radix-2 stage up to n, stage by stage: e^(+2 pi i k / length) for
+// k < length / 2 is stored from index length / 2 - 1, so the butterflies read them in order
+void buildTwiddles(size_t n, std::vector<Complex>& twiddles) {
+    if (twiddles.size() == n - 1) {
+        return;
+    }
+    twiddles.resize(n - 1);
+    for (size_t length = 2; length <= n; length <<= 1) {
+        Complex* stage = twiddles.data() + length / 2 - 1;
+        for (size_t k = 0; k < length / 2; ++k) {
+            stage[k] = std::polar(1.0, 2.0 * PI * static_cast<double>(k) / static_cast<double>(length));
+        }
+    }
+}
+
+// In-place radix-2 transform with kernel e^(+2 pi i jk / n), unnormalized; n is a power of two
+void inverseFft(Complex* data, size_t n, const std::vector<Complex>& twiddles) {
+    for (size_t i = 1, j = 0; i < n; ++i) {
+        size_t bit = n >> 1;
+        for (; j & bit; bit >>= 1) {
+            j ^= bit;
+        }
+        j ^= bit;
+        if (i < j) {
+            std::swap(data[i], data[j]);
+        }
+    }
+    for (size_t half = 1; half < n; half <<= 1) {
+        const Complex* stage = twiddles.data() + half - 1;
+        for (size_t start = 0; start < n; start += 2 * half) {
+            Complex* low = data + start;
+            Complex* high = low + half;
+            for (size_t k = 0; k < half; ++k) {
+                const Complex w = stage[k];
+                const Complex a = low[k];
+                const Complex b = high[k];
+                const Complex t(b.real() * w.real() - b.imag() * w.imag(), b.real() * w.imag() + b.imag() * w.real());
+                low[k] = a + t;
+                high[k] = a - t;
+            }
+        }
+    }
+}
+
+// Inverse transform of a Hermitian spectrum, whose result is real, with one complex transform
+// of half the size: even samples land in the real parts and odd samples in the imaginary parts
+void inverseRealFft(std::vector<Complex>& spectrum, std::vector<Complex>& twiddles, std::vector<double>& profile) {
+    const size_t n = spectrum.size();
+    const size_t half = n / 2;
+    buildTwiddles(n, twiddles);
+    const Complex* unpack = twiddles.data() + half - 1; // e^(+2 pi i k / n)
+    for (size_t k = 0; k < half; ++k) {
+        const Complex a = spectrum[k];
+        const Complex b = spectrum[k + half];
+        const Complex d = (a - b) * unpack[k];
+        spectrum[k] = Complex(a.real() + b.real() - d.imag(), a.imag() + b.imag() + d.real());
+    }
+    inverseFft(spectrum.data(), half, twiddles);
+    profile.resize(n);
+    for (size_t m = 0; m < half; ++m) {
+        profile[2 * m] = spectrum[m].real();
+        profile[2 * m + 1] = spectrum[m].imag();
+    }
+}
+
+// Per-thread FFT buffers, reused between patterns
+struct Scratch {
+    std::vector<Complex> spectrum;
+    std::vector<Complex> twiddles;
+    std::vector<double> profile;
+    std::vector<IsotopePattern::Peak> segments;
+};
+
+Scratch& scratch() {
+    thread_local Scratch buffers;
+    return buffers;
+}
+
+} // namespace
+
+double IsotopePattern::monoisotopicMass(const FormulaParser::ElementCounts& counts) {
+    const auto labelled = labelledAtoms(counts);
+    double mass = labelledMass(counts);
+    counts.forEach([&](int z, std::int64_t n) {
+        std::int64_t natural = n - labelled[z];
+        if (natural == 0) return;
+        int isotope = IsotopeTable::mostAbundant(z);
+        if (isotope < 0) {
+            throw std::invalid_argument(missingDataMessage(z));
+        }
+        mass += IsotopeTable::ISOTOPES[isotope].mass * static_cast<double>(natural);
+    });
+    return mass;
+}
+
+IsotopePattern::Pattern IsotopePattern::compute(const FormulaParser::ElementCounts& counts, const Options& options) {
+    if (!(options.resolution > 0.0) || !std::isfinite(options.resolution) ||
+        !(options.probabilityCutoff >= 0.0 && options.probabilityCutoff < 1.0)) {
+        throw std::invalid_argument("Isotope pattern needs a positive resolution and a cutoff in [0, 1)");
+    }
+
+    Pattern pattern;
+    pattern.charge = counts.charge;
+    if (counts.empty()) {
+        return pattern;
+    }
+    pattern.monoisotopicMass = monoisotopicMass(counts);
+
+    // Labelled atoms have one fixed mass; the rest follow the natural abundances
+    const auto labelled = labelledAtoms(counts);
+    std::vector<ElementTerm> terms;
+    double mean = labelledMass(counts);
+    double variance = 0.0;
+    double lightest = mean;
+    double heaviest = mean;
+    counts.forEach([&](int z, std::int64_t n) {
+        std::int64_t natural = n - labelled[z];
+        if (natural == 0) return;
+        ElementTerm term = makeTerm(z, natural);
+        double low = *std::min_element(term.offsets.begin(), term.offsets.begin() + term.isotopeCount);
+        double high = *std::max_element(term.offsets.begin(), term.offsets.begin() + term.isotopeCount);
+        mean += term.atoms * term.mean;
+        variance += term.atoms * term.variance;
+        lightest += term.atoms * (term.mean + low);
+        heaviest += term.atoms * (term.mean + high);
+        terms.push_back(term);
+    });
+    pattern.averageMass = mean;
+
+    // Mass grid: window around the mean plus room for the peak shape at both ends
+    const double step = options.resolution / STEPS_PER_RESOLUTION;
+    const double peakSigma = PEAK_SIGMA_STEPS * step;
+    const double spread = WINDOW_SIGMAS * std::sqrt(variance) + 1.0;
+    const double origin = std::max(lightest, mean - spread) - 8.0 * peakSigma;
+    const double end = std::min(heaviest, mean + spread) + 8.0 * peakSigma;
+    const double needed = (end - origin) / step + 1.0;
+    if (needed > static_cast<double>(MAX_POINTS)) {
+        throw std::invalid_argument("Isotope pattern resolution is too fine for this formula");
+    }
+    size_t points = 16;
+    while (static_cast<double>(points) < needed) {
+        points <<= 1;
+    }
+    const double period = static_cast<double>(points) * step;
+    const double shift = mean - origin;
+
+    // Characteristic function times the Gaussian peak shape, moved so the window starts at
+    // index 0. Frequencies above points / 2 are the complex conjugates of those below.
+    Scratch& buffers = scratch();
+    std::vector<Complex>& spectrum = buffers.spectrum;
+    spectrum.assign(points, Complex(0.0, 0.0));
+    const double omegaStep = 2.0 * PI / period;
+    for (ElementTerm& term : terms) {
+        for (int i = 0; i < term.isotopeCount; ++i) {
+            term.rotations[i] = std::polar(1.0, -omegaStep * term.offsets[i]);
+        }
+    }
+    for (size_t k = 0; k <= points / 2; ++k) {
+        const double omega = omegaStep * static_cast<double>(k);
+        double logMagnitude = -0.5 * omega * omega * peakSigma * peakSigma;
+        for (ElementTerm& term : terms) {
+            Complex sum(0.0, 0.0);
+            for (int i = 0; i < term.isotopeCount; ++i) {
+                Complex& phasor = term.phasors[i];
+                if (k % PHASOR_RESEED == 0) {
+                    phasor = std::polar(1.0, -omega * term.offsets[i]);
+                }
+                sum += term.abundances[i] * phasor;
+                const Complex& r = term.rotations[i];
+                phasor = Complex(phasor.real() * r.real() - phasor.imag() * r.imag(),
+                                 phasor.real() * r.imag() + phasor.imag() * r.real());
+            }
+            term.value = sum;
+            logMagnitude += term.atoms * 0.5 * std::log(std::norm(sum));
+        }
+        // Large molecules: most frequencies away from the nominal-mass harmonics vanish
+        if (logMagnitude < NEGLIGIBLE_LOG_AMPLITUDE) {
+            continue;
+        }
+        // Raising to an integer power: the branch of the logarithm does not matter
+        double phase = -omega * shift;
+        for (const ElementTerm& term : terms) {
+            phase += term.atoms * std::arg(term.value);
+        }
+        spectrum[k] = std::polar(std::exp(logMagnitude), phase);
+        if (k != 0 && k != points / 2) {
+            spectrum[points - k] = std::conj(spectrum[k]);
+        }
+    }
+
+    std::vector<double>& profile = buffers.profile;
+    inverseRealFft(spectrum, buffers.twiddles, profile);
+
+    // Split the profile at its local minima and centroid each piece
+    double total = 0.0;
+    for (double value : profile) {
+        total += std::max(value, 0.0);
+    }
+    std::vector<Peak>& segments = buffers.segments;
+    segments.clear();
+    double weight = 0.0;
+    double moment = 0.0;
+    auto closeSegment = [&]() {
+        if (weight > NOISE_FLOOR * total) {
+            segments.push_back(Peak{moment / weight, weight / total});
+        }
+        weight = 0.0;
+        moment = 0.0;
+    };
+    for (size_t j = 0; j < points; ++j) {
+        const double value = profile[j];
+        if (j > 0 && j + 1 < points && value < profile[j - 1] && value <= profile[j + 1]) {
+            closeSegment();
+        }
+        if (value > 0.0) {
+            weight += value;
+            moment += value * (origin + static_cast<double>(j) * step);
+        }
+    }
+    closeSegment();
+
+    // Merge peaks closer than the resolution, then apply the cutoff
+    std::vector<Peak> merged;
+    for (const Peak& peak : segments) {
+        if (!merged.empty() && peak.mass - merged.back().mass < options.resolution) {
+            Peak& last = merged.back();
+            double probability = last.probability + peak.probability;
+            last.mass = (last.mass * last.probability + peak.mass * peak.probability) / probability;
+            last.probability = probability;
+        } else {
+            merged.push_back(peak);
+        }
+    }
+    double tallest = 0.0;
+    for (const Peak& peak : merged) {
+        tallest = std::max(tallest, peak.probability);
+    }
+    for (const Peak& peak : merged) {
+        if (peak.probability >= options.probabilityCutoff * tallest) {
+            pattern.peaks.push_back(peak);
+        }
+    }
+    auto byProbability = [](const Peak& a, const Peak& b) { return a.probability < b.probability; };
+    pattern.basePeak = static_cast<size_t>(
+        std::max_element(pattern.peaks.begin(), pattern.peaks.end(), byProbability) - pattern.peaks.begin());
+
+    // Ions: remove the electrons and divide by the charge
+    if (pattern.charge != 0) {
+        const double electrons = static_cast<double>(pattern.charge) * ELECTRON_MASS;
+        const double z = std::abs(static_cast<double>(pattern.charge));
+        for (Peak& peak : pattern.peaks) {
+            peak.mass = (peak.mass - electrons) / z;
+        }
+        pattern.monoisotopicMass = (pattern.monoisotopicMass - electrons) / z;
+        pattern.averageMass = (pattern.averageMass - electrons) / z;
+    }
+    return pattern;
+}
+
+std::vector<IsotopePattern::Pattern> IsotopePattern::computeBatch(
+    const std::vector<FormulaParser::ElementCounts>& formulas, const Options& options, ThreadPool& pool, size_t grain) {
+    std::vector<Pattern> patterns(formulas.size());
+    // parallelFor rethrows for the first failing formula in input order, whatever the thread timing
+    pool.parallelFor(formulas.size(), grain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            patterns[i] = compute(formulas[i], options);
+        }
+    });
+    return patterns;
+}
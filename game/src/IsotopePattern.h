@@ -0,0 +1,55 @@
+#ifndef ISOTOPEPATTERN_H
+#define ISOTOPEPATTERN_H
+
+#include "FormulaParser.h"
+#include <cstdint>
+#include <vector>
+
+class ThreadPool;
+
+/**
+ * @brief IsotopePattern - Isotope distribution (mass spectrum) of a formula
+ * The characteristic function of the molecule's mass is the product, over
+ * elements, of each element's isotope characteristic function raised to its
+ * atom count. It is sampled on a frequency grid and turned into a spectrum by
+ * one inverse FFT. Every peak gets a narrow Gaussian shape so the grid can
+ * resolve it. Each peak is then centroided and peaks closer than the
+ * resolution are merged. Cost depends on the spread of the distribution, not
+ * on the number of atoms, so a 5,000-atom protein takes about as long as glucose.
+ * Natural abundances come from IsotopeTable. Explicitly labelled atoms ([13C])
+ * keep their nuclide's mass.
+ */
+class IsotopePattern {
+public:
+    static constexpr double ELECTRON_MASS = 0.000548579909065; // u
+
+    struct Options {
+        double resolution = 0.01;         // Peaks closer than this (u) are reported as one
+        double probabilityCutoff = 1e-6;  // Peaks below this fraction of the tallest one are dropped
+    };
+
+    struct Peak {
+        double mass;        // Centroid; m/z when the formula is charged
+        double probability; // Fraction of all molecules
+    };
+
+    struct Pattern {
+        std::vector<Peak> peaks;       // Ascending mass
+        size_t basePeak = 0;           // Index of the most probable peak
+        double monoisotopicMass = 0.0; // Most abundant isotope of every element (m/z for ions)
+        double averageMass = 0.0;      // Abundance-weighted mean (m/z for ions)
+        std::int64_t charge = 0;
+    };
+
+    // Throws std::invalid_argument for elements without natural isotope data or bad options
+    static Pattern compute(const FormulaParser::ElementCounts& counts, const Options& options);
+
+    // Patterns of many formulas in parallel; patterns[i] belongs to formulas[i]
+    static std::vector<Pattern> computeBatch(const std::vector<FormulaParser::ElementCounts>& formulas,
+                                             const Options& options, ThreadPool& pool, size_t grain = 16);
+
+    // Sum of the most abundant isotope masses (explicit labels keep their own mass), neutral molecule
+    static double monoisotopicMass(const FormulaParser::ElementCounts& counts);
+};
+
+#endif // ISOTOPEPATTERN_H
@@ -0,0 +1,149 @@
+#ifndef ISOTOPETABLE_H
+#define ISOTOPETABLE_H
+
+#include "PeriodicTable.h"
+#include <array>
+#include <cstdint>
+
+/**
+ * @brief IsotopeTable - Compile-time table of nuclide masses and natural abundances
+ * Covers the stable isotopes of the elements that occur in the game and in common
+ * lab chemistry, plus the usual radioactive labels (3H, 14C, 32P, 35S, 125I, 131I)
+ * with zero natural abundance. Entries are sorted by atomic number, then mass number.
+ */
+class IsotopeTable {
+public:
+    struct Isotope {
+        std::uint8_t atomicNumber;
+        std::uint16_t massNumber;
+        double mass;      // Atomic mass in u
+        double abundance; // Natural mole fraction (0 for radioactive labels)
+    };
+
+    static constexpr Isotope ISOTOPES[] = {
+        {1, 1, 1.00782503223, 0.999885},   {1, 2, 2.01410177812, 0.000115},   {1, 3, 3.01604927790, 0.0},
+        {2, 3, 3.01602932010, 0.00000134}, {2, 4, 4.00260325413, 0.99999866},
+        {3, 6, 6.01512288740, 0.0759},     {3, 7, 7.01600343660, 0.9241},
+        {4, 9, 9.01218306500, 1.0},
+        {5, 10, 10.0129369500, 0.199},     {5, 11, 11.0093053600, 0.801},
+        {6, 12, 12.0000000000, 0.9893},    {6, 13, 13.0033548351, 0.0107},    {6, 14, 14.0032419884, 0.0},
+        {7, 14, 14.0030740044, 0.99636},   {7, 15, 15.0001088989, 0.00364},
+        {8, 16, 15.9949146196, 0.99757},   {8, 17, 16.9991317565, 0.00038},   {8, 18, 17.9991596129, 0.00205},
+        {9, 19, 18.9984031627, 1.0},
+        {10, 20, 19.9924401762, 0.9048},   {10, 21, 20.9938466850, 0.0027},   {10, 22, 21.9913851140, 0.0925},
+        {11, 23, 22.9897692820, 1.0},
+        {12, 24, 23.9850416970, 0.7899},   {12, 25, 24.9858369760, 0.1000},   {12, 26, 25.9825929680, 0.1101},
+        {13, 27, 26.9815385300, 1.0},
+        {14, 28, 27.9769265347, 0.92223},  {14, 29, 28.9764946649, 0.04685},  {14, 30, 29.9737701360, 0.03092},
+        {15, 31, 30.9737619984, 1.0},      {15, 32, 31.9739076430, 0.0},
+        {16, 32, 31.9720711744, 0.9499},   {16, 33, 32.9714589098, 0.0075},   {16, 34, 33.9678670040, 0.0425},
+        {16, 35, 34.9690323220, 0.0},      {16, 36, 35.9670807100, 0.0001},
+        {17, 35, 34.9688526820, 0.7576},   {17, 37, 36.9659026020, 0.2424},
+        {18, 36, 35.9675451050, 0.003336}, {18, 38, 37.9627321100, 0.000629}, {18, 40, 39.9623831237, 0.996035},
+        {19, 39, 38.9637064864, 0.932581}, {19, 40, 39.9639981660, 0.000117}, {19, 41, 40.9618252579, 0.067302},
+        {20, 40, 39.9625908630, 0.96941},  {20, 42, 41.9586178300, 0.00647},  {20, 43, 42.9587664400, 0.00135},
+        {20, 44, 43.9554816000, 0.02086},  {20, 46, 45.9536890000, 0.00004},  {20, 48, 47.9525227600, 0.00187},
+        {22, 46, 45.9526277200, 0.0825},   {22, 47, 46.9517587900, 0.0744},   {22, 48, 47.9479419800, 0.7372},
+        {22, 49, 48.9478656800, 0.0541},   {22, 50, 49.9447868900, 0.0518},
+        {24, 50, 49.9460418300, 0.04345},  {24, 52, 51.9405062300, 0.83789},  {24, 53, 52.9406481500, 0.09501},
+        {24, 54, 53.9388791600, 0.02365},
+        {25, 55, 54.9380439100, 1.0},
+        {26, 54, 53.9396089900, 0.05845},  {26, 56, 55.9349363300, 0.91754},  {26, 57, 56.9353928400, 0.02119},
+        {26, 58, 57.9332744300, 0.00282},
+        {27, 59, 58.9331942900, 1.0},
+        {28, 58, 57.9353424100, 0.68077},  {28, 60, 59.9307858800, 0.26223},  {28, 61, 60.9310555700, 0.011399},
+        {28, 62, 61.9283453700, 0.036346}, {28, 64, 63.9279668200, 0.009255},
+        {29, 63, 62.9295977200, 0.6915},   {29, 65, 64.9277897000, 0.3085},
+        {30, 64, 63.9291420100, 0.4917},   {30, 66, 65.9260338100, 0.2773},   {30, 67, 66.9271277500, 0.0404},
+        {30, 68, 67.9248445500, 0.1845},   {30, 70, 69.9253192000, 0.0061},
+        {33, 75, 74.9215945700, 1.0},
+        {34, 74, 73.9224759340, 0.0089},   {34, 76, 75.9192137040, 0.0937},   {34, 77, 76.9199141540, 0.0763},
+        {34, 78, 77.9173092800, 0.2377},   {34, 80, 79.9165218000, 0.4961},   {34, 82, 81.9166995000, 0.0873},
+        {35, 79, 78.9183376000, 0.5069},   {35, 81, 80.9162897000, 0.4931},
+        {47, 107, 106.905091600, 0.51839}, {47, 109, 108.904755300, 0.48161},
+        {50, 112, 111.904823870, 0.0097},  {50, 114, 113.902782700, 0.0066},  {50, 115, 114.903344699, 0.0034},
+        {50, 116, 115.901742800, 0.1454},  {50, 117, 116.902953980, 0.0768},  {50, 118, 117.901606570, 0.2422},
+        {50, 119, 118.903311170, 0.0859},  {50, 120, 119.902201630, 0.3258},  {50, 122, 121.903443800, 0.0463},
+        {50, 124, 123.905276600, 0.0579},
+        {53, 125, 124.904629400, 0.0},     {53, 127, 126.904471900, 1.0},     {53, 131, 130.906126300, 0.0},
+        {55, 133, 132.905451961, 1.0},
+        {78, 190, 189.959929700, 0.00012}, {78, 192, 191.961038700, 0.00782}, {78, 194, 193.962680900, 0.3286},
+        {78, 195, 194.964791700, 0.3378},  {78, 196, 195.964952090, 0.2521},  {78, 198, 197.967894900, 0.07356},
+        {79, 197, 196.966568790, 1.0},
+        {80, 196, 195.965832600, 0.0015},  {80, 198, 197.966768600, 0.0997},  {80, 199, 198.968280640, 0.1687},
+        {80, 200, 199.968326590, 0.2310},  {80, 201, 200.970302840, 0.1318},  {80, 202, 201.970643400, 0.2986},
+        {80, 204, 203.973493980, 0.0687},
+        {82, 204, 203.973044000, 0.014},   {82, 206, 205.974465700, 0.241},   {82, 207, 206.975897300, 0.221},
+        {82, 208, 207.976652500, 0.524},
+        {83, 209, 208.980399100, 1.0},
+        {92, 234, 234.040952300, 0.000054}, {92, 235, 235.043930100, 0.007204}, {92, 238, 238.050788400, 0.992742},
+    };
+
+    static constexpr int ISOTOPE_COUNT = static_cast<int>(sizeof(ISOTOPES) / sizeof(ISOTOPES[0]));
+
+    // Index into ISOTOPES of nuclide (atomicNumber, massNumber), or -1 if it is not tabulated
+    static constexpr int find(int atomicNumber, int massNumber) {
+        if (atomicNumber <= 0 || atomicNumber > PeriodicTable::ELEMENT_COUNT) {
+            return -1;
+        }
+        for (int i = FIRST_ISOTOPE[atomicNumber]; i < FIRST_ISOTOPE[atomicNumber + 1]; ++i) {
+            if (ISOTOPES[i].massNumber == massNumber) {
+                return i;
+            }
+        }
+        return -1;
+    }
+
+    // Isotopes of one element are ISOTOPES[first(z)] .. ISOTOPES[first(z) + count(z) - 1]
+    static constexpr int first(int atomicNumber) { return FIRST_ISOTOPE[atomicNumber]; }
+    static constexpr int count(int atomicNumber) {
+        return FIRST_ISOTOPE[atomicNumber + 1] - FIRST_ISOTOPE[atomicNumber];
+    }
+
+    // Most abundant natural isotope of an element, or -1 if none is tabulated
+    static constexpr int mostAbundant(int atomicNumber) {
+        int best = -1;
+        for (int i = first(atomicNumber); i < first(atomicNumber) + count(atomicNumber); ++i) {
+            if (ISOTOPES[i].abundance > 0.0 && (best < 0 || ISOTOPES[i].abundance > ISOTOPES[best].abundance)) {
+                best = i;
+            }
+        }
+        return best;
+    }
+
+    // True when entries are sorted by (atomic number, mass number) (checked by a static_assert below)
+    static constexpr bool isSorted() {
+        for (int i = 1; i < ISOTOPE_COUNT; ++i) {
+            const Isotope& a = ISOTOPES[i - 1];
+            const Isotope& b = ISOTOPES[i];
+            if (a.atomicNumber > b.atomicNumber ||
+                (a.atomicNumber == b.atomicNumber && a.massNumber >= b.massNumber)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+private:
+    // FIRST_ISOTOPE[z] is the index of the first isotope of element z; [z + 1] ends the run
+    static constexpr std::array<std::int16_t, PeriodicTable::ELEMENT_COUNT + 2> buildFirstIsotope() {
+        std::array<std::int16_t, PeriodicTable::ELEMENT_COUNT + 2> first{};
+        int i = 0;
+        for (int z = 0; z <= PeriodicTable::ELEMENT_COUNT + 1; ++z) {
+            while (i < ISOTOPE_COUNT && ISOTOPES[i].atomicNumber < z) {
+                i++;
+            }
+            first[z] = static_cast<std::int16_t>(i);
+        }
+        return first;
+    }
+
+    static const std::array<std::int16_t, PeriodicTable::ELEMENT_COUNT + 2> FIRST_ISOTOPE;
+};
+
+inline constexpr std::array<std::int16_t, PeriodicTable::ELEMENT_COUNT + 2> IsotopeTable::FIRST_ISOTOPE =
+    IsotopeTable::buildFirstIsotope();
+
+static_assert(IsotopeTable::isSorted(), "Isotope table must be sorted by atomic and mass number");
+
+#endif // ISOTOPETABLE_H
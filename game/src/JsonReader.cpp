@@ -0,0 +1,368 @@
+#include "JsonReader.h"
+#include <cerrno>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+
+namespace {
+
+// skipValue() stops here rather than recursing without bound on hostile input
+constexpr int MAX_DEPTH = 512;
+
+// Longest number handed to strtod, which needs a terminated copy
+constexpr size_t MAX_NUMBER_LENGTH = 64;
+
+bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+int hexValue(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+void appendUtf8(std::string& out, std::uint32_t code) {
+    if (code < 0x80) {
+        out += static_cast<char>(code);
+    } else if (code < 0x800) {
+        out += static_cast<char>(0xC0 | (code >> 6));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else if (code < 0x10000) {
+        out += static_cast<char>(0xE0 | (code >> 12));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    } else {
+        out += static_cast<char>(0xF0 | (code >> 18));
+        out += static_cast<char>(0x80 | ((code >> 12) & 0x3F));
+        out += static_cast<char>(0x80 | ((code >> 6) & 0x3F));
+        out += static_cast<char>(0x80 | (code & 0x3F));
+    }
+}
+
+} // namespace
+
+std::string JsonReader::Error::toString() const {
+    return std::to_string(line) + ":" + std::to_string(column) + ": " + message;
+}
+
+JsonReader::JsonReader(std::string_view text) : text(text) {}
+
+void JsonReader::skipSpace() {
+    while (pos < text.size()) {
+        const char c = text[pos];
+        if (c != ' ' && c != '\n' && c != '\r' && c != '\t') break;
+        pos++;
+    }
+}
+
+size_t JsonReader::position() {
+    skipSpace();
+    return pos;
+}
+
+bool JsonReader::fail(std::string_view message) {
+    return failAt(position(), message);
+}
+
+bool JsonReader::failAt(size_t offset, std::string_view message) {
+    if (hasError) return false;
+    hasError = true;
+    lastError.message = std::string(message);
+    lastError.offset = offset;
+    lastError.line = 1;
+    size_t lineStart = 0;
+    for (size_t i = 0; i < offset && i < text.size(); ++i) {
+        if (text[i] == '\n') {
+            lastError.line++;
+            lineStart = i + 1;
+        }
+    }
+    lastError.column = offset - lineStart + 1;
+    return false;
+}
+
+bool JsonReader::expect(char c, std::string_view message) {
+    skipSpace();
+    if (pos >= text.size() || text[pos] != c) {
+        return fail(message);
+    }
+    pos++;
+    return true;
+}
+
+JsonReader::Kind JsonReader::peek() {
+    if (hasError) return Kind::INVALID;
+    skipSpace();
+    if (pos >= text.size()) return Kind::END;
+    switch (text[pos]) {
+        case '{': return Kind::OBJECT;
+        case '[': return Kind::ARRAY;
+        case '"': return Kind::STRING;
+        case 't':
+        case 'f': return Kind::BOOLEAN;
+        case 'n': return Kind::NULL_VALUE;
+        default: return text[pos] == '-' || isDigit(text[pos]) ? Kind::NUMBER : Kind::INVALID;
+    }
+}
+
+bool JsonReader::beginObject() {
+    if (hasError || !expect('{', "Expected an object")) return false;
+    firstInScope.push_back(1);
+    return true;
+}
+
+bool JsonReader::beginArray() {
+    if (hasError || !expect('[', "Expected an array")) return false;
+    firstInScope.push_back(1);
+    return true;
+}
+
+bool JsonReader::nextMember(char close, std::string_view message) {
+    if (hasError) return false;
+    if (firstInScope.empty()) return fail("No object or array is open");
+    skipSpace();
+    if (pos < text.size() && text[pos] == close) {
+        pos++;
+        firstInScope.pop_back();
+        return false;
+    }
+    if (!firstInScope.back() && !expect(',', message)) return false;
+    firstInScope.back() = 0;
+    return true;
+}
+
+bool JsonReader::nextKey(std::string_view& key) {
+    if (!nextMember('}', "Expected ',' or '}'")) return false;
+    if (peek() != Kind::STRING) return fail("Expected a key in double quotes");
+    return readString(key) && expect(':', "Expected ':'");
+}
+
+bool JsonReader::nextElement() {
+    return nextMember(']', "Expected ',' or ']'");
+}
+
+bool JsonReader::readString(std::string_view& out) {
+    if (hasError || !expect('"', "Expected a string")) return false;
+    const size_t start = pos;
+
+    // Fast path: no escapes, the view points into the text
+    while (pos < text.size()) {
+        const char c = text[pos];
+        if (c == '"') {
+            out = text.substr(start, pos - start);
+            pos++;
+            return true;
+        }
+        if (c == '\\') break;
+        if (static_cast<unsigned char>(c) < 0x20) return failAt(pos, "Control character in string");
+        pos++;
+    }
+    if (pos >= text.size()) return failAt(start - 1, "Unterminated string");
+
+    decoded.assign(text.data() + start, pos - start);
+    while (pos < text.size()) {
+        const char c = text[pos];
+        if (c == '"') {
+            out = decoded;
+            pos++;
+            return true;
+        }
+        if (static_cast<unsigned char>(c) < 0x20) return failAt(pos, "Control character in string");
+        if (c != '\\') {
+            decoded += c;
+            pos++;
+            continue;
+        }
+        const size_t escape = pos;
+        if (++pos >= text.size()) break;
+        switch (text[pos++]) {
+            case '"': decoded += '"'; break;
+            case '\\': decoded += '\\'; break;
+            case '/': decoded += '/'; break;
+            case 'b': decoded += '\b'; break;
+            case 'f': decoded += '\f'; break;
+            case 'n': decoded += '\n'; break;
+            case 'r': decoded += '\r'; break;
+            case 't': decoded += '\t'; break;
+            case 'u': {
+                auto readHex = [this](std::uint32_t& value) {
+                    if (pos + 4 > text.size()) return false;
+                    value = 0;
+                    for (int i = 0; i < 4; ++i) {
+                        int digit = hexValue(text[pos + i]);
+                        if (digit < 0) return false;
+                        value = value * 16 + static_cast<std::uint32_t>(digit);
+                    }
+                    pos += 4;
+                    return true;
+                };
+                std::uint32_t code = 0;
+                if (!readHex(code)) return failAt(escape, "Expected four hex digits after \\u");
+                if (code >= 0xD800 && code < 0xDC00) {
+                    // High surrogate: the low half must follow as another \u escape
+                    std::uint32_t low = 0;
+                    if (pos + 2 > text.size() || text[pos] != '\\' || text[pos + 1] != 'u') {
+                        return failAt(escape, "Unpaired surrogate in \\u escape");
+                    }
+                    pos += 2;
+                    if (!readHex(low) || low < 0xDC00 || low >= 0xE000) {
+                        return failAt(escape, "Unpaired surrogate in \\u escape");
+                    }
+                    code = 0x10000 + ((code - 0xD800) << 10) + (low - 0xDC00);
+                } else if (code >= 0xDC00 && code < 0xE000) {
+                    return failAt(escape, "Unpaired surrogate in \\u escape");
+                }
+                appendUtf8(decoded, code);
+                break;
+            }
+            default:
+                return failAt(escape, "Unknown escape in string");
+        }
+    }
+    return failAt(start - 1, "Unterminated string");
+}
+
+bool JsonReader::scanNumber(size_t& end, bool& integral) {
+    skipSpace();
+    end = pos;
+    integral = true;
+    if (end < text.size() && text[end] == '-') end++;
+    if (end >= text.size() || !isDigit(text[end])) return fail("Expected a number");
+    if (text[end] == '0') {
+        end++;
+    } else {
+        while (end < text.size() && isDigit(text[end])) end++;
+    }
+    if (end < text.size() && text[end] == '.') {
+        integral = false;
+        if (++end >= text.size() || !isDigit(text[end])) return failAt(end, "Expected a digit after '.'");
+        while (end < text.size() && isDigit(text[end])) end++;
+    }
+    if (end < text.size() && (text[end] == 'e' || text[end] == 'E')) {
+        integral = false;
+        end++;
+        if (end < text.size() && (text[end] == '+' || text[end] == '-')) end++;
+        if (end >= text.size() || !isDigit(text[end])) return failAt(end, "Expected a digit in the exponent");
+        while (end < text.size() && isDigit(text[end])) end++;
+    }
+    return true;
+}
+
+bool JsonReader::readInteger(std::int64_t& out) {
+    size_t end = 0;
+    bool integral = false;
+    if (hasError || !scanNumber(end, integral)) return false;
+    if (!integral) return fail("Expected an integer");
+
+    const bool negative = text[pos] == '-';
+    std::uint64_t magnitude = 0;
+    const std::uint64_t limit = negative ? 9223372036854775808ull : 9223372036854775807ull;
+    for (size_t i = pos + (negative ? 1 : 0); i < end; ++i) {
+        const std::uint64_t digit = static_cast<std::uint64_t>(text[i] - '0');
+        if (magnitude > (limit - digit) / 10) return fail("Integer out of range");
+        magnitude = magnitude * 10 + digit;
+    }
+    out = negative ? static_cast<std::int64_t>(0 - magnitude) : static_cast<std::int64_t>(magnitude);
+    pos = end;
+    return true;
+}
+
+bool JsonReader::readNumber(double& out) {
+    size_t end = 0;
+    bool integral = false;
+    if (hasError || !scanNumber(end, integral)) return false;
+
+    // Short integers are exact as doubles: no strtod needed
+    const bool negative = text[pos] == '-';
+    const size_t digits = end - pos - (negative ? 1 : 0);
+    if (integral && digits <= 15) {
+        std::int64_t value = 0;
+        for (size_t i = end - digits; i < end; ++i) value = value * 10 + (text[i] - '0');
+        out = static_cast<double>(negative ? -value : value);
+        pos = end;
+        return true;
+    }
+
+    if (end - pos >= MAX_NUMBER_LENGTH) return fail("Number too long");
+    char buffer[MAX_NUMBER_LENGTH];
+    std::memcpy(buffer, text.data() + pos, end - pos);
+    buffer[end - pos] = '\0';
+    errno = 0;
+    out = std::strtod(buffer, nullptr);
+    if (errno == ERANGE && std::isinf(out)) return fail("Number out of range");
+    pos = end;
+    return true;
+}
+
+bool JsonReader::readNumberText(std::string_view& out) {
+    size_t end = 0;
+    bool integral = false;
+    if (hasError || !scanNumber(end, integral)) return false;
+    out = text.substr(pos, end - pos);
+    pos = end;
+    return true;
+}
+
+bool JsonReader::literal(std::string_view word) {
+    skipSpace();
+    if (text.compare(pos, word.size(), word) != 0) return false;
+    pos += word.size();
+    return true;
+}
+
+bool JsonReader::readBool(bool& out) {
+    if (hasError) return false;
+    if (literal("true")) {
+        out = true;
+        return true;
+    }
+    if (literal("false")) {
+        out = false;
+        return true;
+    }
+    return fail("Expected true or false");
+}
+
+bool JsonReader::readNull() {
+    return !hasError && (literal("null") || fail("Expected null"));
+}
+
+bool JsonReader::skipValue() {
+    return skipNested(0);
+}
+
+bool JsonReader::skipNested(int depth) {
+    if (depth > MAX_DEPTH) return fail("Nesting too deep");
+    std::string_view ignored;
+    double number = 0.0;
+    bool flag = false;
+    switch (peek()) {
+        case Kind::OBJECT:
+            if (!beginObject()) return false;
+            while (nextKey(ignored)) {
+                if (!skipNested(depth + 1)) return false;
+            }
+            return !hasError;
+        case Kind::ARRAY:
+            if (!beginArray()) return false;
+            while (nextElement()) {
+                if (!skipNested(depth + 1)) return false;
+            }
+            return !hasError;
+        case Kind::STRING: return readString(ignored);
+        case Kind::NUMBER: return readNumber(number);
+        case Kind::BOOLEAN: return readBool(flag);
+        case Kind::NULL_VALUE: return readNull();
+        case Kind::END: return fail("Unexpected end of text");
+        default: return fail("Expected a value");
+    }
+}
+
+bool JsonReader::finish() {
+    if (hasError) return false;
+    if (!firstInScope.empty()) return fail("Object or array not closed");
+    skipSpace();
+    return pos == text.size() || fail("Unexpected text after the end of the document");
+}
@@ -0,0 +1,82 @@
+#ifndef JSONREADER_H
+#define JSONREADER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @brief JsonReader - Single-pass pull reader for JSON text
+ * The caller walks the document in order: beginObject() and then nextKey()
+ * until it returns false, beginArray() and then nextElement() likewise, and
+ * a read call for each value. Nothing is built in between. A string without
+ * escapes comes back as a view into the text itself (a memory-mapped file
+ * stays untouched); one with escapes is decoded into a buffer that the next
+ * read reuses. skipValue() passes over values the caller does not know.
+ *
+ * The first error stops the reader: every later call returns false, and
+ * error() tells what was expected with the line and column (from 1). Lines
+ * are only counted when an error is reported.
+ */
+class JsonReader {
+public:
+    enum class Kind { OBJECT, ARRAY, STRING, NUMBER, BOOLEAN, NULL_VALUE, END, INVALID };
+
+    struct Error {
+        std::string message;
+        size_t offset = 0;
+        size_t line = 0;
+        size_t column = 0; // In bytes
+
+        std::string toString() const; // "12:5: Expected ':'"
+    };
+
+    explicit JsonReader(std::string_view text);
+
+    // Kind of the next value, without reading it
+    Kind peek();
+
+    bool beginObject();
+    bool nextKey(std::string_view& key); // false at the closing '}' (or on error)
+    bool beginArray();
+    bool nextElement();                  // false at the closing ']' (or on error)
+
+    bool readString(std::string_view& out); // Valid until the next read
+    bool readNumber(double& out);
+    bool readInteger(std::int64_t& out);    // A number without fraction or exponent
+    bool readNumberText(std::string_view& out); // The number as written, e.g. to keep "18.015" exact
+    bool readBool(bool& out);
+    bool readNull();
+    bool skipValue();
+
+    // Succeeds when only whitespace is left
+    bool finish();
+
+    // Offset of the next token, for errors found by the caller after reading a value
+    size_t position();
+    // Records an error (the first one wins) and returns false
+    bool fail(std::string_view message);
+    bool failAt(size_t offset, std::string_view message);
+
+    bool failed() const { return hasError; }
+    const Error& error() const { return lastError; }
+
+private:
+    std::string_view text;
+    size_t pos = 0;
+    std::vector<char> firstInScope; // Per open object/array: no member read yet
+    std::string decoded;
+    Error lastError;
+    bool hasError = false;
+
+    void skipSpace();
+    bool expect(char c, std::string_view message);
+    bool nextMember(char close, std::string_view message);
+    bool scanNumber(size_t& end, bool& integral);
+    bool literal(std::string_view word);
+    bool skipNested(int depth);
+};
+
+#endif // JSONREADER_H
@@ -0,0 +1,573 @@
+#include "Kinetics.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+namespace {
+
+// Step-size controller: new step = old * clamp(SAFETY * error^(-1/order), MIN_FACTOR, MAX_FACTOR)
+constexpr double SAFETY = 0.9;
+constexpr double MIN_FACTOR = 0.2;
+constexpr double MAX_FACTOR = 6.0;
+
+// ROS3 (Sandu et al. 1997): L-stable, order 3 with an embedded order-2 error estimate.
+// The second and third stages share one function evaluation.
+constexpr double ROS_GAMMA = 0.43586652150845899941601945119356;
+constexpr double ROS_A21 = 1.0;
+constexpr double ROS_C21 = -1.0156171083877702091975600115545;
+constexpr double ROS_C31 = 4.0759956452537699824805835358067;
+constexpr double ROS_C32 = 9.2076794298330791242156818474003;
+constexpr double ROS_M1 = 1.0;
+constexpr double ROS_M2 = 6.1697947043828245592553615689730;
+constexpr double ROS_M3 = -0.42772256543218573326238373806514;
+constexpr double ROS_E1 = 0.5;
+constexpr double ROS_E2 = -2.9079558716805469821718236208017;
+constexpr double ROS_E3 = 0.22354069897811569627360909276199;
+
+// Dormand-Prince 5(4)
+constexpr double DP_A21 = 1.0 / 5.0;
+constexpr double DP_A31 = 3.0 / 40.0, DP_A32 = 9.0 / 40.0;
+constexpr double DP_A41 = 44.0 / 45.0, DP_A42 = -56.0 / 15.0, DP_A43 = 32.0 / 9.0;
+constexpr double DP_A51 = 19372.0 / 6561.0, DP_A52 = -25360.0 / 2187.0, DP_A53 = 64448.0 / 6561.0,
+                 DP_A54 = -212.0 / 729.0;
+constexpr double DP_A61 = 9017.0 / 3168.0, DP_A62 = -355.0 / 33.0, DP_A63 = 46732.0 / 5247.0, DP_A64 = 49.0 / 176.0,
+                 DP_A65 = -5103.0 / 18656.0;
+constexpr double DP_B1 = 35.0 / 384.0, DP_B3 = 500.0 / 1113.0, DP_B4 = 125.0 / 192.0, DP_B5 = -2187.0 / 6784.0,
+                 DP_B6 = 11.0 / 84.0;
+// Fifth- minus fourth-order weights
+constexpr double DP_E1 = 71.0 / 57600.0, DP_E3 = -71.0 / 16695.0, DP_E4 = 71.0 / 1920.0,
+                 DP_E5 = -17253.0 / 339200.0, DP_E6 = 22.0 / 525.0, DP_E7 = -1.0 / 40.0;
+
+// Weighted RMS norm of an error estimate
+double errorNorm(const double* y, const double* next, const double* error, size_t n, const Kinetics::Options& options) {
+    double sum = 0.0;
+    for (size_t i = 0; i < n; ++i) {
+        double scale = options.absoluteTolerance +
+                       options.relativeTolerance * std::max(std::fabs(y[i]), std::fabs(next[i]));
+        double ratio = error[i] / scale;
+        sum += ratio * ratio;
+    }
+    return std::sqrt(sum / static_cast<double>(n));
+}
+
+} // namespace
+
+struct Kinetics::Workspace {
+    std::vector<double> k1, k2, k3, k4, k5, k6, k7;
+    std::vector<double> rates, stage, next, error;
+    std::vector<double> jacobian, matrix, work, factorDerivatives;
+};
+
+void Kinetics::addReaction(const ChemistryEngine::ChemicalEquation& equation, double forwardRate, double reverseRate) {
+    if (!(forwardRate >= 0.0) || !(reverseRate >= 0.0) || !std::isfinite(forwardRate) || !std::isfinite(reverseRate)) {
+        throw std::invalid_argument("Rate constants must be finite and non-negative");
+    }
+    for (const auto* side : {&equation.reactants, &equation.products}) {
+        for (const ChemistryEngine::EquationComponent& component : *side) {
+            if (component.coefficient <= 0) {
+                throw std::invalid_argument("Elementary steps need positive coefficients: " + equation.toString());
+            }
+        }
+    }
+    addDirection(equation.reactants, equation.products, forwardRate);
+    if (reverseRate > 0.0) {
+        addDirection(equation.products, equation.reactants, reverseRate);
+    }
+}
+
+void Kinetics::addReaction(std::string_view equation, double forwardRate, double reverseRate) {
+    addReaction(ChemistryEngine::parseEquation(equation), forwardRate, reverseRate);
+}
+
+size_t Kinetics::addSpecies(const std::string& formula) {
+    auto inserted = speciesLookup.emplace(formula, species.size());
+    if (inserted.second) {
+        species.push_back(formula);
+        analysed = false;
+    }
+    return inserted.first->second;
+}
+
+size_t Kinetics::speciesIndex(const std::string& formula) const {
+    auto it = speciesLookup.find(formula);
+    return it == speciesLookup.end() ? SIZE_MAX : it->second;
+}
+
+void Kinetics::addDirection(const std::vector<ChemistryEngine::EquationComponent>& from,
+                            const std::vector<ChemistryEngine::EquationComponent>& to, double rate) {
+    // Merge repeated species ("A + A" is second order in A) and net out catalysts
+    std::vector<std::pair<size_t, std::int32_t>> orders;
+    std::vector<std::pair<size_t, double>> changes;
+    auto accumulate = [](auto& list, size_t index, auto amount) {
+        for (auto& entry : list) {
+            if (entry.first == index) {
+                entry.second += amount;
+                return;
+            }
+        }
+        list.emplace_back(index, amount);
+    };
+    for (const ChemistryEngine::EquationComponent& component : from) {
+        size_t index = addSpecies(component.formula->originalFormula);
+        accumulate(orders, index, component.coefficient);
+        accumulate(changes, index, -static_cast<double>(component.coefficient));
+    }
+    for (const ChemistryEngine::EquationComponent& component : to) {
+        accumulate(changes, addSpecies(component.formula->originalFormula), static_cast<double>(component.coefficient));
+    }
+
+    rateConstant.push_back(rate);
+    for (const auto& order : orders) {
+        factorSpecies.push_back(static_cast<std::uint32_t>(order.first));
+        factorOrder.push_back(order.second);
+    }
+    factorBegin.push_back(static_cast<std::uint32_t>(factorSpecies.size()));
+    for (const auto& change : changes) {
+        if (change.second != 0.0) {
+            changeSpecies.push_back(static_cast<std::uint32_t>(change.first));
+            changeAmount.push_back(change.second);
+        }
+    }
+    changeBegin.push_back(static_cast<std::uint32_t>(changeSpecies.size()));
+    analysed = false;
+}
+
+void Kinetics::derivatives(const double* concentrations, double* rates) const {
+    std::fill(rates, rates + species.size(), 0.0);
+    for (size_t r = 0; r < rateConstant.size(); ++r) {
+        double rate = rateConstant[r];
+        for (std::uint32_t f = factorBegin[r]; f < factorBegin[r + 1]; ++f) {
+            const double c = concentrations[factorSpecies[f]];
+            for (std::int32_t power = 0; power < factorOrder[f]; ++power) {
+                rate *= c;
+            }
+        }
+        for (std::uint32_t x = changeBegin[r]; x < changeBegin[r + 1]; ++x) {
+            rates[changeSpecies[x]] += changeAmount[x] * rate;
+        }
+    }
+}
+
+void Kinetics::analyse() {
+    const size_t n = species.size();
+    // Pattern of the Jacobian: rate of change of i depends on j whenever j is a rate-law factor
+    // of a reaction that changes i
+    std::vector<std::uint8_t> adjacent(n * n, 0);
+    jacobianEntries = 0;
+    for (size_t r = 0; r < rateConstant.size(); ++r) {
+        for (std::uint32_t f = factorBegin[r]; f < factorBegin[r + 1]; ++f) {
+            for (std::uint32_t x = changeBegin[r]; x < changeBegin[r + 1]; ++x) {
+                std::uint8_t& entry = adjacent[changeSpecies[x] * n + factorSpecies[f]];
+                jacobianEntries += entry & 1 ? 0 : 1;
+                entry |= 1;
+            }
+        }
+    }
+
+    // Minimum-degree ordering on the symmetrised pattern; eliminating a node joins its neighbours
+    std::vector<std::uint8_t> linked(n * n, 0);
+    std::vector<size_t> degree(n, 0);
+    for (size_t i = 0; i < n; ++i) {
+        for (size_t j = 0; j < n; ++j) {
+            if (i != j && ((adjacent[i * n + j] | adjacent[j * n + i]) & 1)) {
+                linked[i * n + j] = 1;
+                degree[i]++;
+            }
+        }
+    }
+    std::vector<std::uint8_t> eliminated(n, 0);
+    std::vector<std::vector<std::uint32_t>> later(n); // Neighbours still present when the node went
+    speciesOfRow.clear();
+    rowOf.assign(n, 0);
+    std::vector<std::uint32_t> neighbours;
+    for (size_t step = 0; step < n; ++step) {
+        size_t pick = SIZE_MAX;
+        for (size_t i = 0; i < n; ++i) {
+            if (!eliminated[i] && (pick == SIZE_MAX || degree[i] < degree[pick])) pick = i;
+        }
+        eliminated[pick] = 1;
+        rowOf[pick] = static_cast<std::uint32_t>(step);
+        speciesOfRow.push_back(static_cast<std::uint32_t>(pick));
+        neighbours.clear();
+        for (size_t j = 0; j < n; ++j) {
+            if (!eliminated[j] && linked[pick * n + j]) neighbours.push_back(static_cast<std::uint32_t>(j));
+        }
+        for (std::uint32_t a : neighbours) {
+            degree[a]--;
+            for (std::uint32_t b : neighbours) {
+                if (a != b && !linked[a * n + b]) {
+                    linked[a * n + b] = 1;
+                    degree[a]++;
+                }
+            }
+        }
+        later[pick] = neighbours;
+    }
+
+    // Filled pattern in row order: node k couples to every neighbour left when it was eliminated
+    std::vector<std::vector<std::uint32_t>> rows(n);
+    for (size_t i = 0; i < n; ++i) {
+        const std::uint32_t row = rowOf[i];
+        rows[row].push_back(row);
+        for (std::uint32_t j : later[i]) {
+            rows[row].push_back(rowOf[j]);
+            rows[rowOf[j]].push_back(row);
+        }
+    }
+    rowBegin.assign(1, 0);
+    column.clear();
+    diagonal.assign(n, 0);
+    for (size_t row = 0; row < n; ++row) {
+        std::sort(rows[row].begin(), rows[row].end());
+        for (std::uint32_t col : rows[row]) {
+            if (col == row) diagonal[row] = static_cast<std::uint32_t>(column.size());
+            column.push_back(col);
+        }
+        rowBegin.push_back(static_cast<std::uint32_t>(column.size()));
+    }
+
+    auto position = [this](std::uint32_t row, std::uint32_t col) {
+        auto begin = column.begin() + rowBegin[row], end = column.begin() + rowBegin[row + 1];
+        return static_cast<std::uint32_t>(std::lower_bound(begin, end, col) - column.begin());
+    };
+    jacobianPosition.clear();
+    jacobianFactor.clear();
+    jacobianAmount.clear();
+    for (size_t r = 0; r < rateConstant.size(); ++r) {
+        for (std::uint32_t f = factorBegin[r]; f < factorBegin[r + 1]; ++f) {
+            for (std::uint32_t x = changeBegin[r]; x < changeBegin[r + 1]; ++x) {
+                jacobianPosition.push_back(position(rowOf[changeSpecies[x]], rowOf[factorSpecies[f]]));
+                jacobianFactor.push_back(f);
+                jacobianAmount.push_back(changeAmount[x]);
+            }
+        }
+    }
+    analysed = true;
+}
+
+size_t Kinetics::jacobianNonZeros() {
+    if (!analysed) analyse();
+    return jacobianEntries;
+}
+
+size_t Kinetics::factorNonZeros() {
+    if (!analysed) analyse();
+    return column.size();
+}
+
+void Kinetics::jacobian(const double* concentrations, double* values, double* factorDerivatives) const {
+    // d(rate)/d[factor species] for every rate-law factor
+    for (size_t r = 0; r < rateConstant.size(); ++r) {
+        const std::uint32_t begin = factorBegin[r], end = factorBegin[r + 1];
+        for (std::uint32_t f = begin; f < end; ++f) {
+            double derivative = rateConstant[r] * factorOrder[f];
+            for (std::uint32_t g = begin; g < end; ++g) {
+                const double c = concentrations[factorSpecies[g]];
+                const std::int32_t power = g == f ? factorOrder[g] - 1 : factorOrder[g];
+                for (std::int32_t p = 0; p < power; ++p) {
+                    derivative *= c;
+                }
+            }
+            factorDerivatives[f] = derivative;
+        }
+    }
+    std::fill(values, values + column.size(), 0.0);
+    for (size_t e = 0; e < jacobianPosition.size(); ++e) {
+        values[jacobianPosition[e]] += jacobianAmount[e] * factorDerivatives[jacobianFactor[e]];
+    }
+}
+
+bool Kinetics::factor(double* values, double* work) const {
+    // Row-by-row Doolittle elimination; the symbolic fill guarantees every update lands in the pattern
+    const size_t n = species.size();
+    for (size_t i = 0; i < n; ++i) {
+        for (std::uint32_t p = rowBegin[i]; p < rowBegin[i + 1]; ++p) {
+            work[column[p]] = values[p];
+        }
+        for (std::uint32_t p = rowBegin[i]; p < diagonal[i]; ++p) {
+            const std::uint32_t k = column[p];
+            const double multiplier = work[k] / values[diagonal[k]];
+            work[k] = multiplier;
+            for (std::uint32_t q = diagonal[k] + 1; q < rowBegin[k + 1]; ++q) {
+                work[column[q]] -= multiplier * values[q];
+            }
+        }
+        for (std::uint32_t p = rowBegin[i]; p < rowBegin[i + 1]; ++p) {
+            values[p] = work[column[p]];
+            work[column[p]] = 0.0;
+        }
+        const double pivot = values[diagonal[i]];
+        if (pivot == 0.0 || !std::isfinite(pivot)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void Kinetics::solve(const double* values, double* x, double* work) const {
+    const size_t n = species.size();
+    for (size_t row = 0; row < n; ++row) {
+        work[row] = x[speciesOfRow[row]];
+    }
+    for (size_t row = 0; row < n; ++row) {
+        double sum = work[row];
+        for (std::uint32_t p = rowBegin[row]; p < diagonal[row]; ++p) {
+            sum -= values[p] * work[column[p]];
+        }
+        work[row] = sum;
+    }
+    for (size_t row = n; row-- > 0;) {
+        double sum = work[row];
+        for (std::uint32_t p = diagonal[row] + 1; p < rowBegin[row + 1]; ++p) {
+            sum -= values[p] * work[column[p]];
+        }
+        work[row] = sum / values[diagonal[row]];
+    }
+    for (size_t row = 0; row < n; ++row) {
+        x[speciesOfRow[row]] = work[row];
+    }
+}
+
+Kinetics::Result Kinetics::integrate(std::vector<double>& concentrations, units::Seconds start, units::Seconds end,
+                                     const Options& options, const Observer& observer) {
+    if (concentrations.size() != species.size()) {
+        throw std::invalid_argument("Expected " + std::to_string(species.size()) + " concentrations, got " +
+                                    std::to_string(concentrations.size()));
+    }
+    if (!(end >= start) || !std::isfinite(end.value()) || !std::isfinite(start.value())) {
+        throw std::invalid_argument("Integration must run forward between finite times");
+    }
+    if (!(options.relativeTolerance > 0.0) || !(options.absoluteTolerance > 0.0)) {
+        throw std::invalid_argument("Tolerances must be positive");
+    }
+    if (options.method == Method::ROSENBROCK && !analysed) {
+        analyse();
+    }
+
+    const size_t n = species.size();
+    Workspace w;
+    for (auto* v : {&w.k1, &w.k2, &w.k3, &w.rates, &w.stage, &w.next, &w.error, &w.work}) v->assign(n, 0.0);
+    if (options.method == Method::RK45) {
+        for (auto* v : {&w.k4, &w.k5, &w.k6, &w.k7}) v->assign(n, 0.0);
+        return integrateRk45(concentrations, start.value(), end.value(), options, observer, w);
+    }
+    w.jacobian.assign(column.size(), 0.0);
+    w.matrix.assign(column.size(), 0.0);
+    w.factorDerivatives.assign(factorSpecies.size(), 0.0);
+    return integrateRosenbrock(concentrations, start.value(), end.value(), options, observer, w);
+}
+
+namespace {
+
+// Output schedule shared by both integrators: steps are shortened to land on output times
+struct Schedule {
+    double start, end, interval;
+    size_t index = 1;
+    double next;
+
+    Schedule(double s, double e, double i) : start(s), end(e), interval(i) {
+        next = interval > 0.0 ? std::min(start + interval, end) : end;
+    }
+    void advance() {
+        if (interval > 0.0) next = std::min(start + static_cast<double>(++index) * interval, end);
+    }
+};
+
+double initialStep(const std::vector<double>& y, const std::vector<double>& rates, double span,
+                   const Kinetics::Options& options) {
+    if (options.initialStep.value() > 0.0) {
+        return std::min(options.initialStep.value(), span);
+    }
+    // Hairer's estimate: 1% of the time for the fastest-changing species to change by its own scale
+    double y0 = 0.0, f0 = 0.0;
+    for (size_t i = 0; i < y.size(); ++i) {
+        double scale = options.absoluteTolerance + options.relativeTolerance * std::fabs(y[i]);
+        y0 += (y[i] / scale) * (y[i] / scale);
+        f0 += (rates[i] / scale) * (rates[i] / scale);
+    }
+    double h = y0 < 1e-10 || f0 < 1e-10 ? 1e-6 : 0.01 * std::sqrt(y0 / f0);
+    return std::min(h, span);
+}
+
+} // namespace
+
+Kinetics::Result Kinetics::integrateRosenbrock(std::vector<double>& y, double start, double end,
+                                               const Options& options, const Observer& observer,
+                                               Workspace& w) const {
+    const size_t n = y.size();
+    Result result;
+    double t = start;
+    if (observer) observer(units::Seconds(t), y.data());
+    if (n == 0 || end == start) {
+        result.time = units::Seconds(end);
+        return result;
+    }
+
+    Schedule schedule(start, end, options.outputInterval.value());
+    derivatives(y.data(), w.k1.data());
+    result.functionEvaluations++;
+    double h = initialStep(y, w.k1, end - start, options);
+    bool rejectedLast = false;
+
+    while (t < end) {
+        if (result.steps >= options.maxSteps) {
+            result.status = Status::MAX_STEPS;
+            break;
+        }
+        // f(y) and J(y) serve every attempt at this step
+        derivatives(y.data(), w.rates.data());
+        jacobian(y.data(), w.jacobian.data(), w.factorDerivatives.data());
+        result.functionEvaluations++;
+        result.jacobianEvaluations++;
+
+        while (true) {
+            const bool hitsOutput = h >= schedule.next - t;
+            const double step = hitsOutput ? schedule.next - t : h;
+            if (step <= 1e-15 * std::max(std::fabs(t), end - start)) {
+                result.status = Status::STEP_TOO_SMALL;
+                result.time = units::Seconds(t);
+                return result;
+            }
+
+            // (I / (h * gamma) - J) K_i = F_i + sum_j c_ij / h * K_j
+            const double diagonalShift = 1.0 / (step * ROS_GAMMA);
+            for (size_t p = 0; p < w.matrix.size(); ++p) w.matrix[p] = -w.jacobian[p];
+            for (size_t row = 0; row < n; ++row) w.matrix[diagonal[row]] += diagonalShift;
+            result.factorizations++;
+            if (!factor(w.matrix.data(), w.work.data())) {
+                std::fill(w.work.begin(), w.work.end(), 0.0);
+                h = 0.5 * step;
+                result.rejectedSteps++;
+                rejectedLast = true;
+                continue;
+            }
+
+            std::copy(w.rates.begin(), w.rates.end(), w.k1.begin());
+            solve(w.matrix.data(), w.k1.data(), w.work.data());
+
+            for (size_t i = 0; i < n; ++i) w.stage[i] = y[i] + ROS_A21 * w.k1[i];
+            derivatives(w.stage.data(), w.k2.data());
+            result.functionEvaluations++;
+            // Stage 3 reuses the stage-2 function value
+            for (size_t i = 0; i < n; ++i) {
+                w.k3[i] = w.k2[i] + (ROS_C31 * w.k1[i]) / step;
+                w.k2[i] += (ROS_C21 * w.k1[i]) / step;
+            }
+            solve(w.matrix.data(), w.k2.data(), w.work.data());
+            for (size_t i = 0; i < n; ++i) w.k3[i] += (ROS_C32 * w.k2[i]) / step;
+            solve(w.matrix.data(), w.k3.data(), w.work.data());
+
+            for (size_t i = 0; i < n; ++i) {
+                w.next[i] = y[i] + ROS_M1 * w.k1[i] + ROS_M2 * w.k2[i] + ROS_M3 * w.k3[i];
+                w.stage[i] = ROS_E1 * w.k1[i] + ROS_E2 * w.k2[i] + ROS_E3 * w.k3[i];
+            }
+            const double error = errorNorm(y.data(), w.next.data(), w.stage.data(), n, options);
+            double factor = std::isfinite(error)
+                                ? std::clamp(SAFETY * std::pow(std::max(error, 1e-10), -1.0 / 3.0), MIN_FACTOR,
+                                             MAX_FACTOR)
+                                : MIN_FACTOR;
+
+            if (error <= 1.0) {
+                y.swap(w.next);
+                t = hitsOutput ? schedule.next : t + step;
+                result.steps++;
+                if (observer && (hitsOutput || schedule.interval <= 0.0)) observer(units::Seconds(t), y.data());
+                if (hitsOutput) schedule.advance();
+                // A step cut short for an output keeps the controller's proposal
+                const double proposal = step * (rejectedLast ? std::min(factor, 1.0) : factor);
+                h = hitsOutput ? std::max(h, proposal) : proposal;
+                rejectedLast = false;
+                break;
+            }
+            h = step * std::min(factor, 1.0);
+            result.rejectedSteps++;
+            rejectedLast = true;
+        }
+    }
+    result.time = units::Seconds(t);
+    return result;
+}
+
+Kinetics::Result Kinetics::integrateRk45(std::vector<double>& y, double start, double end, const Options& options,
+                                         const Observer& observer, Workspace& w) const {
+    const size_t n = y.size();
+    Result result;
+    double t = start;
+    if (observer) observer(units::Seconds(t), y.data());
+    if (n == 0 || end == start) {
+        result.time = units::Seconds(end);
+        return result;
+    }
+
+    Schedule schedule(start, end, options.outputInterval.value());
+    derivatives(y.data(), w.k1.data());
+    result.functionEvaluations++;
+    double h = initialStep(y, w.k1, end - start, options);
+    bool rejectedLast = false;
+
+    while (t < end) {
+        if (result.steps >= options.maxSteps) {
+            result.status = Status::MAX_STEPS;
+            break;
+        }
+        const bool hitsOutput = h >= schedule.next - t;
+        const double step = hitsOutput ? schedule.next - t : h;
+        if (step <= 1e-15 * std::max(std::fabs(t), end - start)) {
+            result.status = Status::STEP_TOO_SMALL;
+            break;
+        }
+
+        double* s = w.stage.data();
+        for (size_t i = 0; i < n; ++i) s[i] = y[i] + step * DP_A21 * w.k1[i];
+        derivatives(s, w.k2.data());
+        for (size_t i = 0; i < n; ++i) s[i] = y[i] + step * (DP_A31 * w.k1[i] + DP_A32 * w.k2[i]);
+        derivatives(s, w.k3.data());
+        for (size_t i = 0; i < n; ++i) {
+            s[i] = y[i] + step * (DP_A41 * w.k1[i] + DP_A42 * w.k2[i] + DP_A43 * w.k3[i]);
+        }
+        derivatives(s, w.k4.data());
+        for (size_t i = 0; i < n; ++i) {
+            s[i] = y[i] + step * (DP_A51 * w.k1[i] + DP_A52 * w.k2[i] + DP_A53 * w.k3[i] + DP_A54 * w.k4[i]);
+        }
+        derivatives(s, w.k5.data());
+        for (size_t i = 0; i < n; ++i) {
+            s[i] = y[i] + step * (DP_A61 * w.k1[i] + DP_A62 * w.k2[i] + DP_A63 * w.k3[i] + DP_A64 * w.k4[i] +
+                                  DP_A65 * w.k5[i]);
+        }
+        derivatives(s, w.k6.data());
+        for (size_t i = 0; i < n; ++i) {
+            w.next[i] = y[i] + step * (DP_B1 * w.k1[i] + DP_B3 * w.k3[i] + DP_B4 * w.k4[i] + DP_B5 * w.k5[i] +
+                                       DP_B6 * w.k6[i]);
+        }
+        derivatives(w.next.data(), w.k7.data()); // First stage of the next step (FSAL)
+        result.functionEvaluations += 6;
+        for (size_t i = 0; i < n; ++i) {
+            w.error[i] = step * (DP_E1 * w.k1[i] + DP_E3 * w.k3[i] + DP_E4 * w.k4[i] + DP_E5 * w.k5[i] +
+                                 DP_E6 * w.k6[i] + DP_E7 * w.k7[i]);
+        }
+        const double error = errorNorm(y.data(), w.next.data(), w.error.data(), n, options);
+        double factor = std::isfinite(error)
+                            ? std::clamp(SAFETY * std::pow(std::max(error, 1e-10), -0.2), MIN_FACTOR, MAX_FACTOR)
+                            : MIN_FACTOR;
+
+        if (error <= 1.0) {
+            y.swap(w.next);
+            w.k1.swap(w.k7);
+            t = hitsOutput ? schedule.next : t + step;
+            result.steps++;
+            if (observer && (hitsOutput || schedule.interval <= 0.0)) observer(units::Seconds(t), y.data());
+            if (hitsOutput) schedule.advance();
+            const double proposal = step * (rejectedLast ? std::min(factor, 1.0) : factor);
+            h = hitsOutput ? std::max(h, proposal) : proposal;
+            rejectedLast = false;
+        } else {
+            h = step * std::min(factor, 1.0);
+            result.rejectedSteps++;
+            rejectedLast = true;
+        }
+    }
+    result.time = units::Seconds(t);
+    return result;
+}
@@ -0,0 +1,136 @@
+#ifndef KINETICS_H
+#define KINETICS_H
+
+#include "ChemistryEngine.h"
+#include "Quantity.h"
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief Kinetics - Concentration-time simulation of elementary reaction mechanisms
+ * Each equation is an elementary step that obeys the law of mass action:
+ * rate = k * product of [reactant]^coefficient. A reversible step also gets a
+ * reverse rate constant. Species are identified by their formula text, and
+ * concentrations are in mol/L.
+ *
+ * Two adaptive integrators are available:
+ * - Dormand-Prince RK45: explicit. Use it for non-stiff mechanisms.
+ * - ROS3: a three-stage, order-3 Rosenbrock method for stiff mechanisms.
+ *   Each step solves linear systems with the matrix I/(h*gamma) - J.
+ *
+ * The Jacobian is kept sparse. When a step is first needed, the species are
+ * put in minimum-degree order and the fill-in of the LU factors is found once.
+ * After that, each Jacobian evaluation is a flat list of scatter-adds. Each
+ * factorization is a row-by-row elimination with no pivoting, restricted to
+ * that fixed pattern.
+ *
+ * Results are streamed to an observer at the requested times, so the
+ * trajectory is never stored.
+ */
+class Kinetics {
+public:
+    enum class Method { RK45, ROSENBROCK };
+
+    enum class Status {
+        COMPLETED,      // Reached the end time
+        MAX_STEPS,      // Gave up after Options::maxSteps accepted steps
+        STEP_TOO_SMALL  // The error test could not be met with a representable step
+    };
+
+    struct Options {
+        Method method = Method::ROSENBROCK;
+        double relativeTolerance = 1e-6;
+        double absoluteTolerance = 1e-12;   // mol/L
+        units::Seconds initialStep{0.0};    // 0: estimated from the initial rates
+        units::Seconds outputInterval{0.0}; // 0: report every accepted step
+        size_t maxSteps = 1000000;
+    };
+
+    struct Result {
+        Status status = Status::COMPLETED;
+        units::Seconds time{0.0}; // Time the concentrations belong to
+        size_t steps = 0;         // Accepted
+        size_t rejectedSteps = 0;
+        size_t functionEvaluations = 0;
+        size_t jacobianEvaluations = 0;
+        size_t factorizations = 0;
+
+        bool ok() const { return status == Status::COMPLETED; }
+    };
+
+    // Called at the start time, at every output time and at the end time
+    using Observer = std::function<void(units::Seconds time, const double* concentrations)>;
+
+    // Adds the step and its species; rate constants in (mol/L)^(1 - order) / s.
+    // Throws std::invalid_argument for negative rate constants or non-positive coefficients.
+    void addReaction(const ChemistryEngine::ChemicalEquation& equation, double forwardRate, double reverseRate = 0.0);
+    void addReaction(std::string_view equation, double forwardRate, double reverseRate = 0.0);
+
+    // Index of the species in concentration vectors, adding it if new
+    size_t addSpecies(const std::string& formula);
+    // SIZE_MAX if the species does not take part in any reaction
+    size_t speciesIndex(const std::string& formula) const;
+    const std::string& speciesName(size_t index) const { return species[index]; }
+    size_t speciesCount() const { return species.size(); }
+    size_t reactionCount() const { return rateConstant.size(); } // Directions: a reversible step counts twice
+
+    // d[concentration]/dt for concentrations[speciesCount()]
+    void derivatives(const double* concentrations, double* rates) const;
+
+    // Advances concentrations (one per species) from start to end.
+    // Throws std::invalid_argument for a wrong vector size, end < start or non-positive tolerances.
+    Result integrate(std::vector<double>& concentrations, units::Seconds start, units::Seconds end,
+                     const Options& options, const Observer& observer = Observer());
+    Result integrate(std::vector<double>& concentrations, units::Seconds start, units::Seconds end) {
+        return integrate(concentrations, start, end, Options());
+    }
+
+    // Sparsity of the Jacobian and of its LU factors (including fill-in)
+    size_t jacobianNonZeros();
+    size_t factorNonZeros();
+
+private:
+    std::vector<std::string> species;
+    std::unordered_map<std::string, size_t> speciesLookup;
+
+    // Directional reactions; factors are the rate-law terms, changes the net stoichiometry
+    std::vector<double> rateConstant;
+    std::vector<std::uint32_t> factorBegin{0};
+    std::vector<std::uint32_t> factorSpecies;
+    std::vector<std::int32_t> factorOrder;
+    std::vector<std::uint32_t> changeBegin{0};
+    std::vector<std::uint32_t> changeSpecies;
+    std::vector<double> changeAmount;
+
+    // Sparse structure, built on first use after the mechanism changes
+    bool analysed = false;
+    std::vector<std::uint32_t> rowOf;   // Species -> row of the reordered matrix
+    std::vector<std::uint32_t> speciesOfRow;
+    std::vector<std::uint32_t> rowBegin; // CSR of the filled pattern, columns ascending
+    std::vector<std::uint32_t> column;
+    std::vector<std::uint32_t> diagonal; // Position of (row, row)
+    std::vector<std::uint32_t> jacobianPosition; // Per contribution: pattern position, factor, amount
+    std::vector<std::uint32_t> jacobianFactor;
+    std::vector<double> jacobianAmount;
+    size_t jacobianEntries = 0;
+
+    struct Workspace;
+
+    void addDirection(const std::vector<ChemistryEngine::EquationComponent>& from,
+                      const std::vector<ChemistryEngine::EquationComponent>& to, double rate);
+    void analyse();
+    void jacobian(const double* concentrations, double* values, double* factorDerivatives) const;
+    bool factor(double* values, double* work) const;
+    void solve(const double* values, double* x, double* work) const;
+
+    Result integrateRk45(std::vector<double>& y, double start, double end, const Options& options,
+                         const Observer& observer, Workspace& w) const;
+    Result integrateRosenbrock(std::vector<double>& y, double start, double end, const Options& options,
+                               const Observer& observer, Workspace& w) const;
+};
+
+#endif // KINETICS_H
@@ -0,0 +1,97 @@
+#include "MappedFile.h"
+#include <stdexcept>
+#include <utility>
+
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string& path) {
+#if defined(_WIN32)
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+                              FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        throw std::invalid_argument("Cannot open " + path);
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize)) {
+        CloseHandle(file);
+        throw std::invalid_argument("Cannot read the size of " + path);
+    }
+    length = static_cast<size_t>(fileSize.QuadPart);
+    if (length != 0) {
+        mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (mapping != nullptr) {
+            bytes = static_cast<const char*>(MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0));
+        }
+        if (bytes == nullptr) {
+            if (mapping != nullptr) CloseHandle(mapping);
+            mapping = nullptr;
+            CloseHandle(file);
+            throw std::invalid_argument("Cannot map " + path);
+        }
+    }
+    // The mapping keeps its own reference to the file
+    CloseHandle(file);
+#else
+    int descriptor = ::open(path.c_str(), O_RDONLY);
+    if (descriptor < 0) {
+        throw std::invalid_argument("Cannot open " + path);
+    }
+    struct stat status;
+    if (::fstat(descriptor, &status) != 0) {
+        ::close(descriptor);
+        throw std::invalid_argument("Cannot read the size of " + path);
+    }
+    length = static_cast<size_t>(status.st_size);
+    if (length != 0) {
+        void* address = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, descriptor, 0);
+        if (address == MAP_FAILED) {
+            ::close(descriptor);
+            throw std::invalid_argument("Cannot map " + path);
+        }
+        bytes = static_cast<const char*>(address);
+    }
+    // The mapping stays valid after the descriptor is closed
+    ::close(descriptor);
+#endif
+}
+
+MappedFile::~MappedFile() {
+    release();
+}
+
+MappedFile::MappedFile(MappedFile&& other) noexcept {
+    *this = std::move(other);
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        release();
+        bytes = std::exchange(other.bytes, nullptr);
+        length = std::exchange(other.length, 0);
+#if defined(_WIN32)
+        mapping = std::exchange(other.mapping, nullptr);
+#endif
+    }
+    return *this;
+}
+
+void MappedFile::release() {
+#if defined(_WIN32)
+    if (bytes != nullptr) UnmapViewOfFile(bytes);
+    if (mapping != nullptr) CloseHandle(mapping);
+    mapping = nullptr;
+#else
+    if (bytes != nullptr) ::munmap(const_cast<char*>(bytes), length);
+#endif
+    bytes = nullptr;
+    length = 0;
+}
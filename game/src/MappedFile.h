@@ -0,0 +1,39 @@
+#ifndef MAPPEDFILE_H
+#define MAPPEDFILE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * @brief MappedFile - Read-only memory mapping of a whole file
+ * The operating system pages the file in on demand and shares the pages
+ * between processes, so opening a large data file costs almost nothing until
+ * it is read. POSIX mmap on Linux and macOS, MapViewOfFile on Windows.
+ * Move-only; the mapping is released by the destructor.
+ */
+class MappedFile {
+public:
+    MappedFile() = default;
+    // Throws std::invalid_argument if the file cannot be opened or mapped
+    explicit MappedFile(const std::string& path);
+    ~MappedFile();
+
+    MappedFile(MappedFile&& other) noexcept;
+    MappedFile& operator=(MappedFile&& other) noexcept;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    const char* data() const { return bytes; }
+    size_t size() const { return length; }
+
+private:
+    const char* bytes = nullptr;
+    size_t length = 0;
+#if defined(_WIN32)
+    void* mapping = nullptr; // HANDLE of the file mapping object
+#endif
+
+    void release();
+};
+
+#endif // MAPPEDFILE_H
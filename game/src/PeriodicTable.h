@@ -0,0 +1,165 @@
+#ifndef PERIODICTABLE_H
+#define PERIODICTABLE_H
+
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+/**
+ * @brief PeriodicTable - Compile-time table of all 118 elements
+ * Symbol -> atomic number lookup goes through a perfect hash built at compile time:
+ * every valid symbol (one uppercase letter plus an optional lowercase letter) maps
+ * to its own slot in a 26 x 27 table, so a lookup is two subtractions and one load.
+ */
+class PeriodicTable {
+public:
+    static constexpr int ELEMENT_COUNT = 118;
+
+    struct ElementInfo {
+        const char* symbol;
+        double atomicMass; // Standard atomic weight (mass number of the most stable isotope for radioactive elements)
+    };
+
+    // Indexed by atomic number; slot 0 is a placeholder so that ELEMENTS[Z] is element Z
+    static constexpr ElementInfo ELEMENTS[ELEMENT_COUNT + 1] = {
+        {"",   0.0},
+        {"H",  1.008},   {"He", 4.0026},  {"Li", 6.94},    {"Be", 9.0122},  {"B",  10.81},
+        {"C",  12.011},  {"N",  14.007},  {"O",  15.999},  {"F",  18.998},  {"Ne", 20.180},
+        {"Na", 22.990},  {"Mg", 24.305},  {"Al", 26.982},  {"Si", 28.085},  {"P",  30.974},
+        {"S",  32.06},   {"Cl", 35.45},   {"Ar", 39.948},  {"K",  39.098},  {"Ca", 40.078},
+        {"Sc", 44.956},  {"Ti", 47.867},  {"V",  50.942},  {"Cr", 51.996},  {"Mn", 54.938},
+        {"Fe", 55.845},  {"Co", 58.933},  {"Ni", 58.693},  {"Cu", 63.546},  {"Zn", 65.38},
+        {"Ga", 69.723},  {"Ge", 72.630},  {"As", 74.922},  {"Se", 78.971},  {"Br", 79.904},
+        {"Kr", 83.798},  {"Rb", 85.468},  {"Sr", 87.62},   {"Y",  88.906},  {"Zr", 91.224},
+        {"Nb", 92.906},  {"Mo", 95.95},   {"Tc", 98.0},    {"Ru", 101.07},  {"Rh", 102.91},
+        {"Pd", 106.42},  {"Ag", 107.87},  {"Cd", 112.41},  {"In", 114.82},  {"Sn", 118.71},
+        {"Sb", 121.76},  {"Te", 127.60},  {"I",  126.90},  {"Xe", 131.29},  {"Cs", 132.91},
+        {"Ba", 137.33},  {"La", 138.91},  {"Ce", 140.12},  {"Pr", 140.91},  {"Nd", 144.24},
+        {"Pm", 145.0},   {"Sm", 150.36},  {"Eu", 151.96},  {"Gd", 157.25},  {"Tb", 158.93},
+        {"Dy", 162.50},  {"Ho", 164.93},  {"Er", 167.26},  {"Tm", 168.93},  {"Yb", 173.05},
+        {"Lu", 174.97},  {"Hf", 178.49},  {"Ta", 180.95},  {"W",  183.84},  {"Re", 186.21},
+        {"Os", 190.23},  {"Ir", 192.22},  {"Pt", 195.08},  {"Au", 196.97},  {"Hg", 200.59},
+        {"Tl", 204.38},  {"Pb", 207.2},   {"Bi", 208.98},  {"Po", 209.0},   {"At", 210.0},
+        {"Rn", 222.0},   {"Fr", 223.0},   {"Ra", 226.0},   {"Ac", 227.0},   {"Th", 232.04},
+        {"Pa", 231.04},  {"U",  238.03},  {"Np", 237.0},   {"Pu", 244.0},   {"Am", 243.0},
+        {"Cm", 247.0},   {"Bk", 247.0},   {"Cf", 251.0},   {"Es", 252.0},   {"Fm", 257.0},
+        {"Md", 258.0},   {"No", 259.0},   {"Lr", 266.0},   {"Rf", 267.0},   {"Db", 268.0},
+        {"Sg", 269.0},   {"Bh", 270.0},   {"Hs", 269.0},   {"Mt", 278.0},   {"Ds", 281.0},
+        {"Rg", 282.0},   {"Cn", 285.0},   {"Nh", 286.0},   {"Fl", 289.0},   {"Mc", 290.0},
+        {"Lv", 293.0},   {"Ts", 294.0},   {"Og", 294.0}
+    };
+
+    // Perfect hash of a symbol: first letter selects a row, second letter (or none) a column
+    static constexpr int HASH_SIZE = 26 * 27;
+
+    static constexpr int hashSymbol(char first, char second) {
+        return (first - 'A') * 27 + (second == '\0' ? 0 : second - 'a' + 1);
+    }
+
+    // Atomic number for a symbol, 0 if the symbol is not an element
+    static constexpr int atomicNumber(std::string_view symbol) {
+        if (symbol.empty() || symbol.size() > 2) return 0;
+        return atomicNumber(symbol[0], symbol.size() == 2 ? symbol[1] : '\0');
+    }
+
+    static constexpr int atomicNumber(char first, char second) {
+        unsigned row = static_cast<unsigned>(first - 'A');
+        unsigned col = second == '\0' ? 0u : static_cast<unsigned>(second - 'a') + 1u;
+        if (row >= 26u || col >= 27u) return 0;
+        return SYMBOL_HASH[row * 27u + col];
+    }
+
+    static constexpr double atomicMass(int atomicNumber) {
+        return (atomicNumber > 0 && atomicNumber <= ELEMENT_COUNT) ? ELEMENTS[atomicNumber].atomicMass : 0.0;
+    }
+
+    static constexpr const char* symbol(int atomicNumber) {
+        return (atomicNumber > 0 && atomicNumber <= ELEMENT_COUNT) ? ELEMENTS[atomicNumber].symbol : "";
+    }
+
+    // True when every element symbol owns its hash slot (checked by a static_assert below)
+    static constexpr bool symbolHashIsPerfect() {
+        for (int z = 1; z <= ELEMENT_COUNT; ++z) {
+            const char* s = ELEMENTS[z].symbol;
+            if (SYMBOL_HASH[hashSymbol(s[0], s[1])] != z) return false;
+        }
+        return true;
+    }
+
+    /**
+     * Molar mass of a plain formula such as "H2O" or "(NH4)2SO4".
+     * Usable in constant expressions, so literal formulas fold at compile time:
+     *     constexpr double water = PeriodicTable::formulaMass("H2O");
+     * Throws std::invalid_argument on an unknown symbol or malformed input
+     * (which is a compile error when evaluated in a constant expression).
+     */
+    static constexpr double formulaMass(std::string_view formula) {
+        constexpr int MAX_DEPTH = 16;
+        double groupMass[MAX_DEPTH + 1] = {};
+        int depth = 0;
+        size_t pos = 0;
+
+        while (pos < formula.size()) {
+            char c = formula[pos];
+            if (c == ' ' || c == '\t') {
+                pos++;
+            } else if (c == '(') {
+                if (depth == MAX_DEPTH) throw std::invalid_argument("Formula nesting is too deep");
+                groupMass[++depth] = 0.0;
+                pos++;
+            } else if (c == ')') {
+                if (depth == 0) throw std::invalid_argument("Unbalanced ')' in formula");
+                pos++;
+                double group = groupMass[depth--];
+                groupMass[depth] += group * readCount(formula, pos);
+            } else if (c >= 'A' && c <= 'Z') {
+                char second = '\0';
+                if (pos + 1 < formula.size() && formula[pos + 1] >= 'a' && formula[pos + 1] <= 'z') {
+                    second = formula[pos + 1];
+                }
+                int z = atomicNumber(c, second);
+                if (z == 0) throw std::invalid_argument("Unknown element symbol in formula");
+                pos += second == '\0' ? 1 : 2;
+                groupMass[depth] += ELEMENTS[z].atomicMass * readCount(formula, pos);
+            } else {
+                throw std::invalid_argument("Unexpected character in formula");
+            }
+        }
+
+        if (depth != 0) throw std::invalid_argument("Unbalanced '(' in formula");
+        return groupMass[0];
+    }
+
+private:
+    // Reads an optional count after a symbol or ')'; a missing count means 1
+    static constexpr int readCount(std::string_view formula, size_t& pos) {
+        int count = 0;
+        bool any = false;
+        while (pos < formula.size() && formula[pos] >= '0' && formula[pos] <= '9') {
+            count = count * 10 + (formula[pos] - '0');
+            any = true;
+            pos++;
+        }
+        return any ? count : 1;
+    }
+
+    static constexpr std::array<std::uint8_t, HASH_SIZE> buildSymbolHash() {
+        std::array<std::uint8_t, HASH_SIZE> table = {};
+        for (int z = 1; z <= ELEMENT_COUNT; ++z) {
+            const char* s = ELEMENTS[z].symbol;
+            table[hashSymbol(s[0], s[1])] = static_cast<std::uint8_t>(z);
+        }
+        return table;
+    }
+
+    // Defined after the class: the builder can only run once PeriodicTable is complete
+    static const std::array<std::uint8_t, HASH_SIZE> SYMBOL_HASH;
+};
+
+inline constexpr std::array<std::uint8_t, PeriodicTable::HASH_SIZE> PeriodicTable::SYMBOL_HASH =
+    PeriodicTable::buildSymbolHash();
+
+static_assert(PeriodicTable::symbolHashIsPerfect(), "Element symbol hash has a collision");
+
+#endif // PERIODICTABLE_H
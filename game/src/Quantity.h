@@ -0,0 +1,283 @@
+#ifndef QUANTITY_H
+#define QUANTITY_H
+
+#include <ratio>
+#include <type_traits>
+
+/**
+ * @brief Quantity - Compile-time dimensional analysis for chemistry quantities
+ * A Quantity is a single double tagged at compile time with its dimension (the
+ * exponents of mass, length, time, amount of substance and temperature) and its
+ * unit (a std::ratio scale relative to the SI unit: kg, m, s, mol, K). Mixing up
+ * moles and grams, or litres and mol/L, does not compile. Values of the same
+ * dimension convert implicitly between units, as std::chrono durations do. The
+ * scale factor is a compile-time constant, so 250_mL + 1_L is one multiply and
+ * one add, exactly like the hand-written double code. The types add no storage
+ * and no run time; bench/QuantityBench.cpp checks this.
+ * Products and quotients get their dimension by adding or subtracting exponents.
+ * If the result is dimensionless (grams / grams), it is a plain double with the
+ * unit ratio already applied.
+ */
+namespace units {
+
+template <int Mass, int Length, int Time, int Amount, int Temperature>
+struct Dimension {
+    static constexpr int mass = Mass;
+    static constexpr int length = Length;
+    static constexpr int time = Time;
+    static constexpr int amount = Amount;
+    static constexpr int temperature = Temperature;
+};
+
+template <typename A, typename B>
+using DimensionProduct = Dimension<A::mass + B::mass, A::length + B::length, A::time + B::time,
+                                   A::amount + B::amount, A::temperature + B::temperature>;
+
+template <typename A, typename B>
+using DimensionQuotient = Dimension<A::mass - B::mass, A::length - B::length, A::time - B::time,
+                                    A::amount - B::amount, A::temperature - B::temperature>;
+
+using Dimensionless = Dimension<0, 0, 0, 0, 0>;
+using MassDimension = Dimension<1, 0, 0, 0, 0>;
+using VolumeDimension = Dimension<0, 3, 0, 0, 0>;
+using TimeDimension = Dimension<0, 0, 1, 0, 0>;
+using AmountDimension = Dimension<0, 0, 0, 1, 0>;
+using TemperatureDimension = Dimension<0, 0, 0, 0, 1>;
+using ConcentrationDimension = Dimension<0, -3, 0, 1, 0>;
+using MolarMassDimension = Dimension<1, 0, 0, -1, 0>;
+using PressureDimension = Dimension<1, -1, -2, 0, 0>;
+using EnergyDimension = Dimension<1, 2, -2, 0, 0>;
+
+// A std::ratio as a double, computed by the compiler
+template <typename Ratio>
+constexpr double RATIO_VALUE = static_cast<double>(Ratio::num) / static_cast<double>(Ratio::den);
+
+template <typename D, typename Scale = std::ratio<1>>
+class Quantity {
+public:
+    using dimension = D;
+    using scale = typename Scale::type;
+
+    constexpr Quantity() = default;
+    constexpr explicit Quantity(double value) : amount(value) {}
+
+    // Same dimension, other unit: multiplied by a compile-time constant
+    template <typename OtherScale>
+    constexpr Quantity(Quantity<D, OtherScale> other)
+        : amount(convert<OtherScale>(other.value())) {}
+
+    // The number in this quantity's own unit
+    constexpr double value() const { return amount; }
+
+    constexpr Quantity operator-() const { return Quantity(-amount); }
+    constexpr Quantity& operator+=(Quantity other) {
+        amount += other.amount;
+        return *this;
+    }
+    constexpr Quantity& operator-=(Quantity other) {
+        amount -= other.amount;
+        return *this;
+    }
+    constexpr Quantity& operator*=(double factor) {
+        amount *= factor;
+        return *this;
+    }
+    constexpr Quantity& operator/=(double divisor) {
+        amount /= divisor;
+        return *this;
+    }
+
+private:
+    double amount = 0.0;
+
+    template <typename OtherScale>
+    static constexpr double convert(double value) {
+        using Factor = std::ratio_divide<OtherScale, Scale>;
+        if constexpr (Factor::num == Factor::den) {
+            return value;
+        } else {
+            return value * RATIO_VALUE<Factor>;
+        }
+    }
+};
+
+// Dimensionless results collapse to double with the scale applied
+template <typename D, typename Scale>
+constexpr auto makeQuantity(double value) {
+    using Reduced = typename Scale::type;
+    if constexpr (std::is_same_v<D, Dimensionless>) {
+        if constexpr (Reduced::num == Reduced::den) {
+            return value;
+        } else {
+            return value * RATIO_VALUE<Reduced>;
+        }
+    } else {
+        return Quantity<D, Reduced>(value);
+    }
+}
+
+// Sums, differences and comparisons use the left operand's unit
+
+template <typename D, typename S1, typename S2>
+constexpr Quantity<D, S1> operator+(Quantity<D, S1> a, Quantity<D, S2> b) {
+    return Quantity<D, S1>(a.value() + Quantity<D, S1>(b).value());
+}
+
+template <typename D, typename S1, typename S2>
+constexpr Quantity<D, S1> operator-(Quantity<D, S1> a, Quantity<D, S2> b) {
+    return Quantity<D, S1>(a.value() - Quantity<D, S1>(b).value());
+}
+
+template <typename D, typename S1, typename S2>
+constexpr bool operator==(Quantity<D, S1> a, Quantity<D, S2> b) {
+    return a.value() == Quantity<D, S1>(b).value();
+}
+
+template <typename D, typename S1, typename S2>
+constexpr bool operator!=(Quantity<D, S1> a, Quantity<D, S2> b) {
+    return !(a == b);
+}
+
+template <typename D, typename S1, typename S2>
+constexpr bool operator<(Quantity<D, S1> a, Quantity<D, S2> b) {
+    return a.value() < Quantity<D, S1>(b).value();
+}
+
+template <typename D, typename S1, typename S2>
+constexpr bool operator>(Quantity<D, S1> a, Quantity<D, S2> b) {
+    return Quantity<D, S1>(b) < a;
+}
+
+template <typename D, typename S1, typename S2>
+constexpr bool operator<=(Quantity<D, S1> a, Quantity<D, S2> b) {
+    return !(a > b);
+}
+
+template <typename D, typename S1, typename S2>
+constexpr bool operator>=(Quantity<D, S1> a, Quantity<D, S2> b) {
+    return !(a < b);
+}
+
+template <typename D, typename S>
+constexpr Quantity<D, S> operator*(Quantity<D, S> q, double factor) {
+    return Quantity<D, S>(q.value() * factor);
+}
+
+template <typename D, typename S>
+constexpr Quantity<D, S> operator*(double factor, Quantity<D, S> q) {
+    return Quantity<D, S>(factor * q.value());
+}
+
+template <typename D, typename S>
+constexpr Quantity<D, S> operator/(Quantity<D, S> q, double divisor) {
+    return Quantity<D, S>(q.value() / divisor);
+}
+
+template <typename D, typename S>
+constexpr auto operator/(double numerator, Quantity<D, S> q) {
+    return makeQuantity<DimensionQuotient<Dimensionless, D>, std::ratio_divide<std::ratio<1>, S>>(numerator / q.value());
+}
+
+template <typename D1, typename S1, typename D2, typename S2>
+constexpr auto operator*(Quantity<D1, S1> a, Quantity<D2, S2> b) {
+    return makeQuantity<DimensionProduct<D1, D2>, std::ratio_multiply<S1, S2>>(a.value() * b.value());
+}
+
+template <typename D1, typename S1, typename D2, typename S2>
+constexpr auto operator/(Quantity<D1, S1> a, Quantity<D2, S2> b) {
+    return makeQuantity<DimensionQuotient<D1, D2>, std::ratio_divide<S1, S2>>(a.value() / b.value());
+}
+
+// Units used by the game (scale relative to kg, m, s, mol, K)
+using Kilograms = Quantity<MassDimension>;
+using Grams = Quantity<MassDimension, std::milli>;
+using Milligrams = Quantity<MassDimension, std::micro>;
+using Moles = Quantity<AmountDimension>;
+using Millimoles = Quantity<AmountDimension, std::milli>;
+using CubicMetres = Quantity<VolumeDimension>;
+using Litres = Quantity<VolumeDimension, std::milli>;
+using Millilitres = Quantity<VolumeDimension, std::micro>;
+using Molarity = Quantity<ConcentrationDimension, std::kilo>; // mol/L
+using Millimolar = Quantity<ConcentrationDimension>;         // mmol/L = mol/m^3
+using GramsPerMole = Quantity<MolarMassDimension, std::milli>;
+using Seconds = Quantity<TimeDimension>;
+using Minutes = Quantity<TimeDimension, std::ratio<60>>;
+using Hours = Quantity<TimeDimension, std::ratio<3600>>;
+using Kelvin = Quantity<TemperatureDimension>;
+using Pascals = Quantity<PressureDimension>;
+using Kilopascals = Quantity<PressureDimension, std::kilo>;
+using Atmospheres = Quantity<PressureDimension, std::ratio<101325>>;
+using Joules = Quantity<EnergyDimension>;
+using Kilojoules = Quantity<EnergyDimension, std::kilo>;
+
+// Molar gas constant, J/(mol K)
+constexpr Quantity<DimensionQuotient<EnergyDimension, DimensionProduct<AmountDimension, TemperatureDimension>>>
+    GAS_CONSTANT(8.314462618);
+
+static_assert(sizeof(Moles) == sizeof(double) && std::is_trivially_copyable_v<Moles>,
+              "A quantity must be exactly one double");
+
+namespace literals {
+
+constexpr Kilograms operator""_kg(long double value) { return Kilograms(static_cast<double>(value)); }
+constexpr Kilograms operator""_kg(unsigned long long value) { return Kilograms(static_cast<double>(value)); }
+
+constexpr Grams operator""_g(long double value) { return Grams(static_cast<double>(value)); }
+constexpr Grams operator""_g(unsigned long long value) { return Grams(static_cast<double>(value)); }
+
+constexpr Milligrams operator""_mg(long double value) { return Milligrams(static_cast<double>(value)); }
+constexpr Milligrams operator""_mg(unsigned long long value) { return Milligrams(static_cast<double>(value)); }
+
+constexpr Moles operator""_mol(long double value) { return Moles(static_cast<double>(value)); }
+constexpr Moles operator""_mol(unsigned long long value) { return Moles(static_cast<double>(value)); }
+
+constexpr Millimoles operator""_mmol(long double value) { return Millimoles(static_cast<double>(value)); }
+constexpr Millimoles operator""_mmol(unsigned long long value) { return Millimoles(static_cast<double>(value)); }
+
+constexpr Litres operator""_L(long double value) { return Litres(static_cast<double>(value)); }
+constexpr Litres operator""_L(unsigned long long value) { return Litres(static_cast<double>(value)); }
+
+constexpr Millilitres operator""_mL(long double value) { return Millilitres(static_cast<double>(value)); }
+constexpr Millilitres operator""_mL(unsigned long long value) { return Millilitres(static_cast<double>(value)); }
+
+constexpr Molarity operator""_M(long double value) { return Molarity(static_cast<double>(value)); }
+constexpr Molarity operator""_M(unsigned long long value) { return Molarity(static_cast<double>(value)); }
+
+constexpr Millimolar operator""_mM(long double value) { return Millimolar(static_cast<double>(value)); }
+constexpr Millimolar operator""_mM(unsigned long long value) { return Millimolar(static_cast<double>(value)); }
+
+constexpr GramsPerMole operator""_g_per_mol(long double value) { return GramsPerMole(static_cast<double>(value)); }
+constexpr GramsPerMole operator""_g_per_mol(unsigned long long value) { return GramsPerMole(static_cast<double>(value)); }
+
+constexpr Seconds operator""_s(long double value) { return Seconds(static_cast<double>(value)); }
+constexpr Seconds operator""_s(unsigned long long value) { return Seconds(static_cast<double>(value)); }
+
+constexpr Minutes operator""_min(long double value) { return Minutes(static_cast<double>(value)); }
+constexpr Minutes operator""_min(unsigned long long value) { return Minutes(static_cast<double>(value)); }
+
+constexpr Hours operator""_h(long double value) { return Hours(static_cast<double>(value)); }
+constexpr Hours operator""_h(unsigned long long value) { return Hours(static_cast<double>(value)); }
+
+constexpr Kelvin operator""_K(long double value) { return Kelvin(static_cast<double>(value)); }
+constexpr Kelvin operator""_K(unsigned long long value) { return Kelvin(static_cast<double>(value)); }
+
+constexpr Pascals operator""_Pa(long double value) { return Pascals(static_cast<double>(value)); }
+constexpr Pascals operator""_Pa(unsigned long long value) { return Pascals(static_cast<double>(value)); }
+
+constexpr Kilopascals operator""_kPa(long double value) { return Kilopascals(static_cast<double>(value)); }
+constexpr Kilopascals operator""_kPa(unsigned long long value) { return Kilopascals(static_cast<double>(value)); }
+
+constexpr Atmospheres operator""_atm(long double value) { return Atmospheres(static_cast<double>(value)); }
+constexpr Atmospheres operator""_atm(unsigned long long value) { return Atmospheres(static_cast<double>(value)); }
+
+constexpr Joules operator""_J(long double value) { return Joules(static_cast<double>(value)); }
+constexpr Joules operator""_J(unsigned long long value) { return Joules(static_cast<double>(value)); }
+
+constexpr Kilojoules operator""_kJ(long double value) { return Kilojoules(static_cast<double>(value)); }
+constexpr Kilojoules operator""_kJ(unsigned long long value) { return Kilojoules(static_cast<double>(value)); }
+
+} // namespace literals
+
+} // namespace units
+
+#endif // QUANTITY_H
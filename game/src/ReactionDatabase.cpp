@@ -0,0 +1,298 @@
+#include "ReactionDatabase.h"
+#include "EquationParser.h"
+#include "FormulaParser.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <functional>
+#include <limits>
+#include <queue>
+#include <stdexcept>
+#include <utility>
+
+namespace {
+
+struct ParsedTerm {
+    std::string_view formula;
+    std::int64_t coefficient;
+    ReactionDatabase::ElementSet elements;
+};
+
+std::string_view trim(std::string_view text) {
+    size_t begin = text.find_first_not_of(" \t\r\n");
+    if (begin == std::string_view::npos) return std::string_view();
+    size_t end = text.find_last_not_of(" \t\r\n");
+    return text.substr(begin, end - begin + 1);
+}
+
+// "0.85" or "85%"
+double parseYield(std::string_view text) {
+    std::string number(trim(text));
+    bool percent = !number.empty() && number.back() == '%';
+    if (percent) number.pop_back();
+    char* end = nullptr;
+    double value = std::strtod(number.c_str(), &end);
+    if (number.empty() || end != number.c_str() + number.size()) {
+        throw std::invalid_argument("Bad yield \"" + std::string(trim(text)) + "\"");
+    }
+    if (percent) value /= 100.0;
+    if (!(value > 0.0 && value <= 1.0)) {
+        throw std::invalid_argument("Yield must be in (0, 1] or (0%, 100%]");
+    }
+    return value;
+}
+
+// Adds one side's terms to out; the same species twice on one side is one term
+void collectSide(const EquationParser::Equation& equation, const std::vector<FormulaParser::ElementCounts>& species,
+                 size_t begin, size_t end, std::vector<ParsedTerm>& out) {
+    for (size_t i = begin; i < end; ++i) {
+        const EquationParser::Term& term = equation.terms[i];
+        auto same = std::find_if(out.begin(), out.end(), [&term](const ParsedTerm& t) { return t.formula == term.formula; });
+        if (same != out.end()) {
+            same->coefficient += term.coefficient;
+            continue;
+        }
+        ReactionDatabase::ElementSet elements;
+        species[i].forEach([&elements](int z, std::int64_t n) {
+            if (n != 0) elements.insert(z);
+        });
+        out.push_back(ParsedTerm{term.formula, term.coefficient, elements});
+    }
+}
+
+} // namespace
+
+ReactionDatabase::ElementSet ReactionDatabase::ElementSet::fromSymbols(std::string_view symbols) {
+    ElementSet set;
+    size_t i = 0;
+    while (i < symbols.size()) {
+        char c = symbols[i];
+        if (c == ' ' || c == ',' || c == '\t') {
+            i++;
+            continue;
+        }
+        size_t length = (i + 1 < symbols.size() && symbols[i + 1] >= 'a' && symbols[i + 1] <= 'z') ? 2 : 1;
+        int z = PeriodicTable::atomicNumber(symbols.substr(i, length));
+        if (z == 0) {
+            throw std::invalid_argument("Unknown element \"" + std::string(symbols.substr(i, length)) + "\"");
+        }
+        set.insert(z);
+        i += length;
+    }
+    return set;
+}
+
+ReactionDatabase::SpeciesId ReactionDatabase::findSpecies(std::string_view formula) const {
+    auto it = speciesIndex.find(trim(formula));
+    return it == speciesIndex.end() ? NO_SPECIES : it->second;
+}
+
+ReactionDatabase::SpeciesId ReactionDatabase::intern(std::string_view formula) {
+    auto it = speciesIndex.find(formula);
+    if (it != speciesIndex.end()) {
+        return it->second;
+    }
+    SpeciesId id = static_cast<SpeciesId>(speciesNames.size());
+    speciesNames.emplace_back(formula);
+    speciesSets.emplace_back();
+    producedBy.emplace_back();
+    consumedBy.emplace_back();
+    speciesIndex.emplace(speciesNames.back(), id);
+    return id;
+}
+
+ReactionDatabase::ReactionId ReactionDatabase::addReaction(std::string_view equation) {
+    double yield = 1.0;
+    size_t semicolon = equation.find(';');
+    if (semicolon != std::string_view::npos) {
+        yield = parseYield(equation.substr(semicolon + 1));
+        equation = equation.substr(0, semicolon);
+    }
+    thread_local EquationParser::Equation parsed;
+    thread_local std::vector<FormulaParser::ElementCounts> atoms;
+    EquationParser::Result result = EquationParser::parse(equation, parsed, atoms);
+    if (!result.ok()) {
+        throw std::invalid_argument(std::string(result.error == EquationParser::Error::BAD_FORMULA
+                                                    ? FormulaParser::errorMessage(result.formulaError)
+                                                    : EquationParser::errorMessage(result.error)) +
+                                    " at position " + std::to_string(result.position));
+    }
+
+    // Collect everything before touching the store, so a bad line leaves it unchanged
+    std::vector<ParsedTerm> reactantTerms;
+    std::vector<ParsedTerm> productTerms;
+    collectSide(parsed, atoms, 0, parsed.reactantCount, reactantTerms);
+    collectSide(parsed, atoms, parsed.reactantCount, parsed.terms.size(), productTerms);
+    if (reactions.size() >= NO_SPECIES) {
+        throw std::invalid_argument("Too many reactions");
+    }
+
+    ReactionId id = static_cast<ReactionId>(reactions.size());
+    Reaction reaction;
+    reaction.firstTerm = static_cast<std::uint32_t>(terms.size());
+    reaction.reactantCount = static_cast<std::uint32_t>(reactantTerms.size());
+    reaction.productCount = static_cast<std::uint32_t>(productTerms.size());
+    reaction.yield = yield;
+    for (const ParsedTerm& term : reactantTerms) {
+        SpeciesId species = intern(term.formula);
+        speciesSets[species] = term.elements;
+        consumedBy[species].push_back(id);
+        reaction.elements |= term.elements;
+        terms.push_back(Term{species, term.coefficient});
+    }
+    for (const ParsedTerm& term : productTerms) {
+        SpeciesId species = intern(term.formula);
+        speciesSets[species] = term.elements;
+        producedBy[species].push_back(id);
+        reaction.elements |= term.elements;
+        terms.push_back(Term{species, term.coefficient});
+    }
+    reactions.push_back(reaction);
+    return id;
+}
+
+size_t ReactionDatabase::load(std::istream& in) {
+    size_t added = 0;
+    size_t lineNumber = 0;
+    std::string line;
+    while (std::getline(in, line)) {
+        lineNumber++;
+        std::string_view text = trim(line);
+        if (text.empty() || text[0] == '#') continue;
+        try {
+            addReaction(text);
+        } catch (const std::invalid_argument& e) {
+            throw std::invalid_argument("Line " + std::to_string(lineNumber) + ": " + e.what());
+        }
+        added++;
+    }
+    return added;
+}
+
+std::string ReactionDatabase::reactionText(ReactionId id) const {
+    const Reaction& r = reactions[id];
+    std::string text;
+    auto appendSide = [this, &text](const Term* side, std::uint32_t count) {
+        for (std::uint32_t i = 0; i < count; ++i) {
+            if (i > 0) text += " + ";
+            if (side[i].coefficient != 1) text += std::to_string(side[i].coefficient);
+            text += speciesNames[side[i].species];
+        }
+    };
+    appendSide(reactants(id), r.reactantCount);
+    text += " -> ";
+    appendSide(products(id), r.productCount);
+    return text;
+}
+
+std::vector<ReactionDatabase::ReactionId> ReactionDatabase::filter(const std::vector<ReactionId>& candidates,
+                                                                   const ElementSet& allowed) const {
+    std::vector<ReactionId> result;
+    for (ReactionId id : candidates) {
+        if (reactions[id].elements.isSubsetOf(allowed)) {
+            result.push_back(id);
+        }
+    }
+    return result;
+}
+
+std::vector<ReactionDatabase::ReactionId> ReactionDatabase::reactionsProducing(SpeciesId species,
+                                                                               const ElementSet& allowed) const {
+    return filter(producedBy[species], allowed);
+}
+
+std::vector<ReactionDatabase::ReactionId> ReactionDatabase::reactionsConsuming(SpeciesId species,
+                                                                               const ElementSet& allowed) const {
+    return filter(consumedBy[species], allowed);
+}
+
+ReactionDatabase::Pathway ReactionDatabase::findPathway(const std::vector<std::string>& precursors,
+                                                        std::string_view target, Objective objective,
+                                                        const ElementSet& allowed) const {
+    Pathway pathway;
+    const SpeciesId goal = findSpecies(target);
+    if (goal == NO_SPECIES) {
+        return pathway;
+    }
+
+    const double infinity = std::numeric_limits<double>::infinity();
+    std::vector<double> cost(speciesNames.size(), infinity);
+    std::vector<ReactionId> madeBy(speciesNames.size(), NO_SPECIES); // NO_SPECIES: precursor or unreached
+    std::vector<char> settled(speciesNames.size(), 0);
+    // Reactants of each reaction not yet settled; filled on first touch
+    std::vector<std::uint32_t> waiting(reactions.size(), 0);
+    std::vector<char> touched(reactions.size(), 0);
+
+    using Entry = std::pair<double, SpeciesId>;
+    std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>> queue;
+    for (const std::string& name : precursors) {
+        SpeciesId species = findSpecies(name);
+        if (species != NO_SPECIES && cost[species] != 0.0) {
+            cost[species] = 0.0;
+            queue.emplace(0.0, species);
+        }
+    }
+
+    while (!queue.empty()) {
+        auto [distance, species] = queue.top();
+        queue.pop();
+        if (settled[species]) continue;
+        settled[species] = 1;
+        if (species == goal) break;
+
+        for (ReactionId id : consumedBy[species]) {
+            const Reaction& r = reactions[id];
+            if (!r.elements.isSubsetOf(allowed)) continue;
+            if (!touched[id]) {
+                touched[id] = 1;
+                waiting[id] = r.reactantCount;
+            }
+            if (--waiting[id] != 0) continue;
+
+            // Last reactant settled: the reaction fires
+            double total = objective == Objective::FEWEST_STEPS ? 1.0 : -std::log(r.yield);
+            const Term* inputs = reactants(id);
+            for (std::uint32_t i = 0; i < r.reactantCount; ++i) {
+                total += cost[inputs[i].species];
+            }
+            const Term* outputs = products(id);
+            for (std::uint32_t i = 0; i < r.productCount; ++i) {
+                SpeciesId product = outputs[i].species;
+                if (!settled[product] && total < cost[product]) {
+                    cost[product] = total;
+                    madeBy[product] = id;
+                    queue.emplace(total, product);
+                }
+            }
+        }
+    }
+    if (!settled[goal]) {
+        return pathway;
+    }
+
+    // Post-order walk from the target: each reaction after the ones that make its inputs
+    pathway.found = true;
+    pathway.cost = cost[goal];
+    pathway.cumulativeYield = 1.0;
+    std::vector<char> listed(reactions.size(), 0);
+    std::vector<std::pair<ReactionId, std::uint32_t>> stack; // Reaction, next reactant to visit
+    if (madeBy[goal] != NO_SPECIES) {
+        stack.emplace_back(madeBy[goal], 0);
+        listed[madeBy[goal]] = 1;
+    }
+    while (!stack.empty()) {
+        auto& [id, next] = stack.back();
+        if (next < reactions[id].reactantCount) {
+            ReactionId source = madeBy[reactants(id)[next++].species];
+            if (source != NO_SPECIES && !listed[source]) {
+                listed[source] = 1;
+                stack.emplace_back(source, 0);
+            }
+            continue;
+        }
+        pathway.reactions.push_back(id);
+        pathway.cumulativeYield *= reactions[id].yield;
+        stack.pop_back();
+    }
+    return pathway;
+}
@@ -0,0 +1,119 @@
+#ifndef REACTIONDATABASE_H
+#define REACTIONDATABASE_H
+
+#include <cstdint>
+#include <deque>
+#include <istream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+/**
+ * @brief ReactionDatabase - Store of known reactions and synthesis-route search
+ * Species are interned by their formula text, and each reaction keeps flat
+ * reactant and product lists. Per-species indexes list the reactions that
+ * produce or consume it. Every species and reaction also has a bitset of the
+ * elements it contains, so a filter like "only C, H, N, O" is a single AND.
+ *
+ * findPathway() searches from the available precursors to a target. A reaction
+ * needs all of its reactants, so the search is Knuth's generalization of
+ * Dijkstra to AND-OR graphs. A reaction fires once its last reactant is
+ * settled. The target's cost is the reaction's weight plus the cost of every
+ * reactant. Each species is settled at most once, and each reaction is looked
+ * at once per reactant.
+ */
+class ReactionDatabase {
+public:
+    using SpeciesId = std::uint32_t;
+    using ReactionId = std::uint32_t;
+    static constexpr SpeciesId NO_SPECIES = 0xFFFFFFFFu;
+
+    // Set of elements, bit Z for atomic number Z
+    struct ElementSet {
+        std::uint64_t bits[2] = {0, 0};
+
+        static ElementSet all() { return ElementSet{{~std::uint64_t(0), ~std::uint64_t(0)}}; }
+        // "C H N O" or "CHNO"; throws std::invalid_argument for unknown symbols
+        static ElementSet fromSymbols(std::string_view symbols);
+
+        void insert(int z) { bits[z >> 6] |= std::uint64_t(1) << (z & 63); }
+        bool contains(int z) const { return (bits[z >> 6] >> (z & 63)) & 1u; }
+        bool isSubsetOf(const ElementSet& other) const {
+            return (bits[0] & ~other.bits[0]) == 0 && (bits[1] & ~other.bits[1]) == 0;
+        }
+        ElementSet& operator|=(const ElementSet& other) {
+            bits[0] |= other.bits[0];
+            bits[1] |= other.bits[1];
+            return *this;
+        }
+    };
+
+    struct Term {
+        SpeciesId species;
+        std::int64_t coefficient;
+    };
+
+    struct Reaction {
+        std::uint32_t firstTerm = 0;    // Reactants, then products, in the shared term list
+        std::uint32_t reactantCount = 0;
+        std::uint32_t productCount = 0;
+        double yield = 1.0;             // Fraction in (0, 1]
+        ElementSet elements;            // Every element on either side
+    };
+
+    enum class Objective {
+        FEWEST_STEPS, // Each reaction costs 1
+        BEST_YIELD    // Each reaction costs -log(yield); the route maximizes the product of yields
+    };
+
+    struct Pathway {
+        bool found = false;
+        std::vector<ReactionId> reactions; // In an order they can be run: inputs before their uses
+        double cumulativeYield = 0.0;      // Product of the yields of the reactions above
+        double cost = 0.0;                 // Search cost of the target (shared intermediates count once per use)
+    };
+
+    // "A + 2B -> C + D" (see EquationParser) with an optional "; yield" (0.85 or 85%).
+    // Duplicate species on one side are merged. Throws std::invalid_argument if malformed.
+    ReactionId addReaction(std::string_view equation);
+
+    // One reaction per line; blank lines and lines starting with '#' are skipped.
+    // Throws std::invalid_argument naming the line of the first malformed reaction.
+    size_t load(std::istream& in);
+
+    SpeciesId findSpecies(std::string_view formula) const; // NO_SPECIES if unknown
+    const std::string& speciesFormula(SpeciesId species) const { return speciesNames[species]; }
+    const ElementSet& speciesElements(SpeciesId species) const { return speciesSets[species]; }
+
+    size_t speciesCount() const { return speciesNames.size(); }
+    size_t reactionCount() const { return reactions.size(); }
+    const Reaction& reaction(ReactionId id) const { return reactions[id]; }
+    const Term* reactants(ReactionId id) const { return terms.data() + reactions[id].firstTerm; }
+    const Term* products(ReactionId id) const { return reactants(id) + reactions[id].reactantCount; }
+    std::string reactionText(ReactionId id) const; // "2H2 + O2 -> 2H2O"
+
+    // Reactions that make or use a species, restricted to those using only allowed elements
+    std::vector<ReactionId> reactionsProducing(SpeciesId species, const ElementSet& allowed = ElementSet::all()) const;
+    std::vector<ReactionId> reactionsConsuming(SpeciesId species, const ElementSet& allowed = ElementSet::all()) const;
+
+    // Cheapest route from the precursors to the target using only reactions within allowed.
+    // Unknown precursors are ignored; found is false if the target cannot be reached.
+    Pathway findPathway(const std::vector<std::string>& precursors, std::string_view target,
+                        Objective objective = Objective::FEWEST_STEPS,
+                        const ElementSet& allowed = ElementSet::all()) const;
+
+private:
+    std::deque<std::string> speciesNames; // A deque never moves its strings, so the index keys stay valid
+    std::vector<ElementSet> speciesSets;
+    std::unordered_map<std::string_view, SpeciesId> speciesIndex; // Keys view into speciesNames
+    std::vector<std::vector<ReactionId>> producedBy;
+    std::vector<std::vector<ReactionId>> consumedBy;
+    std::vector<Reaction> reactions;
+    std::vector<Term> terms;
+
+    SpeciesId intern(std::string_view formula);
+    std::vector<ReactionId> filter(const std::vector<ReactionId>& candidates, const ElementSet& allowed) const;
+};
+
+#endif // REACTIONDATABASE_H
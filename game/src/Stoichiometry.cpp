@@ -0,0 +1,171 @@
+#include "Stoichiometry.h"
+#include <algorithm>
+#include <stdexcept>
+
+namespace {
+
+// Scenarios per block, so extent and limiting stay in L1 while every column streams past
+constexpr size_t BLOCK_SCENARIOS = 1024;
+
+// Negative and NaN amounts would come out as negative or NaN yields instead of an error
+void checkAmounts(const std::vector<double>& amounts) {
+    for (double amount : amounts) {
+        if (!(amount >= 0.0)) {
+            throw std::invalid_argument("Amounts must be non-negative numbers");
+        }
+    }
+}
+
+} // namespace
+
+Stoichiometry::Stoichiometry(const ChemistryEngine::ChemicalEquation& equation) {
+    if (equation.reactants.empty() || equation.products.empty()) {
+        throw std::invalid_argument("Equation needs at least one reactant and one product");
+    }
+    if (!equation.isBalanced()) {
+        throw std::invalid_argument("Equation is not balanced: " + equation.toString());
+    }
+
+    auto load = [](const std::vector<ChemistryEngine::EquationComponent>& side, std::vector<double>& coefficients,
+                   std::vector<double>& masses, std::vector<std::string>& names) {
+        for (const auto& component : side) {
+            if (component.coefficient <= 0) {
+                throw std::invalid_argument("Coefficient of " + component.formula->toString() + " must be positive");
+            }
+            coefficients.push_back(static_cast<double>(component.coefficient));
+            masses.push_back(ChemistryEngine::calculateMolarMass(*component.formula));
+            names.push_back(component.formula->toString());
+        }
+    };
+    load(equation.reactants, reactantCoefficients, reactantMasses, reactantNames);
+    load(equation.products, productCoefficients, productMasses, productNames);
+}
+
+void Stoichiometry::solve(const double* const* amounts, size_t count, double* extent, std::int32_t* limiting,
+                          double* const* leftover, double* const* products) const {
+    const size_t reactants = reactantCount();
+
+    // Extent = min over reactants of amount / coefficient; the first minimum is the limiting reagent
+    const double firstCoefficient = reactantCoefficients[0];
+    for (size_t s = 0; s < count; ++s) {
+        extent[s] = amounts[0][s] / firstCoefficient;
+        limiting[s] = 0;
+    }
+    for (size_t r = 1; r < reactants; ++r) {
+        const double* amount = amounts[r];
+        const double coefficient = reactantCoefficients[r];
+        const std::int32_t index = static_cast<std::int32_t>(r);
+        for (size_t s = 0; s < count; ++s) {
+            double ratio = amount[s] / coefficient;
+            bool smaller = ratio < extent[s];
+            extent[s] = smaller ? ratio : extent[s];
+            limiting[s] = smaller ? index : limiting[s];
+        }
+    }
+
+    // Leftovers: the limiting reagent is used up exactly; rounding never leaves a negative excess
+    for (size_t r = 0; r < reactants; ++r) {
+        const double* amount = amounts[r];
+        double* left = leftover[r];
+        const double coefficient = reactantCoefficients[r];
+        const std::int32_t index = static_cast<std::int32_t>(r);
+        for (size_t s = 0; s < count; ++s) {
+            double used = coefficient * extent[s];
+            double remaining = amount[s] - used;
+            remaining = remaining > 0.0 ? remaining : 0.0;
+            left[s] = limiting[s] == index ? 0.0 : remaining;
+        }
+    }
+
+    for (size_t p = 0; p < productCount(); ++p) {
+        double* yield = products[p];
+        const double coefficient = productCoefficients[p];
+        for (size_t s = 0; s < count; ++s) {
+            yield[s] = coefficient * extent[s];
+        }
+    }
+}
+
+Stoichiometry::Result Stoichiometry::evaluate(const std::vector<double>& reactantMoles) const {
+    if (reactantMoles.size() != reactantCount()) {
+        throw std::invalid_argument("Expected one amount per reactant");
+    }
+    checkAmounts(reactantMoles);
+
+    Result result;
+    result.productMoles.resize(productCount());
+    result.leftoverMoles.resize(reactantCount());
+
+    // One-scenario columns pointing straight into the inputs and the result
+    std::vector<const double*> amounts(reactantCount());
+    std::vector<double*> leftover(reactantCount());
+    std::vector<double*> products(productCount());
+    for (size_t r = 0; r < reactantCount(); ++r) {
+        amounts[r] = &reactantMoles[r];
+        leftover[r] = &result.leftoverMoles[r];
+    }
+    for (size_t p = 0; p < productCount(); ++p) {
+        products[p] = &result.productMoles[p];
+    }
+
+    std::int32_t limiting = 0;
+    solve(amounts.data(), 1, &result.extent, &limiting, leftover.data(), products.data());
+    result.limitingReagent = limiting;
+
+    for (size_t p = 0; p < productCount(); ++p) {
+        result.productGrams.push_back(result.productMoles[p] * productMasses[p]);
+    }
+    for (size_t r = 0; r < reactantCount(); ++r) {
+        result.leftoverGrams.push_back(result.leftoverMoles[r] * reactantMasses[r]);
+    }
+    return result;
+}
+
+Stoichiometry::Result Stoichiometry::evaluateGrams(const std::vector<double>& reactantGrams) const {
+    if (reactantGrams.size() != reactantCount()) {
+        throw std::invalid_argument("Expected one amount per reactant");
+    }
+    checkAmounts(reactantGrams);
+    std::vector<double> moles(reactantGrams.size());
+    for (size_t r = 0; r < moles.size(); ++r) {
+        moles[r] = reactantGrams[r] / reactantMasses[r];
+    }
+    return evaluate(moles);
+}
+
+void Stoichiometry::evaluateBatch(const std::vector<std::vector<double>>& reactantMoles, BatchResult& out) const {
+    if (reactantMoles.size() != reactantCount()) {
+        throw std::invalid_argument("Expected one amount column per reactant");
+    }
+    const size_t count = reactantMoles[0].size();
+    for (const auto& column : reactantMoles) {
+        if (column.size() != count) {
+            throw std::invalid_argument("Amount columns must have the same length");
+        }
+        checkAmounts(column);
+    }
+
+    out.scenarioCount = count;
+    out.limitingReagent.resize(count);
+    out.extent.resize(count);
+    out.productMoles.resize(productCount());
+    out.leftoverMoles.resize(reactantCount());
+    for (auto& column : out.productMoles) column.resize(count);
+    for (auto& column : out.leftoverMoles) column.resize(count);
+
+    std::vector<const double*> amounts(reactantCount());
+    std::vector<double*> leftover(reactantCount());
+    std::vector<double*> products(productCount());
+    for (size_t start = 0; start < count; start += BLOCK_SCENARIOS) {
+        size_t n = std::min(BLOCK_SCENARIOS, count - start);
+        for (size_t r = 0; r < reactantCount(); ++r) {
+            amounts[r] = reactantMoles[r].data() + start;
+            leftover[r] = out.leftoverMoles[r].data() + start;
+        }
+        for (size_t p = 0; p < productCount(); ++p) {
+            products[p] = out.productMoles[p].data() + start;
+        }
+        solve(amounts.data(), n, out.extent.data() + start, out.limitingReagent.data() + start,
+              leftover.data(), products.data());
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef STOICHIOMETRY_H
+#define STOICHIOMETRY_H
+
+#include "ChemistryEngine.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/**
+ * @brief Stoichiometry - Limiting-reagent solver for a balanced equation
+ * Given the available amount of every reactant, finds the extent of reaction
+ * (the largest number of "equation units" the reactants allow), the limiting
+ * reagent, the theoretical yield of every product and the excess left over.
+ *
+ * evaluateBatch() solves many what-if scenarios at once. Inputs and outputs are
+ * stored one column per species, so every step is a straight loop over
+ * contiguous doubles that the compiler vectorizes. evaluate() runs the same
+ * kernel on a single scenario, so both give bit-identical results.
+ */
+class Stoichiometry {
+public:
+    struct Result {
+        int limitingReagent = 0;          // Index into the equation's reactants (first one on ties)
+        double extent = 0.0;              // Moles of reaction, in units of the balanced equation
+        std::vector<double> productMoles; // Theoretical yield
+        std::vector<double> productGrams;
+        std::vector<double> leftoverMoles; // Excess reactant after the reaction (0 for the limiting one)
+        std::vector<double> leftoverGrams;
+    };
+
+    // Scenario s of species i lives at column[i][s]
+    struct BatchResult {
+        size_t scenarioCount = 0;
+        std::vector<std::int32_t> limitingReagent;
+        std::vector<double> extent;
+        std::vector<std::vector<double>> productMoles;  // [product][scenario]
+        std::vector<std::vector<double>> leftoverMoles; // [reactant][scenario]
+    };
+
+    // Throws std::invalid_argument unless the equation is balanced with positive coefficients
+    explicit Stoichiometry(const ChemistryEngine::ChemicalEquation& equation);
+
+    // Amounts are non-negative and given per reactant, in equation order.
+    // Throws std::invalid_argument if the number of amounts does not match or an amount is
+    // negative or NaN.
+    Result evaluate(const std::vector<double>& reactantMoles) const;
+    Result evaluateGrams(const std::vector<double>& reactantGrams) const;
+
+    // reactantMoles[r][s]: amount of reactant r in scenario s (all columns equally long).
+    // Reuses the storage already held by out. Throws like evaluate().
+    void evaluateBatch(const std::vector<std::vector<double>>& reactantMoles, BatchResult& out) const;
+
+    size_t reactantCount() const { return reactantCoefficients.size(); }
+    size_t productCount() const { return productCoefficients.size(); }
+    double reactantMolarMass(size_t index) const { return reactantMasses[index]; }
+    double productMolarMass(size_t index) const { return productMasses[index]; }
+    const std::string& reactantFormula(size_t index) const { return reactantNames[index]; }
+    const std::string& productFormula(size_t index) const { return productNames[index]; }
+
+private:
+    std::vector<double> reactantCoefficients;
+    std::vector<double> productCoefficients;
+    std::vector<double> reactantMasses;
+    std::vector<double> productMasses;
+    std::vector<std::string> reactantNames;
+    std::vector<std::string> productNames;
+
+    // Solves scenarios [0, count) of the given column pointers
+    void solve(const double* const* amounts, size_t count, double* extent, std::int32_t* limiting,
+               double* const* leftover, double* const* products) const;
+};
+
+#endif // STOICHIOMETRY_H
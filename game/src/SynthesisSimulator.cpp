@@ -0,0 +1,242 @@
+#include "SynthesisSimulator.h"
+#include "ChemistryEngine.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+
+namespace {
+
+// Trials per chunk: fixed, so the merge order never depends on the pool
+constexpr size_t CHUNK_TRIALS = 4096;
+
+// Draw slots per trial: weighing, impurity, then one per step
+constexpr std::uint32_t DRAW_WEIGHING = 0;
+constexpr std::uint32_t DRAW_IMPURITY = 1;
+constexpr std::uint32_t DRAW_FIRST_STEP = 2;
+
+constexpr double TWO_PI = 6.283185307179586476925286766559;
+
+// Philox4x32-10 (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3")
+struct Philox {
+    std::uint32_t c[4];
+};
+
+inline Philox philox(std::uint32_t c0, std::uint32_t c1, std::uint32_t c2, std::uint32_t c3, std::uint64_t seed) {
+    std::uint32_t k0 = static_cast<std::uint32_t>(seed), k1 = static_cast<std::uint32_t>(seed >> 32);
+    for (int round = 0; round < 10; ++round) {
+        const std::uint64_t p0 = std::uint64_t{0xD2511F53u} * c0;
+        const std::uint64_t p1 = std::uint64_t{0xCD9E8D57u} * c2;
+        const std::uint32_t n0 = static_cast<std::uint32_t>(p1 >> 32) ^ c1 ^ k0;
+        const std::uint32_t n2 = static_cast<std::uint32_t>(p0 >> 32) ^ c3 ^ k1;
+        c1 = static_cast<std::uint32_t>(p1);
+        c3 = static_cast<std::uint32_t>(p0);
+        c0 = n0;
+        c2 = n2;
+        k0 += 0x9E3779B9u;
+        k1 += 0xBB67AE85u;
+    }
+    return Philox{{c0, c1, c2, c3}};
+}
+
+// Standard normal for (trial, draw): Box-Muller on two 53-bit uniforms from one Philox block
+inline double normal(std::uint64_t seed, std::uint64_t trial, std::uint32_t draw) {
+    const Philox block =
+        philox(static_cast<std::uint32_t>(trial), static_cast<std::uint32_t>(trial >> 32), draw, 0, seed);
+    const double scale = 1.0 / 9007199254740992.0; // 2^-53
+    const std::uint64_t a = ((std::uint64_t{block.c[0]} << 32) | block.c[1]) >> 11;
+    const std::uint64_t b = ((std::uint64_t{block.c[2]} << 32) | block.c[3]) >> 11;
+    const double u1 = (static_cast<double>(a) + 1.0) * scale; // (0, 1]: log stays finite
+    const double u2 = static_cast<double>(b) * scale;
+    return std::sqrt(-2.0 * std::log(u1)) * std::cos(TWO_PI * u2);
+}
+
+void addToHistogram(std::uint64_t* histogram, double low, double high, double value) {
+    const double position = (value - low) / (high - low) * static_cast<double>(SynthesisSimulator::HISTOGRAM_BINS);
+    const double last = static_cast<double>(SynthesisSimulator::HISTOGRAM_BINS - 1);
+    histogram[static_cast<size_t>(std::clamp(position, 0.0, last))]++;
+}
+
+void checkFraction(double value, const char* name) {
+    if (!(value >= 0.0 && value <= 1.0)) {
+        throw std::invalid_argument(std::string(name) + " must be between 0 and 1");
+    }
+}
+
+} // namespace
+
+// Welford moments of one chunk per quantity (yield, purity, mass)
+struct SynthesisSimulator::ChunkStatistics {
+    size_t count = 0;
+    double mean[3] = {0.0, 0.0, 0.0};
+    double m2[3] = {0.0, 0.0, 0.0};
+    double min[3] = {0.0, 0.0, 0.0};
+    double max[3] = {0.0, 0.0, 0.0};
+};
+
+double SynthesisSimulator::Distribution::percentile(double fraction) const {
+    std::uint64_t total = 0;
+    for (std::uint64_t count : histogram) total += count;
+    if (total == 0) return 0.0;
+    const double target = std::clamp(fraction, 0.0, 1.0) * static_cast<double>(total);
+    const double width = (histogramMax - histogramMin) / static_cast<double>(histogram.size());
+    double seen = 0.0;
+    for (size_t i = 0; i < histogram.size(); ++i) {
+        const double next = seen + static_cast<double>(histogram[i]);
+        if (next >= target && histogram[i] > 0) {
+            double value = histogramMin + width * (static_cast<double>(i) + (target - seen) / histogram[i]);
+            return std::clamp(value, min, max);
+        }
+        seen = next;
+    }
+    return max;
+}
+
+SynthesisSimulator::SynthesisSimulator(const Route& route) : route(route) {
+    if (route.steps.empty()) {
+        throw std::invalid_argument("A synthesis route needs at least one step");
+    }
+    if (!(route.startingMass.value() > 0.0) || !std::isfinite(route.startingMass.value())) {
+        throw std::invalid_argument("Starting mass must be positive");
+    }
+    if (!(route.weighingStdDev >= 0.0) || !(route.impurityStdDev >= 0.0)) {
+        throw std::invalid_argument("Standard deviations must not be negative");
+    }
+    checkFraction(route.impurityFraction, "Impurity fraction");
+    if (route.impurityFraction == 1.0) {
+        throw std::invalid_argument("Starting material must not be pure impurity");
+    }
+
+    double productPerStart = 1.0;
+    for (const Step& step : route.steps) {
+        if (step.reactantCoefficient <= 0 || step.productCoefficient <= 0) {
+            throw std::invalid_argument("Step coefficients must be positive");
+        }
+        checkFraction(step.meanYield, "Mean yield");
+        checkFraction(step.impurityCarryOver, "Impurity carry-over");
+        checkFraction(step.byproductFraction, "Byproduct fraction");
+        if (!(step.yieldStdDev >= 0.0)) {
+            throw std::invalid_argument("Standard deviations must not be negative");
+        }
+        // Product grams per gram of reactant, through the same stoichiometry the game uses
+        const units::Grams perMole = ChemistryEngine::calculateProductYield(
+            step.reactantFormula, units::Moles(1.0), step.productFormula, step.reactantCoefficient,
+            step.productCoefficient);
+        const double ratio = perMole.value() / ChemistryEngine::molarMass(step.reactantFormula).value();
+        gramsPerGram.push_back(ratio);
+        productPerStart *= ratio;
+    }
+    theoreticalGrams = route.startingMass.value() * (1.0 - route.impurityFraction) * productPerStart;
+    massRange = route.startingMass.value() * (1.0 + 6.0 * route.weighingStdDev) * productPerStart;
+}
+
+units::Grams SynthesisSimulator::expectedMass() const {
+    double pure = route.startingMass.value() * (1.0 - route.impurityFraction);
+    for (size_t s = 0; s < route.steps.size(); ++s) {
+        pure *= gramsPerGram[s] * route.steps[s].meanYield;
+    }
+    return units::Grams(pure);
+}
+
+void SynthesisSimulator::simulateChunk(std::uint64_t seed, size_t firstTrial, size_t count, ChunkStatistics& out,
+                                       std::uint64_t* histograms) const {
+    double pure[CHUNK_TRIALS], impurity[CHUNK_TRIALS];
+
+    for (size_t i = 0; i < count; ++i) {
+        const std::uint64_t trial = firstTrial + i;
+        const double mass =
+            std::max(0.0, route.startingMass.value() * (1.0 + route.weighingStdDev * normal(seed, trial, DRAW_WEIGHING)));
+        const double fraction =
+            std::clamp(route.impurityFraction + route.impurityStdDev * normal(seed, trial, DRAW_IMPURITY), 0.0, 1.0);
+        pure[i] = mass * (1.0 - fraction);
+        impurity[i] = mass * fraction;
+    }
+
+    for (size_t s = 0; s < route.steps.size(); ++s) {
+        const Step& step = route.steps[s];
+        const double ratio = gramsPerGram[s];
+        const std::uint32_t draw = DRAW_FIRST_STEP + static_cast<std::uint32_t>(s);
+        for (size_t i = 0; i < count; ++i) {
+            const double yield =
+                std::clamp(step.meanYield + step.yieldStdDev * normal(seed, firstTrial + i, draw), 0.0, 1.0);
+            const double theoretical = pure[i] * ratio;
+            pure[i] = theoretical * yield;
+            impurity[i] = impurity[i] * step.impurityCarryOver + theoretical * (1.0 - yield) * step.byproductFraction;
+        }
+    }
+
+    const double yieldRange = massRange / theoreticalGrams;
+    const double low[3] = {0.0, 0.0, 0.0};
+    const double high[3] = {yieldRange, 1.0, massRange};
+    for (int q = 0; q < 3; ++q) {
+        out.min[q] = std::numeric_limits<double>::infinity();
+        out.max[q] = -std::numeric_limits<double>::infinity();
+    }
+    out.count = count;
+    for (size_t i = 0; i < count; ++i) {
+        const double total = pure[i] + impurity[i];
+        const double values[3] = {pure[i] / theoreticalGrams, total > 0.0 ? pure[i] / total : 0.0, pure[i]};
+        for (int q = 0; q < 3; ++q) {
+            const double delta = values[q] - out.mean[q];
+            out.mean[q] += delta / static_cast<double>(i + 1);
+            out.m2[q] += delta * (values[q] - out.mean[q]);
+            out.min[q] = std::min(out.min[q], values[q]);
+            out.max[q] = std::max(out.max[q], values[q]);
+            addToHistogram(histograms + q * HISTOGRAM_BINS, low[q], high[q], values[q]);
+        }
+    }
+}
+
+SynthesisSimulator::Result SynthesisSimulator::run(size_t trials, std::uint64_t seed, ThreadPool& pool) const {
+    const size_t chunks = (trials + CHUNK_TRIALS - 1) / CHUNK_TRIALS;
+    std::vector<ChunkStatistics> statistics(chunks);
+    // Counts commute, so the shared histograms can be summed in any order
+    std::unique_ptr<std::atomic<std::uint64_t>[]> histograms(new std::atomic<std::uint64_t>[3 * HISTOGRAM_BINS]);
+    for (size_t i = 0; i < 3 * HISTOGRAM_BINS; ++i) histograms[i].store(0, std::memory_order_relaxed);
+
+    pool.parallelFor(chunks, 1, [&](size_t begin, size_t end) {
+        std::vector<std::uint64_t> local(3 * HISTOGRAM_BINS, 0);
+        for (size_t c = begin; c < end; ++c) {
+            const size_t first = c * CHUNK_TRIALS;
+            simulateChunk(seed, first, std::min(CHUNK_TRIALS, trials - first), statistics[c], local.data());
+        }
+        for (size_t i = 0; i < local.size(); ++i) {
+            if (local[i]) histograms[i].fetch_add(local[i], std::memory_order_relaxed);
+        }
+    });
+
+    // Chan's parallel merge, in chunk order
+    Result result;
+    result.trials = trials;
+    Distribution* distributions[3] = {&result.yield, &result.purity, &result.pureMass};
+    const double high[3] = {massRange / theoreticalGrams, 1.0, massRange};
+    for (int q = 0; q < 3; ++q) {
+        double count = 0.0, mean = 0.0, m2 = 0.0;
+        double low = std::numeric_limits<double>::infinity(), top = -std::numeric_limits<double>::infinity();
+        for (const ChunkStatistics& chunk : statistics) {
+            const double n = static_cast<double>(chunk.count);
+            const double delta = chunk.mean[q] - mean;
+            const double merged = count + n;
+            mean += delta * n / merged;
+            m2 += chunk.m2[q] + delta * delta * count * n / merged;
+            count = merged;
+            low = std::min(low, chunk.min[q]);
+            top = std::max(top, chunk.max[q]);
+        }
+        Distribution& d = *distributions[q];
+        d.mean = mean;
+        d.stdDev = count > 1.0 ? std::sqrt(m2 / (count - 1.0)) : 0.0;
+        d.min = count > 0.0 ? low : 0.0;
+        d.max = count > 0.0 ? top : 0.0;
+        d.histogramMin = 0.0;
+        d.histogramMax = high[q];
+        d.histogram.resize(HISTOGRAM_BINS);
+        for (size_t i = 0; i < HISTOGRAM_BINS; ++i) {
+            d.histogram[i] = histograms[q * HISTOGRAM_BINS + i].load(std::memory_order_relaxed);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,92 @@
+#ifndef SYNTHESISSIMULATOR_H
+#define SYNTHESISSIMULATOR_H
+
+#include "Quantity.h"
+#include <cstdint>
+#include <string>
+#include <vector>
+
+class ThreadPool;
+
+/**
+ * @brief SynthesisSimulator - Monte Carlo yield and purity of a multi-step synthesis
+ * Each trial weighs the starting material with a random error, draws its
+ * impurity content, then runs every step with a randomly drawn yield. The
+ * product mass of each step comes from ChemistryEngine::calculateProductYield.
+ * Impurities are carried into the next product, and part of the lost product
+ * can come through as a byproduct.
+ *
+ * Random numbers come from Philox4x32-10, a counter-based generator keyed by
+ * the seed, whose counter is (trial, draw). Any trial can be replayed alone.
+ * Trials run in fixed-size chunks on the pool. Each chunk reduces its own
+ * moments and histograms, and the chunks are merged in index order. The result
+ * depends only on the seed and the trial count, not on the thread count.
+ */
+class SynthesisSimulator {
+public:
+    struct Step {
+        std::string reactantFormula;
+        std::string productFormula;
+        int reactantCoefficient = 1;
+        int productCoefficient = 1;
+        double meanYield = 1.0;         // Isolated fraction of the theoretical product
+        double yieldStdDev = 0.0;       // Trial-to-trial spread; drawn yields are clamped to [0, 1]
+        double impurityCarryOver = 1.0; // Fraction of incoming impurity mass left in the isolated product
+        double byproductFraction = 0.0; // Fraction of the lost product mass isolated with it as impurity
+    };
+
+    struct Route {
+        units::Grams startingMass{0.0};  // Nominal mass of the (impure) starting material
+        double weighingStdDev = 0.0;     // Relative: 0.01 is a 1% balance error
+        double impurityFraction = 0.0;   // Mass fraction of the starting material
+        double impurityStdDev = 0.0;
+        std::vector<Step> steps;
+    };
+
+    struct Distribution {
+        double mean = 0.0;
+        double stdDev = 0.0;
+        double min = 0.0;
+        double max = 0.0;
+        double histogramMin = 0.0; // histogram[i] counts [min + i * width, min + (i + 1) * width)
+        double histogramMax = 0.0; // Values outside the range go to the end bins
+        std::vector<std::uint64_t> histogram;
+
+        // Interpolated within a histogram bin (fraction in [0, 1])
+        double percentile(double fraction) const;
+    };
+
+    struct Result {
+        size_t trials = 0;
+        Distribution yield;    // Pure final product / theoretical product of the nominal pure start
+        Distribution purity;   // Mass fraction of product in the isolated final material
+        Distribution pureMass; // Grams of pure final product
+    };
+
+    static constexpr size_t HISTOGRAM_BINS = 1000;
+
+    // Throws std::invalid_argument for an empty route, unknown formulas, non-positive
+    // coefficients or fractions outside [0, 1]
+    explicit SynthesisSimulator(const Route& route);
+
+    Result run(size_t trials, std::uint64_t seed, ThreadPool& pool) const;
+
+    // Final pure product mass with every draw at its mean
+    units::Grams expectedMass() const;
+    // Final product mass from the nominal pure starting material at 100% yield
+    units::Grams theoreticalMass() const { return units::Grams(theoreticalGrams); }
+
+private:
+    struct ChunkStatistics;
+
+    Route route;
+    std::vector<double> gramsPerGram; // Theoretical product mass per gram of reactant, per step
+    double theoreticalGrams = 0.0;
+    double massRange = 0.0; // Upper end of the pure-mass histogram
+
+    // Adds the chunk's values to histograms (three blocks of HISTOGRAM_BINS: yield, purity, mass)
+    void simulateChunk(std::uint64_t seed, size_t firstTrial, size_t count, ChunkStatistics& out,
+                       std::uint64_t* histograms) const;
+};
+
+#endif // SYNTHESISSIMULATOR_H
@@ -0,0 +1,45 @@
+#include "TextLayout.h"
+#include <sstream>
+
+std::vector<std::string> TextLayout::wrapText(const std::string& text, float maxWidth, int fontSize) {
+    std::vector<std::string> lines;
+    
+    // Approximate character width (monospace font)
+    float charWidth = fontSize * 0.6f;
+    int charsPerLine = static_cast<int>(maxWidth / charWidth);
+    
+    // Split by newlines first
+    std::istringstream textStream(text);
+    std::string paragraph;
+    
+    while (std::getline(textStream, paragraph)) {
+        // Handle each paragraph separately
+        if (paragraph.empty()) {
+            lines.push_back(""); // Empty line
+            continue;
+        }
+        
+        // Word wrap within paragraph
+        std::istringstream paraStream(paragraph);
+        std::string word;
+        std::string currentLine;
+        
+        while (paraStream >> word) {
+            std::string testLine = currentLine.empty() ? word : currentLine + " " + word;
+            if (static_cast<int>(testLine.length()) <= charsPerLine || currentLine.empty()) {
+                currentLine = testLine;
+            } else {
+                if (!currentLine.empty()) {
+                    lines.push_back(currentLine);
+                }
+                currentLine = word;
+            }
+        }
+        
+        if (!currentLine.empty()) {
+            lines.push_back(currentLine);
+        }
+    }
+    
+    return lines;
+}
@@ -0,0 +1,19 @@
+#ifndef TEXTLAYOUT_H
+#define TEXTLAYOUT_H
+
+#include <string>
+#include <vector>
+
+/**
+ * @brief TextLayout - Word wrapping for the game's text panels
+ * Kept apart from GameWindow so it builds without SFML and can be benchmarked.
+ */
+class TextLayout {
+public:
+    // Splits text into lines no wider than maxWidth, assuming a monospace font
+    // (character width ~0.6 of the font size). Newlines start a new paragraph;
+    // a word longer than a line is kept whole.
+    static std::vector<std::string> wrapText(const std::string& text, float maxWidth, int fontSize);
+};
+
+#endif // TEXTLAYOUT_H
@@ -0,0 +1,138 @@
+#include "ThreadPool.h"
+#include <algorithm>
+
+ThreadPool::ThreadPool(size_t threadCount)
+    : pending(0), queued(0), stopping(false), nextQueue(0) {
+    if (threadCount == 0) {
+        threadCount = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (size_t i = 0; i < threadCount; ++i) {
+        queues.push_back(std::make_unique<TaskQueue>());
+    }
+    for (size_t i = 0; i < threadCount; ++i) {
+        workers.emplace_back(&ThreadPool::workerLoop, this, i);
+    }
+}
+
+ThreadPool::~ThreadPool() {
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        stopping = true;
+    }
+    workAvailable.notify_all();
+    for (auto& worker : workers) {
+        worker.join();
+    }
+}
+
+void ThreadPool::submit(std::function<void()> task) {
+    // Round-robin placement; stealing evens out whatever imbalance remains
+    size_t index = nextQueue.fetch_add(1, std::memory_order_relaxed) % queues.size();
+
+    // Count first, so a worker can never take the task before it is counted
+    {
+        std::lock_guard<std::mutex> lock(stateMutex);
+        pending++;
+        queued++;
+    }
+    {
+        std::lock_guard<std::mutex> lock(queues[index]->mutex);
+        queues[index]->tasks.push_back(std::move(task));
+    }
+    workAvailable.notify_one();
+}
+
+void ThreadPool::wait() {
+    std::exception_ptr error;
+    {
+        std::unique_lock<std::mutex> lock(stateMutex);
+        allDone.wait(lock, [this] { return pending == 0; });
+        error.swap(firstError);
+    }
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+void ThreadPool::parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body) {
+    if (grain == 0) grain = 1;
+    // A chunk stops at its first exception, so the earliest failing chunk holds the earliest failing item
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    size_t errorBegin = count;
+    for (size_t begin = 0; begin < count; begin += grain) {
+        size_t end = std::min(count, begin + grain);
+        submit([&body, &errorMutex, &error, &errorBegin, begin, end] {
+            try {
+                body(begin, end);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(errorMutex);
+                if (begin < errorBegin) {
+                    errorBegin = begin;
+                    error = std::current_exception();
+                }
+            }
+        });
+    }
+    wait();
+    if (error) {
+        std::rethrow_exception(error);
+    }
+}
+
+bool ThreadPool::takeTask(size_t index, std::function<void()>& task) {
+    // Own queue first (LIFO end), then steal from the others (FIFO end)
+    {
+        TaskQueue& own = *queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty()) {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            return true;
+        }
+    }
+    for (size_t offset = 1; offset < queues.size(); ++offset) {
+        TaskQueue& victim = *queues[(index + offset) % queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty()) {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            return true;
+        }
+    }
+    return false;
+}
+
+void ThreadPool::workerLoop(size_t index) {
+    std::function<void()> task;
+    for (;;) {
+        if (takeTask(index, task)) {
+            {
+                std::lock_guard<std::mutex> lock(stateMutex);
+                queued--;
+            }
+            std::exception_ptr error;
+            try {
+                task();
+            } catch (...) {
+                error = std::current_exception();
+            }
+            task = nullptr;
+
+            std::lock_guard<std::mutex> lock(stateMutex);
+            if (error && !firstError) {
+                firstError = error;
+            }
+            if (--pending == 0) {
+                allDone.notify_all();
+            }
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(stateMutex);
+        workAvailable.wait(lock, [this] { return stopping || queued > 0; });
+        if (stopping && queued == 0) {
+            return;
+        }
+    }
+}
@@ -0,0 +1,64 @@
+#ifndef THREADPOOL_H
+#define THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief ThreadPool - Fixed-size work-stealing thread pool
+ * Every worker owns a task deque: it pops its own work from the back and, when
+ * empty, steals from the front of the other workers' deques. Tasks must not
+ * block on other tasks of the same pool (wait() is for the submitting thread).
+ * A task may throw: the worker keeps the first exception and wait() rethrows
+ * it once every task has finished.
+ */
+class ThreadPool {
+public:
+    explicit ThreadPool(size_t threadCount = 0); // 0 = one worker per hardware thread
+    ~ThreadPool();
+
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    size_t size() const { return workers.size(); }
+
+    void submit(std::function<void()> task);
+
+    // Blocks until every submitted task has finished, then rethrows the first exception a task threw
+    void wait();
+
+    // Runs body(begin, end) over [0, count) in chunks of at most `grain` items and waits.
+    // If chunks throw, the one nearest the start wins, so callers see the same error as a serial loop.
+    void parallelFor(size_t count, size_t grain, const std::function<void(size_t, size_t)>& body);
+
+private:
+    struct TaskQueue {
+        std::mutex mutex;
+        std::deque<std::function<void()>> tasks;
+    };
+
+    std::vector<std::unique_ptr<TaskQueue>> queues;
+    std::vector<std::thread> workers;
+
+    std::mutex stateMutex;
+    std::condition_variable workAvailable;
+    std::condition_variable allDone;
+    size_t pending;       // Submitted but not finished (guarded by stateMutex)
+    size_t queued;        // Sitting in a deque (guarded by stateMutex)
+    bool stopping;
+    std::exception_ptr firstError; // Thrown by a task since the last wait() (guarded by stateMutex)
+    std::atomic<size_t> nextQueue;
+
+    void workerLoop(size_t index);
+    bool takeTask(size_t index, std::function<void()>& task);
+};
+
+#endif // THREADPOOL_H
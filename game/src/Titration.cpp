@@ -0,0 +1,280 @@
+#include "Titration.h"
+#include "ThreadPool.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <string>
+#include <utility>
+
+namespace {
+
+// Volumes solved together; every per-lane array of a block stays in L1
+constexpr size_t BLOCK_POINTS = 64;
+
+// Newton steps change ln[H+] by less than this at convergence (pH to about 1e-13)
+constexpr double TOLERANCE = 1e-12;
+constexpr int MAX_ITERATIONS = 200;
+
+} // namespace
+
+Titration::Titration(const Problem& problem) {
+    if (!(problem.sampleVolume.value() > 0.0) || !std::isfinite(problem.sampleVolume.value())) {
+        throw std::invalid_argument("Titration sample volume must be positive");
+    }
+    if (!(problem.titrantConcentration.value() > 0.0) || !std::isfinite(problem.titrantConcentration.value())) {
+        throw std::invalid_argument("Titrant concentration must be positive");
+    }
+    if (!(problem.spectatorCations.value() >= 0.0) || !(problem.spectatorAnions.value() >= 0.0)) {
+        throw std::invalid_argument("Spectator ion concentrations must not be negative");
+    }
+    if (!std::isfinite(problem.pKw)) {
+        throw std::invalid_argument("pKw must be finite");
+    }
+
+    for (const Analyte& analyte : problem.analytes) {
+        if (analyte.pKa.empty() || analyte.pKa.size() > MAX_PROTONS) {
+            throw std::invalid_argument("Each analyte needs between 1 and " + std::to_string(MAX_PROTONS) +
+                                        " pKa values");
+        }
+        if (!(analyte.concentration.value() >= 0.0) || !std::isfinite(analyte.concentration.value())) {
+            throw std::invalid_argument("Analyte concentration must not be negative");
+        }
+        std::vector<double> pKa = analyte.pKa;
+        std::sort(pKa.begin(), pKa.end());
+        System system;
+        system.protons = pKa.size();
+        for (size_t i = 0; i < pKa.size(); ++i) {
+            if (!std::isfinite(pKa[i])) {
+                throw std::invalid_argument("pKa values must be finite");
+            }
+            system.dissociation[i] = std::pow(10.0, -pKa[i]);
+        }
+        system.charge = static_cast<double>(analyte.protonatedCharge);
+        system.concentration = units::Molarity(analyte.concentration).value();
+        systems.push_back(system);
+    }
+
+    sampleMl = problem.sampleVolume.value();
+    titrantMolar = problem.titrantConcentration.value();
+    titrantSign = problem.titrant == Titrant::STRONG_BASE ? 1.0 : -1.0;
+    spectatorCharge = problem.spectatorCations.value() - problem.spectatorAnions.value();
+    kw = std::pow(10.0, -problem.pKw);
+}
+
+void Titration::solveBlock(const double* volumesMl, double* pH, size_t count) const {
+    double h[BLOCK_POINTS], low[BLOCK_POINTS], high[BLOCK_POINTS];
+    double dilution[BLOCK_POINTS], strongCharge[BLOCK_POINTS];
+    double balance[BLOCK_POINTS], slope[BLOCK_POINTS], inverseH[BLOCK_POINTS];
+    double term[BLOCK_POINTS], sum[BLOCK_POINTS], lost[BLOCK_POINTS], lostSquared[BLOCK_POINTS];
+    bool done[BLOCK_POINTS];
+
+    // Bracket: outside [Kw / M, M], where M bounds every other term of the balance, the
+    // [H+] or OH- term alone decides the sign
+    for (size_t l = 0; l < count; ++l) {
+        const double total = sampleMl + volumesMl[l];
+        dilution[l] = sampleMl / total;
+        strongCharge[l] = spectatorCharge * dilution[l] + titrantSign * titrantMolar * volumesMl[l] / total;
+        high[l] = std::fabs(strongCharge[l]) + 1.0;
+    }
+    for (const System& system : systems) {
+        const double bound = system.concentration * (std::fabs(system.charge) + static_cast<double>(system.protons));
+        for (size_t l = 0; l < count; ++l) {
+            high[l] += bound * dilution[l];
+        }
+    }
+    for (size_t l = 0; l < count; ++l) {
+        low[l] = kw / high[l];
+        h[l] = std::sqrt(low[l] * high[l]);
+        done[l] = false;
+    }
+
+    for (int iteration = 0; iteration < MAX_ITERATIONS; ++iteration) {
+        // Charge balance and its derivative with respect to [H+]
+        for (size_t l = 0; l < count; ++l) {
+            inverseH[l] = 1.0 / h[l];
+            balance[l] = h[l] - kw * inverseH[l] + strongCharge[l];
+            slope[l] = 1.0 + kw * inverseH[l] * inverseH[l];
+        }
+        for (const System& system : systems) {
+            // Species that lost i protons, relative to the fully protonated one: prod(Ka_k / [H+])
+            for (size_t l = 0; l < count; ++l) {
+                term[l] = 1.0;
+                sum[l] = 1.0;
+                lost[l] = 0.0;
+                lostSquared[l] = 0.0;
+            }
+            for (size_t i = 1; i <= system.protons; ++i) {
+                const double ka = system.dissociation[i - 1];
+                const double weight = static_cast<double>(i);
+                for (size_t l = 0; l < count; ++l) {
+                    term[l] *= ka * inverseH[l];
+                    sum[l] += term[l];
+                    lost[l] += weight * term[l];
+                    lostSquared[l] += weight * weight * term[l];
+                }
+            }
+            for (size_t l = 0; l < count; ++l) {
+                const double concentration = system.concentration * dilution[l];
+                const double meanLost = lost[l] / sum[l];
+                const double variance = lostSquared[l] / sum[l] - meanLost * meanLost;
+                balance[l] += concentration * (system.charge - meanLost);
+                slope[l] += concentration * variance * inverseH[l];
+            }
+        }
+
+        // Newton in ln[H+] (exp(-s) replaced by a first-order rational that keeps [H+] positive),
+        // geometric bisection when the step leaves the bracket
+        size_t remaining = 0;
+        for (size_t l = 0; l < count; ++l) {
+            const bool above = balance[l] > 0.0;
+            high[l] = above ? h[l] : high[l];
+            low[l] = above ? low[l] : h[l];
+            const double step = balance[l] / (h[l] * slope[l]);
+            const double newton = step > 0.0 ? h[l] / (1.0 + step) : h[l] * (1.0 - step);
+            const bool converged = std::fabs(step) < TOLERANCE; // Also an exact root, which sits on the bracket
+            const bool inside = newton > low[l] && newton < high[l];
+            const double next = inside || converged ? newton : std::sqrt(low[l] * high[l]);
+            h[l] = done[l] ? h[l] : next;
+            done[l] = done[l] || converged;
+            remaining += done[l] ? 0 : 1;
+        }
+        if (remaining == 0) {
+            break;
+        }
+    }
+
+    for (size_t l = 0; l < count; ++l) {
+        pH[l] = -std::log10(h[l]);
+    }
+}
+
+double Titration::pH(units::Millilitres titrantVolume) const {
+    double volume = titrantVolume.value();
+    double result = 0.0;
+    solveBlock(&volume, &result, 1);
+    return result;
+}
+
+void Titration::pH(const units::Millilitres* titrantVolumes, double* pH, size_t count) const {
+    double volumes[BLOCK_POINTS];
+    for (size_t begin = 0; begin < count; begin += BLOCK_POINTS) {
+        const size_t block = std::min(BLOCK_POINTS, count - begin);
+        for (size_t l = 0; l < block; ++l) {
+            volumes[l] = titrantVolumes[begin + l].value();
+        }
+        solveBlock(volumes, pH + begin, block);
+    }
+}
+
+std::vector<units::Millilitres> Titration::equivalenceVolumes() const {
+    // Proton steps of every system, weakest-bound proton last
+    std::vector<std::pair<double, double>> steps; // Ka, mmol of protons in the sample
+    double protonatedCharge = spectatorCharge * sampleMl;
+    for (const System& system : systems) {
+        const double amount = system.concentration * sampleMl;
+        protonatedCharge += system.charge * amount;
+        for (size_t i = 0; i < system.protons; ++i) {
+            steps.emplace_back(system.dissociation[i], amount);
+        }
+    }
+    std::sort(steps.begin(), steps.end(), [](const auto& a, const auto& b) { return a.first > b.first; });
+
+    // After the first m steps the strong-ion charge balances: strong charge = removed - z0 charge
+    std::vector<units::Millilitres> volumes;
+    double removed = 0.0;
+    for (size_t m = 0; m <= steps.size(); ++m) {
+        if (m > 0) removed += steps[m - 1].second;
+        const double volume = titrantSign * (removed - protonatedCharge) / titrantMolar;
+        if (volume > 0.0) {
+            volumes.emplace_back(volume);
+        }
+    }
+    std::sort(volumes.begin(), volumes.end());
+    volumes.erase(std::unique(volumes.begin(), volumes.end()), volumes.end());
+    return volumes;
+}
+
+Titration::Curve Titration::curve(units::Millilitres maxVolume, size_t points) const {
+    if (points < 2 || !(maxVolume.value() > 0.0)) {
+        throw std::invalid_argument("A titration curve needs at least two points and a positive volume");
+    }
+    Curve result;
+    result.volumes.reserve(points);
+    for (size_t i = 0; i < points; ++i) {
+        result.volumes.emplace_back(maxVolume.value() * static_cast<double>(i) / static_cast<double>(points - 1));
+    }
+    result.pH.resize(points);
+    pH(result.volumes.data(), result.pH.data(), points);
+    return result;
+}
+
+Titration::Curve Titration::adaptiveCurve(units::Millilitres maxVolume, double maxStepPH, size_t coarsePoints,
+                                          units::Millilitres minStep, size_t maxPoints) const {
+    if (!(maxStepPH > 0.0)) {
+        throw std::invalid_argument("Adaptive sampling needs a positive pH step");
+    }
+    Curve result = curve(maxVolume, std::max<size_t>(coarsePoints, 2));
+
+    // The jumps sit at the equivalence points, so sample them exactly
+    std::vector<units::Millilitres> extra;
+    for (units::Millilitres volume : equivalenceVolumes()) {
+        if (volume < maxVolume) extra.push_back(volume);
+    }
+
+    std::vector<units::Millilitres> volumes;
+    std::vector<double> values;
+    std::vector<double> extraPH;
+    while (true) {
+        if (!extra.empty()) {
+            extraPH.resize(extra.size());
+            pH(extra.data(), extraPH.data(), extra.size());
+
+            // Merge the two ascending lists
+            volumes.clear();
+            values.clear();
+            size_t i = 0, j = 0;
+            while (i < result.volumes.size() || j < extra.size()) {
+                bool takeOld = j == extra.size() || (i < result.volumes.size() && result.volumes[i] <= extra[j]);
+                if (takeOld) {
+                    volumes.push_back(result.volumes[i]);
+                    values.push_back(result.pH[i++]);
+                } else if (volumes.empty() || volumes.back() != extra[j]) {
+                    volumes.push_back(extra[j]);
+                    values.push_back(extraPH[j++]);
+                } else {
+                    j++;
+                }
+            }
+            result.volumes.swap(volumes);
+            result.pH.swap(values);
+        }
+
+        // Midpoints of the intervals that are still too steep
+        extra.clear();
+        for (size_t i = 0; i + 1 < result.volumes.size(); ++i) {
+            if (std::fabs(result.pH[i + 1] - result.pH[i]) > maxStepPH &&
+                result.volumes[i + 1] - result.volumes[i] > minStep) {
+                extra.push_back(units::Millilitres(0.5 * (result.volumes[i].value() + result.volumes[i + 1].value())));
+            }
+        }
+        if (result.volumes.size() + extra.size() > maxPoints) {
+            extra.resize(maxPoints > result.volumes.size() ? maxPoints - result.volumes.size() : 0);
+        }
+        if (extra.empty()) {
+            return result;
+        }
+    }
+}
+
+std::vector<Titration::Curve> Titration::adaptiveCurves(const std::vector<Titration>& titrations,
+                                                        units::Millilitres maxVolume, double maxStepPH,
+                                                        ThreadPool& pool, size_t grain) {
+    std::vector<Curve> curves(titrations.size());
+    // parallelFor rethrows for the first failing titration in input order, whatever the thread timing
+    pool.parallelFor(titrations.size(), grain, [&](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; ++i) {
+            curves[i] = titrations[i].adaptiveCurve(maxVolume, maxStepPH);
+        }
+    });
+    return curves;
+}
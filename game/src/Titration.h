@@ -0,0 +1,95 @@
+#ifndef TITRATION_H
+#define TITRATION_H
+
+#include "Quantity.h"
+#include <cstddef>
+#include <vector>
+
+class ThreadPool;
+
+/**
+ * @brief Titration - pH curves of acid-base titrations
+ * The sample holds weak acid/base systems, each described by its pKa values.
+ * The titrant is a strong base or a strong acid. At every titrant volume the pH
+ * is the root of the charge balance:
+ *   [H+] - Kw/[H+] + (strong cations - strong anions) + sum over systems of C * (z0 - n(H+)) = 0
+ * Here z0 is the charge of a system's fully protonated form and n(H+) is the
+ * average number of protons it has lost. The left side rises steadily with
+ * [H+], so the root is unique and a bracket always contains it.
+ *
+ * Many volumes are solved together, one lane per volume, in blocks. Each step
+ * is a branch-free Newton update in ln[H+], with geometric bisection whenever
+ * Newton leaves the bracket. The inner loops run over lanes and use only
+ * multiply, divide, sqrt and select, so the compiler vectorizes them. Finished
+ * lanes stop changing, so every lane's result is independent of its block. A
+ * single pH() gives the same bits as the batch.
+ */
+class Titration {
+public:
+    static constexpr size_t MAX_PROTONS = 8; // pKa values per system
+
+    // Weak acid/base system; pKa values in any order (they are sorted)
+    struct Analyte {
+        std::vector<double> pKa;      // H3PO4: {2.15, 7.20, 12.35}; NH3 (as NH4+): {9.25}
+        int protonatedCharge = 0;     // Charge of the fully protonated form: 0 for H3PO4, +1 for NH4+
+        units::Molarity concentration{0.0};
+    };
+
+    enum class Titrant { STRONG_BASE, STRONG_ACID };
+
+    struct Problem {
+        std::vector<Analyte> analytes;
+        units::Millilitres sampleVolume{0.0};
+        Titrant titrant = Titrant::STRONG_BASE;
+        units::Molarity titrantConcentration{0.0};
+        units::Molarity spectatorCations{0.0}; // Strong-electrolyte charge already in the sample (Na+ of Na2CO3), eq/L
+        units::Molarity spectatorAnions{0.0};  // Cl- of NH4Cl, eq/L
+        double pKw = 14.0;
+    };
+
+    struct Curve {
+        std::vector<units::Millilitres> volumes; // Ascending
+        std::vector<double> pH;
+    };
+
+    // Throws std::invalid_argument for negative concentrations, non-positive volumes or too many pKa values
+    explicit Titration(const Problem& problem);
+
+    double pH(units::Millilitres titrantVolume) const;
+    void pH(const units::Millilitres* titrantVolumes, double* pH, size_t count) const;
+
+    // Titrant volumes at which a whole proton step has been titrated, ascending (0 excluded)
+    std::vector<units::Millilitres> equivalenceVolumes() const;
+
+    // pH at points evenly spaced from 0 to maxVolume (at least two points)
+    Curve curve(units::Millilitres maxVolume, size_t points) const;
+
+    // Starts from an even grid of coarsePoints plus the equivalence volumes, then halves every
+    // interval whose pH jump exceeds maxStepPH, until no such interval is wider than minStep or
+    // maxPoints is reached. Each round of new points is solved as one batch.
+    Curve adaptiveCurve(units::Millilitres maxVolume, double maxStepPH = 0.05, size_t coarsePoints = 64,
+                        units::Millilitres minStep = units::Millilitres(1e-4), size_t maxPoints = 8192) const;
+
+    // Adaptive curves of many titrations on the pool; curves[i] belongs to titrations[i]
+    static std::vector<Curve> adaptiveCurves(const std::vector<Titration>& titrations, units::Millilitres maxVolume,
+                                             double maxStepPH, ThreadPool& pool, size_t grain = 4);
+
+private:
+    struct System {
+        size_t protons;
+        double dissociation[MAX_PROTONS]; // Ka, strongest first
+        double charge;                    // z0
+        double concentration;             // mol/L before dilution
+    };
+
+    std::vector<System> systems;
+    double sampleMl;
+    double titrantMolar;
+    double titrantSign; // +1 adds cations (base), -1 adds anions (acid)
+    double spectatorCharge; // Cations minus anions in the sample, eq/L
+    double kw;
+
+    void solveBlock(const double* volumesMl, double* pH, size_t count) const;
+};
+
+#endif // TITRATION_H
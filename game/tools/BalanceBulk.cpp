@@ -0,0 +1,178 @@
+#include "BulkBalancer.h"
+#include "ThreadPool.h"
+#include <cerrno>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+/**
+ * @brief balance_bulk - Checks and balances every equation in a file
+ *
+ * Usage: balance_bulk <equations.txt> [--threads N] [--repeat K] [--scaling] [--medium M] [--out results.txt]
+ *   --threads N   worker threads (default: all hardware threads)
+ *   --medium M    acidic or basic: add H2O and H^+ or OH^- to redox equations as needed
+ *   --repeat K    balance the file K times over (for throughput measurements)
+ *   --scaling     run with 1, 2, 4, ... N threads and report speedup
+ *   --out FILE    write one result line per input equation
+ */
+
+namespace {
+
+struct Options {
+    std::string input;
+    std::string output;
+    size_t threads = 0;
+    size_t repeat = 1;
+    bool scaling = false;
+    EquationBalancer::Medium medium = EquationBalancer::Medium::NONE;
+};
+
+// Whole unsigned decimal number only: std::stoul throws on "abc" and accepts "-1" and "5x"
+bool readCount(const char* text, size_t& out) {
+    if (*text < '0' || *text > '9') {
+        return false;
+    }
+    char* end = nullptr;
+    errno = 0;
+    unsigned long long value = std::strtoull(text, &end, 10);
+    if (*end != '\0' || errno == ERANGE || value > static_cast<unsigned long long>(SIZE_MAX)) {
+        return false;
+    }
+    out = static_cast<size_t>(value);
+    return true;
+}
+
+bool parseArguments(int argc, char** argv, Options& options) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--threads" && i + 1 < argc) {
+            if (!readCount(argv[++i], options.threads)) return false;
+        } else if (arg == "--repeat" && i + 1 < argc) {
+            if (!readCount(argv[++i], options.repeat)) return false;
+        } else if (arg == "--out" && i + 1 < argc) {
+            options.output = argv[++i];
+        } else if (arg == "--medium" && i + 1 < argc) {
+            std::string medium = argv[++i];
+            if (medium == "acidic") {
+                options.medium = EquationBalancer::Medium::ACIDIC;
+            } else if (medium == "basic") {
+                options.medium = EquationBalancer::Medium::BASIC;
+            } else {
+                return false;
+            }
+        } else if (arg == "--scaling") {
+            options.scaling = true;
+        } else if (options.input.empty() && arg[0] != '-') {
+            options.input = arg;
+        } else {
+            return false;
+        }
+    }
+    return !options.input.empty();
+}
+
+struct Run {
+    size_t threads;
+    double seconds;
+    std::uint64_t digest;
+};
+
+Run timedRun(const std::vector<std::string>& equations, size_t threads, EquationBalancer::Medium medium,
+             std::vector<BulkBalancer::Outcome>* keep = nullptr) {
+    ThreadPool pool(threads);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<BulkBalancer::Outcome> outcomes = BulkBalancer::balanceAll(equations, pool, 256, medium);
+    double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    Run run{pool.size(), seconds, BulkBalancer::digest(outcomes)};
+    if (keep) *keep = std::move(outcomes);
+    return run;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    Options options;
+    if (!parseArguments(argc, argv, options)) {
+        std::cerr << "Usage: balance_bulk <equations.txt> [--threads N] [--repeat K] [--scaling] [--medium acidic|basic]"
+                     " [--out results.txt]\n";
+        return 2;
+    }
+
+    std::ifstream in(options.input);
+    if (!in) {
+        std::cerr << "Cannot open " << options.input << "\n";
+        return 1;
+    }
+    std::vector<std::string> lines = BulkBalancer::readEquations(in);
+    std::vector<std::string> equations;
+    equations.reserve(lines.size() * options.repeat);
+    for (size_t r = 0; r < options.repeat; ++r) {
+        equations.insert(equations.end(), lines.begin(), lines.end());
+    }
+
+    size_t maxThreads = options.threads != 0 ? options.threads : std::max(1u, std::thread::hardware_concurrency());
+
+    if (options.scaling) {
+        std::vector<size_t> counts;
+        for (size_t t = 1; t < maxThreads; t *= 2) counts.push_back(t);
+        counts.push_back(maxThreads);
+
+        std::cout << "equations: " << equations.size() << "\n"
+                  << std::setw(8) << "threads" << std::setw(12) << "seconds" << std::setw(14) << "eq/s"
+                  << std::setw(10) << "speedup" << std::setw(12) << "efficiency" << "  digest\n";
+        double baseline = 0.0;
+        std::uint64_t firstDigest = 0;
+        bool deterministic = true;
+        for (size_t t : counts) {
+            Run run = timedRun(equations, t, options.medium);
+            if (baseline == 0.0) {
+                baseline = run.seconds;
+                firstDigest = run.digest;
+            }
+            deterministic = deterministic && run.digest == firstDigest;
+            double speedup = baseline / run.seconds;
+            std::cout << std::setw(8) << run.threads
+                      << std::setw(12) << std::fixed << std::setprecision(4) << run.seconds
+                      << std::setw(14) << std::setprecision(0) << equations.size() / run.seconds
+                      << std::setw(10) << std::setprecision(2) << speedup
+                      << std::setw(11) << std::setprecision(0) << 100.0 * speedup / run.threads << "%"
+                      << "  " << std::hex << run.digest << std::dec << "\n";
+        }
+        std::cout << (deterministic ? "Results identical for every thread count\n"
+                                    : "ERROR: results differ between thread counts\n");
+        return deterministic ? 0 : 1;
+    }
+
+    std::vector<BulkBalancer::Outcome> outcomes;
+    Run run = timedRun(equations, maxThreads, options.medium, &outcomes);
+
+    size_t balanced = 0, alreadyBalanced = 0, parseErrors = 0;
+    for (const auto& outcome : outcomes) {
+        if (!outcome.parsed) parseErrors++;
+        if (outcome.status == EquationBalancer::Status::BALANCED) balanced++;
+        if (outcome.inputBalanced) alreadyBalanced++;
+    }
+
+    std::cout << "equations:        " << equations.size() << "\n"
+              << "balanced:         " << balanced << "\n"
+              << "already balanced: " << alreadyBalanced << "\n"
+              << "not balanceable:  " << equations.size() - balanced - parseErrors << "\n"
+              << "parse errors:     " << parseErrors << "\n"
+              << "threads:          " << run.threads << "\n"
+              << "time:             " << std::fixed << std::setprecision(4) << run.seconds << " s ("
+              << std::setprecision(0) << equations.size() / run.seconds << " eq/s)\n";
+
+    if (!options.output.empty()) {
+        std::ofstream out(options.output);
+        for (size_t i = 0; i < outcomes.size(); ++i) {
+            out << equations[i] << "\t" << BulkBalancer::formatOutcome(outcomes[i]) << "\n";
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,48 @@
+#include "ContentPack.h"
+#include "DialogSystem.h"
+#include <iostream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+/**
+ * @brief build_content_pack - Compiles a JSON content pack into a binary pack
+ *
+ * Usage: build_content_pack <content.json> <content.pack>
+ *        build_content_pack --built-in <content.pack>
+ *   content.json  dialogs and tasks in the format read by the game (see README)
+ *   --built-in    the game's five built-in levels instead
+ *
+ * The game maps content.pack from its working directory when present, before
+ * looking for content.json.
+ */
+
+int main(int argc, char** argv) {
+    if (argc != 3) {
+        std::cerr << "Usage: build_content_pack <content.json | --built-in> <content.pack>\n";
+        return 2;
+    }
+    const std::string input = argv[1];
+    const std::string output = argv[2];
+
+    DialogSystem content;
+    if (input != "--built-in" && !content.loadFromJSON(input)) {
+        std::cerr << content.getLoadError() << "\n";
+        return 1;
+    }
+    try {
+        const std::vector<char> image = content.buildPack();
+        ContentPack::save(image, output);
+        // Reopen through the mapping the game uses and read everything, as a check
+        const ContentPack pack = ContentPack::open(output);
+        if (!pack.verify()) {
+            throw std::invalid_argument("Checksum mismatch after writing");
+        }
+        std::cout << pack.taskCount() << " tasks, " << pack.dialogCount() << " dialogs, " << pack.imageBytes()
+                  << " bytes -> " << output << "\n";
+    } catch (const std::invalid_argument& e) {
+        std::cerr << output << ": " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,64 @@
+#include "CompoundDictionary.h"
+#include <fstream>
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+/**
+ * @brief build_dictionary - Compiles a compound-name list into a dictionary image
+ *
+ * Usage: build_dictionary <names.tsv> <out.dict> [--with-built-in]
+ *   names.tsv        lines "name<TAB>formula[<TAB>score]", '#' starts a comment
+ *   --with-built-in  also include the game's built-in names
+ *
+ * The game maps compounds.dict from its working directory when present.
+ */
+
+int main(int argc, char** argv) {
+    std::string input, output;
+    bool withBuiltIn = false;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--with-built-in") {
+            withBuiltIn = true;
+        } else if (input.empty() && arg[0] != '-') {
+            input = arg;
+        } else if (output.empty() && arg[0] != '-') {
+            output = arg;
+        } else {
+            input.clear();
+            break;
+        }
+    }
+    if (input.empty() || output.empty()) {
+        std::cerr << "Usage: build_dictionary <names.tsv> <out.dict> [--with-built-in]\n";
+        return 2;
+    }
+
+    std::ifstream in(input);
+    if (!in) {
+        std::cerr << "Cannot open " << input << "\n";
+        return 1;
+    }
+    try {
+        CompoundDictionary::Builder builder;
+        if (withBuiltIn) {
+            const CompoundDictionary builtIn = CompoundDictionary::builtIn();
+            std::vector<CompoundDictionary::Entry> all;
+            builtIn.complete("", builtIn.size(), all);
+            for (const CompoundDictionary::Entry& entry : all) {
+                builder.add(entry.name, entry.formula, entry.score);
+            }
+        }
+        builder.load(in);
+        const std::vector<char> image = builder.build();
+        CompoundDictionary::save(image, output);
+        // Reopen through the mapping the game uses, as a check
+        const CompoundDictionary dictionary = CompoundDictionary::open(output);
+        std::cout << dictionary.size() << " names, " << dictionary.imageBytes() << " bytes -> " << output << "\n";
+    } catch (const std::invalid_argument& e) {
+        std::cerr << input << ": " << e.what() << "\n";
+        return 1;
+    }
+    return 0;
+}